@@ -17,22 +17,62 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
     src/main/bitrate_box.cpp \
+    src/main/bus_load_meter.cpp \
+    src/main/bus_load_window.cpp \
+    src/main/conformance_checker.cpp \
+    src/main/conformance_window.cpp \
+    src/main/device_decoders.cpp \
     src/main/filter.cpp \
     src/main/filter_list.cpp \
+    src/main/latency_analyzer.cpp \
+    src/main/latency_window.cpp \
+    src/main/log_reader.cpp \
     src/main/log_window.cpp \
     src/main/main.cpp \
     src/main/main_window.cpp \
-    src/main/settings_dialog.cpp
+    src/main/period_analyzer.cpp \
+    src/main/period_window.cpp \
+    src/main/register_decoder.cpp \
+    src/main/register_history.cpp \
+    src/main/register_history_window.cpp \
+    src/main/register_map.cpp \
+    src/main/register_map_window.cpp \
+    src/main/settings_dialog.cpp \
+    src/main/time_series.cpp \
+    src/main/time_series_window.cpp \
+    src/main/traffic_counters.cpp \
+    src/main/traffic_window.cpp
 
 HEADERS += \
     src/cannabus_library/cannabus_common.h \
+    src/cannabus_library/cannabus_frame_bits.h \
     src/main/bitrate.h \
     src/main/bitrate_box.h \
+    src/main/bus_load_meter.h \
+    src/main/bus_load_window.h \
+    src/main/conformance_checker.h \
+    src/main/conformance_window.h \
+    src/main/device_decoder_interface.h \
+    src/main/device_decoders.h \
     src/main/filter.h \
     src/main/filter_list.h \
+    src/main/latency_analyzer.h \
+    src/main/latency_window.h \
+    src/main/log_reader.h \
     src/main/log_window.h \
     src/main/main_window.h \
-    src/main/settings_dialog.h
+    src/main/period_analyzer.h \
+    src/main/period_window.h \
+    src/main/register_decoder.h \
+    src/main/register_history.h \
+    src/main/register_history_window.h \
+    src/main/register_map.h \
+    src/main/register_map_window.h \
+    src/main/settings_dialog.h \
+    src/main/time_series.h \
+    src/main/time_series_window.h \
+    src/main/traffic_counters.h \
+    src/main/traffic_window.h
 
 FORMS += \
     src/main/main_window.ui \
@@ -0,0 +1,176 @@
+#include "bench_runner.h"
+#include "cannabus_request_creator.h"
+#include "cannabus_frame_bits.h"
+#include "cannabus_msg_queue.h"
+#include "cannabus_block_transfer.h"
+
+namespace benchmark
+{
+    namespace
+    {
+        using namespace cannabus;
+
+        static constexpr uint8_t slave_address = 5;
+
+        using Register = RequestCreator::Register;
+    }
+
+    void addRequestBenchmarks( Runner & runner )
+    {
+        runner.add( "request_creator/read_range", max_regs_in_range, []( uint64_t iterations, Counters & )
+        {
+            RequestCreator creator;
+            creator.init( slave_address );
+
+            can::CanMessage request;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                uint8_t regNumBegin = (uint8_t)( i % 16 );
+
+                creator.createReadRange( request, regNumBegin, regNumBegin + max_regs_in_range - 1 );
+                doNotOptimize( request );
+            }
+
+            return iterations;
+        } );
+
+        runner.add( "request_creator/write_range", max_regs_in_range, []( uint64_t iterations, Counters & )
+        {
+            RequestCreator creator;
+            creator.init( slave_address );
+
+            uint8_t values[ max_regs_in_range ] = { 1, 2, 3, 4, 5, 6 };
+            can::CanMessage request;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                uint8_t regNumBegin = (uint8_t)( 16 + i % 16 );
+
+                creator.createWriteRange( request, regNumBegin, regNumBegin + max_regs_in_range - 1,
+                                          umba::ArrayView<const uint8_t>( values, max_regs_in_range ) );
+                doNotOptimize( request );
+            }
+
+            return iterations;
+        } );
+
+        runner.add( "request_creator/write_series", max_regs_in_series, []( uint64_t iterations, Counters & )
+        {
+            RequestCreator creator;
+            creator.init( slave_address );
+
+            Register series[ max_regs_in_series ];
+            can::CanMessage request;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                for( uint8_t k = 0; k < max_regs_in_series; k++ )
+                {
+                    series[k].num = (uint8_t)( 16 + ( i + 3 * k ) % 16 );
+                    series[k].val = (uint8_t)i;
+                }
+
+                creator.createWriteSeries( request, umba::ArrayView<const Register>( series, max_regs_in_series ) );
+                doNotOptimize( request );
+            }
+
+            return iterations;
+        } );
+
+        runner.add( "request_creator/read_series", max_regs_in_series, []( uint64_t iterations, Counters & )
+        {
+            RequestCreator creator;
+            creator.init( slave_address );
+
+            Register series[ max_regs_in_series ];
+            can::CanMessage request;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                for( uint8_t k = 0; k < max_regs_in_series; k++ )
+                {
+                    series[k].num = (uint8_t)( ( i + 3 * k ) % 16 );
+                }
+
+                creator.createReadSeries( request, umba::ArrayView<const Register>( series, max_regs_in_series ) );
+                doNotOptimize( request );
+            }
+
+            return iterations;
+        } );
+
+        // разбор кадра: поля ID, которые смотрят сессии, фильтры и лог на каждом кадре
+        runner.add( "frame/decode_id", 0, []( uint64_t iterations, Counters & )
+        {
+            uint32_t sum = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                uint32_t id = (uint32_t)( i & 0x7FF );
+
+                sum += getAddressFromId( id ) + (uint32_t)getFCodeFromId( id ) + (uint32_t)getMsgTypeFromId( id );
+                doNotOptimize( sum );
+            }
+
+            return iterations;
+        } );
+
+        runner.add( "frame/exact_bits", 8, []( uint64_t iterations, Counters & )
+        {
+            uint8_t data[8] = { 0x00, 0xFF, 0x55, 0xAA, 0x0F, 0xF0, 0x12, 0x34 };
+            uint32_t sum = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                data[0] = (uint8_t)i;
+
+                sum += getFrameBits( (uint32_t)( i & 0x7FF ), data, 8 );
+                doNotOptimize( sum );
+            }
+
+            return iterations;
+        } );
+
+        runner.add( "msg_queue/push_pop", 8, []( uint64_t iterations, Counters & )
+        {
+            MsgQueue< 8 > queue;
+            can::CanMessage msg;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                msg.id = (uint32_t)i;
+
+                queue.tryPush( msg );
+                queue.tryPop( msg );
+                doNotOptimize( msg );
+            }
+
+            return iterations;
+        } );
+
+        // CRC блока потоковой передачи, операция - один байт
+        runner.add( "block_transfer/crc", block_bytes_max, []( uint64_t iterations, Counters & )
+        {
+            uint8_t block[ block_bytes_max ];
+
+            for( uint32_t i = 0; i < block_bytes_max; i++ )
+            {
+                block[i] = (uint8_t)( i * 7 );
+            }
+
+            uint32_t sum = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                block[0] = (uint8_t)i;
+
+                sum += calcBlockCrc( block, block_bytes_max );
+                doNotOptimize( sum );
+            }
+
+            return iterations * block_bytes_max;
+        } );
+    }
+
+} // namespace benchmark
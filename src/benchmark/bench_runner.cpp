@@ -0,0 +1,191 @@
+#include "bench_runner.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace benchmark
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // пока прогон короче этого, число итераций удваивается, дальше - пересчитывается до min-time
+        const double calibration_share = 0.1;
+
+        const char * const usage = "usage: cannabus_benchmark [--filter substring] [--min-time ms] [--repeats N]"
+                                   " [--format json|csv]\n";
+    }
+
+    void Counters::set( const char * name, double value )
+    {
+        for( auto & counter : m_counters )
+        {
+            if( strcmp( counter.name, name ) == 0 )
+            {
+                counter.value = value;
+                return;
+            }
+        }
+
+        m_counters.push_back( Counter{ name, value } );
+    }
+
+    void Runner::add( const char * name, uint32_t param, Body body )
+    {
+        m_cases.push_back( Case{ name, param, body } );
+    }
+
+    /**************************************************************************************************
+    Описание:  Запуск всех замеров
+    Аргументы: --filter подстрока  - только замеры, в имени которых она есть
+               --min-time мс       - минимальная длительность одного прогона
+               --repeats N         - число прогонов каждого замера
+               --format json|csv   - формат вывода
+    Возврат:   код завершения процесса
+    Замечания: -
+    **************************************************************************************************/
+    int Runner::run( int argc, char * argv[] )
+    {
+        // опция без значения или незнакомая - ошибка, а не молчаливый прогон всех замеров
+        for( int i = 1; i < argc; i++ )
+        {
+            const char * name = argv[i];
+
+            if( i + 1 >= argc )
+            {
+                fprintf( stderr, "no value for %s\n%s", name, usage );
+                return 1;
+            }
+
+            const char * value = argv[ ++i ];
+
+            if( strcmp( name, "--filter" ) == 0 )
+            {
+                m_filter = value;
+            }
+            else if( strcmp( name, "--min-time" ) == 0 )
+            {
+                m_minTime = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--repeats" ) == 0 )
+            {
+                m_repeats = std::max( 1ul, strtoul( value, nullptr, 10 ) );
+            }
+            else if( strcmp( name, "--format" ) == 0 && ( strcmp( value, "json" ) == 0 || strcmp( value, "csv" ) == 0 ) )
+            {
+                m_isCsv = strcmp( value, "csv" ) == 0;
+            }
+            else
+            {
+                fprintf( stderr, "unknown option %s %s\n%s", name, value, usage );
+                return 1;
+            }
+        }
+
+        printHeader();
+
+        for( auto & benchCase : m_cases )
+        {
+            if( m_filter != nullptr && strstr( benchCase.name, m_filter ) == nullptr )
+            {
+                continue;
+            }
+
+            Counters counters;
+            Result result = measure( benchCase, counters );
+
+            print( benchCase, result, counters );
+        }
+
+        return 0;
+    }
+
+    Runner::Result Runner::measure( Case & benchCase, Counters & counters )
+    {
+        const double minTimeNs = m_minTime * 1e6;
+
+        auto runOnce = [&]( uint64_t iterations, uint64_t & ops ) -> double
+        {
+            counters.clear();
+
+            auto start = Clock::now();
+            ops = benchCase.body( iterations, counters );
+            auto finish = Clock::now();
+
+            return std::chrono::duration< double, std::nano >( finish - start ).count();
+        };
+
+        uint64_t iterations = 1;
+        uint64_t ops = 0;
+        double elapsed = runOnce( iterations, ops );
+
+        while( elapsed < minTimeNs * calibration_share )
+        {
+            iterations *= 2;
+            elapsed = runOnce( iterations, ops );
+        }
+
+        iterations = std::max< uint64_t >( iterations, (uint64_t)( iterations * minTimeNs / elapsed ) );
+
+        std::vector< double > nsPerOp;
+
+        for( uint32_t i = 0; i < m_repeats; i++ )
+        {
+            elapsed = runOnce( iterations, ops );
+
+            nsPerOp.push_back( elapsed / std::max< uint64_t >( ops, 1 ) );
+        }
+
+        std::sort( nsPerOp.begin(), nsPerOp.end() );
+
+        return Result{ iterations, ops, nsPerOp.front(), nsPerOp[ nsPerOp.size() / 2 ] };
+    }
+
+    void Runner::printHeader( void )
+    {
+        if( m_isCsv )
+        {
+            printf( "benchmark,param,iterations,ops,ns_per_op_min,ns_per_op_median,ops_per_sec,counters\n" );
+        }
+    }
+
+    void Runner::print( const Case & benchCase, const Result & result, const Counters & counters )
+    {
+        double opsPerSec = result.nsPerOpMedian > 0 ? 1e9 / result.nsPerOpMedian : 0;
+
+        if( m_isCsv )
+        {
+            printf( "%s,%u,%llu,%llu,%.2f,%.2f,%.0f,", benchCase.name, benchCase.param,
+                    (unsigned long long)result.iterations, (unsigned long long)result.ops,
+                    result.nsPerOpMin, result.nsPerOpMedian, opsPerSec );
+
+            // счетчики одной ячейкой: имя=значение через точку с запятой
+            for( uint32_t i = 0; i < counters.get().size(); i++ )
+            {
+                printf( i == 0 ? "%s=%g" : ";%s=%g", counters.get()[i].name, counters.get()[i].value );
+            }
+
+            printf( "\n" );
+        }
+        else
+        {
+            printf( "{\"benchmark\":\"%s\",\"param\":%u,\"iterations\":%llu,\"ops\":%llu,"
+                    "\"ns_per_op_min\":%.2f,\"ns_per_op_median\":%.2f,\"ops_per_sec\":%.0f",
+                    benchCase.name, benchCase.param,
+                    (unsigned long long)result.iterations, (unsigned long long)result.ops,
+                    result.nsPerOpMin, result.nsPerOpMedian, opsPerSec );
+
+            for( const auto & counter : counters.get() )
+            {
+                printf( ",\"%s\":%g", counter.name, counter.value );
+            }
+
+            printf( "}\n" );
+        }
+
+        fflush( stdout );
+    }
+
+} // namespace benchmark
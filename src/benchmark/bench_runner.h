@@ -0,0 +1,112 @@
+#pragma once
+
+#include "callbacks/callbacks.h"
+#include <stdint.h>
+#include <vector>
+
+namespace benchmark
+{
+    // Дополнительные величины, которые замер может сообщить помимо времени на операцию
+    // (например, худшая задержка приема). Имена - строковые литералы
+    class Counters
+    {
+
+    public:
+
+        void set( const char * name, double value );
+
+        struct Counter
+        {
+            const char * name;
+            double value;
+        };
+
+        const std::vector< Counter > & get( void ) const
+        {
+            return m_counters;
+        }
+
+        void clear( void )
+        {
+            m_counters.clear();
+        }
+
+    private:
+
+        std::vector< Counter > m_counters;
+    };
+
+    // Тело замера: выполнить iterations итераций и вернуть число сделанных операций
+    // (запросов, кадров, обращений к таблице), на которое делится время
+    using Body = callback::Callback<uint64_t ( uint64_t iterations, Counters & counters )>;
+
+    // Набор замеров. Каждый прогоняется столько итераций, чтобы занять не меньше min-time,
+    // и повторяется repeats раз; в отчет идут минимум и медиана времени на операцию.
+    // Результаты печатаются по строке на замер в JSON (по умолчанию) или CSV, чтобы сравнивать релизы скриптом
+    class Runner
+    {
+
+    public:
+
+        // param - размер задачи (число слейвов, регистров); 0 - без параметра
+        void add( const char * name, uint32_t param, Body body );
+
+        int run( int argc, char * argv[] );
+
+    private:
+
+        struct Case
+        {
+            const char * name;
+            uint32_t param;
+            Body body;
+        };
+
+        struct Result
+        {
+            uint64_t iterations;
+            uint64_t ops;
+            double nsPerOpMin;
+            double nsPerOpMedian;
+        };
+
+        Result measure( Case & benchCase, Counters & counters );
+
+        void printHeader( void );
+        void print( const Case & benchCase, const Result & result, const Counters & counters );
+
+        std::vector< Case > m_cases;
+
+        const char * m_filter = nullptr;
+        uint32_t m_minTime = 200;
+        uint32_t m_repeats = 5;
+        bool m_isCsv = false;
+    };
+
+    // не дает компилятору выбросить вычисления, результат которых больше нигде не используется
+    template< typename T >
+    inline void doNotOptimize( const T & value )
+    {
+        asm volatile( "" : : "r,m"( value ) : "memory" );
+    }
+
+    inline void clobberMemory( void )
+    {
+        asm volatile( "" : : : "memory" );
+    }
+
+    // Прячет от компилятора, на что указывает указатель: объект становится доступным извне,
+    // поэтому обращения через указатель не сворачиваются, а виртуальные вызовы не девиртуализуются
+    template< typename T >
+    inline T * hidePointer( T * pointer )
+    {
+        asm volatile( "" : "+r"( pointer ) : : "memory" );
+        return pointer;
+    }
+
+    // замеры из разных файлов
+    void addSessionBenchmarks( Runner & runner );
+    void addTableBenchmarks( Runner & runner );
+    void addRequestBenchmarks( Runner & runner );
+
+} // namespace benchmark
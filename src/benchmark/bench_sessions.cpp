@@ -0,0 +1,261 @@
+#include "bench_runner.h"
+#include "mock_can.h"
+#include "cannabus_master_session.h"
+#include "cannabus_slave_session.h"
+#include "cannabus_slave.h"
+#include "cannabus_slave_scheduler.h"
+#include "cannabus_reg_table.h"
+#include "cannabus_request_creator.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace benchmark
+{
+    namespace
+    {
+        using namespace cannabus;
+
+        using BenchRegTable = CannabusRegTable< 0, 15, 16, 31 >;
+
+        static constexpr uint8_t slave_address = 5;
+        static constexpr uint8_t slaves_max = (uint8_t)IdAddresses::MAX_SLAVE_ADDRESS;
+
+        // модель слейва на стороне мастера, как у синхронизатора
+        class BenchSlave : public RegTableSlave< BenchRegTable >
+        {
+
+        public:
+
+            virtual void synchronize() override
+            {
+            }
+        };
+
+        can::CanMessage makeReadRange( uint8_t slaveAdr, uint8_t regNumBegin, uint8_t regNumEnd )
+        {
+            RequestCreator creator;
+            creator.init( slaveAdr );
+
+            can::CanMessage request;
+            creator.createReadRange( request, regNumBegin, regNumEnd );
+
+            return request;
+        }
+
+        // запрос - ответ через MasterSession с эхо-слейвом прямо в порту: чистая стоимость автомата сессии
+        uint64_t runMasterRequests( uint64_t iterations, bool isAdaptive )
+        {
+            MockCan can;
+            MasterSession session( 100 );
+
+            uint64_t answers = 0;
+
+            session.init( can,
+                          [&answers]( const can::CanMessage & ){ answers++; },
+                          []( const can::CanMessage &, uint32_t ){},
+                          [](){} );
+
+            if( isAdaptive )
+            {
+                session.setAdaptiveTimeout( 5 );
+            }
+
+            can.setTransmitHandler( [&can]( const can::CanMessage & request )
+            {
+                can::CanMessage answer;
+                makeEchoAnswer( request, answer );
+                can.pushRx( answer );
+            } );
+
+            std::vector< can::CanMessage > requests;
+
+            for( uint8_t adr = 1; adr <= slaves_max; adr++ )
+            {
+                requests.push_back( makeReadRange( adr, 0, max_regs_in_range - 1 ) );
+            }
+
+            uint32_t curTime = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                session.sendRequest( requests[ i % requests.size() ] );
+
+                uint64_t answersBefore = answers;
+
+                while( answers == answersBefore )
+                {
+                    session.work( curTime++ );
+                }
+            }
+
+            return answers;
+        }
+
+        // слейв с одним запросом в порту на каждый вызов work(): стоимость приема, обработки и ответа
+        uint64_t runSlaveRequests( uint64_t iterations, const can::CanMessage & request )
+        {
+            MockCan can;
+            BenchRegTable table;
+            SlaveSession session;
+
+            session.init( can, slave_address, table );
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                can.pushRx( request );
+                session.work( (uint32_t)i );
+            }
+
+            doNotOptimize( can.getTxCount() );
+
+            return iterations;
+        }
+
+        // Худший прием у слейва, когда ящики заняты: в каждом вызове приходят запрос и пара бродкастов,
+        // а передача проходит только в одном вызове из tx_free_period.
+        // Задержка - длительность вызова work(), который разгреб порт; хвост в драйвере должен быть нулевым
+        uint64_t runSlaveRxLatency( uint64_t iterations, Counters & counters )
+        {
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr uint64_t tx_free_period = 8;
+
+            MockCan can;
+            BenchRegTable table;
+            SlaveSession session;
+
+            session.init( can, slave_address, table );
+
+            can::CanMessage request = makeReadRange( slave_address, 0, max_regs_in_range - 1 );
+
+            RequestCreator broadcastCreator;
+            broadcastCreator.init( (uint8_t)IdAddresses::BROADCAST );
+
+            uint8_t value = 0x55;
+            can::CanMessage broadcast;
+            broadcastCreator.createWriteRange( broadcast, 16, 16, umba::ArrayView<const uint8_t>( &value, 1 ) );
+
+            double latencyMax = 0;
+            uint32_t backlogMax = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                can.setTxReady( i % tx_free_period == 0 );
+
+                can.pushRx( request );
+                can.pushRx( broadcast );
+                can.pushRx( broadcast );
+
+                auto start = Clock::now();
+                session.work( (uint32_t)i );
+                auto finish = Clock::now();
+
+                latencyMax = std::max( latencyMax, std::chrono::duration< double, std::nano >( finish - start ).count() );
+                backlogMax = std::max( backlogMax, can.getRxSize() );
+            }
+
+            counters.set( "rx_latency_max_ns", latencyMax );
+            counters.set( "rx_backlog_max", backlogMax );
+            counters.set( "answers_dropped", session.getAnswerOverflowCount() );
+
+            return iterations;
+        }
+
+        // Обход моделей слейвов планировщиком SlaveScheduler: на каждом тике планировщик выдает
+        // следующий запрос, а ответ сразу возвращается слейву-адресату.
+        // Оператор раз в тик меняет одну rw-уставку у очередного слейва
+        uint64_t runScheduler( uint64_t iterations, uint32_t slavesNum, Counters & counters )
+        {
+            static constexpr uint32_t ro_interval = 100;
+
+            std::vector< std::unique_ptr< BenchSlave > > slaves;
+            SlaveScheduler< slaves_max > scheduler;
+
+            for( uint32_t i = 0; i < slavesNum; i++ )
+            {
+                slaves.emplace_back( new BenchSlave );
+                slaves.back()->init( i + 1, ro_interval );
+
+                scheduler.addSlave( *slaves.back() );
+            }
+
+            uint64_t requests = 0;
+
+            for( uint64_t tick = 0; tick < iterations; tick++ )
+            {
+                uint32_t curTime = (uint32_t)tick;
+
+                slaves[ tick % slavesNum ]->getTable().setRegVal( 16 + tick % 16, (uint8_t)tick );
+
+                can::CanMessage request;
+
+                if( scheduler.tryGetRequest( request, curTime ) )
+                {
+                    can::CanMessage answer;
+                    makeEchoAnswer( request, answer );
+
+                    slaves[ getAddressFromId( request.id ) - 1 ]->processAnswer( answer );
+                    scheduler.onAnswerReceived();
+
+                    requests++;
+                }
+            }
+
+            counters.set( "requests_per_tick", (double)requests / iterations );
+
+            return iterations;
+        }
+    }
+
+    void addSessionBenchmarks( Runner & runner )
+    {
+        runner.add( "master_session/request_answer", 0, []( uint64_t iterations, Counters & )
+        {
+            return runMasterRequests( iterations, false );
+        } );
+
+        runner.add( "master_session/request_answer_adaptive", 0, []( uint64_t iterations, Counters & )
+        {
+            return runMasterRequests( iterations, true );
+        } );
+
+        runner.add( "slave_session/read_range", max_regs_in_range, []( uint64_t iterations, Counters & )
+        {
+            return runSlaveRequests( iterations, makeReadRange( slave_address, 0, max_regs_in_range - 1 ) );
+        } );
+
+        runner.add( "slave_session/write_series", max_regs_in_series, []( uint64_t iterations, Counters & )
+        {
+            RequestCreator creator;
+            creator.init( slave_address );
+
+            RequestCreator::Register series[ max_regs_in_series ];
+
+            for( uint8_t i = 0; i < max_regs_in_series; i++ )
+            {
+                series[i].num = 16 + 2 * i;
+                series[i].val = i;
+            }
+
+            can::CanMessage request;
+            creator.createWriteSeries( request, umba::ArrayView<const RequestCreator::Register>( series, max_regs_in_series ) );
+
+            return runSlaveRequests( iterations, request );
+        } );
+
+        runner.add( "slave_session/rx_latency_blocked_tx", 0, []( uint64_t iterations, Counters & counters )
+        {
+            return runSlaveRxLatency( iterations, counters );
+        } );
+
+        for( uint32_t slavesNum : { 1u, 10u, 30u, 60u } )
+        {
+            runner.add( "scheduler/drr_tick", slavesNum, [slavesNum]( uint64_t iterations, Counters & counters )
+            {
+                return runScheduler( iterations, slavesNum, counters );
+            } );
+        }
+    }
+
+} // namespace benchmark
@@ -0,0 +1,182 @@
+#include "bench_runner.h"
+#include "mock_can.h"
+#include "cannabus_slave.h"
+#include "cannabus_reg_table.h"
+#include "cannabus_host_reg_table.h"
+#include "cannabus_typed_reg_table.h"
+
+namespace benchmark
+{
+    namespace
+    {
+        using namespace cannabus;
+
+        // таблица на все 255 rw-регистров - худший случай для линейного поиска изменённых
+        using WideRegTable = CannabusRegTable< 0, 0, 1, 255 >;
+
+        static constexpr uint8_t rw_regs_num = 255;
+
+        class WideSlave : public Slave
+        {
+
+        public:
+
+            explicit WideSlave( bool isBitmapUsed ) :
+                m_isBitmapUsed( isBitmapUsed )
+            {
+            }
+
+            virtual void synchronize() override
+            {
+            }
+
+            virtual ICannabusRegTable * getSlaveTable() override
+            {
+                return &table;
+            }
+
+            // без карты Slave ищет изменённые регистры перебором всей таблицы
+            virtual DirtyRegs * getDirtyRegs() override
+            {
+                return m_isBitmapUsed ? &table.getDirtyRegs() : nullptr;
+            }
+
+            WideRegTable table;
+
+        private:
+
+            bool m_isBitmapUsed;
+        };
+
+        // За итерацию меняются changedNum rw-регистров, разбросанных по таблице,
+        // затем собираются все запросы на запись. Операция - один собранный запрос
+        uint64_t runDirtyRegs( uint64_t iterations, uint32_t changedNum, bool isBitmapUsed )
+        {
+            static constexpr uint32_t ro_interval = 0xFFFFFFF;
+
+            WideSlave slave( isBitmapUsed );
+            slave.init( 1, ro_interval );
+
+            uint32_t step = rw_regs_num / changedNum;
+            uint64_t requests = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                for( uint32_t k = 0; k < changedNum; k++ )
+                {
+                    slave.table.setRegVal( 1 + k * step, (uint8_t)( i + 1 ) );
+                }
+
+                can::CanMessage request;
+
+                while( slave.tryGetRequest( request, 1 ) )
+                {
+                    can::CanMessage answer;
+                    makeEchoAnswer( request, answer );
+
+                    slave.processAnswer( answer );
+                    requests++;
+                }
+            }
+
+            return requests;
+        }
+
+        static constexpr uint32_t table_regs_num = 16;
+
+        // запись и чтение 16 регистров через интерфейс таблицы, операция - одно обращение.
+        // Таблица - локальная переменная вызывающего, поэтому без hidePointer компилятор
+        // встраивает вызовы и сворачивает весь цикл
+        uint64_t runTableAccess( ICannabusRegTable & localTable, uint64_t iterations )
+        {
+            ICannabusRegTable & table = *hidePointer( &localTable );
+            uint32_t sum = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                for( uint8_t reg = 0; reg < table_regs_num; reg++ )
+                {
+                    table.setRegVal( 16 + reg, (uint8_t)( i + reg ) );
+                }
+
+                for( uint8_t reg = 0; reg < table_regs_num; reg++ )
+                {
+                    sum += table.getRegVal( 16 + reg );
+                }
+
+                clobberMemory();
+            }
+
+            doNotOptimize( sum );
+
+            return iterations * table_regs_num * 2;
+        }
+
+        using Setpoint = RwReg< 16, uint16_t >;
+        using Limit = RwReg< 18, uint32_t >;
+        using Mode = RwReg< 22, uint8_t >;
+
+        using BenchTypedTable = TypedRegTable< 0, 15, 16, 31, Setpoint, Limit, Mode >;
+    }
+
+    void addTableBenchmarks( Runner & runner )
+    {
+        for( uint32_t changedNum : { 4u, 32u, 255u } )
+        {
+            runner.add( "dirty_regs/bitmap", changedNum, [changedNum]( uint64_t iterations, Counters & )
+            {
+                return runDirtyRegs( iterations, changedNum, true );
+            } );
+
+            runner.add( "dirty_regs/linear_scan", changedNum, [changedNum]( uint64_t iterations, Counters & )
+            {
+                return runDirtyRegs( iterations, changedNum, false );
+            } );
+        }
+
+        runner.add( "reg_table/cannabus", table_regs_num, []( uint64_t iterations, Counters & )
+        {
+            CannabusRegTable< 0, 15, 16, 31 > table;
+
+            return runTableAccess( table, iterations );
+        } );
+
+        runner.add( "reg_table/host", table_regs_num, []( uint64_t iterations, Counters & )
+        {
+            CannabusHostRegTable< 0, 15, 16, 31 > table;
+
+            return runTableAccess( table, iterations );
+        } );
+
+        runner.add( "reg_table/typed_adapter", table_regs_num, []( uint64_t iterations, Counters & )
+        {
+            BenchTypedTable table;
+
+            return runTableAccess( table, iterations );
+        } );
+
+        // те же три регистра через типизированный доступ: запись и чтение каждого
+        runner.add( "reg_table/typed", 3, []( uint64_t iterations, Counters & )
+        {
+            BenchTypedTable localTable;
+            BenchTypedTable & table = *hidePointer( &localTable );
+            uint32_t sum = 0;
+
+            for( uint64_t i = 0; i < iterations; i++ )
+            {
+                table.set< Setpoint >( (uint16_t)i );
+                table.set< Limit >( (uint32_t)i );
+                table.set< Mode >( (uint8_t)i );
+
+                sum += table.get< Setpoint >() + table.get< Limit >() + table.get< Mode >();
+
+                clobberMemory();
+            }
+
+            doNotOptimize( sum );
+
+            return iterations * 3 * 2;
+        } );
+    }
+
+} // namespace benchmark
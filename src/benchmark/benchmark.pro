@@ -0,0 +1,34 @@
+# Замеры производительности cannabus_library на хосте, консольное приложение без Qt.
+# Внешние библиотеки (umba, can, callbacks, reg_tables) ищутся в LIBS_ROOT:
+#   qmake benchmark.pro LIBS_ROOT=/path/to/libs
+# Результаты сравнимы только в релизной сборке.
+
+TEMPLATE = app
+TARGET = cannabus_benchmark
+
+CONFIG += console c++14 release
+CONFIG -= qt app_bundle debug
+
+isEmpty(LIBS_ROOT): LIBS_ROOT = $$PWD/../../../libs
+
+INCLUDEPATH += \
+    $$PWD \
+    $$PWD/../cannabus_library \
+    $$LIBS_ROOT
+
+SOURCES += \
+    bench_requests.cpp \
+    bench_runner.cpp \
+    bench_sessions.cpp \
+    bench_tables.cpp \
+    main.cpp \
+    ../cannabus_library/cannabus_block_transfer.cpp \
+    ../cannabus_library/cannabus_master_session.cpp \
+    ../cannabus_library/cannabus_request_creator.cpp \
+    ../cannabus_library/cannabus_slave.cpp \
+    ../cannabus_library/cannabus_slave_session.cpp
+
+HEADERS += \
+    bench_runner.h \
+    mock_can.h \
+    project_config.h
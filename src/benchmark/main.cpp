@@ -0,0 +1,27 @@
+/****************************************************************************
+
+Замеры производительности cannabus_library на хосте.
+
+Сессии работают через порт-заглушку, поэтому меряется сама библиотека:
+автоматы MasterSession и SlaveSession, сборка запросов, таблицы регистров и
+обход слейвов планировщиком. Результаты печатаются по строке на замер
+(JSON или CSV), чтобы сравнивать релизы скриптом.
+
+Использование:
+    cannabus_benchmark [--filter подстрока] [--min-time мс] [--repeats N]
+                       [--format json|csv] > results.jsonl
+
+****************************************************************************/
+
+#include "bench_runner.h"
+
+int main( int argc, char * argv[] )
+{
+    benchmark::Runner runner;
+
+    benchmark::addSessionBenchmarks( runner );
+    benchmark::addTableBenchmarks( runner );
+    benchmark::addRequestBenchmarks( runner );
+
+    return runner.run( argc, argv );
+}
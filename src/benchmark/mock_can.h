@@ -0,0 +1,192 @@
+#pragma once
+
+#include "can/i_can.h"
+#include "callbacks/callbacks.h"
+#include "cannabus_common.h"
+#include <stdint.h>
+
+namespace benchmark
+{
+    // Порт без железа для замеров: приемное кольцо фиксированного размера и передача,
+    // которая либо просто считает кадры, либо сразу отдает их обработчику (например, эхо-слейву).
+    // Никаких выделений памяти и виртуальных вызовов сверх самого ICan, чтобы мерить сессии, а не порт
+    class MockCan : public can::ICan
+    {
+
+    public:
+
+        using OnTransmit = callback::Callback<void ( const can::CanMessage & msg )>;
+
+        void setTransmitHandler( OnTransmit onTransmit )
+        {
+            m_onTransmit = onTransmit;
+        }
+
+        // занятые ящики: передача не проходит, как при загруженной шине
+        void setTxReady( bool isReady )
+        {
+            m_isTxReady = isReady;
+        }
+
+        bool pushRx( const can::CanMessage & msg )
+        {
+            if( m_rxSize == rx_size )
+            {
+                return false;
+            }
+
+            m_rx[ ( m_rxHead + m_rxSize ) % rx_size ] = msg;
+            m_rxSize++;
+
+            return true;
+        }
+
+        uint32_t getRxSize( void ) const
+        {
+            return m_rxSize;
+        }
+
+        uint64_t getTxCount( void ) const
+        {
+            return m_txCount;
+        }
+
+        const can::CanMessage & getLastTx( void ) const
+        {
+            return m_lastTx;
+        }
+
+        // can::ICan
+        virtual void lock( void ) override
+        {
+        }
+
+        virtual bool isLocked( void ) override
+        {
+            return false;
+        }
+
+        virtual bool isInited( void ) override
+        {
+            return true;
+        }
+
+        virtual bool tryToReceive( can::CanMessage & msg ) override
+        {
+            if( m_rxSize == 0 )
+            {
+                return false;
+            }
+
+            msg = m_rx[ m_rxHead ];
+            m_rxHead = ( m_rxHead + 1 ) % rx_size;
+            m_rxSize--;
+
+            return true;
+        }
+
+        virtual can::ReturnState transmitMessage( const can::CanMessage & msg ) override
+        {
+            if( ! m_isTxReady )
+            {
+                return can::ReturnState::ERROR;
+            }
+
+            m_txCount++;
+            m_lastTx = msg;
+
+            if( m_onTransmit )
+            {
+                m_onTransmit( msg );
+            }
+
+            return can::ReturnState::OK;
+        }
+
+        virtual bool isReadyToTransmit( void ) override
+        {
+            return m_isTxReady;
+        }
+
+        virtual uint32_t getFilterCapacity( void ) override
+        {
+            return 14;
+        }
+
+        virtual void addFilter( const can::CanFilter & filter, uint32_t filterNum ) override
+        {
+            (void)filter;
+            (void)filterNum;
+        }
+
+    private:
+
+        static constexpr uint32_t rx_size = 64;
+
+        can::CanMessage m_rx[ rx_size ] = {};
+        uint32_t m_rxHead = 0;
+        uint32_t m_rxSize = 0;
+
+        bool m_isTxReady = true;
+        uint64_t m_txCount = 0;
+        can::CanMessage m_lastTx = {};
+
+        OnTransmit m_onTransmit = {};
+    };
+
+    // Ответ слейва на запрос мастера в том виде, в каком его собирает SlaveSession;
+    // значения регистров - нули. Для замеров мастера без настоящего слейва
+    inline void makeEchoAnswer( const can::CanMessage & request, can::CanMessage & answer )
+    {
+        using namespace cannabus;
+
+        IdFCode fcode = getFCodeFromId( request.id );
+
+        answer = request;
+        answer.id = makeId( getAddressFromId( request.id ), fcode, IdMsgTypes::SLAVE );
+
+        switch( fcode )
+        {
+        case IdFCode::WRITE_REGS_RANGE:
+
+            answer.length = 2;
+            break;
+
+        case IdFCode::WRITE_REGS_SERIES:
+
+            for( uint8_t i = 0; i < request.length / 2; i++ )
+            {
+                answer.data[i] = request.data[ 2 * i ];
+            }
+
+            answer.length = request.length / 2;
+            break;
+
+        case IdFCode::READ_REGS_RANGE:
+
+            for( uint8_t i = 2; i < 2 + request.data[1] - request.data[0] + 1; i++ )
+            {
+                answer.data[i] = 0;
+            }
+
+            answer.length = 2 + request.data[1] - request.data[0] + 1;
+            break;
+
+        case IdFCode::READ_REGS_SERIES:
+
+            for( uint8_t i = request.length; i > 0; i-- )
+            {
+                answer.data[ 2 * ( i - 1 ) ] = request.data[ i - 1 ];
+                answer.data[ 2 * ( i - 1 ) + 1 ] = 0;
+            }
+
+            answer.length = 2 * request.length;
+            break;
+
+        default:
+
+            break;
+        }
+    }
+
+} // namespace benchmark
@@ -0,0 +1,5 @@
+#pragma once
+
+// Конфигурация библиотек для сборки на хосте: без ОС и без железа,
+// ассерты и STRONG_ENUM - из umba, как и в прошивках
+#include "umba/umba.h"
@@ -0,0 +1,582 @@
+#include "cannabus_block_transfer.h"
+#include "cannabus_slave_session.h"
+#include <algorithm>
+
+namespace cannabus
+{
+    namespace
+    {
+        const uint8_t frame_type_offset = 6;
+        const uint8_t frame_seq_mask = 0x3F;
+
+        uint8_t makeHeader( BlockFrameType type, uint8_t seq )
+        {
+            return (uint8_t)( ( (uint32_t)type << frame_type_offset ) | ( seq & frame_seq_mask ) );
+        }
+
+        BlockFrameType getFrameType( uint8_t header )
+        {
+            return (BlockFrameType)( header >> frame_type_offset );
+        }
+
+        uint8_t getFrameSeq( uint8_t header )
+        {
+            return header & frame_seq_mask;
+        }
+
+        uint32_t getFullBitmap( uint8_t framesNum )
+        {
+            return framesNum >= 32 ? UINT32_MAX : ( ( 1u << framesNum ) - 1 );
+        }
+    }
+
+    uint16_t calcBlockCrc( const uint8_t * data, uint32_t length )
+    {
+        uint16_t crc = 0xFFFF;
+
+        for( uint32_t i = 0; i < length; i++ )
+        {
+            crc ^= (uint16_t)data[i] << 8;
+
+            for( uint8_t bit = 0; bit < 8; bit++ )
+            {
+                crc = ( crc & 0x8000 ) ? (uint16_t)( ( crc << 1 ) ^ 0x1021 ) : (uint16_t)( crc << 1 );
+            }
+        }
+
+        return crc;
+    }
+
+    // ------------------------------------------------------------------------------------------------
+    // Сторона мастера
+    // ------------------------------------------------------------------------------------------------
+
+    void BlockSender::init( MasterSession & session, uint8_t slaveAdr, IdFCode fcode )
+    {
+        UMBA_ASSERT( slaveAdr >= (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS );
+        UMBA_ASSERT( slaveAdr <= (uint32_t)IdAddresses::MAX_SLAVE_ADDRESS );
+        UMBA_ASSERT( (uint32_t)fcode >= (uint32_t)IdFCode::DEVICE_SPECIFIC1 );
+        UMBA_ASSERT( (uint32_t)fcode <= (uint32_t)IdFCode::DEVICE_SPECIFIC4 );
+
+        m_session = &session;
+        m_slaveAdr = slaveAdr;
+        m_fcode = fcode;
+    }
+
+    /**************************************************************************************************
+    Описание:  Запуск передачи
+    Аргументы: Данные, число кадров в окне, колбэк завершения, время
+    Возврат:   Запущена передача или нет
+    Замечания: Чем больше окно, тем реже опросы, но тем больше данных придется повторить
+               при ошибке CRC блока
+    **************************************************************************************************/
+    bool BlockSender::tryStart( umba::ArrayView<const uint8_t> data, //-V813
+                                uint8_t windowFrames,
+                                OnComplete onComplete,
+                                uint32_t curTime )
+    {
+        UMBA_ASSERT( m_session );
+        UMBA_ASSERT( windowFrames != 0 && windowFrames <= block_frames_max );
+        UMBA_ASSERT( data.size() != 0 );
+
+        if( isActive() )
+        {
+            return false;
+        }
+
+        m_data = data;
+        m_windowFrames = windowFrames;
+        m_onComplete = onComplete;
+
+        m_blockNum = 0;
+        m_framesToSend = 0;
+        m_pollRetries = 0;
+
+        m_startTime = curTime;
+        m_curTime = curTime;
+        m_finishTime = curTime;
+
+        m_bytesAcked = 0;
+        m_retransmittedFrames = 0;
+
+        m_isRequestSent = false;
+        m_state = States::STARTING;
+
+        return true;
+    }
+
+    void BlockSender::work( uint32_t curTime )
+    {
+        m_curTime = curTime;
+
+        switch( m_state )
+        {
+            case States::IDLE:
+                break;
+
+            case States::STARTING:
+            {
+                if( m_isRequestSent )
+                {
+                    break;
+                }
+
+                uint32_t size = m_data.size();
+
+                makeFrame( m_frame, BlockFrameType::START, 0, 6 );
+                m_frame.data[1] = (uint8_t)size;
+                m_frame.data[2] = (uint8_t)( size >> 8 );
+                m_frame.data[3] = (uint8_t)( size >> 16 );
+                m_frame.data[4] = (uint8_t)( size >> 24 );
+                m_frame.data[5] = m_windowFrames;
+
+                m_isRequestSent = m_session->tryToSendOwnRequest( m_frame,
+                                                                  [this]( const can::CanMessage & answer ){ onStartAnswer( answer ); },
+                                                                  [this](){ onFailure(); } );
+                break;
+            }
+
+            case States::SENDING:
+
+                // кадры данных сыплются в очередь сессии, пока она их принимает
+                while( m_framesToSend != 0 )
+                {
+                    if( ! trySendData() )
+                    {
+                        break;
+                    }
+                }
+
+                if( m_framesToSend != 0 )
+                {
+                    break;
+                }
+
+                m_state = States::POLLING;
+
+                // опрос уйдет за данными - сессия сначала опустошает очередь запросов без ответа
+                m_isRequestSent = trySendPoll();
+                break;
+
+            case States::POLLING:
+
+                if( ! m_isRequestSent )
+                {
+                    m_isRequestSent = trySendPoll();
+                }
+                break;
+
+            case States::FINISHING:
+
+                if( m_isRequestSent )
+                {
+                    break;
+                }
+
+                makeFrame( m_frame, BlockFrameType::FINISH, 0, 1 );
+
+                m_isRequestSent = m_session->tryToSendOwnRequest( m_frame,
+                                                                  [this]( const can::CanMessage & answer ){ onFinishAnswer( answer ); },
+                                                                  [this](){ onFailure(); } );
+                break;
+
+            default:
+PRAGMA_SUPPRESS_STATEMENT_UNREACHABLE_BEGIN
+                UMBA_ASSERT_FAIL();
+                break;
+PRAGMA_END
+        }
+    }
+
+    uint32_t BlockSender::getBytesPerSecond( void ) const
+    {
+        uint32_t finishTime = isActive() ? m_curTime : m_finishTime;
+        uint32_t elapsed = finishTime - m_startTime;
+
+        if( elapsed == 0 )
+        {
+            return 0;
+        }
+
+        return (uint32_t)( (uint64_t)m_bytesAcked * 1000 / elapsed );
+    }
+
+    uint32_t BlockSender::getBlockLength( void ) const
+    {
+        return std::min<uint32_t>( m_windowFrames * block_frame_payload, m_data.size() - getBlockOffset() );
+    }
+
+    uint8_t BlockSender::getBlockFramesNum( void ) const
+    {
+        return (uint8_t)( ( getBlockLength() + block_frame_payload - 1 ) / block_frame_payload );
+    }
+
+    void BlockSender::makeFrame( can::CanMessage & frame, BlockFrameType type, uint8_t seq, uint8_t length )
+    {
+        frame.id = makeId( m_slaveAdr, m_fcode, IdMsgTypes::MASTER );
+        frame.frameFormat = can::FrameFormat::STANDART;
+        frame.type = can::MsgType::DATA;
+        frame.length = length;
+        frame.data[0] = makeHeader( type, seq );
+    }
+
+    bool BlockSender::trySendData( void )
+    {
+        uint8_t seq = 0;
+
+        while( ( m_framesToSend & ( 1u << seq ) ) == 0 )
+        {
+            seq++;
+        }
+
+        uint32_t offset = seq * block_frame_payload;
+        uint8_t length = (uint8_t)std::min<uint32_t>( block_frame_payload, getBlockLength() - offset );
+
+        makeFrame( m_frame, BlockFrameType::DATA, seq, length + 1 );
+
+        std::copy( m_data.data() + getBlockOffset() + offset,
+                   m_data.data() + getBlockOffset() + offset + length,
+                   m_frame.data + 1 );
+
+        if( ! m_session->tryToSendWithoutAnswer( m_frame ) )
+        {
+            return false;
+        }
+
+        m_framesToSend &= ~( 1u << seq );
+
+        return true;
+    }
+
+    bool BlockSender::trySendPoll( void )
+    {
+        uint16_t crc = calcBlockCrc( m_data.data() + getBlockOffset(), getBlockLength() );
+
+        makeFrame( m_frame, BlockFrameType::POLL, 0, 4 );
+        m_frame.data[1] = (uint8_t)m_blockNum;
+        m_frame.data[2] = (uint8_t)crc;
+        m_frame.data[3] = (uint8_t)( crc >> 8 );
+
+        return m_session->tryToSendOwnRequest( m_frame,
+                                               [this]( const can::CanMessage & answer ){ onPollAnswer( answer ); },
+                                               [this](){ onFailure(); } );
+    }
+
+    void BlockSender::onStartAnswer( const can::CanMessage & answer )
+    {
+        m_isRequestSent = false;
+
+        if( answer.length < 2 || getFrameType( answer.data[0] ) != BlockFrameType::START ||
+            answer.data[1] != (uint8_t)BlockStatus::OK )
+        {
+            finish( false );
+            return;
+        }
+
+        m_framesToSend = getFullBitmap( getBlockFramesNum() );
+        m_state = States::SENDING;
+    }
+
+    /**************************************************************************************************
+    Описание:  Разбор ответа на опрос
+    Аргументы: Ответ слейва
+    Возврат:   Нет
+    Замечания: Повторяются только кадры, которых нет в битовой карте слейва;
+               при ошибке CRC слейв сбрасывает карту, и блок уходит заново целиком
+    **************************************************************************************************/
+    void BlockSender::onPollAnswer( const can::CanMessage & answer )
+    {
+        m_isRequestSent = false;
+
+        if( answer.length < 7 || getFrameType( answer.data[0] ) != BlockFrameType::POLL ||
+            answer.data[1] != (uint8_t)m_blockNum )
+        {
+            finish( false );
+            return;
+        }
+
+        m_pollRetries = 0;
+
+        uint32_t bitmap = (uint32_t)answer.data[2] |
+                          (uint32_t)answer.data[3] << 8 |
+                          (uint32_t)answer.data[4] << 16 |
+                          (uint32_t)answer.data[5] << 24;
+
+        uint32_t fullBitmap = getFullBitmap( getBlockFramesNum() );
+
+        switch( (BlockStatus)answer.data[6] )
+        {
+            case BlockStatus::OK:
+
+                m_bytesAcked += getBlockLength();
+                m_blockNum++;
+
+                if( getBlockOffset() >= m_data.size() )
+                {
+                    m_state = States::FINISHING;
+                    return;
+                }
+
+                m_framesToSend = getFullBitmap( getBlockFramesNum() );
+                m_state = States::SENDING;
+                return;
+
+            case BlockStatus::INCOMPLETE:
+            case BlockStatus::CRC_ERROR:
+
+                m_framesToSend = ~bitmap & fullBitmap;
+                break;
+
+            default:
+                finish( false );
+                return;
+        }
+
+        for( uint32_t frames = m_framesToSend; frames != 0; frames &= frames - 1 )
+        {
+            m_retransmittedFrames++;
+        }
+
+        m_state = States::SENDING;
+    }
+
+    void BlockSender::onFinishAnswer( const can::CanMessage & answer )
+    {
+        m_isRequestSent = false;
+
+        bool isOk = answer.length >= 2 &&
+                    getFrameType( answer.data[0] ) == BlockFrameType::FINISH &&
+                    answer.data[1] == (uint8_t)BlockStatus::OK;
+
+        finish( isOk );
+    }
+
+    // сессия исчерпала повторы; опрос можно повторить - слейв отвечает на него идемпотентно
+    void BlockSender::onFailure( void )
+    {
+        m_isRequestSent = false;
+
+        if( m_state == States::POLLING && m_pollRetries < poll_retries_max )
+        {
+            m_pollRetries++;
+            return;
+        }
+
+        finish( false );
+    }
+
+    void BlockSender::finish( bool isOk )
+    {
+        m_state = States::IDLE;
+        m_finishTime = m_curTime;
+
+        if( m_onComplete )
+        {
+            m_onComplete( isOk );
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------------
+    // Сторона слейва
+    // ------------------------------------------------------------------------------------------------
+
+    void BlockReceiver::init( OnStart onStart, OnBlock onBlock, OnComplete onComplete )
+    {
+        // без приемника блоков данные уходить некуда; остальные колбэки необязательны
+        UMBA_ASSERT( onBlock );
+
+        m_onStart = onStart;
+        m_onBlock = onBlock;
+        m_onComplete = onComplete;
+    }
+
+    /**************************************************************************************************
+    Описание:  Обработчик device-specific функции потоковой передачи
+    Аргументы: Запрос и место под ответ
+    Возврат:   Длина ответа или SlaveSession::device_specific_no_answer для кадров данных
+    Замечания: -
+    **************************************************************************************************/
+    uint8_t BlockReceiver::handle( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer ) //-V813
+    {
+        if( request.size() == 0 )
+        {
+            return 0;
+        }
+
+        switch( getFrameType( request[0] ) )
+        {
+            case BlockFrameType::START:
+                return handleStart( request, answer );
+            case BlockFrameType::DATA:
+                return handleData( request );
+            case BlockFrameType::POLL:
+                return handlePoll( request, answer );
+            case BlockFrameType::FINISH:
+                return handleFinish( answer );
+            default:
+                return 0;
+        }
+    }
+
+    uint8_t BlockReceiver::handleStart( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer ) //-V813
+    {
+        answer[0] = makeHeader( BlockFrameType::START, 0 );
+        answer[1] = (uint8_t)BlockStatus::REJECTED;
+
+        if( request.size() < 6 )
+        {
+            return 2;
+        }
+
+        uint32_t size = (uint32_t)request[1] |
+                        (uint32_t)request[2] << 8 |
+                        (uint32_t)request[3] << 16 |
+                        (uint32_t)request[4] << 24;
+
+        uint8_t windowFrames = request[5];
+
+        if( size == 0 || windowFrames == 0 || windowFrames > block_frames_max )
+        {
+            return 2;
+        }
+
+        if( m_onStart && ! m_onStart( size ) )
+        {
+            return 2;
+        }
+
+        // новый START обрывает незаконченную передачу
+        m_isActive = true;
+        m_size = size;
+        m_windowFrames = windowFrames;
+        m_blockNum = 0;
+        m_bitmap = 0;
+        m_bytesReceived = 0;
+
+        answer[1] = (uint8_t)BlockStatus::OK;
+
+        return 2;
+    }
+
+    uint8_t BlockReceiver::handleData( umba::ArrayView<uint8_t> request ) //-V813
+    {
+        if( ! m_isActive )
+        {
+            return SlaveSession::device_specific_no_answer;
+        }
+
+        uint8_t seq = getFrameSeq( request[0] );
+
+        if( seq >= getBlockFramesNum() )
+        {
+            return SlaveSession::device_specific_no_answer;
+        }
+
+        uint32_t offset = seq * block_frame_payload;
+        uint32_t length = std::min<uint32_t>( block_frame_payload, getBlockLength() - offset );
+
+        // кадр не той длины - считаем потерянным, мастер его повторит
+        if( request.size() != length + 1 )
+        {
+            return SlaveSession::device_specific_no_answer;
+        }
+
+        std::copy( request.data() + 1, request.data() + 1 + length, m_block.data() + offset );
+
+        m_bitmap |= 1u << seq;
+
+        return SlaveSession::device_specific_no_answer;
+    }
+
+    uint8_t BlockReceiver::handlePoll( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer ) //-V813
+    {
+        if( ! m_isActive || request.size() < 4 )
+        {
+            return makePollAnswer( answer, 0, 0, BlockStatus::WRONG_BLOCK );
+        }
+
+        uint8_t blockNum = request[1];
+        uint16_t crc = (uint16_t)( request[2] | request[3] << 8 );
+
+        // ответ на прошлый опрос потерялся, а блок уже принят - подтверждаем еще раз
+        if( m_blockNum != 0 && blockNum == (uint8_t)( m_blockNum - 1 ) )
+        {
+            return makePollAnswer( answer, blockNum, UINT32_MAX, BlockStatus::OK );
+        }
+
+        if( blockNum != (uint8_t)m_blockNum )
+        {
+            return makePollAnswer( answer, blockNum, m_bitmap, BlockStatus::WRONG_BLOCK );
+        }
+
+        if( m_bitmap != getFullBitmap( getBlockFramesNum() ) )
+        {
+            return makePollAnswer( answer, blockNum, m_bitmap, BlockStatus::INCOMPLETE );
+        }
+
+        if( calcBlockCrc( m_block.data(), getBlockLength() ) != crc )
+        {
+            m_bitmap = 0;
+
+            return makePollAnswer( answer, blockNum, 0, BlockStatus::CRC_ERROR );
+        }
+
+        uint32_t offset = m_blockNum * m_windowFrames * block_frame_payload;
+        uint32_t length = getBlockLength();
+
+        m_onBlock( offset, umba::ArrayView<const uint8_t>( m_block.data(), length ) );
+
+        m_bytesReceived += length;
+        m_blockNum++;
+        m_bitmap = 0;
+
+        return makePollAnswer( answer, blockNum, UINT32_MAX, BlockStatus::OK );
+    }
+
+    uint8_t BlockReceiver::handleFinish( umba::ArrayView<uint8_t> answer ) //-V813
+    {
+        // повторный FINISH после потерянного ответа получает тот же результат
+        bool isOk = m_size != 0 && m_bytesReceived == m_size;
+
+        answer[0] = makeHeader( BlockFrameType::FINISH, 0 );
+        answer[1] = (uint8_t)( isOk ? BlockStatus::OK : BlockStatus::INCOMPLETE );
+
+        if( m_isActive )
+        {
+            m_isActive = false;
+
+            if( m_onComplete )
+            {
+                m_onComplete( isOk );
+            }
+        }
+
+        return 2;
+    }
+
+    uint8_t BlockReceiver::makePollAnswer( umba::ArrayView<uint8_t> answer, uint8_t blockNum, uint32_t bitmap, BlockStatus status ) //-V813
+    {
+        answer[0] = makeHeader( BlockFrameType::POLL, 0 );
+        answer[1] = blockNum;
+        answer[2] = (uint8_t)bitmap;
+        answer[3] = (uint8_t)( bitmap >> 8 );
+        answer[4] = (uint8_t)( bitmap >> 16 );
+        answer[5] = (uint8_t)( bitmap >> 24 );
+        answer[6] = (uint8_t)status;
+
+        return 7;
+    }
+
+    uint32_t BlockReceiver::getBlockLength( void ) const
+    {
+        uint32_t offset = m_blockNum * m_windowFrames * block_frame_payload;
+
+        return std::min<uint32_t>( m_windowFrames * block_frame_payload, m_size - offset );
+    }
+
+    uint8_t BlockReceiver::getBlockFramesNum( void ) const
+    {
+        return (uint8_t)( ( getBlockLength() + block_frame_payload - 1 ) / block_frame_payload );
+    }
+
+} // namespace cannabus
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "project_config.h"
+#include "cannabus_common.h"
+#include "cannabus_master_session.h"
+#include "can/i_can.h"
+#include "callbacks/callbacks.h"
+#include "umba_array/umba_array.h"
+
+namespace cannabus
+{
+    // Потоковая передача больших блоков данных (прошивки, калибровки) через одну device-specific функцию.
+    //
+    // Данные режутся на блоки по окну из нескольких кадров. Кадры данных уходят подряд без ответов,
+    // затем мастер опрашивает слейва, и тот отвечает битовой картой принятых кадров.
+    // Повторяются только потерянные кадры; блок целиком - только если не сошлась его CRC.
+    //
+    // Первый байт каждого кадра: тип кадра в битах 6-7, номер кадра в блоке в битах 0-5.
+    //
+    //  START  (запрос):  | тип | Size0 | Size1 | Size2 | Size3 | WindowFrames |
+    //         (ответ):   | тип | Status |
+    //  DATA   (запрос):  | тип + номер | Data0 | ... | DataN |                 - без ответа
+    //  POLL   (запрос):  | тип | BlockNum | Crc0 | Crc1 |
+    //         (ответ):   | тип | BlockNum | Bitmap0 | Bitmap1 | Bitmap2 | Bitmap3 | Status |
+    //  FINISH (запрос):  | тип |
+    //         (ответ):   | тип | Status |
+    enum class BlockFrameType{ DATA   = 0,
+                               START  = 1,
+                               POLL   = 2,
+                               FINISH = 3 };
+
+    enum class BlockStatus{ OK          = 0,
+                            INCOMPLETE  = 1,
+                            CRC_ERROR   = 2,
+                            WRONG_BLOCK = 3,
+                            REJECTED    = 4 };
+
+    static constexpr uint8_t block_frames_max = 32;
+    static constexpr uint8_t block_frame_payload = max_regs_in_specific - 1;
+    static constexpr uint32_t block_bytes_max = block_frames_max * block_frame_payload;
+
+    // CRC-16/CCITT-FALSE, без таблицы - блоки короткие
+    uint16_t calcBlockCrc( const uint8_t * data, uint32_t length );
+
+
+    // Сторона мастера
+    class BlockSender
+    {
+
+    public:
+
+        BlockSender() = default;
+
+        // копировать запрещено
+        BlockSender( const BlockSender & rhs ) = delete;
+        BlockSender & operator=( BlockSender & s ) = delete;
+
+        using OnComplete = callback::Callback<void ( bool isOk )>;
+
+        void init( MasterSession & session, uint8_t slaveAdr, IdFCode fcode );
+
+        // данные должны жить до вызова onComplete
+        bool tryStart( umba::ArrayView<const uint8_t> data,
+                       uint8_t windowFrames,
+                       OnComplete onComplete,
+                       uint32_t curTime );
+
+        void work( uint32_t curTime );
+
+        bool isActive( void ) const
+        {
+            return m_state != States::IDLE;
+        }
+
+        uint32_t getBytesAcked( void ) const
+        {
+            return m_bytesAcked;
+        }
+
+        uint32_t getRetransmittedFrames( void ) const
+        {
+            return m_retransmittedFrames;
+        }
+
+        // полезная скорость в байтах в секунду, время в миллисекундах
+        uint32_t getBytesPerSecond( void ) const;
+
+    protected:
+
+        STRONG_ENUM( States, IDLE,
+                             STARTING,
+                             SENDING,
+                             POLLING,
+                             FINISHING );
+
+        // опрос без ответа повторяется столько раз, потом передача обрывается
+        static constexpr uint8_t poll_retries_max = 3;
+
+        uint32_t getBlockOffset( void ) const
+        {
+            return m_blockNum * m_windowFrames * block_frame_payload;
+        }
+
+        uint32_t getBlockLength( void ) const;
+        uint8_t getBlockFramesNum( void ) const;
+
+        void makeFrame( can::CanMessage & frame, BlockFrameType type, uint8_t seq, uint8_t length );
+        bool trySendData( void );
+        bool trySendPoll( void );
+
+        void onStartAnswer( const can::CanMessage & answer );
+        void onPollAnswer( const can::CanMessage & answer );
+        void onFinishAnswer( const can::CanMessage & answer );
+        void onFailure( void );
+
+        void finish( bool isOk );
+
+        MasterSession * m_session = nullptr;
+        uint8_t m_slaveAdr = 0;
+        IdFCode m_fcode = IdFCode::DEVICE_SPECIFIC1;
+
+        States m_state = States::IDLE;
+
+        umba::ArrayView<const uint8_t> m_data;
+        uint8_t m_windowFrames = 0;
+
+        uint32_t m_blockNum = 0;
+        uint32_t m_framesToSend = 0;
+        uint8_t m_pollRetries = 0;
+
+        // запрос отдан сессии, ждем его колбэка
+        bool m_isRequestSent = false;
+
+        uint32_t m_startTime = 0;
+        uint32_t m_curTime = 0;
+        uint32_t m_finishTime = 0;
+
+        uint32_t m_bytesAcked = 0;
+        uint32_t m_retransmittedFrames = 0;
+
+        can::CanMessage m_frame = {};
+
+        OnComplete m_onComplete = {};
+    };
+
+
+    // Сторона слейва; handle() подключается через SlaveSession::setDeviceSpecific
+    class BlockReceiver
+    {
+
+    public:
+
+        BlockReceiver() = default;
+
+        // копировать запрещено
+        BlockReceiver( const BlockReceiver & rhs ) = delete;
+        BlockReceiver & operator=( BlockReceiver & s ) = delete;
+
+        // приложение решает, готово ли принять столько данных (например, хватит ли флеша)
+        using OnStart = callback::Callback<bool ( uint32_t size )>;
+        // очередной проверенный блок и его смещение от начала передачи
+        using OnBlock = callback::Callback<void ( uint32_t offset, umba::ArrayView<const uint8_t> data )>;
+        using OnComplete = callback::Callback<void ( bool isOk )>;
+
+        // onBlock обязателен, onStart и onComplete можно не задавать
+        void init( OnStart onStart, OnBlock onBlock, OnComplete onComplete );
+
+        uint8_t handle( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer );
+
+        uint32_t getBytesReceived( void ) const
+        {
+            return m_bytesReceived;
+        }
+
+    protected:
+
+        uint8_t handleStart( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer );
+        uint8_t handleData( umba::ArrayView<uint8_t> request );
+        uint8_t handlePoll( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer );
+        uint8_t handleFinish( umba::ArrayView<uint8_t> answer );
+
+        uint8_t makePollAnswer( umba::ArrayView<uint8_t> answer, uint8_t blockNum, uint32_t bitmap, BlockStatus status );
+
+        uint32_t getBlockLength( void ) const;
+        uint8_t getBlockFramesNum( void ) const;
+
+        OnStart m_onStart = {};
+        OnBlock m_onBlock = {};
+        OnComplete m_onComplete = {};
+
+        bool m_isActive = false;
+
+        uint32_t m_size = 0;
+        uint8_t m_windowFrames = 0;
+
+        uint32_t m_blockNum = 0;
+        uint32_t m_bitmap = 0;
+        uint32_t m_bytesReceived = 0;
+
+        umba::Array< uint8_t, block_bytes_max > m_block;
+    };
+
+} // namespace cannabus
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include "cannabus_frame_bits.h"
 //#include "project_config.h"
 //#include "umba_array/umba_array.h"
 //#include "can/i_can.h"
@@ -96,6 +97,62 @@ namespace cannabus
     static const uint8_t max_regs_in_series = 4;
     static const uint8_t max_regs_in_specific = 8;
 
+    // Профили протокола: классический CAN с 8 байтами данных в кадре и CAN FD с 64 байтами.
+    // Кадр CAN FD бывает только длиной 0..8, 12, 16, 20, 24, 32, 48 или 64 байта, а длина серии
+    // по-прежнему определяется длиной кадра, поэтому добивки нет - в FD-профиле собираются
+    // только кадры допустимой длины. Отсюда и пределы: диапазон 2 + 62 = 64, серия 32 * 2 = 64.
+    // В can::CanMessage внешней библиотеки драйверов нет флагов FDF и BRS, поэтому формат кадра драйвер
+    // выбирает сам по длине: кадр длиннее 8 байт уходит как FD с переключением скорости, короче - классическим,
+    // который FD-узел тоже принимает
+    enum class Profile{ CLASSIC, FD };
+
+    static const uint8_t fd_max_regs_in_range = 62;
+    static const uint8_t fd_max_regs_in_series = 32;
+    static const uint8_t fd_max_regs_in_specific = 64;
+
+    constexpr uint8_t getMaxRegsInRange( Profile profile )
+    {
+        return profile == Profile::FD ? fd_max_regs_in_range : max_regs_in_range;
+    }
+
+    constexpr uint8_t getMaxRegsInSeries( Profile profile )
+    {
+        return profile == Profile::FD ? fd_max_regs_in_series : max_regs_in_series;
+    }
+
+    constexpr uint8_t getMaxRegsInSpecific( Profile profile )
+    {
+        return profile == Profile::FD ? fd_max_regs_in_specific : max_regs_in_specific;
+    }
+
+    constexpr bool isFrameLengthValid( Profile profile, uint32_t length )
+    {
+        return length <= getMaxRegsInSpecific( profile ) &&
+               ( length <= 8 || length == 12 || length == 16 || length == 20 ||
+                 length == 24 || length == 32 || length == 48 || length == 64 );
+    }
+
+    // сколько регистров из regsNum влезает в диапазон так, чтобы и запрос на запись, и ответ на чтение
+    // (2 + N байт) были кадрами допустимой длины
+    constexpr uint8_t getRangeRegsFit( Profile profile, uint8_t regsNum )
+    {
+        return regsNum > getMaxRegsInRange( profile ) ? getRangeRegsFit( profile, getMaxRegsInRange( profile ) ) :
+               ( regsNum <= 1 || isFrameLengthValid( profile, regsNum + 2 ) ) ? regsNum :
+               getRangeRegsFit( profile, regsNum - 1 );
+    }
+
+    // то же для серии: запрос на чтение N байт, ответ и запрос на запись 2 * N байт
+    constexpr uint8_t getSeriesRegsFit( Profile profile, uint8_t regsNum )
+    {
+        return regsNum > getMaxRegsInSeries( profile ) ? getSeriesRegsFit( profile, getMaxRegsInSeries( profile ) ) :
+               ( regsNum <= 1 || ( isFrameLengthValid( profile, regsNum ) && isFrameLengthValid( profile, 2 * regsNum ) ) ) ? regsNum :
+               getSeriesRegsFit( profile, regsNum - 1 );
+    }
+
+    // FD-профиль согласуется чтением диапазона из такого числа регистров: классический слейв
+    // отвечает на него ошибкой, а ответ FD-слейва (2 + 10 байт) - кадр допустимой длины
+    static const uint8_t fd_probe_regs_num = 10;
+
     static constexpr uint8_t device_specific_functions_num = (uint32_t)IdFCode::DEVICE_SPECIFIC4 -
                                                              (uint32_t)IdFCode::DEVICE_SPECIFIC1 + 1;
 
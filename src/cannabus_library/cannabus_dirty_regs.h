@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <utility>
+
+namespace cannabus
+{
+    // Битовая карта регистров, ожидающих записи.
+    // Карты разделены по длине регистра (1, 2 и 4 байта), бит выставляется по номеру младшего регистра.
+    // Поиск следующего изменённого регистра сводится к count trailing zeros по машинному слову,
+    // вместо линейного прохода по всей таблице через виртуальные isRegChanged/getRegLength.
+    // Слова карты атомарные: в CannabusHostRegTable регистры отмечают потоки, пишущие в таблицу,
+    // а ищет и сбрасывает их поток протокола. Такая таблица создает карту с isConcurrent,
+    // и отметка со сбросом идут атомарными ИЛИ и И; у таблиц с одним потоком это обычные
+    // чтение и запись слова, как и без атомиков
+    class DirtyRegs
+    {
+
+    public:
+
+        explicit DirtyRegs( bool isConcurrent = false ) :
+            m_isConcurrent( isConcurrent )
+        {
+            clearAll();
+        }
+
+        // копировать запрещено
+        DirtyRegs( const DirtyRegs & rhs ) = delete;
+        DirtyRegs & operator=( const DirtyRegs & rhs ) = delete;
+
+        void mark( uint8_t regNum, uint8_t length )
+        {
+            uint32_t width = getWidthIndex( length );
+
+            // регистров другой длины в cannabus не бывает
+            if( width >= widths_num )
+            {
+                return;
+            }
+
+            std::atomic< Word > & word = m_bits[ width ][ regNum / word_bits ];
+
+            // отметка публикует записанное значение для потока, который найдет регистр
+            if( m_isConcurrent )
+            {
+                word.fetch_or( getBit( regNum ), std::memory_order_release );
+                return;
+            }
+
+            Word value = word.load( std::memory_order_relaxed );
+
+            if( ( value & getBit( regNum ) ) == 0 )
+            {
+                word.store( value | getBit( regNum ), std::memory_order_relaxed );
+            }
+        }
+
+        // сброс регистра во всех картах сразу - длину при сбросе знать не обязательно
+        void clear( uint8_t regNum )
+        {
+            for( auto & bits : m_bits )
+            {
+                std::atomic< Word > & word = bits[ regNum / word_bits ];
+                Word value = word.load( std::memory_order_relaxed );
+
+                // регистр отмечен только в одной из карт, в остальные не пишем
+                if( ( value & getBit( regNum ) ) == 0 )
+                {
+                    continue;
+                }
+
+                // соседние биты слова в это время может отмечать другой поток
+                if( m_isConcurrent )
+                {
+                    word.fetch_and( ~getBit( regNum ), std::memory_order_relaxed );
+                }
+                else
+                {
+                    word.store( value & ~getBit( regNum ), std::memory_order_relaxed );
+                }
+            }
+        }
+
+        void clearAll()
+        {
+            for( auto & bits : m_bits )
+            {
+                for( auto & word : bits )
+                {
+                    word.store( 0, std::memory_order_relaxed );
+                }
+            }
+        }
+
+        bool isEmpty() const
+        {
+            for( const auto & bits : m_bits )
+            {
+                for( const auto & word : bits )
+                {
+                    if( word.load( std::memory_order_acquire ) != 0 )
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        // поиск первого изменённого регистра нужной длины, начиная с regNum включительно
+        auto findNext( uint16_t regNum, uint8_t length ) const -> std::pair<uint8_t, bool>
+        {
+            uint32_t width = getWidthIndex( length );
+
+            if( width >= widths_num || regNum >= regs_num )
+            {
+                return std::make_pair( 0, false );
+            }
+
+            uint32_t wordNum = regNum / word_bits;
+
+            // в первом слове отбрасываем биты регистров, которые меньше regNum
+            Word word = m_bits[ width ][ wordNum ].load( std::memory_order_acquire ) & ( ~( Word )0 << ( regNum % word_bits ) );
+
+            while( true )
+            {
+                if( word != 0 )
+                {
+                    return std::make_pair( ( uint8_t )( wordNum * word_bits + countTrailingZeros( word ) ), true );
+                }
+
+                wordNum++;
+
+                if( wordNum >= words_num )
+                {
+                    return std::make_pair( 0, false );
+                }
+
+                word = m_bits[ width ][ wordNum ].load( std::memory_order_acquire );
+            }
+        }
+
+        // поиск первого изменённого регистра любой длины; возвращает номер и длину, длина 0 - ничего не найдено
+        auto findFirst( uint16_t regNum ) const -> std::pair<uint8_t, uint8_t>
+        {
+            std::pair<uint8_t, uint8_t> result = std::make_pair( 0, 0 );
+
+            for( uint32_t width = 0; width < widths_num; width++ )
+            {
+                auto found = findNext( regNum, getLength( width ) );
+
+                if( found.second == false )
+                {
+                    continue;
+                }
+
+                if( result.second == 0 || found.first < result.first )
+                {
+                    result = std::make_pair( found.first, getLength( width ) );
+                }
+            }
+
+            return result;
+        }
+
+        // номер младшего выставленного бита; слово гарантированно ненулевое
+        static uint32_t countTrailingZeros( uint32_t word )
+        {
+#if defined( __GNUC__ ) || defined( __clang__ )
+            return ( uint32_t )__builtin_ctz( word );
+#else
+            // последовательность де Брёйна для компиляторов без встроенного ctz
+            static const uint8_t debruijn_positions[ 32 ] =
+            {
+                0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+                31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+            };
+
+            return debruijn_positions[ ( ( word & ( 0 - word ) ) * 0x077CB531u ) >> 27 ];
+#endif
+        }
+
+    private:
+
+        // на целевых контроллерах машинное слово 32-битное
+        using Word = uint32_t;
+
+        static constexpr uint32_t regs_num = 256;
+        static constexpr uint32_t word_bits = sizeof( Word ) * 8;
+        static constexpr uint32_t words_num = regs_num / word_bits;
+        static constexpr uint32_t widths_num = 3;
+
+        static Word getBit( uint8_t regNum )
+        {
+            return ( Word )1 << ( regNum % word_bits );
+        }
+
+        static uint32_t getWidthIndex( uint8_t length )
+        {
+            switch( length )
+            {
+                case 1: return 0;
+                case 2: return 1;
+                case 4: return 2;
+                default: return widths_num;
+            }
+        }
+
+        static uint8_t getLength( uint32_t width )
+        {
+            return ( uint8_t )( 1u << width );
+        }
+
+        std::atomic< Word > m_bits[ widths_num ][ words_num ];
+
+        const bool m_isConcurrent;
+    };
+
+} // namespace cannabus
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace cannabus
+{
+    // Длина кадра на шине в битах, посчитанная по его содержимому.
+    //
+    // Стандартный кадр (11-битный ID) от SOF до конца CRC подвержен бит-стаффингу: после пяти одинаковых
+    // бит вставляется противоположный, и вставленный бит сам участвует в следующей пятерке.
+    // Поэтому CRC-15 считается честно, а стаффинг - проходом по всем битам.
+    // За CRC идут разделитель, ACK, разделитель ACK, EOF и межкадровый промежуток - они не стаффятся
+    //
+    // Заголовок кадра: SOF, ID, RTR, IDE, r0, DLC
+    static const uint32_t frame_header_bits = 1 + 11 + 3 + 4;
+    static const uint32_t frame_crc_bits = 15;
+    static const uint32_t frame_tail_bits = 1 + 1 + 1 + 7 + 3;
+
+    // кадр ошибки: флаг, флаги остальных узлов в худшем случае, разделитель и межкадровый промежуток
+    static const uint32_t error_frame_bits = 6 + 6 + 8 + 3;
+
+    inline uint32_t getFrameBits( uint32_t id, const uint8_t * data, uint8_t length )
+    {
+        uint32_t bitsNum = 0;
+        uint32_t stuffBits = 0;
+        uint32_t lastBit = 2;
+        uint32_t runLength = 0;
+
+        uint16_t crc = 0;
+
+        auto putBit = [&]( uint32_t bit, bool isCrcCounted )
+        {
+            if( isCrcCounted )
+            {
+                uint32_t crcNext = bit ^ ( ( crc >> 14 ) & 1 );
+
+                crc = (uint16_t)( ( crc << 1 ) & 0x7FFF );
+
+                if( crcNext != 0 )
+                {
+                    crc ^= 0x4599;
+                }
+            }
+
+            bitsNum++;
+
+            if( bit == lastBit )
+            {
+                runLength++;
+            }
+            else
+            {
+                lastBit = bit;
+                runLength = 1;
+            }
+
+            // вставленный бит противоположен пятерке и начинает новую серию
+            if( runLength == 5 )
+            {
+                stuffBits++;
+                lastBit = 1 - bit;
+                runLength = 1;
+            }
+        };
+
+        auto putField = [&]( uint32_t value, uint32_t fieldBits, bool isCrcCounted )
+        {
+            for( uint32_t i = fieldBits; i > 0; i-- )
+            {
+                putBit( ( value >> ( i - 1 ) ) & 1, isCrcCounted );
+            }
+        };
+
+        // SOF, ID, RTR, IDE, r0, DLC
+        putField( 0, 1, true );
+        putField( id & 0x7FF, 11, true );
+        putField( 0, 3, true );
+        putField( length, 4, true );
+
+        for( uint8_t i = 0; i < length; i++ )
+        {
+            putField( data[i], 8, true );
+        }
+
+        putField( crc, frame_crc_bits, false );
+
+        return bitsNum + stuffBits + frame_tail_bits;
+    }
+
+    // Та же длина в наихудшем случае, когда известна только длина данных: стаффинг худший - бит на каждые
+    // четыре после первого, как при чередовании серий 1 + 4. Для оценок занятости шины заранее
+    constexpr uint32_t getFrameBitsWorstCase( uint8_t dataLength )
+    {
+        return frame_header_bits + 8 * (uint32_t)dataLength + frame_crc_bits +
+               ( frame_header_bits + 8 * (uint32_t)dataLength + frame_crc_bits - 1 ) / 4 +
+               frame_tail_bits;
+    }
+
+    // Кадр CAN FD (ISO, 11-битный ID, с переключением скорости) - в наихудшем случае по стаффингу.
+    // Фаза арбитража идет на номинальной скорости, фаза данных - на скорости данных
+    struct FdFrameBits
+    {
+        uint32_t arbitration;
+        uint32_t data;
+    };
+
+    inline FdFrameBits getFdFrameBitsWorstCase( uint8_t length )
+    {
+        // SOF, ID, RRS, IDE, FDF, res, BRS и их стаффинг, затем хвост кадра
+        static const uint32_t arbitration_bits = 17;
+
+        // ESI, DLC; счетчик стаффинга с четностью и фиксированным битом
+        static const uint32_t data_header_bits = 1 + 4;
+        static const uint32_t stuff_count_bits = 4 + 1;
+
+        uint32_t crcBits = length <= 16 ? 17 : 21;
+        uint32_t dynamicBits = data_header_bits + 8 * (uint32_t)length;
+
+        FdFrameBits result;
+
+        result.arbitration = arbitration_bits + ( arbitration_bits - 1 ) / 4 + frame_tail_bits;
+
+        // в поле CRC стаффинг фиксированный: бит после каждых четырех
+        result.data = dynamicBits + ( dynamicBits - 1 ) / 4 + stuff_count_bits + crcBits + crcBits / 4;
+
+        return result;
+    }
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include "project_config.h"
+#include "i_cannabus_reg_table.h"
+#include "cannabus_dirty_regs.h"
+#include <atomic>
+#include <utility>
+
+namespace cannabus
+{
+    // Таблица регистров для мастера на хосте, где к регистрам ходят сразу несколько потоков
+    // (интерфейс, протокол, логирование).
+    // Табличного мьютекса нет: значения лежат в атомиках, многобайтные регистры защищены seqlock'ом,
+    // флаги изменения - атомарная битовая карта. Читатели никогда не блокируют поток протокола,
+    // а 16- и 32-битные значения читаются согласованно.
+    // Изменёнными отмечаются только rw-регистры, значение которых действительно поменялось;
+    // как и CannabusRegTable, таблица ведет битовую карту для Slave (RegTableSlave)
+    template <uint8_t TRoRegMin, uint8_t TRoRegMax,
+              uint8_t TRwRegMin, uint8_t TRwRegMax>
+    class CannabusHostRegTable : public ICannabusRegTable
+    {
+
+    public:
+
+        CannabusHostRegTable(void) :
+            m_dirtyRegs( true )
+        {
+            for( uint32_t i = 0; i < regs_num; i++ )
+            {
+                m_values[i].store( 0, std::memory_order_relaxed );
+                m_seqs[i].store( 0, std::memory_order_relaxed );
+                m_lengths[i] = 1;
+                m_groupBegin[i] = (uint8_t)i;
+            }
+
+            for( auto & word : m_changed )
+            {
+                word.store( 0, std::memory_order_relaxed );
+            }
+        }
+
+        // копировать запрещено
+        CannabusHostRegTable( const CannabusHostRegTable & rhs ) = delete;
+        CannabusHostRegTable & operator=( CannabusHostRegTable & s ) = delete;
+
+        // длины регистров задаются до запуска потоков, дальше только читаются
+        void setRegLength(uint8_t lowRegNum, uint8_t length)
+        {
+            UMBA_ASSERT( length == 1 || length == 2 || length == 4 );
+            UMBA_ASSERT( lowRegNum + length <= regs_num );
+
+            for( uint8_t i = 0; i < length; i++ )
+            {
+                m_lengths[ lowRegNum + i ] = length;
+                m_groupBegin[ lowRegNum + i ] = lowRegNum;
+            }
+        }
+
+        virtual uint8_t getRegLength(uint8_t regNum)
+        {
+            return m_lengths[ regNum ];
+        }
+
+        // просто прочитать значение регистра
+        virtual uint8_t getRegVal(uint8_t regNum)
+        {
+            UMBA_ASSERT( isRegNumValid( regNum ) );
+
+            return m_values[ regNum ].load( std::memory_order_relaxed );
+        }
+
+        // просто записать значение регистра
+        virtual void setRegVal(uint8_t regNum, uint8_t val)
+        {
+            UMBA_ASSERT( isRegNumValid( regNum ) );
+
+            // байт многобайтного регистра пишется под seqlock'ом всего регистра
+            uint8_t lowRegNum = m_groupBegin[ regNum ];
+
+            uint8_t changedBytes = writeGroup( lowRegNum, regNum - lowRegNum, &val, 1 );
+
+            markChanged( regNum, changedBytes );
+        }
+
+        // сдвоенные регистры и двухбайтные значения
+        virtual uint16_t getReg16Val(uint8_t lowRegNum)
+        {
+            UMBA_ASSERT( isRegNumValid( lowRegNum ) );
+
+            return (uint16_t)readGroup( lowRegNum, 2 );
+        }
+
+        virtual void setReg16Val(uint8_t lowRegNum, uint16_t val)
+        {
+            UMBA_ASSERT( isRegNumValid( lowRegNum ) );
+
+            uint8_t bytes[2] = { (uint8_t)val, (uint8_t)( val >> 8 ) };
+
+            uint8_t changedBytes = writeGroup( lowRegNum, 0, bytes, 2 );
+
+            markChanged( lowRegNum, changedBytes );
+        }
+
+        // счетверенные регистры и четырехбайтные значения
+        virtual uint32_t getReg32Val(uint8_t lowRegNum)
+        {
+            UMBA_ASSERT( isRegNumValid( lowRegNum ) );
+
+            return readGroup( lowRegNum, 4 );
+        }
+
+        virtual void setReg32Val(uint8_t lowRegNum, uint32_t val)
+        {
+            UMBA_ASSERT( isRegNumValid( lowRegNum ) );
+
+            uint8_t bytes[4] = { (uint8_t)val, (uint8_t)( val >> 8 ), (uint8_t)( val >> 16 ), (uint8_t)( val >> 24 ) };
+
+            uint8_t changedBytes = writeGroup( lowRegNum, 0, bytes, 4 );
+
+            markChanged( lowRegNum, changedBytes );
+        }
+
+        // флаги изменения
+        virtual bool isRegChanged(uint8_t regNum)
+        {
+            return ( m_changed[ regNum / word_bits ].load( std::memory_order_acquire ) & getBit( regNum ) ) != 0;
+        }
+
+        // сбрасывает флаг, возвращает, был ли он выставлен
+        virtual bool checkRegUpdate(uint8_t regNum)
+        {
+            uint32_t old = m_changed[ regNum / word_bits ].fetch_and( ~getBit( regNum ), std::memory_order_acq_rel );
+
+            return ( old & getBit( regNum ) ) != 0;
+        }
+
+        DirtyRegs & getDirtyRegs(void)
+        {
+            return m_dirtyRegs;
+        }
+
+        // поиск первого изменённого регистра, начиная с regNum включительно
+        auto findNextChanged( uint16_t regNum ) const -> std::pair<uint8_t, bool>
+        {
+            if( regNum >= regs_num )
+            {
+                return std::make_pair( 0, false );
+            }
+
+            uint32_t wordNum = regNum / word_bits;
+            uint32_t word = m_changed[ wordNum ].load( std::memory_order_acquire ) & ( ~0u << ( regNum % word_bits ) );
+
+            while( true )
+            {
+                if( word != 0 )
+                {
+                    return std::make_pair( (uint8_t)( wordNum * word_bits + DirtyRegs::countTrailingZeros( word ) ), true );
+                }
+
+                wordNum++;
+
+                if( wordNum >= words_num )
+                {
+                    return std::make_pair( 0, false );
+                }
+
+                word = m_changed[ wordNum ].load( std::memory_order_acquire );
+            }
+        }
+
+        virtual uint8_t getRoMinRegNum(void)
+        {
+            return TRoRegMin;
+        }
+
+        virtual uint8_t getRoMaxRegNum(void)
+        {
+            return TRoRegMax;
+        }
+
+        virtual uint8_t getRwMinRegNum(void)
+        {
+            return TRwRegMin;
+        }
+
+        virtual uint8_t getRwMaxRegNum(void)
+        {
+            return TRwRegMax;
+        }
+
+        virtual bool isRegNumRw(uint8_t regNum)
+        {
+            return regNum >= TRwRegMin && regNum <= TRwRegMax;
+        }
+
+        virtual bool isRegNumValid(uint8_t regNum)
+        {
+            return isRegNumRw( regNum ) || ( regNum >= TRoRegMin && regNum <= TRoRegMax );
+        }
+
+        // таблица lock-free, табличный лок ей не нужен - но интерфейс его требует
+        virtual bool isTableLocked(void)
+        {
+            return false;
+        }
+
+        virtual void lockTable(void)
+        {
+        }
+
+        virtual void unlockTable(void)
+        {
+        }
+
+    private:
+
+        static constexpr uint32_t regs_num = 256;
+        static constexpr uint32_t word_bits = 32;
+        static constexpr uint32_t words_num = regs_num / word_bits;
+
+        static uint32_t getBit( uint8_t regNum )
+        {
+            return 1u << ( regNum % word_bits );
+        }
+
+        // changedBytes - маска байт, записанных начиная с regNum, значение которых поменялось.
+        // В карте для Slave регистр отмечается по младшему байту и целиком
+        void markChanged( uint8_t regNum, uint8_t changedBytes )
+        {
+            // ro-регистры никуда не отправляются, их отслеживать незачем
+            if( changedBytes == 0 || regNum < TRwRegMin || regNum > TRwRegMax )
+            {
+                return;
+            }
+
+            for( uint8_t i = 0; changedBytes != 0; i++, changedBytes >>= 1 )
+            {
+                if( ( changedBytes & 1 ) != 0 )
+                {
+                    m_changed[ ( regNum + i ) / word_bits ].fetch_or( getBit( regNum + i ), std::memory_order_release );
+                }
+            }
+
+            m_dirtyRegs.mark( m_groupBegin[ regNum ], m_lengths[ regNum ] );
+        }
+
+        // запись под seqlock'ом: нечетный счетчик - идет запись.
+        // Писателей может быть несколько, поэтому нечетное значение захватывается через CAS.
+        // Возвращает маску байт, значение которых поменялось
+        uint8_t writeGroup( uint8_t lowRegNum, uint8_t offset, const uint8_t * bytes, uint8_t count )
+        {
+            std::atomic<uint32_t> & seq = m_seqs[ lowRegNum ];
+
+            uint32_t s = seq.load( std::memory_order_relaxed );
+
+            while( true )
+            {
+                if( ( s & 1 ) != 0 )
+                {
+                    s = seq.load( std::memory_order_relaxed );
+                    continue;
+                }
+
+                if( seq.compare_exchange_weak( s, s + 1, std::memory_order_acquire, std::memory_order_relaxed ) )
+                {
+                    break;
+                }
+            }
+
+            std::atomic_thread_fence( std::memory_order_release );
+
+            uint8_t changedBytes = 0;
+
+            // под seqlock'ом регистр пишет только этот поток, поэтому старое значение можно просто прочитать
+            for( uint8_t i = 0; i < count; i++ )
+            {
+                std::atomic<uint8_t> & value = m_values[ lowRegNum + offset + i ];
+
+                if( value.load( std::memory_order_relaxed ) != bytes[i] )
+                {
+                    value.store( bytes[i], std::memory_order_relaxed );
+                    changedBytes |= 1u << i;
+                }
+            }
+
+            seq.store( s + 2, std::memory_order_release );
+
+            return changedBytes;
+        }
+
+        // чтение под seqlock'ом: повторяем, пока запись не завершится и счетчик не перестанет меняться
+        uint32_t readGroup( uint8_t lowRegNum, uint8_t count )
+        {
+            std::atomic<uint32_t> & seq = m_seqs[ lowRegNum ];
+
+            uint32_t before = 0;
+            uint32_t after = 0;
+            uint32_t result = 0;
+
+            do
+            {
+                before = seq.load( std::memory_order_acquire );
+
+                result = 0;
+
+                for( uint8_t i = 0; i < count; i++ )
+                {
+                    result |= (uint32_t)m_values[ lowRegNum + i ].load( std::memory_order_relaxed ) << ( 8 * i );
+                }
+
+                std::atomic_thread_fence( std::memory_order_acquire );
+
+                after = seq.load( std::memory_order_relaxed );
+            }
+            while( ( before & 1 ) != 0 || before != after );
+
+            return result;
+        }
+
+        std::atomic<uint8_t> m_values[ regs_num ];
+        std::atomic<uint32_t> m_seqs[ regs_num ];
+        std::atomic<uint32_t> m_changed[ words_num ];
+
+        uint8_t m_lengths[ regs_num ];
+        uint8_t m_groupBegin[ regs_num ];
+
+        // карту отмечают несколько потоков
+        DirtyRegs m_dirtyRegs;
+    };
+
+} // namespace cannabus
@@ -73,11 +73,54 @@ namespace cannabus
                 break;
         }
 
+        // после ответа следующий запрос уходит в этом же вызове, а не на следующем такте,
+        // чтобы запросы шли по шине подряд
+        for( uint32_t i = 0; i < work_passes_max; i++ )
+        {
+            SessionStates prevState = m_state;
+
+            processState();
+
+            if( m_state == prevState )
+            {
+                break;
+            }
+
+            if( m_state != SessionStates::WAITING_REQUEST && m_state != SessionStates::SENDING_REQUEST )
+            {
+                break;
+            }
+        }
+    }
+
+    void MasterSession :: processState( void )
+    {
         switch( m_state )
         {
 
         case SessionStates::WAITING_REQUEST:
 
+            // запросы без ответа уходят пачкой, пока есть ящики; остальное - когда очередь опустеет
+            while( ! m_noAnswerQueue.isEmpty() )
+            {
+                if( m_can->isReadyToTransmit() == false )
+                {
+                    break;
+                }
+
+                if( m_can->transmitMessage( m_noAnswerQueue.front() ) != can::ReturnState::OK )
+                {
+                    break;
+                }
+
+                m_noAnswerQueue.pop();
+            }
+
+            if( ! m_noAnswerQueue.isEmpty() )
+            {
+                break;
+            }
+
             // а еще у мастера может висеть неотправленный бродкаст или уникаст
             if( m_isBroadcastPending )
             {
@@ -93,10 +136,48 @@ namespace cannabus
                 m_state = SessionStates::SENDING_REQUEST;
                 break;
             }
+            if( m_isProbePending )
+            {
+                m_actualRequestToSend = &m_requestProbe;
+                m_isProbePending = false;
+                m_answerTimeout = getAnswerTimeout( (uint8_t)getAddressFromId( m_requestProbe.id ) );
+                m_state = SessionStates::SENDING_REQUEST;
+                break;
+            }
+            if( m_isOwnPending )
+            {
+                m_actualRequestToSend = &m_requestOwn;
+                m_isOwnPending = false;
+                m_answerTimeout = getAnswerTimeout( (uint8_t)getAddressFromId( m_requestOwn.id ) );
+                m_state = SessionStates::SENDING_REQUEST;
+                break;
+            }
+            // блочная передача вытесняет обычный опрос до своего завершения
+            if( m_bulk.isActive )
+            {
+                if( tryGetBulkRequest() )
+                {
+                    m_actualRequestToSend = &m_requestBulk;
+                    m_answerTimeout = getAnswerTimeout( m_bulk.slaveAdr );
+                    m_state = SessionStates::SENDING_REQUEST;
+                }
+                break;
+            }
             if( m_isRequestPending )
             {
-                m_actualRequestToSend = &m_requestBasic;
                 m_isRequestPending = false;
+
+                uint8_t slaveAdr = (uint8_t)getAddressFromId( m_requestBasic.id );
+
+                // слейв недавно пропал - шину на него не тратим, пока не выйдет пауза
+                if( isSlaveBackedOff( slaveAdr ) )
+                {
+                    m_onConnectionFailure();
+                    break;
+                }
+
+                m_actualRequestToSend = &m_requestBasic;
+                m_answerTimeout = getAnswerTimeout( slaveAdr );
                 m_state = SessionStates::SENDING_REQUEST;
                 break;
             }
@@ -144,17 +225,44 @@ namespace cannabus
             if( m_can->tryToReceive( m_answer ) == false )
             {
                 // не слишком ли долго мы ждем
-                if( m_curCallTime - m_lastRequestTime < m_answer_timeout_max )
+                if( m_curCallTime - m_lastRequestTime < m_answerTimeout )
                 {
                     break;
                 }
 
+                uint8_t slaveAdr = (uint8_t)getAddressFromId( m_actualRequestToSend->id );
+
+                // слейв, который уже терял связь, проверяется одним запросом без повторов
+                uint8_t repeatsMax = m_repeats_max;
+
+                if( m_isTimeoutAdaptive && m_links[ slaveAdr ].failuresInRow != 0 )
+                {
+                    repeatsMax = 0;
+                }
+
                 // повторы не помогают - связь потеряна
-                if( m_repeatsCount >= m_repeats_max )
+                if( m_repeatsCount >= repeatsMax )
                 {
                     m_repeatsCount = 0;
 
-                    m_onConnectionFailure();
+                    onLinkFailure( slaveAdr );
+
+                    if( m_actualRequestToSend == &m_requestBulk )
+                    {
+                        onBulkFailure();
+                    }
+                    else if( m_actualRequestToSend == &m_requestProbe )
+                    {
+                        finishProfileNegotiation( Profile::CLASSIC );
+                    }
+                    else if( m_actualRequestToSend == &m_requestOwn )
+                    {
+                        finishOwnRequest( false );
+                    }
+                    else
+                    {
+                        m_onConnectionFailure();
+                    }
 
                     // дальше можно слать новое сообщение
                     m_state = SessionStates::WAITING_REQUEST;
@@ -165,6 +273,12 @@ namespace cannabus
                 // попробуем повторить текущее сообщение еще раз
                 m_repeatsCount++;
 
+                // повтор ждем дольше - вдруг слейв просто медленнее, чем мы думали
+                if( m_isTimeoutAdaptive )
+                {
+                    m_answerTimeout = std::min( m_answerTimeout * 2, m_answer_timeout_max );
+                }
+
                 m_state = SessionStates::SENDING_REQUEST;
 
 
@@ -183,8 +297,24 @@ namespace cannabus
                 break;
             }
             
+            // классический слейв отвечает на пробу FD-профиля ошибкой - это тоже ответ
+            if( m_actualRequestToSend == &m_requestProbe &&
+                m_answer.length == 0 &&
+                getAddressFromId( m_answer.id ) == getAddressFromId( m_requestProbe.id ) &&
+                getFCodeFromId( m_answer.id ) == getFCodeFromId( m_requestProbe.id ) )
+            {
+                onLinkRestored( (uint8_t)getAddressFromId( m_answer.id ) );
+
+                finishProfileNegotiation( Profile::CLASSIC );
+
+                m_repeatsCount = 0;
+                m_state = SessionStates::WAITING_REQUEST;
+
+                break;
+            }
+
             // что-то не то
-            if( ! isAnswerRelevant( m_answer, m_requestBasic ) )
+            if( ! isAnswerRelevant( m_answer, *m_actualRequestToSend ) )
             {
                 m_onIrrelevantAnswer(m_answer);
                 break;
@@ -192,7 +322,32 @@ namespace cannabus
             // то, что надо
             else
             {
-                m_onAnswerReceived(m_answer);
+                uint8_t slaveAdr = (uint8_t)getAddressFromId( m_actualRequestToSend->id );
+
+                // время обмена по повторенному запросу неоднозначно, его не учитываем
+                if( m_repeatsCount == 0 )
+                {
+                    onRttMeasured( slaveAdr, m_curCallTime - m_lastRequestTime );
+                }
+
+                onLinkRestored( slaveAdr );
+
+                if( m_actualRequestToSend == &m_requestBulk )
+                {
+                    onBulkAnswerReceived( m_answer );
+                }
+                else if( m_actualRequestToSend == &m_requestProbe )
+                {
+                    finishProfileNegotiation( Profile::FD );
+                }
+                else if( m_actualRequestToSend == &m_requestOwn )
+                {
+                    finishOwnRequest( true );
+                }
+                else
+                {
+                    m_onAnswerReceived(m_answer);
+                }
             }
 
 
@@ -252,6 +407,315 @@ PRAGMA_SUPPRESS_STATEMENT_UNREACHABLE_BEGIN
 PRAGMA_END
         }
     }
+    bool MasterSession::tryStartBulkRead( uint8_t slaveAdr,
+                                          uint8_t regNumBegin,
+                                          umba::ArrayView<uint8_t> values, //-V813
+                                          OnBulkComplete onComplete )
+    {
+        if( ! tryStartBulk( slaveAdr, regNumBegin, values.size(), onComplete ) )
+        {
+            return false;
+        }
+
+        m_bulk.isWrite = false;
+        m_bulk.readValues = values.data();
+        m_bulk.writeValues = nullptr;
+
+        return true;
+    }
+
+    bool MasterSession::tryStartBulkWrite( uint8_t slaveAdr,
+                                           uint8_t regNumBegin,
+                                           umba::ArrayView<const uint8_t> values, //-V813
+                                           OnBulkComplete onComplete )
+    {
+        if( ! tryStartBulk( slaveAdr, regNumBegin, values.size(), onComplete ) )
+        {
+            return false;
+        }
+
+        m_bulk.isWrite = true;
+        m_bulk.readValues = nullptr;
+        m_bulk.writeValues = values.data();
+
+        return true;
+    }
+
+    /**************************************************************************************************
+    Описание:  Общая часть запуска блочной передачи
+    Аргументы: Адрес слейва, первый регистр, число регистров, колбэк завершения
+    Возврат:   Запущена передача или нет
+    Замечания: Одновременно идет только одна блочная передача.
+               Диапазон режется на сегменты по max_regs_in_range регистров,
+               а для слейва, согласовавшего FD-профиль, - по 62
+    **************************************************************************************************/
+    bool MasterSession::tryStartBulk( uint8_t slaveAdr, uint8_t regNumBegin, uint16_t regsNum, OnBulkComplete onComplete )
+    {
+        UMBA_ASSERT( slaveAdr >= (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS );
+        UMBA_ASSERT( slaveAdr <= (uint32_t)IdAddresses::MAX_SLAVE_ADDRESS );
+        UMBA_ASSERT( regsNum != 0 );
+        UMBA_ASSERT( regNumBegin + regsNum <= UINT8_MAX + 1 );
+
+        if( m_bulk.isActive )
+        {
+            return false;
+        }
+
+        m_bulk.isActive = true;
+        m_bulk.slaveAdr = slaveAdr;
+        m_bulk.regNumBegin = regNumBegin;
+        m_bulk.regsNum = regsNum;
+        m_bulk.profile = m_links[ slaveAdr ].profile;
+        m_bulk.segmentsNum = 0;
+
+        for( uint16_t offset = 0; offset < regsNum; m_bulk.segmentsNum++ )
+        {
+            offset += getRangeRegsFit( m_bulk.profile, (uint8_t)std::min<uint16_t>( regsNum - offset, UINT8_MAX ) );
+        }
+
+        m_bulk.currentSegment = 0;
+        m_bulk.passesLeft = bulk_retry_passes_max;
+        m_bulk.pendingSegments = ( m_bulk.segmentsNum == 64 ) ? UINT64_MAX : ( ( (uint64_t)1 << m_bulk.segmentsNum ) - 1 );
+        m_bulk.failedSegments = 0;
+        m_bulk.onComplete = onComplete;
+
+        m_bulkCreator.init( slaveAdr, m_bulk.profile );
+
+        return true;
+    }
+
+    /**************************************************************************************************
+    Описание:  Собирает запрос для следующего сегмента блочной передачи
+    Аргументы: Нет
+    Возврат:   Есть запрос/нет
+    Замечания: Сегменты идут по возрастанию; когда проход закончен, повторяются только не прошедшие.
+               Одиночный регистр дешевле передать серией, чем диапазоном:
+               на запись 2 байта вместо 3, на чтение 1 + 2 вместо 2 + 3
+    **************************************************************************************************/
+    bool MasterSession::tryGetBulkRequest( void )
+    {
+        if( m_bulk.pendingSegments == 0 )
+        {
+            if( m_bulk.failedSegments == 0 || m_bulk.passesLeft == 0 )
+            {
+                finishBulk( m_bulk.failedSegments == 0 );
+                return false;
+            }
+
+            m_bulk.passesLeft--;
+            m_bulk.pendingSegments = m_bulk.failedSegments;
+            m_bulk.failedSegments = 0;
+        }
+
+        // слейв потерял связь - оставшиеся сегменты все равно не пройдут
+        if( isSlaveBackedOff( m_bulk.slaveAdr ) )
+        {
+            finishBulk( false );
+            return false;
+        }
+
+        uint8_t segment = 0;
+
+        while( ( m_bulk.pendingSegments & ( (uint64_t)1 << segment ) ) == 0 )
+        {
+            segment++;
+        }
+
+        m_bulk.pendingSegments &= ~( (uint64_t)1 << segment );
+        m_bulk.currentSegment = segment;
+
+        uint16_t offset = 0;
+        uint8_t regsNum = 0;
+
+        getBulkSegment( segment, offset, regsNum );
+
+        uint8_t regNum = m_bulk.regNumBegin + offset;
+
+        if( regsNum == 1 )
+        {
+            RequestCreator::Register reg;
+            reg.num = regNum;
+
+            if( m_bulk.isWrite )
+            {
+                reg.val = m_bulk.writeValues[ offset ];
+                m_bulkCreator.createWriteSeries( m_requestBulk, umba::ArrayView<const RequestCreator::Register>( &reg, 1 ) );
+            }
+            else
+            {
+                m_bulkCreator.createReadSeries( m_requestBulk, umba::ArrayView<const RequestCreator::Register>( &reg, 1 ) );
+            }
+
+            return true;
+        }
+
+        if( m_bulk.isWrite )
+        {
+            m_bulkCreator.createWriteRange( m_requestBulk,
+                                            regNum,
+                                            regNum + regsNum - 1,
+                                            umba::ArrayView<const uint8_t>( m_bulk.writeValues + offset, regsNum ) );
+        }
+        else
+        {
+            m_bulkCreator.createReadRange( m_requestBulk, regNum, regNum + regsNum - 1 );
+        }
+
+        return true;
+    }
+
+    void MasterSession::onBulkAnswerReceived( const can::CanMessage & answer )
+    {
+        if( m_bulk.isWrite )
+        {
+            return;
+        }
+
+        uint16_t offset = 0;
+        uint8_t regsNum = 0;
+
+        getBulkSegment( m_bulk.currentSegment, offset, regsNum );
+
+        // ответ уже проверен на соответствие запросу
+        if( getFCodeFromId( answer.id ) == IdFCode::READ_REGS_SERIES )
+        {
+            m_bulk.readValues[ offset ] = answer.data[1];
+            return;
+        }
+
+        std::copy( answer.data + 2, answer.data + answer.length, m_bulk.readValues + offset );
+    }
+
+    // сегменты набираются жадно: каждый - самый длинный диапазон, который влезает в кадр допустимой длины
+    void MasterSession::getBulkSegment( uint8_t segment, uint16_t & offset, uint8_t & regsNum ) const
+    {
+        offset = 0;
+        regsNum = 0;
+
+        for( uint8_t i = 0; i <= segment; i++ )
+        {
+            offset += regsNum;
+            regsNum = getRangeRegsFit( m_bulk.profile, (uint8_t)std::min<uint16_t>( m_bulk.regsNum - offset, UINT8_MAX ) );
+        }
+    }
+
+    void MasterSession::onBulkFailure( void )
+    {
+        m_bulk.failedSegments |= (uint64_t)1 << m_bulk.currentSegment;
+    }
+
+    void MasterSession::finishBulk( bool isOk )
+    {
+        m_bulk.isActive = false;
+
+        // в колбэке можно сразу запустить следующую передачу
+        OnBulkComplete onComplete = m_bulk.onComplete;
+        m_bulk.onComplete = OnBulkComplete();
+
+        if( onComplete )
+        {
+            onComplete( isOk );
+        }
+    }
+
+    bool MasterSession::tryToSendWithoutAnswer( const can::CanMessage & request )
+    {
+        UMBA_ASSERT( isRequestValid( request ) );
+        UMBA_ASSERT( getAddressFromId( request.id ) != (uint32_t)IdAddresses::DIRECT_ACCESS );
+
+        return m_noAnswerQueue.tryPush( request );
+    }
+
+    bool MasterSession::tryToSendOwnRequest( const can::CanMessage & request,
+                                             OnAnswerReceived onAnswer,
+                                             callback::VoidCallback onFailure )
+    {
+        UMBA_ASSERT( isRequestValid( request ) );
+        UMBA_ASSERT( getAddressFromId( request.id ) != (uint32_t)IdAddresses::DIRECT_ACCESS );
+
+        // пока предыдущий свой запрос ждет отправки, ответа или повторяется, слот занят
+        if( m_isOwnActive )
+        {
+            return false;
+        }
+
+        m_requestOwn = request;
+        m_onOwnAnswer = onAnswer;
+        m_onOwnFailure = onFailure;
+
+        m_isOwnPending = true;
+        m_isOwnActive = true;
+
+        return true;
+    }
+
+    /**************************************************************************************************
+    Описание:  Запускает согласование профиля протокола со слейвом
+    Аргументы: Адрес слейва, первый регистр пробного диапазона, колбэк с результатом
+    Возврат:   Запущено согласование или нет
+    Замечания: Проба - чтение диапазона из fd_probe_regs_num регистров, больше, чем влезает в
+               классический кадр. FD-слейв отвечает на нее, классический - ответом об ошибке.
+               Если ответа нет совсем, профиль остается классическим
+    **************************************************************************************************/
+    bool MasterSession::tryStartProfileNegotiation( uint8_t slaveAdr, uint8_t regNumBegin, OnProfileNegotiated onNegotiated )
+    {
+        UMBA_ASSERT( slaveAdr >= (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS );
+        UMBA_ASSERT( slaveAdr <= (uint32_t)IdAddresses::MAX_SLAVE_ADDRESS );
+        UMBA_ASSERT( regNumBegin + fd_probe_regs_num <= UINT8_MAX + 1 );
+
+        // мастер сам должен уметь FD-кадры
+        UMBA_ASSERT( RequestCreator::isProfileSupported( Profile::FD ) );
+
+        // проба в полете: ее ответ сверяется с m_requestProbe, поэтому второе согласование ждет колбэка первого
+        if( m_isProbeActive )
+        {
+            return false;
+        }
+
+        RequestCreator creator;
+        creator.init( slaveAdr, Profile::FD );
+        creator.createReadRange( m_requestProbe, regNumBegin, regNumBegin + fd_probe_regs_num - 1 );
+
+        m_onProfileNegotiated = onNegotiated;
+        m_isProbePending = true;
+        m_isProbeActive = true;
+
+        return true;
+    }
+
+    void MasterSession::finishProfileNegotiation( Profile profile )
+    {
+        uint8_t slaveAdr = (uint8_t)getAddressFromId( m_requestProbe.id );
+
+        m_links[ slaveAdr ].profile = profile;
+
+        // в колбэке можно сразу начать следующее согласование
+        OnProfileNegotiated onNegotiated = m_onProfileNegotiated;
+        m_isProbeActive = false;
+
+        if( onNegotiated )
+        {
+            onNegotiated( slaveAdr, profile );
+        }
+    }
+
+    void MasterSession::finishOwnRequest( bool isAnswered )
+    {
+        // в колбэке можно сразу отправить следующий свой запрос
+        m_isOwnActive = false;
+
+        if( isAnswered )
+        {
+            OnAnswerReceived onAnswer = m_onOwnAnswer;
+            onAnswer( m_answer );
+        }
+        else
+        {
+            callback::VoidCallback onFailure = m_onOwnFailure;
+            onFailure();
+        }
+    }
+
     bool MasterSession::tryToSendBroadcast(   const can::CanMessage & msg,
                                               IdFCode fcode,
                                               Priority priority )
@@ -312,6 +776,124 @@ PRAGMA_END
         return true;
    }
 
+    /**************************************************************************************************
+    Описание:  Включает адаптивный таймаут ответа
+    Аргументы: Нижняя граница таймаута, границы паузы для слейва после потери связи
+    Возврат:   Нет
+    Замечания: Таймаут считается для каждого слейва как srtt + 4 * rttvar и зажимается
+               между answer_timeout_min и answer_timeout_max из конструктора.
+               Пока время обмена со слейвом не измерено, используется answer_timeout_max.
+               Потерявший связь слейв пропускается без выхода на шину, пауза растет вдвое
+               с каждой новой потерей, а после паузы проверяется одним запросом без повторов
+    **************************************************************************************************/
+    void MasterSession::setAdaptiveTimeout( uint32_t answer_timeout_min,
+                                            uint32_t backoff_min,
+                                            uint32_t backoff_max )
+    {
+        UMBA_ASSERT( answer_timeout_min <= m_answer_timeout_max );
+        UMBA_ASSERT( backoff_min <= backoff_max );
+
+        m_isTimeoutAdaptive = true;
+        m_answerTimeoutMin = answer_timeout_min;
+        m_backoffMin = backoff_min;
+        m_backoffMax = backoff_max;
+    }
+
+    uint32_t MasterSession::getAnswerTimeout( uint8_t slaveAdr ) const
+    {
+        UMBA_ASSERT( slaveAdr < slaves_links_num );
+
+        const SlaveLink & link = m_links[ slaveAdr ];
+
+        if( ! m_isTimeoutAdaptive || ! link.hasRtt )
+        {
+            return m_answer_timeout_max;
+        }
+
+        // rttvar4 уже равен 4 * rttvar; +1 на дискретность часов
+        uint32_t timeout = ( link.srtt8 >> rtt_shift ) + link.rttvar4 + 1;
+
+        return std::min( std::max( timeout, m_answerTimeoutMin ), m_answer_timeout_max );
+    }
+
+    /**************************************************************************************************
+    Описание:  Учитывает очередное измерение времени обмена со слейвом
+    Аргументы: Адрес слейва, время от отправки запроса до ответа
+    Возврат:   Нет
+    Замечания: Алгоритм Джекобсона: srtt += (rtt - srtt) / 8, rttvar += (|rtt - srtt| - rttvar) / 4
+    **************************************************************************************************/
+    void MasterSession::onRttMeasured( uint8_t slaveAdr, uint32_t rtt )
+    {
+        UMBA_ASSERT( slaveAdr < slaves_links_num );
+
+        SlaveLink & link = m_links[ slaveAdr ];
+
+        if( ! link.hasRtt )
+        {
+            link.srtt8 = rtt << rtt_shift;
+            link.rttvar4 = ( rtt / 2 ) << rttvar_shift;
+            link.hasRtt = true;
+
+            return;
+        }
+
+        int32_t error = (int32_t)rtt - (int32_t)( link.srtt8 >> rtt_shift );
+
+        link.srtt8 = (uint32_t)( (int32_t)link.srtt8 + error );
+
+        uint32_t absError = error < 0 ? (uint32_t)( -error ) : (uint32_t)error;
+
+        link.rttvar4 = link.rttvar4 + absError - ( link.rttvar4 >> rttvar_shift );
+    }
+
+    void MasterSession::onLinkRestored( uint8_t slaveAdr )
+    {
+        UMBA_ASSERT( slaveAdr < slaves_links_num );
+
+        m_links[ slaveAdr ].failuresInRow = 0;
+    }
+
+    void MasterSession::onLinkFailure( uint8_t slaveAdr )
+    {
+        UMBA_ASSERT( slaveAdr < slaves_links_num );
+
+        if( ! m_isTimeoutAdaptive )
+        {
+            return;
+        }
+
+        SlaveLink & link = m_links[ slaveAdr ];
+
+        uint32_t backoff = m_backoffMin;
+
+        for( uint8_t i = 0; i < link.failuresInRow && backoff < m_backoffMax; i++ )
+        {
+            backoff *= 2;
+        }
+
+        link.backoffUntil = m_curCallTime + std::min( backoff, m_backoffMax );
+
+        if( link.failuresInRow < UINT8_MAX )
+        {
+            link.failuresInRow++;
+        }
+    }
+
+    bool MasterSession::isSlaveBackedOff( uint8_t slaveAdr ) const
+    {
+        UMBA_ASSERT( slaveAdr < slaves_links_num );
+
+        const SlaveLink & link = m_links[ slaveAdr ];
+
+        if( ! m_isTimeoutAdaptive || link.failuresInRow == 0 )
+        {
+            return false;
+        }
+
+        // время сравнивается через разность, чтобы пережить переполнение
+        return (int32_t)( m_curCallTime - link.backoffUntil ) < 0;
+    }
+
     // заполнить can фильтры
     void MasterSession::fillFilters()
     {
@@ -368,13 +950,10 @@ PRAGMA_END
         if( reqFcode != ansFcode )
             return false;
 
-        // ни разу не валидный ответ об ошибке
+        // ответ об ошибке: слейв отверг запрос, он уходит в нерелевантные, а запрос закончится таймаутом
         if( answer.length == 0 )
         {
-PRAGMA_SUPPRESS_STATEMENT_UNREACHABLE_BEGIN
-            UMBA_ASSERT_FAIL();
             return false;
-PRAGMA_END
         }
 
         bool result = false;
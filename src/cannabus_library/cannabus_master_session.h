@@ -2,6 +2,8 @@
 
 #include "project_config.h"
 #include "cannabus_common.h"
+#include "cannabus_request_creator.h"
+#include "cannabus_msg_queue.h"
 #include "can/i_can.h"
 #include "callbacks/callbacks.h"
 
@@ -38,6 +40,41 @@ namespace cannabus
 
         void sendRequest( can::CanMessage & request );
 
+        // блочное чтение и запись произвольного диапазона регистров.
+        // Диапазон сам режется на сегменты, сегменты уходят подряд, не прошедшие повторяются отдельно.
+        // Буфер должен жить до вызова onComplete, в который передается успех передачи
+        using OnBulkComplete = callback::Callback<void ( bool isOk )>;
+
+        bool tryStartBulkRead( uint8_t slaveAdr,
+                               uint8_t regNumBegin,
+                               umba::ArrayView<uint8_t> values,
+                               OnBulkComplete onComplete );
+
+        bool tryStartBulkWrite( uint8_t slaveAdr,
+                                uint8_t regNumBegin,
+                                umba::ArrayView<const uint8_t> values,
+                                OnBulkComplete onComplete );
+
+        bool isBulkActive( void ) const
+        {
+            return m_bulk.isActive;
+        }
+
+        // согласование FD-профиля со слейвом: читается диапазон из fd_probe_regs_num регистров начиная с regNumBegin,
+        // эти регистры должны быть у слейва. Классический слейв отвечает на такой запрос ошибкой.
+        // Пока профиль не согласован, со слейвом говорим классическими кадрами.
+        // Одновременно идет одно согласование, следующее можно начать из колбэка
+        using OnProfileNegotiated = callback::Callback<void ( uint8_t slaveAdr, Profile profile )>;
+
+        bool tryStartProfileNegotiation( uint8_t slaveAdr, uint8_t regNumBegin, OnProfileNegotiated onNegotiated );
+
+        Profile getProfile( uint8_t slaveAdr ) const
+        {
+            UMBA_ASSERT( slaveAdr < slaves_links_num );
+
+            return m_links[ slaveAdr ].profile;
+        }
+
         void work(uint32_t curTime);
 
         bool tryToSendBroadcast( const can::CanMessage & msg,
@@ -50,6 +87,30 @@ namespace cannabus
 
         void fillFilters();
 
+        // запрос слейву, на который ответа не ждем (слейв его подавляет, см. SlaveSession::device_specific_no_answer).
+        // Такие запросы встают в очередь и уходят подряд, пока есть свободные ящики, раньше всех остальных
+        bool tryToSendWithoutAnswer( const can::CanMessage & request );
+
+        // запрос со своими колбэками: ответ и потеря связи не уходят в колбэки синхронизатора.
+        // Новый свой запрос принимается только после колбэка предыдущего
+        bool tryToSendOwnRequest( const can::CanMessage & request,
+                                  OnAnswerReceived onAnswer,
+                                  callback::VoidCallback onFailure );
+
+        // адаптивный таймаут ответа по измеренному времени обмена с каждым слейвом
+        void setAdaptiveTimeout( uint32_t answer_timeout_min,
+                                 uint32_t backoff_min = 100,
+                                 uint32_t backoff_max = 5000 );
+
+        uint32_t getAnswerTimeout( uint8_t slaveAdr ) const;
+
+        uint32_t getSmoothedRtt( uint8_t slaveAdr ) const
+        {
+            UMBA_ASSERT( slaveAdr < slaves_links_num );
+
+            return m_links[ slaveAdr ].srtt8 >> rtt_shift;
+        }
+
     protected:
 
         STRONG_ENUM(SessionStates, WAITING_REQUEST,
@@ -60,12 +121,78 @@ namespace cannabus
 
 
 
+        void processState( void );
+
+        // за один вызов work успевает принять ответ и отправить следующий запрос
+        static constexpr uint32_t work_passes_max = 3;
+
         bool isAnswerRelevant( const can::CanMessage & answer, const can::CanMessage & request ) const;
 
         bool isAnswerAdressValid( const uint8_t ansAdr, const uint8_t reqAdr ) const;
 
         bool isMsgHighPrio( const can::CanMessage & msg ) const;
 
+        // состояние связи со слейвом: сглаженное время обмена и пауза после потери связи.
+        // Как в TCP, srtt хранится умноженным на 8, а rttvar - на 4, чтобы обойтись целочисленной арифметикой
+        struct SlaveLink
+        {
+            uint32_t srtt8 = 0;
+            uint32_t rttvar4 = 0;
+            bool hasRtt = false;
+
+            uint8_t failuresInRow = 0;
+            uint32_t backoffUntil = 0;
+
+            Profile profile = Profile::CLASSIC;
+        };
+
+        static constexpr uint32_t slaves_links_num = (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS + 1;
+        static constexpr uint32_t rtt_shift = 3;
+        static constexpr uint32_t rttvar_shift = 2;
+
+        void onRttMeasured( uint8_t slaveAdr, uint32_t rtt );
+        void onLinkRestored( uint8_t slaveAdr );
+        void onLinkFailure( uint8_t slaveAdr );
+        bool isSlaveBackedOff( uint8_t slaveAdr ) const;
+
+        // сегменты блочной передачи отмечаются битами, в 256 регистров их влезает не больше 43
+        struct BulkTransfer
+        {
+            bool isActive = false;
+            bool isWrite = false;
+
+            uint8_t slaveAdr = 0;
+            uint8_t regNumBegin = 0;
+            uint16_t regsNum = 0;
+
+            uint8_t * readValues = nullptr;
+            const uint8_t * writeValues = nullptr;
+
+            Profile profile = Profile::CLASSIC;
+
+            uint8_t segmentsNum = 0;
+            uint8_t currentSegment = 0;
+            uint8_t passesLeft = 0;
+
+            uint64_t pendingSegments = 0;
+            uint64_t failedSegments = 0;
+
+            OnBulkComplete onComplete = {};
+        };
+
+        // кроме первого прохода, не прошедшие сегменты повторяются еще столько раз
+        static constexpr uint8_t bulk_retry_passes_max = 2;
+
+        bool tryStartBulk( uint8_t slaveAdr, uint8_t regNumBegin, uint16_t regsNum, OnBulkComplete onComplete );
+        bool tryGetBulkRequest( void );
+        void getBulkSegment( uint8_t segment, uint16_t & offset, uint8_t & regsNum ) const;
+        void onBulkAnswerReceived( const can::CanMessage & answer );
+        void onBulkFailure( void );
+        void finishBulk( bool isOk );
+
+        void finishProfileNegotiation( Profile profile );
+        void finishOwnRequest( bool isAnswered );
+
         bool isWriteRegsRangeValid( const can::CanMessage & answer, const can::CanMessage & request ) const;
         bool isWriteRegsSeriesValid( const can::CanMessage & answer, const can::CanMessage & request ) const;
         bool isReadRegsRangeValid( const can::CanMessage & answer, const can::CanMessage & request ) const;
@@ -92,6 +219,12 @@ namespace cannabus
         can::CanMessage m_requestBasic = {};
         can::CanMessage m_requestBroadcast = {};
         can::CanMessage m_requestDirect = {};
+        can::CanMessage m_requestBulk = {};
+        can::CanMessage m_requestProbe = {};
+        can::CanMessage m_requestOwn = {};
+
+        static constexpr uint32_t no_answer_queue_size = 8;
+        MsgQueue< no_answer_queue_size > m_noAnswerQueue;
         can::CanMessage * m_actualRequestToSend = nullptr;
 
         can::CanMessage m_answer = {};
@@ -99,6 +232,12 @@ namespace cannabus
         bool m_isRequestPending = false;
         bool m_isBroadcastPending = false;
         bool m_isDirectPending = false;
+        bool m_isProbePending = false;
+        bool m_isOwnPending = false;
+
+        // проба и свой запрос занимают слот от постановки до колбэка, а не только до отправки
+        bool m_isProbeActive = false;
+        bool m_isOwnActive = false;
 
         can::CanMessage m_unexpectedSlaveMsg = {};
 
@@ -112,6 +251,20 @@ namespace cannabus
 
         uint8_t m_repeatsCount = 0;
 
+        // по умолчанию таймаут фиксированный и паузы после потери связи нет
+        bool m_isTimeoutAdaptive = false;
+        uint32_t m_answerTimeoutMin = 0;
+        uint32_t m_backoffMin = 0;
+        uint32_t m_backoffMax = 0;
+
+        // таймаут текущего запроса
+        uint32_t m_answerTimeout = 0;
+
+        SlaveLink m_links[ slaves_links_num ];
+
+        BulkTransfer m_bulk;
+        RequestCreator m_bulkCreator;
+
         SessionStates m_state = SessionStates::WAITING_REQUEST;
 
         callback::VoidCallback m_onConnectionFailure = {};
@@ -120,6 +273,11 @@ namespace cannabus
 
         OnUnexpectedMsgReceived m_onUnexpectedReceived = {};
 
+        OnProfileNegotiated m_onProfileNegotiated = {};
+
+        OnAnswerReceived m_onOwnAnswer = {};
+        callback::VoidCallback m_onOwnFailure = {};
+
     };
 
 } // namespace cannabus
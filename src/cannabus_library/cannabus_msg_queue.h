@@ -0,0 +1,118 @@
+#pragma once
+
+#include "project_config.h"
+#include "can/i_can.h"
+#include "umba_array/umba_array.h"
+#include <atomic>
+
+namespace cannabus
+{
+    // Кольцевая очередь can-сообщений фиксированного размера без выделения памяти.
+    // Один писатель и один читатель (например, прикладная задача и задача сессии) работают без блокировок.
+    // Переполнение не блокирует писателя: сообщение отбрасывается, а счетчик переполнений растет
+    template< uint32_t TSize >
+    class MsgQueue
+    {
+
+    public:
+
+        MsgQueue() = default;
+
+        // копировать запрещено
+        MsgQueue( const MsgQueue & rhs ) = delete;
+        MsgQueue & operator=( MsgQueue & s ) = delete;
+
+        // для писателя
+        bool tryPush( const can::CanMessage & msg )
+        {
+            uint32_t tail = m_tail.load( std::memory_order_relaxed );
+            uint32_t next = getNext( tail );
+
+            if( next == m_head.load( std::memory_order_acquire ) )
+            {
+                m_overflowCount.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+
+            m_buffer[ tail ] = msg;
+
+            m_tail.store( next, std::memory_order_release );
+
+            return true;
+        }
+
+        bool isFull( void ) const
+        {
+            return getNext( m_tail.load( std::memory_order_relaxed ) ) == m_head.load( std::memory_order_acquire );
+        }
+
+        // для читателя
+        bool isEmpty( void ) const
+        {
+            return m_head.load( std::memory_order_relaxed ) == m_tail.load( std::memory_order_acquire );
+        }
+
+        const can::CanMessage & front( void ) const
+        {
+            UMBA_ASSERT( ! isEmpty() );
+
+            return m_buffer[ m_head.load( std::memory_order_relaxed ) ];
+        }
+
+        void pop( void )
+        {
+            UMBA_ASSERT( ! isEmpty() );
+
+            m_head.store( getNext( m_head.load( std::memory_order_relaxed ) ), std::memory_order_release );
+        }
+
+        bool tryPop( can::CanMessage & msg )
+        {
+            if( isEmpty() )
+            {
+                return false;
+            }
+
+            msg = front();
+            pop();
+
+            return true;
+        }
+
+        uint32_t getSize( void ) const
+        {
+            uint32_t head = m_head.load( std::memory_order_acquire );
+            uint32_t tail = m_tail.load( std::memory_order_acquire );
+
+            return ( tail + buffer_size - head ) % buffer_size;
+        }
+
+        static constexpr uint32_t getCapacity( void )
+        {
+            return TSize;
+        }
+
+        uint32_t getOverflowCount( void ) const
+        {
+            return m_overflowCount.load( std::memory_order_relaxed );
+        }
+
+    private:
+
+        // одна ячейка всегда пустая, чтобы отличать полную очередь от пустой
+        static constexpr uint32_t buffer_size = TSize + 1;
+
+        static uint32_t getNext( uint32_t index )
+        {
+            return ( index + 1 ) % buffer_size;
+        }
+
+        umba::Array< can::CanMessage, buffer_size > m_buffer;
+
+        std::atomic<uint32_t> m_head{ 0 };
+        std::atomic<uint32_t> m_tail{ 0 };
+
+        std::atomic<uint32_t> m_overflowCount{ 0 };
+    };
+
+} // namespace cannabus
@@ -1,11 +1,90 @@
 #pragma once
 
 #include "reg_tables/not_type_safe_reg_table.h"
+#include "cannabus_dirty_regs.h"
 
 namespace cannabus
 {
+    // таблица дополнительно ведет битовую карту изменённых rw-регистров,
+    // чтобы Slave не перебирал всю таблицу при сборке каждого запроса
     template < uint8_t TRoRegMin, uint8_t TRoRegMax,
                uint8_t TRwRegMin, uint8_t TRwRegMax>
-    using CannabusRegTable = ::regs::NotTypeSafeRegTable<TRoRegMin, TRoRegMax, TRwRegMin, TRwRegMax>;
-}
+    class CannabusRegTable : public ::regs::NotTypeSafeRegTable<TRoRegMin, TRoRegMax, TRwRegMin, TRwRegMax>
+    {
+        typedef ::regs::NotTypeSafeRegTable<TRoRegMin, TRoRegMax, TRwRegMin, TRwRegMax> Parent;
+
+    public:
+
+        virtual void setRegVal(uint8_t regNum, uint8_t val)
+        {
+            Parent::setRegVal(regNum, val);
+
+            markIfChanged(regNum);
+        }
+
+        virtual void setReg16Val(uint8_t lowRegNum, uint16_t val)
+        {
+            Parent::setReg16Val(lowRegNum, val);
+
+            markIfChanged(lowRegNum);
+        }
+
+        virtual void setReg32Val(uint8_t lowRegNum, uint32_t val)
+        {
+            Parent::setReg32Val(lowRegNum, val);
+
+            markIfChanged(lowRegNum);
+        }
+
+        DirtyRegs & getDirtyRegs(void)
+        {
+            return m_dirtyRegs;
+        }
 
+    private:
+
+        // бит в карте ставится по младшему регистру, если изменился любой байт значения -
+        // иначе Slave собрал бы пакет с середины многобайтного регистра
+        void markIfChanged(uint8_t regNum)
+        {
+            // ro-регистры никуда не отправляются, их отслеживать незачем
+            if( regNum < TRwRegMin || regNum > TRwRegMax )
+            {
+                return;
+            }
+
+            const uint8_t lowRegNum = getLowRegNum(regNum);
+            const uint8_t length = this->getRegLength(lowRegNum);
+
+            for( uint8_t i = 0; i < length; i++ )
+            {
+                if( this->isRegChanged(lowRegNum + i) )
+                {
+                    m_dirtyRegs.mark( lowRegNum, length );
+                    return;
+                }
+            }
+        }
+
+        // границ многобайтных регистров таблица не хранит, поэтому младший регистр ищется
+        // шагами по длинам от начала rw-диапазона; для однобайтных регистров поиска нет
+        uint8_t getLowRegNum(uint8_t regNum)
+        {
+            if( this->getRegLength(regNum) == 1 )
+            {
+                return regNum;
+            }
+
+            uint16_t lowRegNum = TRwRegMin;
+
+            while( lowRegNum + this->getRegLength((uint8_t)lowRegNum) <= regNum )
+            {
+                lowRegNum += this->getRegLength((uint8_t)lowRegNum);
+            }
+
+            return (uint8_t)lowRegNum;
+        }
+
+        DirtyRegs m_dirtyRegs;
+    };
+}
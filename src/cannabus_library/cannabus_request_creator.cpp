@@ -15,8 +15,8 @@ namespace cannabus
         UMBA_ASSERT( regNumEnd >= regNumBegin );
 
         uint8_t regsNum = regNumEnd - regNumBegin + 1;
-        // в сообщении может лежать 6 значений, а диапазон от начала до конца включительно
-        UMBA_ASSERT( regsNum <= max_regs_in_range);
+        // в сообщении может лежать 6 значений (62 в FD), а диапазон от начала до конца включительно
+        UMBA_ASSERT( getRangeRegsFit( m_profile, regsNum ) == regsNum );
 
         request.length = regsNum + 2;
         request.data[0] = regNumBegin;
@@ -35,8 +35,9 @@ namespace cannabus
         //идентификатор собираю
         request.id = makeId( m_deviceAddress, IdFCode::WRITE_REGS_SERIES, msgTypeFromPriority( isHighPrio ) );
 
-        // в cannabus сообщение влезает серия из четырех регистров максимум
-        UMBA_ASSERT( series.size() <= max_regs_in_series );
+        // в cannabus сообщение влезает серия из четырех регистров максимум (32 в FD)
+        UMBA_ASSERT( series.size() <= getMaxRegsInSeries( m_profile ) );
+        UMBA_ASSERT( isFrameLengthValid( m_profile, series.size() * 2 ) );
 
         request.length = series.size() * 2;
 
@@ -60,8 +61,8 @@ namespace cannabus
 
         uint8_t regsNum = regNumEnd - regNumBegin + 1;
 
-        // в сообщении может лежать 6 значений, а диапазон от начала до конца включительно
-        UMBA_ASSERT( regsNum <= max_regs_in_range );
+        // в сообщении может лежать 6 значений (62 в FD), а диапазон от начала до конца включительно
+        UMBA_ASSERT( getRangeRegsFit( m_profile, regsNum ) == regsNum );
 
         request.length = 2;
 
@@ -76,8 +77,8 @@ namespace cannabus
         //идентификатор собираю
         request.id = makeId( m_deviceAddress, IdFCode::READ_REGS_SERIES, msgTypeFromPriority( isHighPrio ) );
 
-        // в cannabus сообщение влезает серия из четырех регистров максимум
-        UMBA_ASSERT( series.size() <= max_regs_in_series );
+        // в cannabus сообщение влезает серия из четырех регистров максимум (32 в FD)
+        UMBA_ASSERT( getSeriesRegsFit( m_profile, series.size() ) == series.size() );
 
         request.length = series.size();
 
@@ -93,7 +94,7 @@ namespace cannabus
                                                  IdFCode fcode,
                                                  bool isHighPrio )
     {
-        UMBA_ASSERT( data.size() <= max_regs_in_specific );
+        UMBA_ASSERT( isFrameLengthValid( m_profile, data.size() ) );
         UMBA_ASSERT( (uint32_t)fcode >= (uint32_t)IdFCode::DEVICE_SPECIFIC1 );
         UMBA_ASSERT( (uint32_t)fcode <= (uint32_t)IdFCode::DEVICE_SPECIFIC4 );
 
@@ -13,11 +13,19 @@ namespace cannabus
 
     public:
 
-        void init( uint8_t deviceAdr )
+        void init( uint8_t deviceAdr, Profile profile = Profile::CLASSIC )
         {
             UMBA_ASSERT( deviceAdr <= (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS );
+            UMBA_ASSERT( isProfileSupported( profile ) );
 
             m_deviceAddress = deviceAdr;
+            m_profile = profile;
+        }
+
+        // FD-профиль доступен, только если драйвер умеет сообщения на 64 байта
+        static constexpr bool isProfileSupported( Profile profile )
+        {
+            return getMaxRegsInSpecific( profile ) <= sizeof( can::CanMessage::data );
         }
 
         struct Register
@@ -48,6 +56,7 @@ namespace cannabus
         }
 
         uint8_t m_deviceAddress = 0;
+        Profile m_profile = Profile::CLASSIC;
 
     };
 
@@ -50,6 +50,94 @@ namespace cannabus
     }
 
 
+    /**************************************************************************************************
+    Описание:  Задает класс обновления для диапазона ro-регистров
+    Аргументы: Первый и последний регистры диапазона, границы интервала опроса
+    Возврат:   -
+    Замечания: Диапазон режется на окна по max_regs_in_range регистров,
+               многобайтный регистр в окно входит целиком, даже если диапазон задевает только его часть
+    **************************************************************************************************/
+    void Slave::addRoRefreshClass( uint8_t regNumBegin, uint8_t regNumEnd, uint32_t minInterval, uint32_t maxInterval )
+    {
+        UMBA_ASSERT( regNumBegin <= regNumEnd );
+        UMBA_ASSERT( regNumBegin >= getSlaveTable()->getRoMinRegNum() );
+        UMBA_ASSERT( regNumEnd <= getSlaveTable()->getRoMaxRegNum() );
+        UMBA_ASSERT( minInterval <= maxInterval );
+
+        // границы класса расширяются до целых регистров: регистр, задетый хоть одним байтом, входит целиком
+        uint16_t windowBegin = getSlaveTable()->getRoMinRegNum();
+
+        while( windowBegin + getSlaveTable()->getRegLength( (uint8_t)windowBegin ) <= regNumBegin )
+        {
+            windowBegin += getSlaveTable()->getRegLength( (uint8_t)windowBegin );
+        }
+
+        while( windowBegin <= regNumEnd )
+        {
+            UMBA_ASSERT( m_roWindowsCount < ro_windows_max );
+
+            uint16_t windowEnd = windowBegin;
+            uint16_t i = windowBegin;
+
+            // набираем регистры, пока они целиком влезают в окно
+            while( i <= regNumEnd )
+            {
+                uint8_t len = getSlaveTable()->getRegLength( (uint8_t)i );
+
+                if( i + len - 1 >= windowBegin + max_regs_in_range )
+                {
+                    break;
+                }
+
+                windowEnd = i + len - 1;
+                i += len;
+            }
+
+            RoWindow & window = m_roWindows[ m_roWindowsCount ];
+
+            window.begin = (uint8_t)windowBegin;
+            window.end = (uint8_t)windowEnd;
+            window.minInterval = minInterval;
+            window.maxInterval = maxInterval;
+            // сначала опрашиваем часто, на стабильных значениях интервал сам вырастет
+            window.interval = minInterval;
+            window.lastUpdateTime = 0;
+
+            m_roWindowsCount++;
+
+            windowBegin = windowEnd + 1;
+        }
+    }
+
+    /**************************************************************************************************
+    Описание:  Задает долю шины для опроса ro-регистров
+    Аргументы: Битрейт шины, доля в процентах
+    Возврат:   -
+    Замечания: Нулевой процент - без ограничений
+    **************************************************************************************************/
+    void Slave::setRoBusBudget( uint32_t bitRate, uint32_t percent )
+    {
+        UMBA_ASSERT( percent <= 100 );
+
+        m_roBudgetBitsPerSecond = bitRate / 100 * percent;
+        m_roBudgetBits = getRoBudgetMax();
+    }
+
+    /**************************************************************************************************
+    Описание:  Предел, до которого копится бюджет шины на опрос ro-регистров
+    Аргументы: -
+    Возврат:   Предел в битах
+    Замечания: Обычно это ro_budget_burst_divider-ая доля секунды, но не меньше стоимости чтения
+               самого длинного окна: иначе при малой доле шины (1% на слейв при 60 слейвах)
+               бюджет никогда не накопится на запрос и опрос встанет навсегда
+    **************************************************************************************************/
+    uint32_t Slave::getRoBudgetMax( void ) const
+    {
+        const uint32_t windowCostMax = getFrameBitsWorstCase( 2 ) + getFrameBitsWorstCase( 2 + max_regs_in_range );
+
+        return std::max( m_roBudgetBitsPerSecond / ro_budget_burst_divider, windowCostMax );
+    }
+
     bool Slave::tryGetRequest(can::CanMessage & req, uint32_t curTime)
     {
         // сначала rw проверяем
@@ -121,10 +209,19 @@ namespace cannabus
         uint8_t regAdrEnd = answer.data[1];
         uint8_t regsTotal = regAdrEnd - regAdrStart + 1;
 
+        bool isChanged = false;
+
         for( uint8_t i = 0; i < regsTotal; i++ )
         {
+            if( getSlaveTable()->getRegVal( regAdrStart + i ) != answer.data[2 + i] )
+            {
+                isChanged = true;
+            }
+
             getSlaveTable()->setRegVal( regAdrStart + i, answer.data[2 + i] );
         }
+
+        adaptRoWindow( answer, isChanged );
     }
 
     /**************************************************************************************************
@@ -160,7 +257,8 @@ namespace cannabus
     Описание:  Пытается собрать rw запрос
     Аргументы: Ссылка на пакет с запросом и время
     Возврат:   Удалось/нет
-    Замечания:
+    Замечания: Для найденного первого изменённого регистра собираются оба варианта пакета -
+               серия и диапазон, - и отправляется тот, что плотнее
     **************************************************************************************************/
     bool Slave::tryGetRwRequest(can::CanMessage & req, uint32_t)
     {
@@ -172,17 +270,6 @@ namespace cannabus
             return true;
         }
 
-        // логика такая - какой первый регистр нашли, такого типа пакет и собираем
-        umba::Array<RequestCreator::Register, max_regs_in_series> series;
-        uint32_t registerLength = 0;
-
-
-        auto fillReg = [this]( RequestCreator::Register & reg, uint8_t regNum )
-            {
-                reg.num = regNum;
-                reg.val = getSlaveTable()->getRegVal( regNum );
-            };
-
         auto firstSingleReg = getFirstReg( getSlaveTable()->getRwMinRegNum() );
 
         // ничего не найдено
@@ -191,98 +278,170 @@ namespace cannabus
             return false;
         }
 
-        // если первый оказался однобайтным, то ищу ему однобайтных коллег для пакетирования
-        if( firstSingleReg.second == 1 )
-        {
-            fillReg( series[0], firstSingleReg.first );
-
-            // сброс флага обновления
-            getSlaveTable()->checkRegUpdate( firstSingleReg.first );
+        umba::Array<RequestCreator::Register, max_regs_in_series> series;
+        uint8_t seriesLength = collectWriteSeries( series, firstSingleReg );
 
-            registerLength = 1;
+        umba::Array<uint8_t, max_regs_in_range> range;
+        uint8_t rangeLength = collectWriteRange( range, firstSingleReg );
 
-            while( registerLength < max_regs_in_series )
+        if( isRangeDenser( rangeLength, seriesLength ) )
+        {
+            // сброс флагов обновления, регистр за регистром
+            for( uint8_t i = 0; i < rangeLength; i += getSlaveTable()->getRegLength( firstSingleReg.first + i ) )
             {
-                auto prevRegNum = series[ registerLength - 1 ].num;
-
-                auto regNum = getNextRegNumToWrite( prevRegNum + 1, 1 );
-
-                // больше нечего слать
-                if( regNum.second == false )
-                {
-                    break;
-                }
+                checkRegUpdate( firstSingleReg.first + i );
+            }
 
-                fillReg( series[registerLength], regNum.first );
+            m_reqCreator.createWriteRange( req,
+                                           firstSingleReg.first,
+                                           firstSingleReg.first + rangeLength - 1,
+                                           umba::ArrayView<const uint8_t>( range.data(), rangeLength ) );
 
-                // сброс флага обновления
-                getSlaveTable()->checkRegUpdate( regNum.first );
+            // серией те же регистры ушли бы за столько пакетов, по два байта на регистр
+            uint32_t seriesFrames = ( rangeLength + max_regs_in_series - 1 ) / max_regs_in_series;
+            uint32_t seriesBits = 0;
 
-                registerLength++;
+            for( uint8_t i = 0; i < rangeLength; i += max_regs_in_series )
+            {
+                seriesBits += getFrameBitsWorstCase( 2 * std::min<uint8_t>( max_regs_in_series, rangeLength - i ) );
             }
-            // на этот момент пакет собран
 
-            m_reqCreator.createWriteSeries( req, umba::ArrayView<const RequestCreator::Register>( series.data(), registerLength ) );
+            // экономия на шине - вместе с заголовками, CRC и стаффингом лишних кадров
+            m_rwFramesSaved += seriesFrames - 1;
+            m_rwBitsSaved += seriesBits - getFrameBitsWorstCase( rangeLength + 2 );
+
             return true;
         }
 
-        // если первый оказался двухбайтным, то ищу ему двухбайтных коллег для пакетирования
-        if( firstSingleReg.second == 2 )
+        // сброс флагов обновления; в серии все регистры одной длины и идут байтами подряд
+        for( uint8_t i = 0; i < seriesLength; i += firstSingleReg.second )
         {
-            fillReg( series[0], firstSingleReg.first );
-            fillReg( series[1], firstSingleReg.first + 1 );
+            checkRegUpdate( series[i].num );
+        }
 
-            // сброс флага обновления
-            getSlaveTable()->checkRegUpdate( firstSingleReg.first );
-            getSlaveTable()->checkRegUpdate( firstSingleReg.first + 1 );
+        m_reqCreator.createWriteSeries( req, umba::ArrayView<const RequestCreator::Register>( series.data(), seriesLength ) );
 
-            registerLength = 2;
+        return true;
+    }
 
-            while( registerLength < max_regs_in_series - 1 )
+    /**************************************************************************************************
+    Описание:  Собирает серию изменённых регистров, начиная с первого найденного
+    Аргументы: Массив для серии, первый изменённый регистр (номер и длина)
+    Возврат:   Количество регистров в серии
+    Замечания: Флаги обновления не сбрасываются.
+               Логика такая - какой первый регистр нашли, такого типа пакет и собираем
+    **************************************************************************************************/
+    uint8_t Slave::collectWriteSeries( umba::Array<RequestCreator::Register, max_regs_in_series> & series,
+                                       std::pair<uint8_t, uint8_t> firstReg )
+    {
+        auto fillReg = [this]( RequestCreator::Register & reg, uint8_t regNum )
             {
-                auto prevRegNum = series[ registerLength - 1 ].num;
+                reg.num = regNum;
+                reg.val = getSlaveTable()->getRegVal( regNum );
+            };
 
-                auto regNum = getNextRegNumToWrite( prevRegNum, 2 );
+        uint8_t registerLength = 0;
 
-                // больше нечего слать
-                if( regNum.second == false )
-                {
-                    break;
-                }
+        // четырехбайтный улетает сразу
+        if( firstReg.second == 4 )
+        {
+            fillReg( series[0], firstReg.first );
+            fillReg( series[1], firstReg.first + 1 );
+            fillReg( series[2], firstReg.first + 2 );
+            fillReg( series[3], firstReg.first + 3 );
+
+            return 4;
+        }
+
+        // однобайтным и двухбайтным ищу коллег той же длины для пакетирования
+        uint8_t length = firstReg.second;
+        uint8_t regNum = firstReg.first;
+
+        while( true )
+        {
+            for( uint8_t i = 0; i < length; i++ )
+            {
+                fillReg( series[registerLength + i], regNum + i );
+            }
 
+            registerLength += length;
 
-                fillReg( series[registerLength], regNum.first );
-                fillReg( series[registerLength + 1], regNum.first + 1 );
+            if( registerLength + length > max_regs_in_series )
+            {
+                break;
+            }
 
-                // сброс флага обновления
-                getSlaveTable()->checkRegUpdate( regNum.first );
-                getSlaveTable()->checkRegUpdate( regNum.first + 1 );
+            // поиск после старшей части предыдущего регистра
+            auto next = getNextRegNumToWrite( series[ registerLength - 1 ].num + 1, length );
 
-                registerLength += 2;
+            // больше нечего слать
+            if( next.second == false )
+            {
+                break;
             }
-            // на этот момент пакет собран
 
-            m_reqCreator.createWriteSeries( req, umba::ArrayView<const RequestCreator::Register>( series.data(), registerLength ) );
-            return true;
+            regNum = next.first;
         }
 
+        return registerLength;
+    }
 
-        // четырехбайтный улетает сразу
-        fillReg( series[0], firstSingleReg.first );
-        fillReg( series[1], firstSingleReg.first + 1 );
-        fillReg( series[2], firstSingleReg.first + 2);
-        fillReg( series[3], firstSingleReg.first + 3 );
-        registerLength = 4;
+    /**************************************************************************************************
+    Описание:  Собирает непрерывный диапазон изменённых регистров, начиная с первого найденного
+    Аргументы: Массив для значений, первый изменённый регистр (номер и длина)
+    Возврат:   Количество регистров в диапазоне
+    Замечания: Флаги обновления не сбрасываются.
+               Многобайтный регистр должен входить в диапазон целиком
+    **************************************************************************************************/
+    uint8_t Slave::collectWriteRange( umba::Array<uint8_t, max_regs_in_range> & range,
+                                      std::pair<uint8_t, uint8_t> firstReg )
+    {
+        uint8_t rangeLength = 0;
+        auto reg = firstReg;
+
+        while( rangeLength + reg.second <= max_regs_in_range )
+        {
+            for( uint8_t i = 0; i < reg.second; i++ )
+            {
+                range[ rangeLength + i ] = getSlaveTable()->getRegVal( reg.first + i );
+            }
 
-        // сброс флага обновления
-        getSlaveTable()->checkRegUpdate( firstSingleReg.first + 0 );
-        getSlaveTable()->checkRegUpdate( firstSingleReg.first + 1 );
-        getSlaveTable()->checkRegUpdate( firstSingleReg.first + 2 );
-        getSlaveTable()->checkRegUpdate( firstSingleReg.first + 3 );
+            rangeLength += reg.second;
 
-        m_reqCreator.createWriteSeries( req, umba::ArrayView<const RequestCreator::Register>( series.data(), registerLength ) );
+            uint16_t nextRegNum = (uint16_t)firstReg.first + rangeLength;
 
-        return true;
+            if( nextRegNum > getSlaveTable()->getRwMaxRegNum() )
+            {
+                break;
+            }
+
+            // следующий регистр должен идти вплотную и тоже ждать записи
+            reg = getFirstReg( (uint8_t)nextRegNum );
+
+            if( reg.second == 0 || reg.first != nextRegNum )
+            {
+                break;
+            }
+        }
+
+        return rangeLength;
+    }
+
+    /**************************************************************************************************
+    Описание:  Выбор между диапазоном и серией
+    Аргументы: Количество регистров в диапазоне и в серии
+    Возврат:   Диапазон выгоднее или нет
+    Замечания: Выгоднее тот пакет, что везет больше регистров. При равенстве - тот, что короче:
+               диапазон из N регистров занимает N + 2 байта, серия - 2 * N байт
+    **************************************************************************************************/
+    bool Slave::isRangeDenser( uint8_t rangeLength, uint8_t seriesLength )
+    {
+        if( rangeLength != seriesLength )
+        {
+            return rangeLength > seriesLength;
+        }
+
+        return rangeLength + 2 < rangeLength * 2;
     }
 
     /**************************************************************************************************
@@ -293,6 +452,11 @@ namespace cannabus
     **************************************************************************************************/
     bool Slave::tryGetRoRequest(can::CanMessage & req, uint32_t curTime)
     {
+        if( m_roWindowsCount != 0 )
+        {
+            return tryGetAdaptiveRoRequest( req, curTime );
+        }
+
         if(curTime - m_lastRoUpdateTime < m_roUpdateInterval)
         {
             return false;
@@ -344,5 +508,122 @@ namespace cannabus
         return true;
     }
 
+    /**************************************************************************************************
+    Описание:  Пытается собрать ro запрос по классам обновления
+    Аргументы: Ссылка на пакет с запросом и время
+    Возврат:   Удалось/нет
+    Замечания: Из окон, у которых вышел интервал, выбирается самое просроченное
+    **************************************************************************************************/
+    bool Slave::tryGetAdaptiveRoRequest(can::CanMessage & req, uint32_t curTime)
+    {
+        uint8_t best = ro_window_none;
+        uint32_t bestLateness = 0;
+
+        for( uint8_t i = 0; i < m_roWindowsCount; i++ )
+        {
+            const RoWindow & window = m_roWindows[i];
+
+            uint32_t elapsed = curTime - window.lastUpdateTime;
+
+            if( elapsed < window.interval )
+            {
+                continue;
+            }
+
+            uint32_t lateness = elapsed - window.interval;
+
+            if( best == ro_window_none || lateness > bestLateness )
+            {
+                best = i;
+                bestLateness = lateness;
+            }
+        }
+
+        if( best == ro_window_none )
+        {
+            return false;
+        }
+
+        RoWindow & window = m_roWindows[ best ];
+
+        if( ! trySpendRoBudget( window.end - window.begin + 1, curTime ) )
+        {
+            return false;
+        }
+
+        window.lastUpdateTime = curTime;
+        m_roPendingWindow = best;
+
+        m_reqCreator.createReadRange( req, window.begin, window.end );
+
+        return true;
+    }
+
+    /**************************************************************************************************
+    Описание:  Списывает из бюджета шины запрос чтения диапазона и ответ на него
+    Аргументы: Количество регистров в диапазоне, время
+    Возврат:   Хватило бюджета или нет
+    Замечания: Бюджет копится не больше, чем до getRoBudgetMax
+    **************************************************************************************************/
+    bool Slave::trySpendRoBudget( uint8_t regsNum, uint32_t curTime )
+    {
+        if( m_roBudgetBitsPerSecond == 0 )
+        {
+            return true;
+        }
+
+        uint64_t gained = (uint64_t)( curTime - m_roBudgetUpdateTime ) * m_roBudgetBitsPerSecond / 1000;
+
+        if( gained != 0 )
+        {
+            m_roBudgetBits = (uint32_t)std::min<uint64_t>( (uint64_t)m_roBudgetBits + gained, getRoBudgetMax() );
+            m_roBudgetUpdateTime = curTime;
+        }
+
+        // запрос - два байта, ответ - два байта и значения
+        const uint32_t cost = getFrameBitsWorstCase( 2 ) + getFrameBitsWorstCase( 2 + regsNum );
+
+        if( m_roBudgetBits < cost )
+        {
+            return false;
+        }
+
+        m_roBudgetBits -= cost;
+
+        return true;
+    }
+
+    /**************************************************************************************************
+    Описание:  Подстраивает интервал опроса окна по ответу на него
+    Аргументы: Ответ, менялись ли значения
+    Возврат:   -
+    Замечания: На изменениях интервал сокращается вдвое, на стабильных значениях растет на четверть
+    **************************************************************************************************/
+    void Slave::adaptRoWindow( const can::CanMessage & answer, bool isChanged )
+    {
+        if( m_roPendingWindow == ro_window_none )
+        {
+            return;
+        }
+
+        RoWindow & window = m_roWindows[ m_roPendingWindow ];
+
+        // ответ не на то окно, которое опрашивали
+        if( window.begin != answer.data[0] || window.end != answer.data[1] )
+        {
+            return;
+        }
+
+        m_roPendingWindow = ro_window_none;
+
+        if( isChanged )
+        {
+            window.interval = std::max( window.minInterval, window.interval / 2 );
+        }
+        else
+        {
+            window.interval = std::min( window.maxInterval, window.interval + window.interval / 4 + 1 );
+        }
+    }
 
 } // namespace cannabus
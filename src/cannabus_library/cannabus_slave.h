@@ -4,6 +4,7 @@
 #include "i_cannabus_reg_table.h"
 #include "can/i_can.h"
 #include "cannabus_request_creator.h"
+#include "cannabus_dirty_regs.h"
 #include <utility>
 #include "umba_array/umba_array.h"
 #include "callbacks/callbacks.h"
@@ -35,11 +36,29 @@ namespace cannabus
         // таблицу тоже создает потомок
         virtual ICannabusRegTable * getSlaveTable() = 0;
 
+        // Битовую карту изменённых регистров отдает потомок, если его таблица её ведет
+        // (CannabusRegTable, TypedRegTable). Без карты rw-регистры ищутся перебором всей таблицы
+        // на каждый запрос, поэтому потомок с такой таблицей обязан переопределить метод -
+        // проще всего унаследоваться от RegTableSlave, где это уже сделано
+        virtual DirtyRegs * getDirtyRegs()
+        {
+            return nullptr;
+        }
+
         UnexpectedMsgHandler processUnexpectedMsg = nullptr;
 
         void init( uint8_t devAddr, uint32_t roUpdateInterval );
 
 
+        // Класс обновления ro-регистров: диапазон опрашивается с интервалом от minInterval до maxInterval.
+        // Пока значения в диапазоне меняются, интервал сокращается, на стабильных - растет.
+        // Вызывать после того, как в таблице заданы длины регистров.
+        // Если ни одного класса не задано, ro-регистры обходятся по очереди с интервалом из init
+        void addRoRefreshClass( uint8_t regNumBegin, uint8_t regNumEnd, uint32_t minInterval, uint32_t maxInterval );
+
+        // Ограничение доли шины, которую может занять опрос ro-регистров этого слейва, в процентах
+        void setRoBusBudget( uint32_t bitRate, uint32_t percent );
+
         void processAnswer( const can::CanMessage & answer );
 
         bool tryGetRequest(can::CanMessage & req, uint32_t curTime);
@@ -65,6 +84,18 @@ namespace cannabus
             return m_slaveAdr;
         }
 
+        // сколько пакетов и бит шины сэкономила запись диапазонами вместо серий;
+        // биты считаются по полной длине кадров (getFrameBitsWorstCase), а не только по данным
+        uint32_t getRwFramesSaved(void) const
+        {
+            return m_rwFramesSaved;
+        }
+
+        uint32_t getRwBitsSaved(void) const
+        {
+            return m_rwBitsSaved;
+        }
+
         DeviceSpecificMsgHandler deviceSpecificFunction = nullptr;
 
     protected:
@@ -86,9 +117,40 @@ namespace cannabus
 
         uint32_t m_connectionFailuresCount = 0;
 
+        uint32_t m_rwFramesSaved = 0;
+        uint32_t m_rwBitsSaved = 0;
+
         uint8_t m_roBeginReg = 0xFF;
         uint8_t m_roEndreg = 0xFF;
 
+        // окно опроса ro-регистров - не больше одного пакета чтения диапазона
+        struct RoWindow
+        {
+            uint8_t begin = 0;
+            uint8_t end = 0;
+
+            uint32_t interval = 0;
+            uint32_t minInterval = 0;
+            uint32_t maxInterval = 0;
+
+            uint32_t lastUpdateTime = 0;
+        };
+
+        static constexpr uint8_t ro_windows_max = 32;
+        static constexpr uint8_t ro_window_none = 0xFF;
+        static constexpr uint32_t ro_budget_burst_divider = 10;
+
+        umba::Array<RoWindow, ro_windows_max> m_roWindows;
+        uint8_t m_roWindowsCount = 0;
+
+        // окно, на которое ждем ответа
+        uint8_t m_roPendingWindow = ro_window_none;
+
+        // бюджет шины в битах: пополняется со временем, тратится на запрос и ответ
+        uint32_t m_roBudgetBitsPerSecond = 0;
+        uint32_t m_roBudgetBits = 0;
+        uint32_t m_roBudgetUpdateTime = 0;
+
         // поля для отправки сообщений без очереди через отдельный метод
         can::CanMessage m_outOfTurnMessage = can::CanMessage();
         bool m_outOfTurnFlag = false;
@@ -97,6 +159,19 @@ namespace cannabus
 
         bool tryGetRwRequest(can::CanMessage & req, uint32_t curTime);
         bool tryGetRoRequest(can::CanMessage & req, uint32_t curTime);
+        bool tryGetAdaptiveRoRequest(can::CanMessage & req, uint32_t curTime);
+
+        bool trySpendRoBudget( uint8_t regsNum, uint32_t curTime );
+        uint32_t getRoBudgetMax( void ) const;
+        void adaptRoWindow( const can::CanMessage & answer, bool isChanged );
+
+        uint8_t collectWriteSeries( umba::Array<RequestCreator::Register, max_regs_in_series> & series,
+                                    std::pair<uint8_t, uint8_t> firstReg );
+
+        uint8_t collectWriteRange( umba::Array<uint8_t, max_regs_in_range> & range,
+                                   std::pair<uint8_t, uint8_t> firstReg );
+
+        static bool isRangeDenser( uint8_t rangeLength, uint8_t seriesLength );
 
 
         auto getNextRegNumToWrite( uint8_t regNum, uint8_t length ) -> std::pair<uint8_t, bool>
@@ -105,14 +180,20 @@ namespace cannabus
             {
                 return std::make_pair( 0, false );
             }
-            for( uint8_t i = regNum; i <= getSlaveTable()->getRwMaxRegNum(); i += getSlaveTable()->getRegLength(i) )
+
+            if( getDirtyRegs() != nullptr )
+            {
+                return getDirtyRegs()->findNext( regNum, length );
+            }
+
+            for( uint32_t i = regNum; i <= getSlaveTable()->getRwMaxRegNum(); i += getSlaveTable()->getRegLength(i) )
             {
-                // если регистр нужной длины, то надо проверить, обновились ли все его части
-                if( ( getSlaveTable()->isRegChanged( i ) ) &&
-                    ( getSlaveTable()->getRegLength(i) == length ) )
+                // если регистр нужной длины, то надо проверить, обновилась ли хоть одна его часть
+                if( ( getSlaveTable()->getRegLength(i) == length ) &&
+                    ( isRegValueChanged( (uint8_t)i ) ) )
                 {
 
-                    return std::make_pair( i, true );
+                    return std::make_pair( (uint8_t)i, true );
                 }
             }
 
@@ -123,16 +204,79 @@ namespace cannabus
         // поиск первого ожидающего записи
         auto getFirstReg( uint8_t regNum ) -> std::pair<uint8_t, uint8_t>
         {
-            for( uint8_t i = regNum; i <= getSlaveTable()->getRwMaxRegNum(); i++ )
+            if( getDirtyRegs() != nullptr )
+            {
+                return getDirtyRegs()->findFirst( regNum );
+            }
+
+            // шагаем по регистрам целиком, чтобы не начать пакет с середины многобайтного
+            for( uint32_t i = regNum; i <= getSlaveTable()->getRwMaxRegNum(); i += getSlaveTable()->getRegLength(i) )
             {
-                if( getSlaveTable()->isRegChanged( i ) )
+                if( isRegValueChanged( (uint8_t)i ) )
                 {
-                    return std::make_pair( i, getSlaveTable()->getRegLength(i) );
+                    return std::make_pair( (uint8_t)i, getSlaveTable()->getRegLength(i) );
                 }
             }
 
             return std::make_pair( 0, 0 );
         }
+
+        // изменился ли хоть один байт регистра, начинающегося с regNum
+        bool isRegValueChanged( uint8_t regNum )
+        {
+            for( uint8_t i = 0; i < getSlaveTable()->getRegLength( regNum ); i++ )
+            {
+                if( getSlaveTable()->isRegChanged( regNum + i ) )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // сброс флагов обновления всех байт регистра и в таблице, и в битовой карте
+        void checkRegUpdate( uint8_t regNum )
+        {
+            for( uint8_t i = 0; i < getSlaveTable()->getRegLength( regNum ); i++ )
+            {
+                getSlaveTable()->checkRegUpdate( regNum + i );
+            }
+
+            if( getDirtyRegs() != nullptr )
+            {
+                getDirtyRegs()->clear( regNum );
+            }
+        }
+    };
+
+
+    // Slave, владеющий таблицей с битовой картой изменённых регистров:
+    // таблицу и карту отдает сам, потомку остается synchronize()
+    template< typename TRegTable >
+    class RegTableSlave : public Slave
+    {
+
+    public:
+
+        virtual ICannabusRegTable * getSlaveTable() override
+        {
+            return &m_table;
+        }
+
+        virtual DirtyRegs * getDirtyRegs() override
+        {
+            return &m_table.getDirtyRegs();
+        }
+
+        TRegTable & getTable()
+        {
+            return m_table;
+        }
+
+    protected:
+
+        TRegTable m_table;
     };
 
 } // namespace cannabus
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "project_config.h"
+#include "cannabus_common.h"
+#include "cannabus_slave.h"
+#include "can/i_can.h"
+#include "umba_array/umba_array.h"
+#include <algorithm>
+
+namespace cannabus
+{
+    // Планировщик запросов к слейвам по алгоритму deficit round robin.
+    // Каждый слейв за круг получает квант шинного времени (в битах), умноженный на его вес,
+    // и может отправлять запросы, пока их стоимость (запрос + ожидаемый ответ) укладывается в накопленный дефицит.
+    // Так слейв с большой грязной rw-таблицей не может выесть шину у остальных,
+    // а круг обхода ограничен суммой квантов - см. getRoundBitsMax().
+    // Отвалившиеся слейвы пропускаются с экспоненциально растущей паузой.
+    template< size_t TSlavesMax >
+    class SlaveScheduler
+    {
+
+    public:
+
+        // квант должен вмещать самый дорогой обмен, иначе слейв может не получить слот за круг
+        explicit SlaveScheduler( uint32_t quantumBits = exchange_bits_max,
+                                 uint32_t backoffMin = 100,
+                                 uint32_t backoffMax = 5000 ) :
+            m_quantumBits( quantumBits ),
+            m_backoffMin( backoffMin ),
+            m_backoffMax( backoffMax )
+        {
+            UMBA_ASSERT( m_quantumBits >= exchange_bits_max );
+            UMBA_ASSERT( m_backoffMin <= m_backoffMax );
+        }
+
+        // копировать запрещено
+        SlaveScheduler( const SlaveScheduler & rhs ) = delete;
+        SlaveScheduler & operator=( SlaveScheduler & s ) = delete;
+
+        void addSlave( Slave & slave, uint32_t weight = 1 )
+        {
+            UMBA_ASSERT( m_slavesCount < TSlavesMax );
+            UMBA_ASSERT( weight != 0 );
+
+            SlaveSlot & slot = m_slots[ m_slavesCount ];
+
+            slot.slave = &slave;
+            slot.weight = weight;
+
+            m_slavesCount++;
+        }
+
+        void setWeight( uint8_t slaveAdr, uint32_t weight )
+        {
+            UMBA_ASSERT( weight != 0 );
+
+            findSlot( slaveAdr ).weight = weight;
+        }
+
+        /**************************************************************************************************
+        Описание:  Выдает следующий запрос по кругу
+        Аргументы: Ссылка на пакет с запросом и время
+        Возврат:   Есть запрос/нет
+        Замечания: Запрос, не влезший в дефицит, остается у слейва до следующего круга
+        **************************************************************************************************/
+        bool tryGetRequest( can::CanMessage & req, uint32_t curTime )
+        {
+            if( m_slavesCount == 0 )
+            {
+                return false;
+            }
+
+            // квант не меньше самого дорогого обмена, так что за полный круг слот получит любой ожидающий
+            for( size_t visited = 0; visited <= m_slavesCount; visited++ )
+            {
+                SlaveSlot & slot = m_slots[ m_current ];
+
+                if( m_isNewVisit )
+                {
+                    m_isNewVisit = false;
+
+                    if( isBackedOff( slot, curTime ) )
+                    {
+                        nextSlot();
+                        continue;
+                    }
+
+                    slot.deficitBits += m_quantumBits * slot.weight;
+                }
+
+                if( ! slot.hasPending )
+                {
+                    slot.hasPending = slot.slave->tryGetRequest( slot.pending, curTime );
+                }
+
+                // слейву нечего слать - неиспользованный дефицит не копится
+                if( ! slot.hasPending )
+                {
+                    slot.deficitBits = 0;
+                    nextSlot();
+                    continue;
+                }
+
+                uint32_t cost = getExchangeBitsWorstCase( slot.pending );
+
+                if( cost > slot.deficitBits )
+                {
+                    nextSlot();
+                    continue;
+                }
+
+                slot.deficitBits -= cost;
+                slot.busBits += cost;
+                slot.hasPending = false;
+
+                req = slot.pending;
+                m_lastSlot = m_current;
+
+                // остаемся на этом слейве, пока у него есть дефицит
+                return true;
+            }
+
+            return false;
+        }
+
+        // ответ на последний выданный запрос получен
+        void onAnswerReceived( void )
+        {
+            if( m_lastSlot >= m_slavesCount )
+            {
+                return;
+            }
+
+            m_slots[ m_lastSlot ].failuresInRow = 0;
+        }
+
+        // на последний выданный запрос так и не ответили - пауза для слейва растет вдвое
+        void onConnectionFailure( uint32_t curTime )
+        {
+            if( m_lastSlot >= m_slavesCount )
+            {
+                return;
+            }
+
+            SlaveSlot & slot = m_slots[ m_lastSlot ];
+
+            uint32_t backoff = m_backoffMin;
+
+            for( uint32_t i = 0; i < slot.failuresInRow && backoff < m_backoffMax; i++ )
+            {
+                backoff *= 2;
+            }
+
+            slot.backoffUntil = curTime + std::min( backoff, m_backoffMax );
+            slot.isBackedOff = true;
+            slot.failuresInRow++;
+            slot.deficitBits = 0;
+
+            // сразу уходим к следующему
+            if( m_lastSlot == m_current )
+            {
+                nextSlot();
+            }
+        }
+
+        // суммарное шинное время, выданное слейву, в битах
+        uint32_t getBusBits( uint8_t slaveAdr )
+        {
+            return findSlot( slaveAdr ).busBits;
+        }
+
+        // верхняя граница длины круга в битах: за это время каждый живой слейв гарантированно получает слот
+        uint32_t getRoundBitsMax( void ) const
+        {
+            uint32_t result = 0;
+
+            for( size_t i = 0; i < m_slavesCount; i++ )
+            {
+                result += m_quantumBits * m_slots[i].weight + exchange_bits_max;
+            }
+
+            return result;
+        }
+
+        /**************************************************************************************************
+        Описание:  Наихудшая стоимость обмена запрос-ответ на шине
+        Аргументы: Запрос
+        Возврат:   Длина запроса и ожидаемого ответа в битах
+        Замечания: Длина ответа выводится из формата запроса, для device-specific берется максимальная
+        **************************************************************************************************/
+        static uint32_t getExchangeBitsWorstCase( const can::CanMessage & req )
+        {
+            uint8_t answerLength = max_regs_in_specific;
+
+            // бродкасты и прямые обращения сюда не попадают, только обычные запросы
+            switch( getFCodeFromId( req.id ) )
+            {
+                case IdFCode::WRITE_REGS_RANGE:
+                    answerLength = 2;
+                    break;
+                case IdFCode::WRITE_REGS_SERIES:
+                    answerLength = req.length / 2;
+                    break;
+                case IdFCode::READ_REGS_RANGE:
+                    answerLength = 2 + req.data[1] - req.data[0] + 1;
+                    break;
+                case IdFCode::READ_REGS_SERIES:
+                    answerLength = req.length * 2;
+                    break;
+                default:
+                    break;
+            }
+
+            return getFrameBitsWorstCase( req.length ) + getFrameBitsWorstCase( answerLength );
+        }
+
+        static constexpr uint32_t exchange_bits_max = 2 * getFrameBitsWorstCase( 8 );
+
+    protected:
+
+        struct SlaveSlot
+        {
+            Slave * slave = nullptr;
+            uint32_t weight = 1;
+
+            uint32_t deficitBits = 0;
+            uint32_t busBits = 0;
+
+            can::CanMessage pending = {};
+            bool hasPending = false;
+
+            uint32_t failuresInRow = 0;
+            uint32_t backoffUntil = 0;
+            bool isBackedOff = false;
+        };
+
+        SlaveSlot & findSlot( uint8_t slaveAdr )
+        {
+            for( size_t i = 0; i < m_slavesCount; i++ )
+            {
+                if( m_slots[i].slave->getAddress() == slaveAdr )
+                {
+                    return m_slots[i];
+                }
+            }
+
+            // такого слейва нет в планировщике
+            UMBA_ASSERT_FAIL();
+
+            return m_slots[0];
+        }
+
+        bool isBackedOff( SlaveSlot & slot, uint32_t curTime )
+        {
+            if( ! slot.isBackedOff )
+            {
+                return false;
+            }
+
+            // время сравнивается через разность, чтобы пережить переполнение
+            if( (int32_t)( curTime - slot.backoffUntil ) < 0 )
+            {
+                return true;
+            }
+
+            slot.isBackedOff = false;
+
+            return false;
+        }
+
+        void nextSlot( void )
+        {
+            m_current++;
+
+            if( m_current >= m_slavesCount )
+            {
+                m_current = 0;
+            }
+
+            m_isNewVisit = true;
+        }
+
+        umba::Array< SlaveSlot, TSlavesMax > m_slots;
+        size_t m_slavesCount = 0;
+
+        size_t m_current = 0;
+        size_t m_lastSlot = TSlavesMax;
+        bool m_isNewVisit = true;
+
+        const uint32_t m_quantumBits = 0;
+        const uint32_t m_backoffMin = 0;
+        const uint32_t m_backoffMax = 0;
+    };
+
+} // namespace cannabus
@@ -9,7 +9,8 @@ namespace cannabus
     Описание:  Воркер для слейва каннабуса
     Аргументы: Время
     Возврат:   -
-    Замечания: -
+    Замечания: Прием, обработка и отправка разнесены очередями: пока ответ ждет свободного ящика,
+               входящие сообщения (бродкасты, высокоприоритетки других слейвов) продолжают разбираться
     **************************************************************************************************/
     void SlaveSession::work( uint32_t curTime )
     {
@@ -17,95 +18,151 @@ namespace cannabus
 
         auto call = []( callback::VoidCallback c ){ if(c)c(); };
 
-        switch( m_state )
+        sendRegChangeNotifications( curTime );
+
+        // забираем из драйвера все, что влезает в очередь приема
+        can::CanMessage received;
+
+        while( ! m_rxQueue.isFull() && m_can->tryToReceive( received ) )
+        {
+            m_rxQueue.tryPush( received );
+        }
+
+        bool isRequestReceived = false;
+
+        while( m_rxQueue.tryPop( m_req ) )
         {
-            case States::WAIT_FOR_REQUEST:
+            // не для нас пакет, игнорим его
+            if( ( isSlaveAddressValid() == false ) && ( isMsgFromMaster() ) )
             {
+                continue;
+            }
 
-                auto result = m_can->tryToReceive( m_req );
-                if( !result )
-                {
-                    if( curTime - m_lastCallTime <= m_request_timeout_max )
-                    {
-                        return;
-                    }
-                    if( ! m_isConnected )
-                    {
-                        return;
-                    }
+            isRequestReceived = true;
 
-                    call( m_onConnectionLost );
+            m_lastCallTime = curTime;
+            process();
 
-                    m_isConnected = false;
-                }
-                else
-                {
-                    // не для нас пакет, игнорим его
-                    if( ( isSlaveAddressValid() == false ) && ( isMsgFromMaster() ) )
-                    {
-                        return;
-                    }
+            call( m_onMessageReceived );
 
-                    m_lastCallTime = curTime;
-                    process();
+            //если не бродкаст - шлём ответ
+            if( ( isAnswerNeeded() == true ) && ( isMsgFromMaster() == true ) )
+            {
+                // если ответы не успевают уйти, этот теряется - мастер повторит запрос по таймауту
+                m_ansQueue.tryPush( m_ans );
+            }
 
-                    call( m_onMessageReceived );
+            // а если связь была потеряна, то находим её
+            if( m_isConnected == false )
+            {
+                m_isConnected = true;
 
-                    //если не бродкаст - шлём ответ
-                    if( ( isAnswerNeeded() == true ) && ( isMsgFromMaster() == true ) )
-                    {
-                        m_state = States::SEND_ANSWER;
-                    }
+                call( m_onConnectionRestored );
+            }
+        }
 
-                    // а если связь была потеряна, то находим её
-                    if( m_isConnected == false )
-                    {
-                        m_isConnected = true;
+        sendQueued();
 
-                        call( m_onConnectionRestored );
-                    }
-                }
+        if( isRequestReceived )
+        {
+            return;
+        }
+
+        if( curTime - m_lastCallTime <= m_request_timeout_max )
+        {
+            return;
+        }
+
+        if( ! m_isConnected )
+        {
+            return;
+        }
+
+        call( m_onConnectionLost );
+
+        m_isConnected = false;
+    }
+
+
+    /**************************************************************************************************
+    Описание:  Отправка из очередей, пока есть свободные ящики
+    Аргументы: -
+    Возврат:   -
+    Замечания: Очереди обходятся по кругу, по одному кадру за ход, и ход начинается с ответа.
+               Так поток высокоприоритеток не может занять все ящики и заморить ответы мастеру,
+               а ответы - высокоприоритетки. Не блокирует
+    **************************************************************************************************/
+    void SlaveSession::sendQueued()
+    {
+        while( true )
+        {
+            bool isAnySent = false;
+
+            if( ! trySendFront( m_ansQueue, isAnySent ) )
+            {
                 return;
             }
-            case States::SEND_ANSWER:
-            {
-                // когда можно будет посылать, тогда пошлем
-                if( m_can->isReadyToTransmit() )
-                {
-                    // отправка представляет собой просто опускание сообщения в буфер, так что это не должно блокировать работу
-                    auto sendState = m_can->transmitMessage( m_ans );
-
-                    if( sendState != can::ReturnState::OK )
-                    {
-                        UMBA_ASSERT_FAIL();
-                    }
 
-                    m_state = States::WAIT_FOR_REQUEST;
-                }
+            if( ! trySendFront( m_txQueue, isAnySent ) )
+            {
                 return;
             }
-            default:
+
+            if( ! trySendFront( m_notifyQueue, isAnySent ) )
             {
-                UMBA_ASSERT_FAIL();
+                return;
             }
 
+            // все очереди пусты
+            if( ! isAnySent )
+            {
+                return;
+            }
         }
-
     }
 
-
     /**************************************************************************************************
     Описание:  Отправка высокоприоритетного сообщения чтения серии
     Аргументы: Массив номеров регистров
-    Возврат:   -
+    Возврат:   Встало ли сообщение в очередь
     Замечания: -
     **************************************************************************************************/
-    void SlaveSession::sendHighPrioMessageSeries( const umba::ArrayView<uint8_t> regNum )
+    bool SlaveSession::sendHighPrioMessageSeries( const umba::ArrayView<uint8_t> regNum )
     {
-        auto cnt = regNum.size();
+        can::CanMessage highPrioMsg;
+
+        fillHighPrioMessageSeries( highPrioMsg, regNum );
 
+        // отправит work(), когда освободится ящик
+        return m_txQueue.tryPush( highPrioMsg );
+    }
+
+    /**************************************************************************************************
+    Описание:  Отправка высокоприоритетного сообщения чтения диапазона
+    Аргументы: Массив номеров регистров
+    Возврат:   Встало ли сообщение в очередь
+    Замечания: -
+    **************************************************************************************************/
+    bool SlaveSession::sendHighPrioMessageRange( uint8_t regNumBegin, uint8_t regNumEnd )
+    {
         can::CanMessage highPrioMsg;
 
+        fillHighPrioMessageRange( highPrioMsg, regNumBegin, regNumEnd );
+
+        // отправит work(), когда освободится ящик
+        return m_txQueue.tryPush( highPrioMsg );
+    }
+
+    /**************************************************************************************************
+    Описание:  Сборка высокоприоритетного сообщения чтения серии
+    Аргументы: Сообщение, массив номеров регистров
+    Возврат:   -
+    Замечания: Значения берутся из таблицы на момент сборки
+    **************************************************************************************************/
+    void SlaveSession::fillHighPrioMessageSeries( can::CanMessage & highPrioMsg, const umba::ArrayView<uint8_t> regNum )
+    {
+        auto cnt = regNum.size();
+
         for( uint8_t i = 0; i < cnt ; i++ )
         {
             highPrioMsg.data[2 * i] = regNum[i];
@@ -116,26 +173,21 @@ namespace cannabus
         highPrioMsg.length = cnt * 2;
 
         highPrioMsg.id = makeId( m_slaveAdr, IdFCode::READ_REGS_SERIES, IdMsgTypes::HIGH_PRIO_SLAVE );
-        
-        //посылать до тех пор, пока не смогу
-        sendAnswerForcedly( highPrioMsg );
     }
 
     /**************************************************************************************************
-    Описание:  Отправка высокоприоритетного сообщения чтения диапазона
-    Аргументы: Массив номеров регистров
+    Описание:  Сборка высокоприоритетного сообщения чтения диапазона
+    Аргументы: Сообщение, первый и последний регистры
     Возврат:   -
-    Замечания: -
+    Замечания: Значения берутся из таблицы на момент сборки
     **************************************************************************************************/
-    void SlaveSession::sendHighPrioMessageRange( uint8_t regNumBegin, uint8_t regNumEnd )
+    void SlaveSession::fillHighPrioMessageRange( can::CanMessage & highPrioMsg, uint8_t regNumBegin, uint8_t regNumEnd )
     {
         auto len = regNumEnd - regNumBegin + 1;
 
         UMBA_ASSERT( regNumBegin <= regNumEnd );
         UMBA_ASSERT( len <= max_regs_in_range );
 
-        can::CanMessage highPrioMsg;
-
         highPrioMsg.data[0] = regNumBegin;
         highPrioMsg.data[1] = regNumEnd;
 
@@ -147,19 +199,16 @@ namespace cannabus
         highPrioMsg.length = len + 2;
 
         highPrioMsg.id = makeId( m_slaveAdr, IdFCode::READ_REGS_RANGE, IdMsgTypes::HIGH_PRIO_SLAVE );
-
-        //посылать до тех пор, пока не смогу
-        sendAnswerForcedly( highPrioMsg );
     }
 
 
     /**************************************************************************************************
     Описание:  Отправка высокоприоритетного сообщения device-specific
     Аргументы: Массив номеров регистров
-    Возврат:   -
+    Возврат:   Встало ли сообщение в очередь
     Замечания: -
     **************************************************************************************************/
-    void SlaveSession::sendHighPrioMessageDeviceSpecific( IdFCode fcode, umba::ArrayView<uint8_t> data )
+    bool SlaveSession::sendHighPrioMessageDeviceSpecific( IdFCode fcode, umba::ArrayView<uint8_t> data )
     {
         auto cnt = data.size();
         UMBA_ASSERT( cnt <= max_regs_in_specific );
@@ -175,8 +224,259 @@ namespace cannabus
 
         highPrioMsg.id = makeId( m_slaveAdr, fcode, IdMsgTypes::HIGH_PRIO_SLAVE );
 
-        //посылать до тех пор, пока не смогу
-        sendAnswerForcedly( highPrioMsg );
+        // отправит work(), когда освободится ящик
+        return m_txQueue.tryPush( highPrioMsg );
+    }
+
+
+    /**************************************************************************************************
+    Описание:  Отметить регистр как изменённый для отложенного уведомления мастера
+    Аргументы: Номер регистра
+    Возврат:   -
+    Замечания: Повторные изменения за окно сливаются в одно уведомление
+    **************************************************************************************************/
+    void SlaveSession::notifyRegChanged( uint8_t regNum )
+    {
+        m_notifyRegs[ regNum / 32 ].fetch_or( 1u << ( regNum % 32 ), std::memory_order_release );
+    }
+
+    void SlaveSession::notifyRegsChanged( uint8_t regNumBegin, uint8_t regNumEnd )
+    {
+        UMBA_ASSERT( regNumBegin <= regNumEnd );
+
+        for( uint16_t i = regNumBegin; i <= regNumEnd; i++ )
+        {
+            notifyRegChanged( (uint8_t)i );
+        }
+    }
+
+    /**************************************************************************************************
+    Описание:  Отправка накопленных уведомлений об изменении регистров
+    Аргументы: Время
+    Возврат:   -
+    Замечания: Регистры обходятся целиком, по длинам из таблицы: если отмечен любой байт многобайтного
+               регистра, уходит весь регистр, и одно значение никогда не делится между двумя кадрами.
+               Непрерывные участки от трех регистров уходят диапазонами (N + 2 байта),
+               одиночные и пары собираются в общие серии (2 байта на регистр).
+               Уведомления идут через собственную очередь, в которую пишет и из которой читает только work(),
+               поэтому с прикладными sendHighPrio* они не соревнуются за одну очередь.
+               Если очередь заполнена, неотправленное возвращается в набор до следующего вызова
+    **************************************************************************************************/
+    void SlaveSession::sendRegChangeNotifications( uint32_t curTime )
+    {
+        if( ! m_isCoalescing )
+        {
+            bool isAnyChanged = false;
+
+            for( auto & word : m_notifyRegs )
+            {
+                if( word.load( std::memory_order_relaxed ) != 0 )
+                {
+                    isAnyChanged = true;
+                    break;
+                }
+            }
+
+            if( ! isAnyChanged )
+            {
+                return;
+            }
+
+            // окно открывается с первым замеченным изменением
+            m_isCoalescing = true;
+            m_coalesceStart = curTime;
+        }
+
+        if( curTime - m_coalesceStart < m_coalesceWindow )
+        {
+            return;
+        }
+
+        m_isCoalescing = false;
+
+        // забираем набор целиком, новые изменения попадут уже в следующее окно
+        uint32_t regs[ notify_words_num ];
+
+        for( uint32_t i = 0; i < notify_words_num; i++ )
+        {
+            regs[i] = m_notifyRegs[i].exchange( 0, std::memory_order_acquire );
+        }
+
+        auto isMarked = [&regs]( uint16_t regNum )
+        {
+            return ( regs[ regNum / 32 ] & ( 1u << ( regNum % 32 ) ) ) != 0;
+        };
+
+        auto unmark = [&regs]( uint16_t regNumBegin, uint16_t regNumEnd )
+        {
+            for( uint16_t i = regNumBegin; i <= regNumEnd; i++ )
+            {
+                regs[ i / 32 ] &= ~( 1u << ( i % 32 ) );
+            }
+        };
+
+        // отмечен ли хоть один байт регистра
+        auto isRegMarked = [&isMarked]( uint16_t regNum, uint8_t length )
+        {
+            for( uint8_t i = 0; i < length; i++ )
+            {
+                if( isMarked( regNum + i ) )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        umba::Array< uint8_t, max_regs_in_series > series;
+        uint8_t seriesLength = 0;
+        bool isQueueFull = false;
+
+        auto flushSeries = [&]()
+        {
+            if( seriesLength == 0 || isQueueFull )
+            {
+                return;
+            }
+
+            can::CanMessage highPrioMsg;
+            fillHighPrioMessageSeries( highPrioMsg, umba::ArrayView<uint8_t>( series.data(), seriesLength ) );
+
+            if( ! m_notifyQueue.tryPush( highPrioMsg ) )
+            {
+                isQueueFull = true;
+                return;
+            }
+
+            for( uint8_t i = 0; i < seriesLength; i++ )
+            {
+                unmark( series[i], series[i] );
+            }
+
+            seriesLength = 0;
+        };
+
+        // участок из подряд идущих отмеченных регистров; границы совпадают с границами регистров
+        auto flushRun = [&]( uint16_t runBegin, uint16_t runEnd )
+        {
+            uint16_t regNum = runBegin;
+
+            // длинный участок режется на диапазоны по целым регистрам, короткий хвост уходит в серию
+            while( runEnd - regNum + 1 >= 3 && ! isQueueFull )
+            {
+                uint16_t chunkEnd = regNum;
+
+                for( uint16_t i = regNum; i <= runEnd; i += m_table->getRegLength( (uint8_t)i ) )
+                {
+                    uint16_t regEnd = i + m_table->getRegLength( (uint8_t)i ) - 1;
+
+                    if( regEnd >= regNum + max_regs_in_range )
+                    {
+                        break;
+                    }
+
+                    chunkEnd = regEnd;
+                }
+
+                can::CanMessage highPrioMsg;
+                fillHighPrioMessageRange( highPrioMsg, (uint8_t)regNum, (uint8_t)chunkEnd );
+
+                if( ! m_notifyQueue.tryPush( highPrioMsg ) )
+                {
+                    isQueueFull = true;
+                    return;
+                }
+
+                unmark( regNum, chunkEnd );
+
+                regNum = chunkEnd + 1;
+            }
+
+            while( regNum <= runEnd && ! isQueueFull )
+            {
+                uint8_t length = m_table->getRegLength( (uint8_t)regNum );
+
+                // регистр целиком не влезает в начатую серию - она уходит, регистр начинает новую
+                if( seriesLength + length > max_regs_in_series )
+                {
+                    flushSeries();
+
+                    // серия не ушла и не освободилась - регистр остается отмеченным до следующего окна
+                    if( isQueueFull )
+                    {
+                        return;
+                    }
+                }
+
+                for( uint8_t i = 0; i < length; i++ )
+                {
+                    series[ seriesLength ] = (uint8_t)( regNum + i );
+                    seriesLength++;
+                }
+
+                regNum += length;
+            }
+        };
+
+        // обходим ro- и rw-регистры таблицы по целым регистрам
+        const uint16_t sections[2][2] =
+        {
+            { m_table->getRoMinRegNum(), m_table->getRoMaxRegNum() },
+            { m_table->getRwMinRegNum(), m_table->getRwMaxRegNum() }
+        };
+
+        for( const auto & section : sections )
+        {
+            bool isRunStarted = false;
+            uint16_t runBegin = 0;
+            uint16_t runEnd = 0;
+
+            for( uint16_t regNum = section[0]; regNum <= section[1] && ! isQueueFull; )
+            {
+                uint8_t length = m_table->getRegLength( (uint8_t)regNum );
+
+                if( isRegMarked( regNum, length ) )
+                {
+                    if( ! isRunStarted )
+                    {
+                        isRunStarted = true;
+                        runBegin = regNum;
+                    }
+
+                    runEnd = regNum + length - 1;
+                }
+                else if( isRunStarted )
+                {
+                    isRunStarted = false;
+                    flushRun( runBegin, runEnd );
+                }
+
+                regNum += length;
+            }
+
+            if( isRunStarted )
+            {
+                flushRun( runBegin, runEnd );
+            }
+        }
+
+        flushSeries();
+
+        // не влезшее в очередь возвращаем в набор, окно для него откроется заново;
+        // отметки вне таблицы отправить нельзя, они просто отбрасываются
+        if( ! isQueueFull )
+        {
+            return;
+        }
+
+        for( uint32_t i = 0; i < notify_words_num; i++ )
+        {
+            if( regs[i] != 0 )
+            {
+                m_notifyRegs[i].fetch_or( regs[i], std::memory_order_release );
+            }
+        }
     }
 
 
@@ -271,6 +571,7 @@ namespace cannabus
 
         //если что-то пойдёт не так, то надо будет отвечать сообщением с длиной 0
         m_ans.length = 0;
+        m_isAnswerSuppressed = false;
 
         auto isRequestValid = false;
 
@@ -351,7 +652,7 @@ namespace cannabus
         if( regAdrEnd < regAdrStart )
             return false;
 
-        if( regsTotal > max_regs_in_range )
+        if( getRangeRegsFit( m_profile, regsTotal ) != regsTotal )
             return false;
 
         //проверяем, что регистры RW
@@ -396,6 +697,10 @@ namespace cannabus
         if( m_req.length % 2 != 0 )
             return false;
 
+        // ответ - номера регистров, он тоже должен быть кадром допустимой длины
+        if( ! isFrameLengthValid( m_profile, m_req.length / 2 ) )
+            return false;
+
         for( uint8_t i = 0; i < m_req.length; i += 2 )
         {
             if( !m_table->isRegNumRw( m_req.data[i] ) )
@@ -446,7 +751,7 @@ namespace cannabus
         if( regAdrEnd < regAdrStart )
             return false;
 
-        if( regsTotal > max_regs_in_range )
+        if( getRangeRegsFit( m_profile, regsTotal ) != regsTotal )
             return false;
 
 
@@ -490,7 +795,7 @@ namespace cannabus
     **************************************************************************************************/
     bool SlaveSession::readRegsSeries()
     {
-        if( m_req.length > max_regs_in_series )
+        if( getSeriesRegsFit( m_profile, m_req.length ) != m_req.length )
             return false;
 
         if( m_req.length <= 0 )
@@ -527,7 +832,7 @@ namespace cannabus
         UMBA_ASSERT( (uint32_t)fcode <= (uint32_t)IdFCode::DEVICE_SPECIFIC4 );
 
 
-        if( m_req.length > cannabus::max_regs_in_specific )
+        if( m_req.length > getMaxRegsInSpecific( m_profile ) )
             return false;
         if( m_req.length == 0 )
             return false;
@@ -536,10 +841,16 @@ namespace cannabus
         if( m_deviceSpecificHandlers[ (uint32_t)fcode - (uint32_t)IdFCode::DEVICE_SPECIFIC1 ] )
         {
             umba::ArrayView<uint8_t> req( m_req.data, m_req.length );
-            umba::ArrayView<uint8_t> ans( m_ans.data, cannabus::max_regs_in_specific );
+            umba::ArrayView<uint8_t> ans( m_ans.data, getMaxRegsInSpecific( m_profile ) );
             
             auto length = m_deviceSpecificHandlers[ (uint32_t)fcode - (uint32_t)IdFCode::DEVICE_SPECIFIC1 ]( req, ans );
 
+            if( length == device_specific_no_answer )
+            {
+                m_isAnswerSuppressed = true;
+                length = 0;
+            }
+
             m_ans.length = length;
 
             return true;
@@ -569,6 +880,11 @@ namespace cannabus
     **************************************************************************************************/
     bool SlaveSession::isAnswerNeeded() const
     {
+        if( m_isAnswerSuppressed )
+        {
+            return false;
+        }
+
         return ( getAddressFromId( m_req.id ) != (uint32_t)IdAddresses::BROADCAST );
     }
 
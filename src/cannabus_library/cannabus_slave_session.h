@@ -6,6 +6,7 @@
 #include "can/i_can.h"
 #include "i_cannabus_reg_table.h"
 #include "cannabus_common.h"
+#include "cannabus_msg_queue.h"
 #include <algorithm>
 #include "umba_array/umba_array.h"
 
@@ -54,9 +55,54 @@ namespace cannabus
             void work(uint32_t curTime);
             
             
-            void sendHighPrioMessageSeries( umba::ArrayView<uint8_t> regNum );
-            void sendHighPrioMessageRange( uint8_t regNumBegin, uint8_t regNumEnd );
-            void sendHighPrioMessageDeviceSpecific( IdFCode fcode, umba::ArrayView<uint8_t> data );
+            // высокоприоритетные сообщения не отправляются сразу, а встают в очередь, которую разгребает work().
+            // Вызывающий не блокируется; если очередь заполнена, сообщение отбрасывается и возвращается false.
+            // У очереди один писатель: вызывать эти методы можно только из одной задачи
+            // (уведомления notifyRegChanged идут через свою очередь и ей не мешают)
+            bool sendHighPrioMessageSeries( umba::ArrayView<uint8_t> regNum );
+            bool sendHighPrioMessageRange( uint8_t regNumBegin, uint8_t regNumEnd );
+            bool sendHighPrioMessageDeviceSpecific( IdFCode fcode, umba::ArrayView<uint8_t> data );
+
+            // сколько высокоприоритетных сообщений не влезло в очереди
+            uint32_t getTxOverflowCount() const
+            {
+                return m_txQueue.getOverflowCount() + m_notifyQueue.getOverflowCount();
+            }
+
+            uint32_t getTxQueueSize() const
+            {
+                return m_txQueue.getSize() + m_notifyQueue.getSize();
+            }
+
+            // сколько ответов потерялось из-за того, что предыдущие не успели уйти
+            uint32_t getAnswerOverflowCount() const
+            {
+                return m_ansQueue.getOverflowCount();
+            }
+
+            // Отложенные уведомления об изменении регистров.
+            // Номера изменённых регистров копятся в течение окна, затем work() отправляет их минимальным
+            // набором высокоприоритетных диапазонов и серий с актуальными на момент отправки значениями.
+            // Многобайтный регистр достаточно отметить любым байтом, уйдет он целиком и в одном кадре.
+            // Отмечать можно из любой задачи
+            void setHighPrioCoalesceWindow( uint32_t window )
+            {
+                m_coalesceWindow = window;
+            }
+
+            void notifyRegChanged( uint8_t regNum );
+            void notifyRegsChanged( uint8_t regNumBegin, uint8_t regNumEnd );
+
+            // FD-слейв принимает запросы до 62 регистров и отвечает на них кадрами до 64 байт.
+            // Мастер узнает об этом сам, прочитав диапазон больше классического (см. MasterSession),
+            // классическим мастерам слейв по-прежнему отвечает классическими кадрами.
+            // Высокоприоритетки всегда классические: неизвестно, все ли слушатели умеют FD
+            void setProfile( Profile profile )
+            {
+                UMBA_ASSERT( getMaxRegsInSpecific( profile ) <= sizeof( can::CanMessage::data ) );
+
+                m_profile = profile;
+            }
 
             void setTimeout( uint32_t lostLinkTimeout )
             {
@@ -64,7 +110,10 @@ namespace cannabus
             }
             
             // на вход принимает принятый запрос и ссылку на массив с ответом, который надо сделать
-            // возвращает длину ответа
+            // возвращает длину ответа; device_specific_no_answer - не отвечать вовсе
+            // (например, на кадры данных потоковой передачи, подтверждаемые пачкой)
+            static constexpr uint8_t device_specific_no_answer = 0xFF;
+
             using DeviceSpecificHandler = callback::Callback< uint8_t ( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer ) >;
 
             // метод для задания колбека на обработку приема и отправки device-specific сообщений
@@ -92,8 +141,6 @@ namespace cannabus
 
         private:
 
-            enum class States{WAIT_FOR_REQUEST, SEND_ANSWER};
-
             void process();
             bool writeRegsRange();
             bool writeRegsSeries();
@@ -108,17 +155,37 @@ namespace cannabus
 
             bool isSlaveAddressValid() const;
 
-            void sendAnswerForcedly( const can::CanMessage & forcedMsg ) const
+            void sendQueued();
+
+            // Отправка первого кадра очереди, если она не пуста.
+            // Возвращает false, если ящиков больше нет; isSent выставляется, если кадр ушел
+            template< uint32_t TSize >
+            bool trySendFront( MsgQueue< TSize > & queue, bool & isSent )
             {
-                can::ReturnState result = can::ReturnState::ERROR;
+                if( queue.isEmpty() )
+                {
+                    return true;
+                }
 
-                while( result != can::ReturnState::OK )
+                if( ! m_can->isReadyToTransmit() )
                 {
-                    result = m_can->transmitMessage( forcedMsg );
+                    return false;
                 }
+
+                if( m_can->transmitMessage( queue.front() ) != can::ReturnState::OK )
+                {
+                    return false;
+                }
+
+                queue.pop();
+                isSent = true;
+
+                return true;
             }
+            void sendRegChangeNotifications( uint32_t curTime );
 
-            States m_state = States::WAIT_FOR_REQUEST;
+            void fillHighPrioMessageSeries( can::CanMessage & highPrioMsg, umba::ArrayView<uint8_t> regNum );
+            void fillHighPrioMessageRange( can::CanMessage & highPrioMsg, uint8_t regNumBegin, uint8_t regNumEnd );
 
             uint32_t m_request_timeout_max = 0;
 
@@ -140,10 +207,41 @@ namespace cannabus
             can::CanMessage m_req = {};
             can::CanMessage m_ans = {};
 
+            static constexpr uint32_t tx_queue_size = 8;
+            static constexpr uint32_t notify_queue_size = 8;
+            static constexpr uint32_t rx_queue_size = 8;
+            // ответов бывает не больше, чем принятых запросов
+            static constexpr uint32_t answer_queue_size = rx_queue_size;
+
+            // высокоприоритетные сообщения прикладного кода
+            MsgQueue< tx_queue_size > m_txQueue;
+
+            // уведомления об изменении регистров; пишет и читает только work()
+            MsgQueue< notify_queue_size > m_notifyQueue;
+
+            // принятые, но еще не обработанные сообщения
+            MsgQueue< rx_queue_size > m_rxQueue;
+
+            // ответы, ждущие свободного ящика
+            MsgQueue< answer_queue_size > m_ansQueue;
+
+            static constexpr uint32_t notify_words_num = 256 / 32;
+
+            // регистры, об изменении которых надо сообщить; пишется из прикладного кода, читается в work()
+            std::atomic<uint32_t> m_notifyRegs[ notify_words_num ] = {};
+
+            uint32_t m_coalesceWindow = 0;
+            uint32_t m_coalesceStart = 0;
+            bool m_isCoalescing = false;
+
             umba::Array< DeviceSpecificHandler, device_specific_functions_num > m_deviceSpecificHandlers = {};
 
             bool m_isInited = false;
 
+            bool m_isAnswerSuppressed = false;
+
+            Profile m_profile = Profile::CLASSIC;
+
             uint32_t m_anotherSlaveNumber = 0;
 
             HighPrioSlaveCallback m_anotherSlaveMsgHandler{};
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "project_config.h"
+#include "i_cannabus_reg_table.h"
+#include "cannabus_dirty_regs.h"
+#include <cstring>
+#include <type_traits>
+
+namespace cannabus
+{
+    enum class RegAccess{ RO, RW };
+
+    // Описание регистра карты: номер младшего регистра, тип значения и доступ.
+    // Длина в регистрах равна размеру типа, поэтому 16- и 32-битные значения
+    // не надо собирать по байтам через setReg16Val/setReg32Val
+    template< uint8_t TRegNum, typename TValue, RegAccess TAccess >
+    struct Reg
+    {
+        static_assert( sizeof( TValue ) == 1 || sizeof( TValue ) == 2 || sizeof( TValue ) == 4,
+                       "Регистр cannabus бывает длиной 1, 2 или 4 байта" );
+        static_assert( std::is_trivially_copyable< TValue >::value,
+                       "Значение регистра копируется побайтно" );
+        static_assert( TRegNum + sizeof( TValue ) - 1 <= UINT8_MAX,
+                       "Регистр выходит за пределы таблицы" );
+
+        using Value = TValue;
+
+        static constexpr uint8_t num = TRegNum;
+        static constexpr uint8_t length = sizeof( TValue );
+        static constexpr RegAccess access = TAccess;
+    };
+
+    template< uint8_t TRegNum, typename TValue >
+    using RoReg = Reg< TRegNum, TValue, RegAccess::RO >;
+
+    template< uint8_t TRegNum, typename TValue >
+    using RwReg = Reg< TRegNum, TValue, RegAccess::RW >;
+
+
+    // Таблица регистров, карта которой целиком известна при компиляции.
+    // Типизированные get/set сводятся к обращению к массиву по константному индексу,
+    // а длины и границы многобайтных регистров лежат в таблице, посчитанной компилятором.
+    // Неописанные регистры из диапазонов считаются однобайтными.
+    // Для сессий и синхронизатора таблица остается ICannabusRegTable.
+    //
+    // Значения хранятся младшим байтом вперед, как и в протоколе;
+    // на целевых контроллерах и хосте порядок байт такой же
+    template< uint8_t TRoRegMin, uint8_t TRoRegMax,
+              uint8_t TRwRegMin, uint8_t TRwRegMax,
+              typename ... TRegs >
+    class TypedRegTable : public ICannabusRegTable
+    {
+
+    public:
+
+        TypedRegTable( void ) = default;
+
+        // копировать запрещено
+        TypedRegTable( const TypedRegTable & rhs ) = delete;
+        TypedRegTable & operator=( TypedRegTable & s ) = delete;
+
+        // типизированный доступ
+        template< typename TReg >
+        typename TReg::Value get( void ) const
+        {
+            static_assert( isRegInMap< TReg >(), "Регистра нет в карте" );
+
+            typename TReg::Value value;
+            std::memcpy( &value, &m_values[ TReg::num ], TReg::length );
+
+            return value;
+        }
+
+        template< typename TReg >
+        void set( typename TReg::Value value )
+        {
+            static_assert( isRegInMap< TReg >(), "Регистра нет в карте" );
+
+            std::memcpy( &m_values[ TReg::num ], &value, TReg::length );
+
+            markChanged( TReg::num, TReg::length, TReg::access == RegAccess::RW );
+        }
+
+        template< typename TReg >
+        bool checkUpdate( void )
+        {
+            static_assert( isRegInMap< TReg >(), "Регистра нет в карте" );
+
+            bool isChanged = false;
+
+            for( uint8_t i = 0; i < TReg::length; i++ )
+            {
+                isChanged |= checkRegUpdate( TReg::num + i );
+            }
+
+            return isChanged;
+        }
+
+        static constexpr uint8_t getLength( uint8_t regNum )
+        {
+            return layout.lengths[ regNum ];
+        }
+
+        static constexpr bool isRw( uint8_t regNum )
+        {
+            return regNum >= TRwRegMin && regNum <= TRwRegMax;
+        }
+
+        static constexpr bool isValid( uint8_t regNum )
+        {
+            return isRw( regNum ) || ( regNum >= TRoRegMin && regNum <= TRoRegMax );
+        }
+
+        DirtyRegs & getDirtyRegs( void )
+        {
+            return m_dirtyRegs;
+        }
+
+        // ICannabusRegTable
+        virtual uint8_t getRegVal( uint8_t regNum )
+        {
+            UMBA_ASSERT( isValid( regNum ) );
+
+            return m_values[ regNum ];
+        }
+
+        virtual void setRegVal( uint8_t regNum, uint8_t val )
+        {
+            UMBA_ASSERT( isValid( regNum ) );
+
+            m_values[ regNum ] = val;
+
+            markChanged( regNum, 1, isRw( regNum ) );
+        }
+
+        virtual uint16_t getReg16Val( uint8_t lowRegNum )
+        {
+            UMBA_ASSERT( isValid( lowRegNum ) );
+
+            return (uint16_t)( m_values[ lowRegNum ] | m_values[ lowRegNum + 1 ] << 8 );
+        }
+
+        virtual void setReg16Val( uint8_t lowRegNum, uint16_t val )
+        {
+            UMBA_ASSERT( isValid( lowRegNum ) );
+
+            m_values[ lowRegNum ] = (uint8_t)val;
+            m_values[ lowRegNum + 1 ] = (uint8_t)( val >> 8 );
+
+            markChanged( lowRegNum, 2, isRw( lowRegNum ) );
+        }
+
+        virtual uint32_t getReg32Val( uint8_t lowRegNum )
+        {
+            UMBA_ASSERT( isValid( lowRegNum ) );
+
+            return (uint32_t)m_values[ lowRegNum ] |
+                   (uint32_t)m_values[ lowRegNum + 1 ] << 8 |
+                   (uint32_t)m_values[ lowRegNum + 2 ] << 16 |
+                   (uint32_t)m_values[ lowRegNum + 3 ] << 24;
+        }
+
+        virtual void setReg32Val( uint8_t lowRegNum, uint32_t val )
+        {
+            UMBA_ASSERT( isValid( lowRegNum ) );
+
+            m_values[ lowRegNum ] = (uint8_t)val;
+            m_values[ lowRegNum + 1 ] = (uint8_t)( val >> 8 );
+            m_values[ lowRegNum + 2 ] = (uint8_t)( val >> 16 );
+            m_values[ lowRegNum + 3 ] = (uint8_t)( val >> 24 );
+
+            markChanged( lowRegNum, 4, isRw( lowRegNum ) );
+        }
+
+        virtual bool isRegChanged( uint8_t regNum )
+        {
+            return ( m_changed[ regNum / word_bits ] & getBit( regNum ) ) != 0;
+        }
+
+        virtual bool checkRegUpdate( uint8_t regNum )
+        {
+            bool isChanged = isRegChanged( regNum );
+
+            m_changed[ regNum / word_bits ] &= ~getBit( regNum );
+
+            return isChanged;
+        }
+
+        virtual uint8_t getRegLength( uint8_t regNum )
+        {
+            return getLength( regNum );
+        }
+
+        // длины заданы картой; менять их на ходу нельзя
+        virtual void setRegLength( uint8_t regNum, uint8_t length )
+        {
+            UMBA_ASSERT( getLength( regNum ) == length );
+        }
+
+        virtual uint8_t getRoMinRegNum( void )
+        {
+            return TRoRegMin;
+        }
+
+        virtual uint8_t getRoMaxRegNum( void )
+        {
+            return TRoRegMax;
+        }
+
+        virtual uint8_t getRwMinRegNum( void )
+        {
+            return TRwRegMin;
+        }
+
+        virtual uint8_t getRwMaxRegNum( void )
+        {
+            return TRwRegMax;
+        }
+
+        virtual bool isRegNumRw( uint8_t regNum )
+        {
+            return isRw( regNum );
+        }
+
+        virtual bool isRegNumValid( uint8_t regNum )
+        {
+            return isValid( regNum );
+        }
+
+        // без ОС таблица живет в одном потоке, лок только отмечается;
+        // для FreeRTOS нужен наследник с мьютексом, как CannabusFreertosRegTable
+        virtual bool isTableLocked( void )
+        {
+            return m_isLocked;
+        }
+
+        virtual void lockTable( void )
+        {
+            m_isLocked = true;
+        }
+
+        virtual void unlockTable( void )
+        {
+            m_isLocked = false;
+        }
+
+    private:
+
+        static constexpr uint32_t regs_num = 256;
+        static constexpr uint32_t word_bits = 32;
+        static constexpr uint32_t words_num = regs_num / word_bits;
+
+        // длина и младший регистр для каждого номера, считаются при компиляции
+        struct Layout
+        {
+            uint8_t lengths[ regs_num ];
+            uint8_t begins[ regs_num ];
+        };
+
+        static constexpr Layout makeLayout( void )
+        {
+            Layout result = {};
+
+            const uint8_t nums[] = { 0, TRegs::num ... };
+            const uint8_t lengths[] = { 0, TRegs::length ... };
+
+            for( uint32_t i = 0; i < regs_num; i++ )
+            {
+                result.lengths[i] = 1;
+                result.begins[i] = (uint8_t)i;
+            }
+
+            // нулевой элемент - заглушка, чтобы массивы не были пустыми
+            for( uint32_t reg = 1; reg < sizeof( nums ); reg++ )
+            {
+                for( uint32_t i = 0; i < lengths[ reg ]; i++ )
+                {
+                    result.lengths[ nums[ reg ] + i ] = lengths[ reg ];
+                    result.begins[ nums[ reg ] + i ] = nums[ reg ];
+                }
+            }
+
+            return result;
+        }
+
+        // каждый регистр целиком лежит в диапазоне своего доступа, и регистры не пересекаются
+        static constexpr bool isMapValid( void )
+        {
+            const uint8_t nums[] = { 0, TRegs::num ... };
+            const uint8_t lengths[] = { 0, TRegs::length ... };
+            const bool isRwRegs[] = { false, TRegs::access == RegAccess::RW ... };
+
+            for( uint32_t reg = 1; reg < sizeof( nums ); reg++ )
+            {
+                uint32_t first = nums[ reg ];
+                uint32_t last = first + lengths[ reg ] - 1;
+
+                uint32_t rangeMin = isRwRegs[ reg ] ? TRwRegMin : TRoRegMin;
+                uint32_t rangeMax = isRwRegs[ reg ] ? TRwRegMax : TRoRegMax;
+
+                if( first < rangeMin || last > rangeMax )
+                {
+                    return false;
+                }
+
+                for( uint32_t other = 1; other < reg; other++ )
+                {
+                    uint32_t otherFirst = nums[ other ];
+                    uint32_t otherLast = otherFirst + lengths[ other ] - 1;
+
+                    if( first <= otherLast && otherFirst <= last )
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        template< typename TReg >
+        static constexpr bool isRegInMap( void )
+        {
+            const bool isSame[] = { false, std::is_same< TReg, TRegs >::value ... };
+
+            for( bool same : isSame )
+            {
+                if( same )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        static_assert( TRoRegMin <= TRoRegMax && TRwRegMin <= TRwRegMax, "Пустой диапазон регистров" );
+        static_assert( TRoRegMax < TRwRegMin || TRwRegMax < TRoRegMin, "Диапазоны ro и rw пересекаются" );
+        static_assert( isMapValid(), "Регистр вне своего диапазона или регистры пересекаются" );
+
+        static constexpr Layout layout = makeLayout();
+
+        static uint32_t getBit( uint8_t regNum )
+        {
+            return 1u << ( regNum % word_bits );
+        }
+
+        // изменение отмечается для всех байт регистра, а в карте для Slave - по младшему
+        void markChanged( uint8_t regNum, uint8_t length, bool isRwReg )
+        {
+            uint8_t lowRegNum = layout.begins[ regNum ];
+            uint8_t regLength = layout.lengths[ regNum ];
+
+            for( uint8_t i = 0; i < length; i++ )
+            {
+                m_changed[ ( regNum + i ) / word_bits ] |= getBit( regNum + i );
+            }
+
+            // ro-регистры никуда не отправляются, их отслеживать незачем
+            if( isRwReg )
+            {
+                m_dirtyRegs.mark( lowRegNum, regLength );
+            }
+        }
+
+        uint8_t m_values[ regs_num ] = {};
+        uint32_t m_changed[ words_num ] = {};
+
+        DirtyRegs m_dirtyRegs;
+
+        bool m_isLocked = false;
+    };
+
+    template< uint8_t TRoRegMin, uint8_t TRoRegMax, uint8_t TRwRegMin, uint8_t TRwRegMax, typename ... TRegs >
+    constexpr typename TypedRegTable< TRoRegMin, TRoRegMax, TRwRegMin, TRwRegMax, TRegs ... >::Layout
+        TypedRegTable< TRoRegMin, TRoRegMax, TRwRegMin, TRwRegMax, TRegs ... >::layout;
+
+} // namespace cannabus
@@ -0,0 +1,21 @@
+# Пример плагина расшифровки device-specific кадров для NarcoCANtrol.
+# Собранную библиотеку нужно положить в каталог decoders рядом с программой.
+
+TEMPLATE = lib
+TARGET = example_decoder
+
+CONFIG += plugin c++14
+QT -= gui
+
+INCLUDEPATH += \
+    $$PWD/../main
+
+SOURCES += \
+    example_decoder.cpp
+
+HEADERS += \
+    example_decoder.h \
+    ../main/device_decoder_interface.h
+
+DISTFILES += \
+    example_decoder.json
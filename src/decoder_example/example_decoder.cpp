@@ -0,0 +1,49 @@
+#include "example_decoder.h"
+
+using namespace cannabus;
+
+const char *ExampleDecoder::getName() const
+{
+    return "Example drive";
+}
+
+bool ExampleDecoder::isSupported(const uint32_t slaveAddress, const IdFCode fCode) const
+{
+    return slaveAddress != (uint32_t)IdAddresses::BROADCAST && fCode == IdFCode::DEVICE_SPECIFIC1;
+}
+
+bool ExampleDecoder::decode(const uint32_t slaveAddress, const IdMsgTypes msgType, const IdFCode fCode,
+                            const PayloadView payload, DecodedFields &fields) const
+{
+    Q_UNUSED(slaveAddress);
+    Q_UNUSED(fCode);
+
+    // Подписи - строковые литералы, они живут, пока загружен плагин
+    static const char *const commands[] = {"STOP", "START", "RESET"};
+    static const char *const states[] = {"STOP", "RUN", "FAULT"};
+
+    if (msgType == IdMsgTypes::MASTER || msgType == IdMsgTypes::HIGH_PRIO_MASTER)
+    {
+        if (payload.size != 1 || payload.data[0] > 2)
+        {
+            return false;
+        }
+
+        fields.add("command", payload.data[0], nullptr, commands[payload.data[0]]);
+        return true;
+    }
+
+    if (payload.size != 5 || payload.data[0] > 2)
+    {
+        return false;
+    }
+
+    const int16_t temperature = (int16_t)(payload.data[1] | (payload.data[2] << 8));
+    const uint16_t voltage = (uint16_t)(payload.data[3] | (payload.data[4] << 8));
+
+    fields.add("state", payload.data[0], nullptr, states[payload.data[0]]);
+    fields.add("temperature", temperature * 0.1, "degC");
+    fields.add("voltage", voltage * 0.001, "V");
+
+    return true;
+}
@@ -0,0 +1,32 @@
+/****************************************************************************
+
+Класс ExampleDecoder - пример плагина расшифровки device-specific кадров
+(DeviceDecoderInterface) для условного привода с F-кодом DEVICE_SPECIFIC1
+на любом адресе:
+
+- запрос ведущего: '[команда]', 0 - стоп, 1 - пуск, 2 - сброс аварии;
+- ответ ведомого: '[состояние] [температура, 2 байта] [напряжение, 2 байта]',
+  состояние 0 - STOP, 1 - RUN, 2 - FAULT, температура - знаковая в 0.1 °C,
+  напряжение - в мВ, младший байт первым, как в setReg16Val.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include "device_decoder_interface.h"
+
+class ExampleDecoder : public QObject, public DeviceDecoderInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID DeviceDecoderInterface_iid FILE "example_decoder.json")
+    Q_INTERFACES(DeviceDecoderInterface)
+
+public:
+    const char *getName() const override;
+
+    bool isSupported(const uint32_t slaveAddress, const cannabus::IdFCode fCode) const override;
+
+    bool decode(const uint32_t slaveAddress, const cannabus::IdMsgTypes msgType, const cannabus::IdFCode fCode,
+                const PayloadView payload, DecodedFields &fields) const override;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <QList>
 #include <QString>
 #include <QObject>
 
@@ -19,6 +20,19 @@ enum class BitRate {
     KBPS_8000 = 8000000,
 };
 
+// Стандартные скорости шины и скорости фазы данных CAN FD
+inline QList<uint32_t> getNominalBitRates()
+{
+    return {(uint32_t)BitRate::KBPS_10, (uint32_t)BitRate::KBPS_20, (uint32_t)BitRate::KBPS_50,
+            (uint32_t)BitRate::KBPS_100, (uint32_t)BitRate::KBPS_125, (uint32_t)BitRate::KBPS_250,
+            (uint32_t)BitRate::KBPS_500, (uint32_t)BitRate::KBPS_800, (uint32_t)BitRate::KBPS_1000};
+}
+
+inline QList<uint32_t> getDataBitRates()
+{
+    return {(uint32_t)BitRate::KBPS_2000, (uint32_t)BitRate::KBPS_5000, (uint32_t)BitRate::KBPS_8000};
+}
+
 inline QString bitRateToString(uint32_t bitRate)
 {
     QString result = QObject::tr("%1 %2")
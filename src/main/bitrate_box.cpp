@@ -50,23 +50,8 @@ void BitRateBox::checkCustomSpeedPolicy(const int32_t index)
 
 void BitRateBox::fillBitRates(uint32_t index)
 {
-    static const QList<uint32_t> rates = {
-        (uint32_t)BitRate::KBPS_10,
-        (uint32_t)BitRate::KBPS_20,
-        (uint32_t)BitRate::KBPS_50,
-        (uint32_t)BitRate::KBPS_100,
-        (uint32_t)BitRate::KBPS_125,
-        (uint32_t)BitRate::KBPS_250,
-        (uint32_t)BitRate::KBPS_500,
-        (uint32_t)BitRate::KBPS_800,
-        (uint32_t)BitRate::KBPS_1000
-    };
-
-    static const QList<uint32_t> dataRates = {
-        (uint32_t)BitRate::KBPS_2000,
-        (uint32_t)BitRate::KBPS_5000,
-        (uint32_t)BitRate::KBPS_8000
-    };
+    static const QList<uint32_t> rates = getNominalBitRates();
+    static const QList<uint32_t> dataRates = getDataBitRates();
 
     clear();
 
@@ -0,0 +1,244 @@
+#include "bus_load_meter.h"
+#include "../cannabus_library/cannabus_frame_bits.h"
+
+#include <algorithm>
+
+using namespace cannabus;
+
+// 29-битный ID добавляет SRR, 18 бит ID и резервный бит, с наихудшим стаффингом
+static constexpr uint32_t extended_id_bits = 20 + 20 / 4;
+
+BusLoadMeter::BusLoadMeter()
+{
+    m_currentBin.fill(0, categories_count);
+    m_bins.fill(0, categories_count * bins_count);
+    m_windowSum.fill(0, categories_count);
+
+    m_load.fill(0, categories_count);
+    m_binLoad.fill(0, categories_count);
+    m_peakLoad.fill(0, categories_count);
+    m_peakBinLoad.fill(0, categories_count);
+    m_isCategoryUsed.fill(false, categories_count);
+}
+
+void BusLoadMeter::setBitRates(const uint32_t bitRate, const uint32_t dataBitRate)
+{
+    m_bitRate = bitRate;
+    m_dataBitRate = dataBitRate;
+}
+
+bool BusLoadMeter::isBitRateKnown() const
+{
+    return m_bitRate != 0;
+}
+
+void BusLoadMeter::clear()
+{
+    m_currentBin.fill(0);
+    m_bins.fill(0);
+    m_windowSum.fill(0);
+
+    m_load.fill(0);
+    m_binLoad.fill(0);
+    m_isCategoryUsed.fill(false);
+
+    resetPeaks();
+
+    m_isStarted = false;
+    m_binStart = 0;
+    m_binsClosed = 0;
+    m_clockOffset = 0;
+}
+
+void BusLoadMeter::resetPeaks()
+{
+    m_peakLoad.fill(0);
+    m_peakBinLoad.fill(0);
+}
+
+uint64_t BusLoadMeter::getBitsDuration(const uint32_t bitsNum, const uint32_t bitRate) const
+{
+    return (uint64_t)bitsNum * 1000000000 / bitRate;
+}
+
+uint64_t BusLoadMeter::getFrameDuration(const QCanBusFrame &frame) const
+{
+    const QByteArray payload = frame.payload();
+    const uint8_t length = (uint8_t)std::min(payload.size(), 64);
+
+    // CAN FD: заголовок и хвост на номинальной скорости, данные - на скорости данных, если она переключается
+    if (frame.hasFlexibleDataRateFormat() != false)
+    {
+        const FdFrameBits bits = getFdFrameBitsWorstCase(length);
+        const uint32_t dataBitRate = (frame.hasBitrateSwitch() != false && m_dataBitRate != 0) ? m_dataBitRate
+                                                                                               : m_bitRate;
+
+        return getBitsDuration(bits.arbitration, m_bitRate) + getBitsDuration(bits.data, dataBitRate);
+    }
+
+    uint32_t bitsNum = getFrameBits(frame.frameId(), reinterpret_cast<const uint8_t *>(payload.constData()),
+                                    std::min<uint8_t>(length, 8));
+
+    if (frame.hasExtendedFrameFormat() != false)
+    {
+        bitsNum += extended_id_bits;
+    }
+
+    return getBitsDuration(bitsNum, m_bitRate);
+}
+
+uint64_t BusLoadMeter::getFrameTime(const QCanBusFrame &frame, const uint64_t hostTime)
+{
+    const uint64_t frameTime = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+
+    // Адаптер без меток времени: считаем кадр пришедшим в момент обработки
+    if (frameTime == 0)
+    {
+        m_clockOffset = 0;
+        return hostTime;
+    }
+
+    m_clockOffset = (int64_t)hostTime - (int64_t)frameTime;
+
+    return frameTime;
+}
+
+void BusLoadMeter::processDataFrame(const QCanBusFrame &frame, const uint64_t hostTime)
+{
+    if (isBitRateKnown() == false)
+    {
+        return;
+    }
+
+    const uint64_t time = getFrameTime(frame, hostTime);
+    const uint64_t duration = getFrameDuration(frame);
+    const uint32_t frameId = frame.frameId();
+
+    closeBins(time);
+
+    addBusyTime(duration, total_category);
+    addBusyTime(duration, msg_types_category + (uint32_t)getMsgTypeFromId(frameId));
+    addBusyTime(duration, addresses_category + getAddressFromId(frameId));
+}
+
+void BusLoadMeter::processErrorFrame(const QCanBusFrame &frame, const uint64_t hostTime)
+{
+    if (isBitRateKnown() == false)
+    {
+        return;
+    }
+
+    const uint64_t time = getFrameTime(frame, hostTime);
+
+    closeBins(time);
+
+    // Кадр ошибки не принадлежит ни типу сообщения, ни адресу
+    addBusyTime(getBitsDuration(error_frame_bits, m_bitRate), total_category);
+}
+
+void BusLoadMeter::advance(const uint64_t hostTime)
+{
+    if (m_isStarted == false)
+    {
+        return;
+    }
+
+    const int64_t time = (int64_t)hostTime - m_clockOffset;
+
+    if (time > 0)
+    {
+        closeBins(time);
+    }
+}
+
+void BusLoadMeter::addBusyTime(const uint64_t duration, const uint32_t category)
+{
+    m_currentBin[category] += duration;
+    m_isCategoryUsed[category] = true;
+}
+
+void BusLoadMeter::closeBins(const uint64_t time)
+{
+    if (m_isStarted == false)
+    {
+        m_isStarted = true;
+        m_binStart = time - time % bin_duration;
+        return;
+    }
+
+    // Кадры с меткой из уже закрытой корзины (часы адаптера отстали) попадают в открытую
+    uint32_t binsClosed = 0;
+
+    while (time >= m_binStart + bin_duration)
+    {
+        closeBin();
+        m_binStart += bin_duration;
+        binsClosed++;
+
+        // После целого окна пустых корзин дальше закрывать нечего - просто переносим начало
+        if (binsClosed >= bins_count && time >= m_binStart + bin_duration)
+        {
+            m_binStart = time - (time - m_binStart) % bin_duration;
+        }
+    }
+}
+
+void BusLoadMeter::closeBin()
+{
+    const uint32_t slot = m_binsClosed % bins_count;
+    const uint32_t binsNum = std::min<uint64_t>(m_binsClosed + 1, bins_count);
+
+    for (uint32_t category = 0; category < categories_count; category++)
+    {
+        uint64_t &oldBin = m_bins[slot * categories_count + category];
+        const uint64_t newBin = m_currentBin[category];
+
+        // Скользящая сумма: уходящая из окна корзина вычитается, новая прибавляется
+        m_windowSum[category] = m_windowSum[category] - oldBin + newBin;
+        oldBin = newBin;
+        m_currentBin[category] = 0;
+
+        m_binLoad[category] = getLoadPercent(newBin, 1);
+        m_load[category] = getLoadPercent(m_windowSum[category], binsNum);
+
+        m_peakBinLoad[category] = std::max(m_peakBinLoad[category], m_binLoad[category]);
+
+        // Пик по окну учитываем, только когда окно заполнено целиком
+        if (binsNum == bins_count)
+        {
+            m_peakLoad[category] = std::max(m_peakLoad[category], m_load[category]);
+        }
+    }
+
+    m_binsClosed++;
+}
+
+double BusLoadMeter::getLoadPercent(const uint64_t busyTime, const uint32_t binsNum)
+{
+    return 100.0 * busyTime / ((double)binsNum * bin_duration * 1000);
+}
+
+double BusLoadMeter::getLoad(const uint32_t category) const
+{
+    return m_load[category];
+}
+
+double BusLoadMeter::getBinLoad(const uint32_t category) const
+{
+    return m_binLoad[category];
+}
+
+double BusLoadMeter::getPeakLoad(const uint32_t category) const
+{
+    return m_peakLoad[category];
+}
+
+double BusLoadMeter::getPeakBinLoad(const uint32_t category) const
+{
+    return m_peakBinLoad[category];
+}
+
+bool BusLoadMeter::isCategoryUsed(const uint32_t category) const
+{
+    return m_isCategoryUsed[category];
+}
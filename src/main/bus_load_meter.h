@@ -0,0 +1,102 @@
+/****************************************************************************
+
+Класс BusLoadMeter оценивает загрузку шины: для каждого кадра считается его
+длина на шине в битах (cannabus_frame_bits.h: точный CRC и бит-стаффинг для
+классического кадра, наихудший стаффинг для CAN FD, хвост кадра и
+межкадровый промежуток), переводится во время по скорости шины, а для
+CAN FD - по номинальной скорости и скорости данных, и складывается в
+корзины по bin_duration.
+
+Загрузка - доля занятого времени шины за последнюю корзину и за окно из
+bins_count корзин, всего, по типам сообщений и по адресам ведомых узлов.
+Для каждой из них запоминается пиковое значение.
+
+Время кадров - метки адаптера, а если их нет - время приёма на хосте.
+Корзины закрываются и по кадрам, и по часам хоста (advance), чтобы на
+молчащей шине загрузка падала до нуля.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QCanBusFrame>
+#include <QVector>
+#include <stdint.h>
+#include "../cannabus_library/cannabus_common.h"
+
+class BusLoadMeter
+{
+public:
+    BusLoadMeter();
+    ~BusLoadMeter() = default;
+
+    // Длительность корзины, мкс, и число корзин в окне (окно - 1 с)
+    static constexpr uint32_t bin_duration = 100000;
+    static constexpr uint32_t bins_count = 10;
+
+    // Категории загрузки: вся шина, типы сообщений, адреса
+    static constexpr uint32_t msg_types_count = 4;
+    static constexpr uint32_t addresses_count = 64;
+
+    static constexpr uint32_t total_category = 0;
+    static constexpr uint32_t msg_types_category = total_category + 1;
+    static constexpr uint32_t addresses_category = msg_types_category + msg_types_count;
+    static constexpr uint32_t categories_count = addresses_category + addresses_count;
+
+    // Скорость шины и скорость фазы данных CAN FD, бит/с; 0 - неизвестна
+    void setBitRates(const uint32_t bitRate, const uint32_t dataBitRate);
+    bool isBitRateKnown() const;
+
+    // Учёт кадров; hostTime - время приёма на хосте, мкс
+    void processDataFrame(const QCanBusFrame &frame, const uint64_t hostTime);
+    void processErrorFrame(const QCanBusFrame &frame, const uint64_t hostTime);
+
+    // Закрытие корзин, время которых прошло по часам хоста
+    void advance(const uint64_t hostTime);
+
+    // Загрузка категории в процентах: за окно, за последнюю корзину и их пики
+    double getLoad(const uint32_t category) const;
+    double getBinLoad(const uint32_t category) const;
+    double getPeakLoad(const uint32_t category) const;
+    double getPeakBinLoad(const uint32_t category) const;
+
+    // Есть ли в категории хоть один кадр с последнего сброса
+    bool isCategoryUsed(const uint32_t category) const;
+
+    void resetPeaks();
+    void clear();
+
+private:
+    // Время кадра на шине, нс
+    uint64_t getFrameDuration(const QCanBusFrame &frame) const;
+    uint64_t getBitsDuration(const uint32_t bitsNum, const uint32_t bitRate) const;
+
+    uint64_t getFrameTime(const QCanBusFrame &frame, const uint64_t hostTime);
+
+    void addBusyTime(const uint64_t duration, const uint32_t category);
+    void closeBins(const uint64_t time);
+    void closeBin();
+
+    static double getLoadPercent(const uint64_t busyTime, const uint32_t binsNum);
+
+    uint32_t m_bitRate = 0;
+    uint32_t m_dataBitRate = 0;
+
+    // Занятое время по категориям: открытая корзина, кольцо закрытых и сумма по кольцу
+    QVector<uint64_t> m_currentBin;
+    QVector<uint64_t> m_bins;
+    QVector<uint64_t> m_windowSum;
+
+    QVector<double> m_load;
+    QVector<double> m_binLoad;
+    QVector<double> m_peakLoad;
+    QVector<double> m_peakBinLoad;
+    QVector<bool> m_isCategoryUsed;
+
+    bool m_isStarted = false;
+    uint64_t m_binStart = 0;
+    uint64_t m_binsClosed = 0;
+
+    // Разность часов хоста и меток адаптера по последнему кадру
+    int64_t m_clockOffset = 0;
+};
@@ -0,0 +1,228 @@
+#include "bus_load_window.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+using namespace cannabus;
+
+BusLoadWindow::BusLoadWindow(QWidget *parent) :
+    QWidget(parent),
+    m_bitRates(new QLabel(this)),
+    m_table(new QTableWidget(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Bus Load"));
+
+    m_categoryRow.fill(-1, BusLoadMeter::categories_count);
+
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    makeHeader();
+
+    auto resetPeaksButton = new QPushButton(tr("Reset Peaks"), this);
+    auto clearButton = new QPushButton(tr("Reset"), this);
+
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(m_bitRates);
+    controlsLayout->addStretch();
+    controlsLayout->addWidget(resetPeaksButton);
+    controlsLayout->addWidget(clearButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(m_table);
+    layout->addLayout(controlsLayout);
+
+    connect(resetPeaksButton, &QPushButton::clicked, this, &BusLoadWindow::resetPeaks);
+    connect(clearButton, &QPushButton::clicked, this, &BusLoadWindow::clearStats);
+
+    setBitRates(0, 0);
+
+    m_clock.start();
+
+    resize(600, 400);
+}
+
+void BusLoadWindow::makeHeader()
+{
+    QStringList busLoadWindowHeader = {"Name", "Load 1 s, %", "Load 100 ms, %", "Peak 1 s, %", "Peak 100 ms, %"};
+
+    m_table->setColumnCount(busLoadWindowHeader.count());
+    m_table->setHorizontalHeaderLabels(busLoadWindowHeader);
+
+    m_table->horizontalHeader()->setSectionsClickable(false);
+
+    // Вся шина и типы сообщений есть всегда, адреса появляются с трафиком
+    for (uint32_t category = BusLoadMeter::total_category; category < BusLoadMeter::addresses_category; category++)
+    {
+        getRow(category);
+    }
+}
+
+void BusLoadWindow::setBitRates(const uint32_t bitRate, const uint32_t dataBitRate)
+{
+    m_meter.setBitRates(bitRate, dataBitRate);
+
+    if (bitRate == 0)
+    {
+        m_bitRates->setText(tr("Bit rate is unknown, bus load is not measured"));
+    }
+    else if (dataBitRate != 0)
+    {
+        m_bitRates->setText(tr("Bit rate: %1 / %2 bit/s").arg(bitRate).arg(dataBitRate));
+    }
+    else
+    {
+        m_bitRates->setText(tr("Bit rate: %1 bit/s").arg(bitRate));
+    }
+}
+
+uint64_t BusLoadWindow::getHostTime() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void BusLoadWindow::processDataFrame(const QCanBusFrame &frame)
+{
+    m_meter.processDataFrame(frame, getHostTime());
+}
+
+void BusLoadWindow::processErrorFrame(const QCanBusFrame &frame)
+{
+    m_meter.processErrorFrame(frame, getHostTime());
+}
+
+double BusLoadWindow::getTotalLoad() const
+{
+    if (m_meter.isBitRateKnown() == false)
+    {
+        return -1;
+    }
+
+    return m_meter.getLoad(BusLoadMeter::total_category);
+}
+
+void BusLoadWindow::refresh()
+{
+    m_meter.advance(getHostTime());
+
+    // Скрытое окно не перерисовываем: загрузка всё равно считается на каждом кадре
+    if (isVisible() == false)
+    {
+        return;
+    }
+
+    for (uint32_t category = 0; category < BusLoadMeter::categories_count; category++)
+    {
+        if (m_categoryRow[category] == -1 && m_meter.isCategoryUsed(category) == false)
+        {
+            continue;
+        }
+
+        const int32_t row = getRow(category);
+
+        setCell(row, BusLoadWindowColumn::load         , tr("%1").arg(m_meter.getLoad(category)       , 0, 'f', 2));
+        setCell(row, BusLoadWindowColumn::bin_load     , tr("%1").arg(m_meter.getBinLoad(category)    , 0, 'f', 2));
+        setCell(row, BusLoadWindowColumn::peak_load    , tr("%1").arg(m_meter.getPeakLoad(category)   , 0, 'f', 2));
+        setCell(row, BusLoadWindowColumn::peak_bin_load, tr("%1").arg(m_meter.getPeakBinLoad(category), 0, 'f', 2));
+    }
+}
+
+void BusLoadWindow::clearStats()
+{
+    m_meter.clear();
+
+    // Строки адресов убираем, постоянные строки перерисуются с нулями
+    for (uint32_t category = BusLoadMeter::addresses_category; category < BusLoadMeter::categories_count; category++)
+    {
+        m_categoryRow[category] = -1;
+    }
+
+    m_table->setRowCount(BusLoadMeter::addresses_category);
+
+    refresh();
+}
+
+void BusLoadWindow::resetPeaks()
+{
+    m_meter.resetPeaks();
+
+    refresh();
+}
+
+int32_t BusLoadWindow::getRow(const uint32_t category)
+{
+    if (m_categoryRow[category] != -1)
+    {
+        return m_categoryRow[category];
+    }
+
+    int32_t row = 0;
+
+    for (uint32_t other = 0; other < category; other++)
+    {
+        if (m_categoryRow[other] != -1)
+        {
+            row++;
+        }
+    }
+
+    for (uint32_t other = category + 1; other < BusLoadMeter::categories_count; other++)
+    {
+        if (m_categoryRow[other] != -1)
+        {
+            m_categoryRow[other]++;
+        }
+    }
+
+    m_table->insertRow(row);
+    m_categoryRow[category] = row;
+
+    auto item = new QTableWidgetItem(getCategoryName(category));
+    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    m_table->setItem(row, (uint32_t)BusLoadWindowColumn::name, item);
+
+    return row;
+}
+
+QString BusLoadWindow::getCategoryName(const uint32_t category) const
+{
+    static const QStringList msgTypeInfo = {"Master's high-prio", "Slave's high-prio",
+                                            "Master's request", "Slave's response"};
+
+    if (category == BusLoadMeter::total_category)
+    {
+        return tr("Total");
+    }
+
+    if (category < BusLoadMeter::addresses_category)
+    {
+        const uint32_t msgType = category - BusLoadMeter::msg_types_category;
+
+        return tr("0b%1 ").arg(msgType, 2, 2, QLatin1Char('0')) + msgTypeInfo.at(msgType);
+    }
+
+    const uint32_t slaveAddress = category - BusLoadMeter::addresses_category;
+
+    return tr("Address %1 (0x").arg(slaveAddress, 2, 10, QLatin1Char(' ')) +
+           tr("%1)").arg(slaveAddress, 2, 16, QLatin1Char('0')).toUpper();
+}
+
+void BusLoadWindow::setCell(const int32_t row, const BusLoadWindowColumn column, const QString text)
+{
+    QTableWidgetItem *item = m_table->item(row, (uint32_t)column);
+
+    if (item == nullptr)
+    {
+        item = new QTableWidgetItem;
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        m_table->setItem(row, (uint32_t)column, item);
+    }
+
+    item->setText(text);
+}
@@ -0,0 +1,75 @@
+/****************************************************************************
+
+Класс BusLoadWindow выводит загрузку шины (BusLoadMeter): за последнюю
+секунду и за последние 100 мс, с пиковыми значениями, всего, по типам
+сообщений и по адресам ведомых узлов. Строки адресов появляются с первым
+кадром узла. Скорость шины берётся из настроек адаптера при подключении;
+пока она неизвестна, загрузка не считается.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <QCanBusFrame>
+#include <QElapsedTimer>
+#include <QVector>
+#include <stdint.h>
+#include "bus_load_meter.h"
+
+QT_BEGIN_NAMESPACE
+
+class QLabel;
+class QTableWidget;
+
+QT_END_NAMESPACE
+
+enum class BusLoadWindowColumn {
+    name,
+    load,
+    bin_load,
+    peak_load,
+    peak_bin_load
+};
+
+class BusLoadWindow : public QWidget
+{
+public:
+    explicit BusLoadWindow(QWidget *parent = nullptr);
+    ~BusLoadWindow() = default;
+
+    // Скорость шины и скорость данных CAN FD, бит/с; 0 - неизвестна
+    void setBitRates(const uint32_t bitRate, const uint32_t dataBitRate);
+
+    // Учёт кадров и обновление таблицы
+    void processDataFrame(const QCanBusFrame &frame);
+    void processErrorFrame(const QCanBusFrame &frame);
+    void refresh();
+
+    // Загрузка всей шины за последнюю секунду, %; отрицательна, если скорость неизвестна
+    double getTotalLoad() const;
+
+public slots:
+    void clearStats();
+    void resetPeaks();
+
+private:
+    void makeHeader();
+
+    // Строка категории; строки адресов вставляются с сохранением порядка
+    int32_t getRow(const uint32_t category);
+    QString getCategoryName(const uint32_t category) const;
+
+    void setCell(const int32_t row, const BusLoadWindowColumn column, const QString text);
+
+    uint64_t getHostTime() const;
+
+    BusLoadMeter m_meter;
+
+    QLabel *m_bitRates = nullptr;
+    QTableWidget *m_table = nullptr;
+
+    QVector<int32_t> m_categoryRow;
+
+    QElapsedTimer m_clock;
+};
@@ -0,0 +1,442 @@
+#include "conformance_checker.h"
+
+#include <QStringList>
+
+using namespace cannabus;
+
+ConformanceChecker::ConformanceChecker()
+{
+    m_violations.fill(0, violations_count);
+}
+
+void ConformanceChecker::clear()
+{
+    m_pending = Pending();
+    m_timedOut = Pending();
+
+    m_answeredRequest = nullptr;
+
+    m_violations.fill(0);
+    m_frames = 0;
+
+    m_records.clear();
+}
+
+ConformanceViolation ConformanceChecker::processDataFrame(const QCanBusFrame &frame)
+{
+    m_frames++;
+    m_answeredRequest = nullptr;
+
+    const uint32_t frameId = frame.frameId();
+    const QByteArray data = frame.payload();
+    const Profile profile = frame.hasFlexibleDataRateFormat() != false ? Profile::FD : Profile::CLASSIC;
+
+    ConformanceViolation violation = ConformanceViolation::none;
+
+    if (getAddressFromId(frameId) > (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS)
+    {
+        violation = ConformanceViolation::invalid_address;
+    }
+    else if (isFrameLengthValid(profile, data.size()) == false)
+    {
+        violation = ConformanceViolation::invalid_length;
+    }
+    else
+    {
+        switch (getMsgTypeFromId(frameId))
+        {
+            case IdMsgTypes::HIGH_PRIO_MASTER:
+            case IdMsgTypes::MASTER:
+            {
+                violation = checkRequest(frameId, data, profile);
+                break;
+            }
+            case IdMsgTypes::SLAVE:
+            {
+                violation = checkAnswer(frameId, data);
+                break;
+            }
+            case IdMsgTypes::HIGH_PRIO_SLAVE:
+            {
+                violation = checkHighPrio(frameId, data, profile);
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    if (violation != ConformanceViolation::none)
+    {
+        m_violations[(uint32_t)violation]++;
+        addRecord(frame, violation);
+    }
+
+    return violation;
+}
+
+ConformanceViolation ConformanceChecker::checkRequest(const uint32_t id, const QByteArray &data, const Profile profile)
+{
+    const uint32_t address = getAddressFromId(id);
+    const IdFCode fCode = getFCodeFromId(id);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.constData());
+    const uint32_t length = data.size();
+
+    ConformanceViolation violation = ConformanceViolation::none;
+
+    // Те же проверки, что и в обработчиках запросов SlaveSession
+    switch (fCode)
+    {
+        case IdFCode::WRITE_REGS_RANGE:
+        {
+            violation = checkRange(bytes, length, profile);
+            break;
+        }
+        case IdFCode::WRITE_REGS_SERIES:
+        {
+            if (length == 0 || length % 2 != 0)
+            {
+                violation = ConformanceViolation::invalid_request;
+            }
+            else if (isFrameLengthValid(profile, length / 2) == false)
+            {
+                violation = ConformanceViolation::series_too_long;
+            }
+            break;
+        }
+        case IdFCode::READ_REGS_RANGE:
+        {
+            if (length != 2)
+            {
+                violation = ConformanceViolation::invalid_request;
+            }
+            else
+            {
+                violation = checkRange(bytes, length, profile, false);
+            }
+            break;
+        }
+        case IdFCode::READ_REGS_SERIES:
+        {
+            if (length == 0)
+            {
+                violation = ConformanceViolation::invalid_request;
+            }
+            else if (getSeriesRegsFit(profile, length) != length)
+            {
+                violation = ConformanceViolation::series_too_long;
+            }
+            break;
+        }
+        default:
+        {
+            if (length == 0 || length > getMaxRegsInSpecific(profile))
+            {
+                violation = ConformanceViolation::invalid_request;
+            }
+            break;
+        }
+    }
+
+    // Ведущий шлёт новый запрос, только когда перестал ждать ответа на предыдущий
+    closePending();
+
+    if (address == (uint32_t)IdAddresses::BROADCAST)
+    {
+        // На широковещательное чтение ответить некому
+        if (fCode == IdFCode::READ_REGS_RANGE || fCode == IdFCode::READ_REGS_SERIES)
+        {
+            violation = ConformanceViolation::invalid_request;
+        }
+
+        return violation;
+    }
+
+    // Ответа ждём и на неверный запрос: ведомый должен ответить на него ошибкой
+    m_pending.isActive = true;
+    m_pending.isAnswered = false;
+    m_pending.id = id;
+    m_pending.data = data;
+
+    return violation;
+}
+
+void ConformanceChecker::closePending()
+{
+    if (m_pending.isActive == false)
+    {
+        return;
+    }
+
+    m_pending.isActive = false;
+
+    if (m_pending.isAnswered == false)
+    {
+        m_timedOut = m_pending;
+        m_timedOut.isActive = true;
+    }
+}
+
+bool ConformanceChecker::isAnswerAddressed(const uint32_t answerId, const Pending &pending)
+{
+    if (pending.isActive == false)
+    {
+        return false;
+    }
+
+    // Как и в MasterSession::isAnswerAdressValid, на прямой доступ может ответить любой адрес
+    const uint32_t requestAddress = getAddressFromId(pending.id);
+
+    return requestAddress == (uint32_t)IdAddresses::DIRECT_ACCESS || requestAddress == getAddressFromId(answerId);
+}
+
+ConformanceViolation ConformanceChecker::checkAnswer(const uint32_t id, const QByteArray &data)
+{
+    if (getAddressFromId(id) == (uint32_t)IdAddresses::BROADCAST)
+    {
+        return ConformanceViolation::invalid_address;
+    }
+
+    if (isAnswerAddressed(id, m_pending) != false)
+    {
+        m_answeredRequest = &m_pending;
+
+        return checkAnswerToPending(id, data);
+    }
+
+    // Ведущий уже закрыл этот запрос по таймауту и ответ отбросит
+    if (isAnswerAddressed(id, m_timedOut) != false && getFCodeFromId(id) == getFCodeFromId(m_timedOut.id))
+    {
+        m_answeredRequest = &m_timedOut;
+
+        return ConformanceViolation::late_answer;
+    }
+
+    return ConformanceViolation::unsolicited_answer;
+}
+
+ConformanceViolation ConformanceChecker::checkAnswerToPending(const uint32_t id, const QByteArray &data)
+{
+    const IdFCode fCode = getFCodeFromId(id);
+
+    if (fCode != getFCodeFromId(m_pending.id))
+    {
+        return ConformanceViolation::f_code_mismatch;
+    }
+
+    // Ответ без данных - отказ выполнить запрос; как и MasterSession::isAnswerRelevant, ответом его не считаем
+    if (data.size() == 0)
+    {
+        return ConformanceViolation::error_answer;
+    }
+
+    const ConformanceViolation violation =
+        checkAnswerData(reinterpret_cast<const uint8_t *>(data.constData()), data.size(),
+                        reinterpret_cast<const uint8_t *>(m_pending.data.constData()), m_pending.data.size(), fCode);
+
+    // Ответ с нарушением ведущий отбрасывает и продолжает ждать
+    if (violation != ConformanceViolation::none)
+    {
+        return violation;
+    }
+
+    m_pending.isAnswered = true;
+
+    if (getAddressFromId(m_pending.id) != (uint32_t)IdAddresses::DIRECT_ACCESS)
+    {
+        m_pending.isActive = false;
+    }
+
+    return ConformanceViolation::none;
+}
+
+ConformanceViolation ConformanceChecker::checkHighPrio(const uint32_t id, const QByteArray &data, const Profile profile) const
+{
+    if (getAddressFromId(id) == (uint32_t)IdAddresses::BROADCAST)
+    {
+        return ConformanceViolation::invalid_address;
+    }
+
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.constData());
+    const uint32_t length = data.size();
+
+    // Высокоприоритетные сообщения ведомых имеют формат ответов на чтение
+    switch (getFCodeFromId(id))
+    {
+        case IdFCode::READ_REGS_RANGE:
+        {
+            const ConformanceViolation violation = checkRange(bytes, length, profile);
+
+            return violation == ConformanceViolation::invalid_request ? ConformanceViolation::invalid_high_prio
+                                                                      : violation;
+        }
+        case IdFCode::READ_REGS_SERIES:
+        {
+            if (length == 0 || length % 2 != 0)
+            {
+                return ConformanceViolation::invalid_high_prio;
+            }
+
+            if (getSeriesRegsFit(profile, length / 2) != length / 2)
+            {
+                return ConformanceViolation::series_too_long;
+            }
+
+            return ConformanceViolation::none;
+        }
+        default:
+        {
+            return ConformanceViolation::invalid_high_prio;
+        }
+    }
+}
+
+ConformanceViolation ConformanceChecker::checkRange(const uint8_t *data, const uint32_t length, const Profile profile,
+                                                    const bool hasValues)
+{
+    if (length < 2 || data[1] < data[0])
+    {
+        return ConformanceViolation::invalid_request;
+    }
+
+    // Регистров может быть до 256, поэтому счёт не в uint8_t
+    const uint32_t regsTotal = data[1] - data[0] + 1;
+
+    if (regsTotal > getMaxRegsInRange(profile) || getRangeRegsFit(profile, regsTotal) != regsTotal)
+    {
+        return ConformanceViolation::range_too_long;
+    }
+
+    if (hasValues != false && length != regsTotal + 2)
+    {
+        return ConformanceViolation::invalid_request;
+    }
+
+    return ConformanceViolation::none;
+}
+
+ConformanceViolation ConformanceChecker::checkAnswerData(const uint8_t *answer, const uint32_t answerLength,
+                                                         const uint8_t *request, const uint32_t requestLength,
+                                                         const IdFCode fCode)
+{
+    // Те же правила, что в MasterSession::isWriteRegsRangeValid и остальных, но с разделением
+    // неверной длины и неверного эха номеров регистров
+    switch (fCode)
+    {
+        case IdFCode::WRITE_REGS_RANGE:
+        {
+            if (answerLength != 2 || requestLength < 2)
+            {
+                return ConformanceViolation::wrong_answer_length;
+            }
+
+            if (request[0] != answer[0] || request[1] != answer[1])
+            {
+                return ConformanceViolation::register_echo_mismatch;
+            }
+
+            return ConformanceViolation::none;
+        }
+        case IdFCode::WRITE_REGS_SERIES:
+        {
+            if (requestLength != answerLength * 2)
+            {
+                return ConformanceViolation::wrong_answer_length;
+            }
+
+            for (uint32_t i = 0; i < answerLength; i++)
+            {
+                if (request[i * 2] != answer[i])
+                {
+                    return ConformanceViolation::register_echo_mismatch;
+                }
+            }
+
+            return ConformanceViolation::none;
+        }
+        case IdFCode::READ_REGS_RANGE:
+        {
+            if (requestLength != 2 || request[1] < request[0] ||
+                answerLength != requestLength + request[1] - request[0] + 1)
+            {
+                return ConformanceViolation::wrong_answer_length;
+            }
+
+            if (request[0] != answer[0] || request[1] != answer[1])
+            {
+                return ConformanceViolation::register_echo_mismatch;
+            }
+
+            return ConformanceViolation::none;
+        }
+        case IdFCode::READ_REGS_SERIES:
+        {
+            if (requestLength * 2 != answerLength)
+            {
+                return ConformanceViolation::wrong_answer_length;
+            }
+
+            for (uint32_t i = 0; i < requestLength; i++)
+            {
+                if (request[i] != answer[i * 2])
+                {
+                    return ConformanceViolation::register_echo_mismatch;
+                }
+            }
+
+            return ConformanceViolation::none;
+        }
+        default:
+        {
+            // Специальные функции могут содержать любые данные
+            return ConformanceViolation::none;
+        }
+    }
+}
+
+void ConformanceChecker::addRecord(const QCanBusFrame &frame, const ConformanceViolation violation)
+{
+    Record record;
+    record.time = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+    record.frameId = frame.frameId();
+    record.data = frame.payload();
+    record.violation = violation;
+
+    if (m_answeredRequest != nullptr)
+    {
+        record.hasRequest = true;
+        record.requestId = m_answeredRequest->id;
+        record.requestData = m_answeredRequest->data;
+    }
+
+    m_records.append(record);
+}
+
+void ConformanceChecker::takeRecords(QVector<Record> &records)
+{
+    // Обмен буферами: ёмкость переданного вектора переиспользуется для следующих записей
+    records.swap(m_records);
+    m_records.clear();
+}
+
+uint64_t ConformanceChecker::getFramesCount() const
+{
+    return m_frames;
+}
+
+uint64_t ConformanceChecker::getViolationsCount(const ConformanceViolation violation) const
+{
+    return m_violations[(uint32_t)violation];
+}
+
+QString ConformanceChecker::getViolationName(const ConformanceViolation violation)
+{
+    static const QStringList violationNames = {"None", "Invalid address", "Invalid frame length", "Invalid request",
+                                               "Range too long", "Series too long", "Invalid high-prio message",
+                                               "Answer without request", "F-code mismatch", "Wrong answer length",
+                                               "Register echo mismatch", "Error answer", "Late answer"};
+
+    return violationNames.at((uint32_t)violation);
+}
@@ -0,0 +1,126 @@
+/****************************************************************************
+
+Класс ConformanceChecker проверяет каждый кадр на соответствие протоколу
+по тем же правилам, что и библиотека CANNABUS: запросы ведущего - как
+SlaveSession::writeRegsRange, readRegsRange и остальные обработчики
+(длина, порядок границ диапазона, число регистров для профиля), ответы
+ведомых - как MasterSession::isAnswerRelevant в контексте запроса,
+которого ждёт ведущий (F-код, длина, эхо номеров регистров).
+Высокоприоритетные сообщения ведомых проверяются по формату чтения.
+
+Как и MasterSession, ведущий ждёт ответа только на один запрос: любой
+новый запрос закрывает оставшийся без ответа по таймауту, а ответ на
+закрытый запрос помечается как опоздавший. Ответ с нарушением запрос
+не закрывает - ведущий отбрасывает его и ждёт дальше. Пустой ответ -
+отказ ведомого; библиотека считает его нерелевантным, запрос
+заканчивается таймаутом.
+
+Кадр без нарушений проверяется за один проход по данным без выделения
+памяти, поэтому проверка успевает за шиной на одном ядре. Нарушения
+считаются по видам, а кадры с нарушениями вместе с запросом копируются
+в отчёт, который окно забирает по таймеру.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QCanBusFrame>
+#include <QString>
+#include <QVector>
+#include <stdint.h>
+#include "../cannabus_library/cannabus_common.h"
+
+enum class ConformanceViolation {
+    none,
+    invalid_address,
+    invalid_length,
+    invalid_request,
+    range_too_long,
+    series_too_long,
+    invalid_high_prio,
+    unsolicited_answer,
+    f_code_mismatch,
+    wrong_answer_length,
+    register_echo_mismatch,
+    error_answer,
+    late_answer
+};
+
+class ConformanceChecker
+{
+public:
+    ConformanceChecker();
+    ~ConformanceChecker() = default;
+
+    static constexpr uint32_t violations_count = (uint32_t)ConformanceViolation::late_answer + 1;
+
+    // Кадр с нарушением и запрос, в контексте которого он проверялся
+    struct Record {
+        uint64_t time = 0;
+        uint32_t frameId = 0;
+        QByteArray data;
+        bool hasRequest = false;
+        uint32_t requestId = 0;
+        QByteArray requestData;
+        ConformanceViolation violation = ConformanceViolation::none;
+    };
+
+    // Проверка кадра; возвращает найденное нарушение
+    ConformanceViolation processDataFrame(const QCanBusFrame &frame);
+
+    // Забрать накопленные с прошлого раза записи отчёта
+    void takeRecords(QVector<Record> &records);
+
+    uint64_t getFramesCount() const;
+    uint64_t getViolationsCount(const ConformanceViolation violation) const;
+
+    static QString getViolationName(const ConformanceViolation violation);
+
+    void clear();
+
+private:
+    // Запрос ведущего, ожидающий ответа
+    struct Pending {
+        bool isActive = false;
+
+        // На прямой доступ отвечают несколько ведомых, он закрывается только следующим запросом
+        bool isAnswered = false;
+
+        uint32_t id = 0;
+        QByteArray data;
+    };
+
+    ConformanceViolation checkRequest(const uint32_t id, const QByteArray &data, const cannabus::Profile profile);
+    ConformanceViolation checkAnswer(const uint32_t id, const QByteArray &data);
+    ConformanceViolation checkAnswerToPending(const uint32_t id, const QByteArray &data);
+    ConformanceViolation checkHighPrio(const uint32_t id, const QByteArray &data, const cannabus::Profile profile) const;
+
+    // Диапазон: границы, число регистров для профиля и, если за границами идут значения, длина
+    static ConformanceViolation checkRange(const uint8_t *data, const uint32_t length, const cannabus::Profile profile,
+                                           const bool hasValues = true);
+    static ConformanceViolation checkAnswerData(const uint8_t *answer, const uint32_t answerLength,
+                                                const uint8_t *request, const uint32_t requestLength,
+                                                const cannabus::IdFCode fCode);
+
+    // Закрытие ожидающего запроса новым запросом; оставшийся без ответа запоминается как истёкший
+    void closePending();
+
+    // Ответ от этого адреса с этим F-кодом мог прийти на запрос
+    static bool isAnswerAddressed(const uint32_t answerId, const Pending &pending);
+
+    void addRecord(const QCanBusFrame &frame, const ConformanceViolation violation);
+
+    Pending m_pending;
+
+    // Последний запрос, закрытый по таймауту, - для поиска опоздавших ответов
+    Pending m_timedOut;
+
+    // Запрос, с которым сопоставлен текущий ответ, - для отчёта
+    const Pending *m_answeredRequest = nullptr;
+
+    QVector<uint64_t> m_violations;
+    uint64_t m_frames = 0;
+
+    QVector<Record> m_records;
+};
@@ -0,0 +1,231 @@
+#include "conformance_window.h"
+
+#include <QCoreApplication>
+#include <QDate>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QTime>
+#include <QVBoxLayout>
+
+using namespace cannabus;
+
+ConformanceWindow::ConformanceWindow(QWidget *parent) :
+    QWidget(parent),
+    m_total(new QLabel(this)),
+    m_summary(new QTableWidget(this)),
+    m_report(new QTableWidget(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Protocol Conformance"));
+
+    for (QTableWidget *table : {m_summary, m_report})
+    {
+        table->verticalHeader()->hide();
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        table->horizontalHeader()->setStretchLastSection(true);
+    }
+
+    makeHeader();
+
+    // Строка на каждый вид нарушения, кроме 'none'
+    m_summary->setRowCount(ConformanceChecker::violations_count - 1);
+
+    for (uint32_t violation = 1; violation < ConformanceChecker::violations_count; violation++)
+    {
+        setCell(m_summary, violation - 1, 0, getViolationName((ConformanceViolation)violation));
+    }
+
+    auto saveButton = new QPushButton(tr("Save..."), this);
+    auto clearButton = new QPushButton(tr("Reset"), this);
+
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(m_total);
+    controlsLayout->addStretch();
+    controlsLayout->addWidget(clearButton);
+    controlsLayout->addWidget(saveButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(m_summary, 1);
+    layout->addWidget(m_report, 3);
+    layout->addLayout(controlsLayout);
+
+    connect(saveButton, &QPushButton::clicked, this, &ConformanceWindow::saveReport);
+    connect(clearButton, &QPushButton::clicked, this, &ConformanceWindow::clearStats);
+
+    refresh();
+
+    resize(900, 600);
+}
+
+void ConformanceWindow::makeHeader()
+{
+    QStringList summaryHeader = {"Violation", "Count"};
+
+    m_summary->setColumnCount(summaryHeader.count());
+    m_summary->setHorizontalHeaderLabels(summaryHeader);
+    m_summary->horizontalHeader()->setSectionsClickable(false);
+
+    QStringList reportHeader = {"Time", "Address", "Msg Type", "F-Code", "Data", "Request", "Violation"};
+
+    m_report->setColumnCount(reportHeader.count());
+    m_report->setHorizontalHeaderLabels(reportHeader);
+    m_report->horizontalHeader()->setSectionsClickable(false);
+}
+
+QString ConformanceWindow::getViolationName(const ConformanceViolation violation)
+{
+    return ConformanceChecker::getViolationName(violation);
+}
+
+ConformanceViolation ConformanceWindow::processDataFrame(const QCanBusFrame &frame)
+{
+    return m_checker.processDataFrame(frame);
+}
+
+void ConformanceWindow::refresh()
+{
+    m_checker.takeRecords(m_records);
+
+    if (m_records.isEmpty() == false)
+    {
+        m_hasNewViolations = true;
+
+        for (const ConformanceChecker::Record &record : qAsConst(m_records))
+        {
+            addReportRow(record);
+        }
+
+        // Старые кадры вытесняются, чтобы отчёт не рос бесконечно
+        const int32_t extraRows = m_report->rowCount() - max_report_rows;
+
+        for (int32_t row = 0; row < extraRows; row++)
+        {
+            m_report->removeRow(0);
+        }
+
+        m_report->scrollToBottom();
+    }
+
+    // Сводку перерисовываем, только если появились нарушения
+    if (m_hasNewViolations == false)
+    {
+        return;
+    }
+
+    m_hasNewViolations = false;
+
+    uint64_t violationsTotal = 0;
+
+    for (uint32_t violation = 1; violation < ConformanceChecker::violations_count; violation++)
+    {
+        const uint64_t count = m_checker.getViolationsCount((ConformanceViolation)violation);
+        violationsTotal += count;
+
+        setCell(m_summary, violation - 1, 1, tr("%1").arg(count));
+    }
+
+    m_total->setText(tr("Frames with violations: %1").arg(violationsTotal));
+}
+
+void ConformanceWindow::clearStats()
+{
+    m_checker.clear();
+    m_report->setRowCount(0);
+
+    m_hasNewViolations = true;
+    refresh();
+}
+
+void ConformanceWindow::addReportRow(const ConformanceChecker::Record &record)
+{
+    const int32_t row = m_report->rowCount();
+    m_report->insertRow(row);
+
+    const uint32_t slaveAddress = getAddressFromId(record.frameId);
+
+    // Время, адрес, тип сообщения и F-код в тех же форматах, что и в логе
+    setCell(m_report, row, (uint32_t)ConformanceWindowColumn::time,
+            tr("%1.%2").arg(record.time / 1000000, 4, 10, QLatin1Char(' '))
+                       .arg(record.time % 1000000 / 100, 4, 10, QLatin1Char('0')));
+    setCell(m_report, row, (uint32_t)ConformanceWindowColumn::slave_address,
+            tr("%1 (0x").arg(slaveAddress, 2, 10, QLatin1Char(' ')) +
+            tr("%1)").arg(slaveAddress, 2, 16, QLatin1Char('0')).toUpper());
+    setCell(m_report, row, (uint32_t)ConformanceWindowColumn::msg_type,
+            tr("0b%1").arg((uint32_t)getMsgTypeFromId(record.frameId), 2, 2, QLatin1Char('0')));
+    setCell(m_report, row, (uint32_t)ConformanceWindowColumn::f_code,
+            tr("0b%1").arg((uint32_t)getFCodeFromId(record.frameId), 3, 2, QLatin1Char('0')));
+    setCell(m_report, row, (uint32_t)ConformanceWindowColumn::data, record.data.toHex(' ').toUpper());
+    setCell(m_report, row, (uint32_t)ConformanceWindowColumn::request,
+            record.hasRequest != false ? frameToString(record.requestId, record.requestData) : "");
+    setCell(m_report, row, (uint32_t)ConformanceWindowColumn::violation, getViolationName(record.violation));
+}
+
+QString ConformanceWindow::frameToString(const uint32_t frameId, const QByteArray &data)
+{
+    // Запрос в виде '0x123 [2] 01 03'
+    return tr("0x%1 [%2] ").arg(frameId, 3, 16, QLatin1Char('0')).arg(data.size()) + data.toHex(' ').toUpper();
+}
+
+void ConformanceWindow::setCell(QTableWidget *table, const int32_t row, const uint32_t column, const QString text)
+{
+    QTableWidgetItem *item = table->item(row, column);
+
+    if (item == nullptr)
+    {
+        item = new QTableWidgetItem;
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        table->setItem(row, column, item);
+    }
+
+    item->setText(text);
+}
+
+void ConformanceWindow::saveReport()
+{
+    QString currentTime = QTime::currentTime().toString().replace(":", "-");
+    QString currentDate = QDate::currentDate().toString(Qt::ISODate);
+
+    QString name = tr("conformance_%1_%2").arg(currentDate).arg(currentTime);
+
+    QString filters("CSV files (*.csv);;All files (*.*)");
+    QString defaultFilter("CSV files (*.csv)");
+    QString fileName = QFileDialog::getSaveFileName(nullptr, "Save Conformance Report",
+                                                    QCoreApplication::applicationDirPath() + "/" + name + ".csv",
+                                                    filters, &defaultFilter);
+
+    QFile saveFile(fileName);
+
+    if (saveFile.open(QIODevice::WriteOnly) == false)
+    {
+        return;
+    }
+
+    QTextStream data(&saveFile);
+    QStringList stringList;
+
+    for (int32_t column = 0; column < m_report->columnCount(); column++)
+    {
+        stringList.append("\"" + m_report->horizontalHeaderItem(column)->text() + "\"");
+    }
+
+    data << stringList.join(";") + "\n";
+
+    for (int32_t row = 0; row < m_report->rowCount(); row++)
+    {
+        stringList.clear();
+
+        for (int32_t column = 0; column < m_report->columnCount(); column++)
+        {
+            stringList.append("\"" + m_report->item(row, column)->text().trimmed() + "\"");
+        }
+
+        data << stringList.join(";") + "\n";
+    }
+
+    saveFile.close();
+}
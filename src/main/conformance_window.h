@@ -0,0 +1,73 @@
+/****************************************************************************
+
+Класс ConformanceWindow выводит результаты проверки трафика на соответствие
+протоколу (ConformanceChecker): количество нарушений по видам и отчёт о
+кадрах с нарушениями вместе с запросами, в контексте которых они
+проверялись. В отчёте хранятся последние max_report_rows кадров, полный
+отчёт этого размера сохраняется в .csv-файл. Сами кадры с нарушениями
+подсвечиваются в логе.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <QCanBusFrame>
+#include <QVector>
+#include <stdint.h>
+#include "conformance_checker.h"
+
+QT_BEGIN_NAMESPACE
+
+class QLabel;
+class QTableWidget;
+
+QT_END_NAMESPACE
+
+enum class ConformanceWindowColumn {
+    time,
+    slave_address,
+    msg_type,
+    f_code,
+    data,
+    request,
+    violation
+};
+
+class ConformanceWindow : public QWidget
+{
+public:
+    explicit ConformanceWindow(QWidget *parent = nullptr);
+    ~ConformanceWindow() = default;
+
+    static constexpr uint32_t max_report_rows = 5000;
+
+    // Проверка кадра и вывод новых нарушений
+    ConformanceViolation processDataFrame(const QCanBusFrame &frame);
+    void refresh();
+
+    static QString getViolationName(const ConformanceViolation violation);
+
+public slots:
+    void clearStats();
+
+    // Сохранение отчёта в .csv-файл
+    void saveReport();
+
+private:
+    void makeHeader();
+
+    void addReportRow(const ConformanceChecker::Record &record);
+    void setCell(QTableWidget *table, const int32_t row, const uint32_t column, const QString text);
+
+    static QString frameToString(const uint32_t frameId, const QByteArray &data);
+
+    ConformanceChecker m_checker;
+
+    QLabel *m_total = nullptr;
+    QTableWidget *m_summary = nullptr;
+    QTableWidget *m_report = nullptr;
+
+    QVector<ConformanceChecker::Record> m_records;
+    bool m_hasNewViolations = true;
+};
@@ -0,0 +1,103 @@
+/****************************************************************************
+
+Интерфейс DeviceDecoderInterface - двоичный интерфейс плагинов расшифровки
+кадров с F-кодами DEVICE_SPECIFIC1..4, содержимое которых протоколом не
+определено и зависит от устройства.
+
+Плагин - разделяемая библиотека Qt (QPluginLoader) с объектом, который
+реализует этот интерфейс (Q_INTERFACES, Q_PLUGIN_METADATA с
+DeviceDecoderInterface_iid). Плагины загружаются при запуске из каталога
+decoders рядом с программой; каждой паре адрес - F-код назначается первый
+плагин, который её поддерживает (isSupported).
+
+Расшифровка не выделяет память: данные кадра передаются видом PayloadView
+без копирования, а поля пишутся в переиспользуемый буфер DecodedFields
+фиксированного размера. Строки полей (имена, подписи, единицы) должны
+жить, пока загружен плагин, - обычно это строковые литералы.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QtPlugin>
+#include <array>
+#include <stdint.h>
+#include "../cannabus_library/cannabus_common.h"
+
+// Данные кадра без копирования
+struct PayloadView {
+    const uint8_t *data = nullptr;
+    uint32_t size = 0;
+};
+
+// Буфер расшифрованных полей кадра
+class DecodedFields
+{
+public:
+    static constexpr uint32_t max_fields = 64;
+
+    struct Field {
+        const char *name = nullptr;
+        double value = 0.0;
+
+        // Подпись значения (например, имя состояния) и единица измерения; nullptr - нет
+        const char *label = nullptr;
+        const char *unit = nullptr;
+    };
+
+    void clear()
+    {
+        m_count = 0;
+    }
+
+    // false, если буфер заполнен
+    bool add(const char *name, const double value, const char *unit = nullptr, const char *label = nullptr)
+    {
+        if (m_count == max_fields)
+        {
+            return false;
+        }
+
+        Field &field = m_fields[m_count++];
+        field.name = name;
+        field.value = value;
+        field.unit = unit;
+        field.label = label;
+
+        return true;
+    }
+
+    uint32_t getCount() const
+    {
+        return m_count;
+    }
+
+    const Field &getField(const uint32_t index) const
+    {
+        return m_fields[index];
+    }
+
+private:
+    std::array<Field, max_fields> m_fields;
+    uint32_t m_count = 0;
+};
+
+class DeviceDecoderInterface
+{
+public:
+    virtual ~DeviceDecoderInterface() = default;
+
+    // Название расшифровщика для сообщений о загрузке
+    virtual const char *getName() const = 0;
+
+    // Расшифровывает ли плагин кадры с F-кодом fCode (DEVICE_SPECIFIC1..4) узла slaveAddress
+    virtual bool isSupported(const uint32_t slaveAddress, const cannabus::IdFCode fCode) const = 0;
+
+    // Расшифровка кадра в пустой буфер fields; false, если кадр не распознан
+    virtual bool decode(const uint32_t slaveAddress, const cannabus::IdMsgTypes msgType, const cannabus::IdFCode fCode,
+                        const PayloadView payload, DecodedFields &fields) const = 0;
+};
+
+#define DeviceDecoderInterface_iid "NarcoCANtrol.DeviceDecoderInterface/1.0"
+
+Q_DECLARE_INTERFACE(DeviceDecoderInterface, DeviceDecoderInterface_iid)
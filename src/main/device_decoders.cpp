@@ -0,0 +1,140 @@
+#include "device_decoders.h"
+
+#include <QDir>
+
+using namespace cannabus;
+
+DeviceDecoders::DeviceDecoders()
+{
+    m_table.fill(nullptr, addresses_count * f_codes_count);
+}
+
+bool DeviceDecoders::isDeviceSpecific(const IdFCode fCode)
+{
+    return fCode == IdFCode::DEVICE_SPECIFIC1 || fCode == IdFCode::DEVICE_SPECIFIC2 ||
+           fCode == IdFCode::DEVICE_SPECIFIC3 || fCode == IdFCode::DEVICE_SPECIFIC4;
+}
+
+uint32_t DeviceDecoders::getIndex(const uint32_t slaveAddress, const IdFCode fCode)
+{
+    return slaveAddress * f_codes_count + ((uint32_t)fCode - (uint32_t)IdFCode::DEVICE_SPECIFIC1);
+}
+
+QStringList DeviceDecoders::loadPlugins(const QString &directory, QStringList &errors)
+{
+    const QDir pluginsDir(directory);
+    QStringList names;
+
+    for (const QString &fileName : pluginsDir.entryList(QDir::Files))
+    {
+        std::unique_ptr<QPluginLoader> loader(new QPluginLoader(pluginsDir.absoluteFilePath(fileName)));
+
+        QObject *plugin = loader->instance();
+
+        if (plugin == nullptr)
+        {
+            errors.append(QString("%1: %2").arg(fileName).arg(loader->errorString()));
+            continue;
+        }
+
+        const DeviceDecoderInterface *decoder = qobject_cast<DeviceDecoderInterface *>(plugin);
+
+        if (decoder == nullptr)
+        {
+            errors.append(QString("%1: not a device decoder").arg(fileName));
+            loader->unload();
+            continue;
+        }
+
+        // Пары адрес - F-код, уже занятые ранее загруженными плагинами, не переназначаем
+        for (uint32_t slaveAddress = 0; slaveAddress < addresses_count; slaveAddress++)
+        {
+            for (const IdFCode fCode : {IdFCode::DEVICE_SPECIFIC1, IdFCode::DEVICE_SPECIFIC2,
+                                        IdFCode::DEVICE_SPECIFIC3, IdFCode::DEVICE_SPECIFIC4})
+            {
+                const uint32_t index = getIndex(slaveAddress, fCode);
+
+                if (m_table[index] == nullptr && decoder->isSupported(slaveAddress, fCode) != false)
+                {
+                    m_table[index] = decoder;
+                }
+            }
+        }
+
+        m_loaders.push_back(std::move(loader));
+        names.append(QString::fromUtf8(decoder->getName()));
+    }
+
+    return names;
+}
+
+bool DeviceDecoders::isLoaded() const
+{
+    return m_loaders.empty() == false;
+}
+
+bool DeviceDecoders::decode(const uint32_t frameId, const QByteArray &payload, DecodedFields &fields) const
+{
+    fields.clear();
+
+    const uint32_t slaveAddress = getAddressFromId(frameId);
+    const IdMsgTypes msgType = getMsgTypeFromId(frameId);
+    const IdFCode fCode = getFCodeFromId(frameId);
+
+    if (slaveAddress >= addresses_count || isDeviceSpecific(fCode) == false)
+    {
+        return false;
+    }
+
+    const DeviceDecoderInterface *decoder = m_table[getIndex(slaveAddress, fCode)];
+
+    if (decoder == nullptr)
+    {
+        return false;
+    }
+
+    // Данные передаём без копирования
+    PayloadView view;
+    view.data = reinterpret_cast<const uint8_t *>(payload.constData());
+    view.size = payload.size();
+
+    if (decoder->decode(slaveAddress, msgType, fCode, view, fields) == false)
+    {
+        fields.clear();
+        return false;
+    }
+
+    return true;
+}
+
+QString DeviceDecoders::toString(const DecodedFields &fields)
+{
+    QString text;
+
+    for (uint32_t index = 0; index < fields.getCount(); index++)
+    {
+        const DecodedFields::Field &field = fields.getField(index);
+
+        if (index != 0)
+        {
+            text += ", ";
+        }
+
+        text += QString::fromUtf8(field.name) + "=";
+
+        if (field.label != nullptr)
+        {
+            text += QString::fromUtf8(field.label);
+            continue;
+        }
+
+        text += QString::number(field.value, 'g', 10);
+
+        if (field.unit != nullptr)
+        {
+            text += " " + QString::fromUtf8(field.unit);
+        }
+    }
+
+    return text;
+}
@@ -0,0 +1,54 @@
+/****************************************************************************
+
+Класс DeviceDecoders загружает плагины расшифровки device-specific кадров
+(DeviceDecoderInterface) и выбирает расшифровщик для кадра по таблице
+адрес x F-код, заполненной при загрузке, то есть за O(1) без перебора
+плагинов.
+
+Расшифрованные поля используются логом (столбец 'Decoded' и сохранение
+лога) и фильтром по полям (Filter).
+
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QPluginLoader>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include "device_decoder_interface.h"
+
+class DeviceDecoders
+{
+public:
+    DeviceDecoders();
+    ~DeviceDecoders() = default;
+
+    static constexpr uint32_t addresses_count = (uint32_t)cannabus::IdAddresses::MAX_PERMITTED_ADDRESS + 1;
+    static constexpr uint32_t f_codes_count = 4;
+
+    // Загрузка всех плагинов каталога; возвращает названия загруженных, причины отказов - в errors
+    QStringList loadPlugins(const QString &directory, QStringList &errors);
+
+    bool isLoaded() const;
+
+    // Расшифровка кадра в буфер fields (очищается); false, если расшифровщика нет или кадр не распознан
+    bool decode(const uint32_t frameId, const QByteArray &payload, DecodedFields &fields) const;
+
+    // Поля в виде 'name=value unit, name=label, ...'
+    static QString toString(const DecodedFields &fields);
+
+    static bool isDeviceSpecific(const cannabus::IdFCode fCode);
+
+private:
+    static uint32_t getIndex(const uint32_t slaveAddress, const cannabus::IdFCode fCode);
+
+    std::vector<std::unique_ptr<QPluginLoader>> m_loaders;
+
+    // Расшифровщик для каждой пары адрес - F-код, nullptr - нет
+    QVector<const DeviceDecoderInterface *> m_table;
+};
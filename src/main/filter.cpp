@@ -1,5 +1,9 @@
 #include "filter.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 using namespace cannabus;
 
 Filter::Filter(QObject *parent) : QObject(parent)
@@ -35,6 +39,12 @@ bool Filter::mustDataFrameBeProcessed(const QCanBusFrame &frame)
     const QByteArray dataArray = frame.payload();
     isFiltrated &= isContentFiltrated(msgType, fCode, dataArray);
 
+    // Расшифровываем device-specific кадр, только если он прошёл остальные фильтры
+    if (isFiltrated != false)
+    {
+        isFiltrated &= isDecodedFieldsFiltrated(frameId, dataArray);
+    }
+
     return isFiltrated;
 }
 
@@ -326,6 +336,83 @@ bool Filter::isContentFiltrated(const IdMsgTypes msgType, const IdFCode fCode, c
     }
 }
 
+void Filter::setDeviceDecoders(const DeviceDecoders *deviceDecoders)
+{
+    m_deviceDecoders = deviceDecoders;
+}
+
+void Filter::setDecodedFieldsFilter(QString fieldsFilter)
+{
+    m_fieldConditions.clear();
+
+    for (const QString &conditionText : fieldsFilter.split(',', Qt::SkipEmptyParts))
+    {
+        FieldCondition condition;
+
+        const int32_t separator = conditionText.indexOf('=');
+        condition.name = conditionText.left(separator).trimmed().toUtf8();
+
+        if (separator != -1)
+        {
+            const QString valueText = conditionText.mid(separator + 1).trimmed();
+
+            condition.hasValue = true;
+            condition.value = valueText.toDouble(&condition.isNumeric);
+            condition.label = valueText.toUtf8();
+        }
+
+        if (condition.name.isEmpty() == false)
+        {
+            m_fieldConditions.append(condition);
+        }
+    }
+}
+
+bool Filter::isDecodedFieldsFiltrated(const uint32_t frameId, const QByteArray &dataArray)
+{
+    if (m_fieldConditions.isEmpty() != false || m_deviceDecoders == nullptr)
+    {
+        return true;
+    }
+
+    // Поля пишутся в буфер фильтра, поэтому проверка кадра обходится без выделения памяти
+    if (m_deviceDecoders->decode(frameId, dataArray, m_decodedFields) == false)
+    {
+        return true;
+    }
+
+    for (uint32_t index = 0; index < m_decodedFields.getCount(); index++)
+    {
+        const DecodedFields::Field &field = m_decodedFields.getField(index);
+
+        for (const FieldCondition &condition : qAsConst(m_fieldConditions))
+        {
+            if (std::strcmp(field.name, condition.name.constData()) != 0)
+            {
+                continue;
+            }
+
+            if (condition.hasValue == false)
+            {
+                return true;
+            }
+
+            if (condition.isNumeric != false &&
+                std::abs(field.value - condition.value) <= 1e-9 * std::max(1.0, std::abs(condition.value)))
+            {
+                return true;
+            }
+
+            if (field.label != nullptr && std::strcmp(field.label, condition.label.constData()) == 0)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 bool Filter::isPairRegDataFiltrated(const uint8_t reg, const uint8_t data) const
 {
     // Поочерёдно проверяем пары регистр-данные
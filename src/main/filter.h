@@ -5,6 +5,9 @@
 слоты для установки и/или удаления фильтров адресов ведомых узлов, типов
 сообщений, кодов функций (F-кодов) и содержимого (регистров и данных).
 
+Device-specific кадры, для которых загружен плагин расшифровки
+(DeviceDecoders), дополнительно фильтруются по расшифрованным полям.
+
 ****************************************************************************/
 
 #pragma once
@@ -13,6 +16,7 @@
 #include <QObject>
 #include <stdint.h>
 #include "../cannabus_library/cannabus_common.h"
+#include "device_decoders.h"
 
 class Filter : public QObject
 {
@@ -52,6 +56,13 @@ public:
     void setContentFiltrated(const QVector<uint8_t> regs, const QVector<uint8_t> data);
     bool isContentFiltrated(const cannabus::IdMsgTypes msgType, const cannabus::IdFCode fCode, QByteArray dataArray) const;
 
+    // Плагины расшифровки device-specific кадров для фильтра по полям
+    void setDeviceDecoders(const DeviceDecoders *deviceDecoders);
+
+    // Проверка фильтрации device-specific кадра по расшифрованным полям;
+    // кадры других F-кодов и кадры, которые некому расшифровать, проходят
+    bool isDecodedFieldsFiltrated(const uint32_t frameId, const QByteArray &dataArray);
+
     // Проверка фильтрации пары регистр-данные
     bool isPairRegDataFiltrated(const uint8_t reg, const uint8_t data) const;
 
@@ -75,6 +86,9 @@ public slots:
     void setContentFilter(QString regsRange, QString dataRange);
     void removeContentFilter(const int32_t index);
 
+    // Установка фильтра по расшифрованным полям: 'name' или 'name=value' через запятую
+    void setDecodedFieldsFilter(QString fieldsFilter);
+
 signals:
     // Сигнал окну лога для инкрементации количества принятых сообщений
     void frameIsProcessing();
@@ -86,5 +100,18 @@ signals:
     void contentFilterAdded(const QString regsRange, const QString dataRange);
 
 private:
+    // Условие на поле: есть поле с именем name и, если задано, значением value или подписью label
+    struct FieldCondition {
+        QByteArray name;
+        bool hasValue = false;
+        bool isNumeric = false;
+        double value = 0.0;
+        QByteArray label;
+    };
+
     Settings m_settings;
+
+    QVector<FieldCondition> m_fieldConditions;
+    const DeviceDecoders *m_deviceDecoders = nullptr;
+    DecodedFields m_decodedFields;
 };
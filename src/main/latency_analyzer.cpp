@@ -0,0 +1,400 @@
+#include "latency_analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cannabus;
+
+LatencyHistogram::LatencyHistogram()
+{
+}
+
+uint32_t LatencyHistogram::getBucket(const uint64_t value)
+{
+    // Первые две октавы хранятся с точностью до единицы, дальше номер корзины -
+    // номер октавы и старшие sub_buckets_bits бит значения
+    const uint64_t maxValue = ((uint64_t)1 << max_value_bits) - 1;
+    const uint64_t clampedValue = std::min(value, maxValue);
+
+    uint32_t shift = 0;
+
+    while ((clampedValue >> shift) >= 2 * sub_buckets_count)
+    {
+        shift++;
+    }
+
+    return (shift << sub_buckets_bits) + (uint32_t)(clampedValue >> shift);
+}
+
+uint32_t LatencyHistogram::getBucketShift(const uint32_t bucket)
+{
+    const uint32_t octave = bucket >> sub_buckets_bits;
+
+    return octave > 1 ? octave - 1 : 0;
+}
+
+void LatencyHistogram::add(const uint64_t value)
+{
+    if (m_buckets.isEmpty() != false)
+    {
+        m_buckets.fill(0, buckets_count);
+    }
+
+    m_buckets[getBucket(value)]++;
+
+    m_min = m_count == 0 ? value : std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    m_sum += value;
+    m_count++;
+}
+
+void LatencyHistogram::clear()
+{
+    m_buckets.clear();
+
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0;
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+    return m_count;
+}
+
+uint64_t LatencyHistogram::getMin() const
+{
+    return m_min;
+}
+
+uint64_t LatencyHistogram::getMax() const
+{
+    return m_max;
+}
+
+double LatencyHistogram::getMean() const
+{
+    return m_count == 0 ? 0 : (double)m_sum / m_count;
+}
+
+uint64_t LatencyHistogram::getPercentile(const double percentile) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+
+    // Номер значения в упорядоченной выборке, начиная с единицы
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(percentile / 100 * m_count));
+
+    if (rank >= m_count)
+    {
+        return m_max;
+    }
+
+    uint64_t counted = 0;
+
+    for (uint32_t bucket = 0; bucket < buckets_count; bucket++)
+    {
+        counted += m_buckets[bucket];
+
+        if (counted >= rank)
+        {
+            const uint32_t shift = getBucketShift(bucket);
+            const uint64_t lowValue = (uint64_t)(bucket - (shift << sub_buckets_bits)) << shift;
+            const uint64_t middleValue = lowValue + ((uint64_t)1 << shift) / 2;
+
+            return std::max(m_min, std::min(m_max, middleValue));
+        }
+    }
+
+    return m_max;
+}
+
+LatencyAnalyzer::LatencyAnalyzer()
+{
+    m_stats.resize(keys_count);
+    m_isKeyUsed.fill(false, keys_count);
+    m_isKeyDirty.fill(false, keys_count);
+}
+
+void LatencyAnalyzer::clear()
+{
+    for (uint32_t key = 0; key < keys_count; key++)
+    {
+        if (m_isKeyUsed[key] != false)
+        {
+            m_stats[key] = Stats();
+            getStatsForUpdate(key);
+        }
+    }
+
+    m_pending = Pending();
+    m_timedOut = Pending();
+
+    m_unexpectedCount = 0;
+}
+
+void LatencyAnalyzer::setLateThreshold(const uint32_t lateThreshold)
+{
+    m_lateThreshold = lateThreshold;
+}
+
+uint32_t LatencyAnalyzer::getLateThreshold() const
+{
+    return m_lateThreshold;
+}
+
+bool LatencyAnalyzer::hasStats(const uint32_t key) const
+{
+    return m_isKeyUsed[key];
+}
+
+const LatencyAnalyzer::Stats &LatencyAnalyzer::getStats(const uint32_t key) const
+{
+    return m_stats[key];
+}
+
+uint64_t LatencyAnalyzer::getUnexpectedCount() const
+{
+    return m_unexpectedCount;
+}
+
+LatencyAnalyzer::Stats &LatencyAnalyzer::getStatsForUpdate(const uint32_t key)
+{
+    m_isKeyUsed[key] = true;
+
+    if (m_isKeyDirty[key] == false)
+    {
+        m_isKeyDirty[key] = true;
+        m_dirtyKeys.append(key);
+    }
+
+    return m_stats[key];
+}
+
+void LatencyAnalyzer::takeDirtyKeys(QVector<uint32_t> &keys)
+{
+    keys.clear();
+    keys.swap(m_dirtyKeys);
+
+    for (const uint32_t key : qAsConst(keys))
+    {
+        m_isKeyDirty[key] = false;
+    }
+}
+
+void LatencyAnalyzer::processDataFrame(const QCanBusFrame &frame)
+{
+    const uint32_t frameId = frame.frameId();
+    const IdMsgTypes msgType = getMsgTypeFromId(frameId);
+
+    if (getAddressFromId(frameId) > (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS)
+    {
+        return;
+    }
+
+    const uint64_t time = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+
+    if (msgType == IdMsgTypes::MASTER || msgType == IdMsgTypes::HIGH_PRIO_MASTER)
+    {
+        processRequest(frameId, frame.payload(), time);
+    }
+    else if (msgType == IdMsgTypes::SLAVE)
+    {
+        processAnswer(frameId, frame.payload(), time);
+    }
+}
+
+void LatencyAnalyzer::processRequest(const uint32_t frameId, const QByteArray &data, const uint64_t time)
+{
+    // Ведущий шлёт новый запрос, только когда перестал ждать ответа на предыдущий
+    const bool isTimedOut = closePending();
+
+    // На широковещательные запросы ведомые не отвечают
+    if (getAddressFromId(frameId) == (uint32_t)IdAddresses::BROADCAST)
+    {
+        return;
+    }
+
+    const bool isRetry = isTimedOut != false && m_timedOut.id == frameId && m_timedOut.data == data;
+
+    Stats &stats = getStatsForUpdate(getKey(getAddressFromId(frameId), getFCodeFromId(frameId)));
+    stats.requests++;
+
+    if (isRetry != false)
+    {
+        stats.retries++;
+    }
+
+    m_pending.isActive = true;
+    m_pending.isRetry = isRetry;
+    m_pending.isAnswered = false;
+    m_pending.id = frameId;
+    m_pending.data = data;
+    m_pending.time = time;
+}
+
+bool LatencyAnalyzer::closePending()
+{
+    if (m_pending.isActive == false)
+    {
+        return false;
+    }
+
+    m_pending.isActive = false;
+
+    // На прямой доступ отвечают несколько ведомых, поэтому он закрывается только следующим запросом
+    if (m_pending.isAnswered != false)
+    {
+        return false;
+    }
+
+    Stats &stats = getStatsForUpdate(getKey(getAddressFromId(m_pending.id), getFCodeFromId(m_pending.id)));
+    stats.timeouts++;
+
+    m_timedOut = m_pending;
+    m_timedOut.isActive = true;
+
+    return true;
+}
+
+void LatencyAnalyzer::processAnswer(const uint32_t frameId, const QByteArray &data, const uint64_t time)
+{
+    if (m_pending.isActive != false && isAnswerRelevant(frameId, data, m_pending.id, m_pending.data) != false)
+    {
+        Stats &stats = getStatsForUpdate(getKey(getAddressFromId(m_pending.id), getFCodeFromId(m_pending.id)));
+
+        const uint64_t latency = time >= m_pending.time ? time - m_pending.time : 0;
+
+        stats.answers++;
+
+        if (latency > m_lateThreshold)
+        {
+            stats.late++;
+        }
+
+        if (m_pending.isRetry == false)
+        {
+            stats.latency.add(latency);
+        }
+
+        m_pending.isAnswered = true;
+
+        if (getAddressFromId(m_pending.id) != (uint32_t)IdAddresses::DIRECT_ACCESS)
+        {
+            m_pending.isActive = false;
+            m_pending.data.clear();
+        }
+
+        return;
+    }
+
+    // Ответ на запрос, который ведущий уже закрыл по таймауту: он его отбросил
+    if (m_timedOut.isActive != false && isAnswerRelevant(frameId, data, m_timedOut.id, m_timedOut.data) != false)
+    {
+        Stats &stats = getStatsForUpdate(getKey(getAddressFromId(m_timedOut.id), getFCodeFromId(m_timedOut.id)));
+        stats.afterTimeout++;
+
+        return;
+    }
+
+    if (m_pending.isActive == false)
+    {
+        m_unexpectedCount++;
+        return;
+    }
+
+    Stats &stats = getStatsForUpdate(getKey(getAddressFromId(m_pending.id), getFCodeFromId(m_pending.id)));
+    stats.irrelevant++;
+}
+
+bool LatencyAnalyzer::isAnswerRelevant(const uint32_t answerId, const QByteArray &answer,
+                                       const uint32_t requestId, const QByteArray &request)
+{
+    const uint32_t requestAddress = getAddressFromId(requestId);
+
+    // Адрес должен совпадать, на прямой доступ отвечает любой
+    if (requestAddress != (uint32_t)IdAddresses::DIRECT_ACCESS && requestAddress != getAddressFromId(answerId))
+    {
+        return false;
+    }
+
+    // F-код должен совпадать
+    const IdFCode fCode = getFCodeFromId(requestId);
+
+    if (fCode != getFCodeFromId(answerId))
+    {
+        return false;
+    }
+
+    // Пустой ответ - сообщение ведомого о некорректном запросе
+    if (answer.size() == 0)
+    {
+        return false;
+    }
+
+    switch (fCode)
+    {
+        case IdFCode::WRITE_REGS_RANGE:
+        {
+            // Эхо начала и конца диапазона
+            return request.size() >= 2 && answer.size() == 2 &&
+                   answer[0] == request[0] && answer[1] == request[1];
+        }
+        case IdFCode::WRITE_REGS_SERIES:
+        {
+            // Эхо номеров регистров серии
+            if (request.size() != answer.size() * 2)
+            {
+                return false;
+            }
+
+            for (int32_t index = 0; index < answer.size(); index++)
+            {
+                if (answer[index] != request[index * 2])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+        case IdFCode::READ_REGS_RANGE:
+        {
+            // Начало и конец диапазона и значения всех регистров
+            if (request.size() != 2)
+            {
+                return false;
+            }
+
+            const int32_t delta = static_cast<uint8_t>(request[1]) - static_cast<uint8_t>(request[0]) + 1;
+
+            return answer.size() == request.size() + delta && answer[0] == request[0] && answer[1] == request[1];
+        }
+        case IdFCode::READ_REGS_SERIES:
+        {
+            // Пары номер - значение в порядке запроса
+            if (request.size() * 2 != answer.size())
+            {
+                return false;
+            }
+
+            for (int32_t index = 0; index < request.size(); index++)
+            {
+                if (request[index] != answer[index * 2])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+        default:
+        {
+            // Специальные функции могут содержать любые данные
+            return true;
+        }
+    }
+}
@@ -0,0 +1,160 @@
+/****************************************************************************
+
+Класс LatencyAnalyzer сопоставляет запросы ведущего узла с ответами ведомых
+по тем же правилам, что и MasterSession::isAnswerRelevant (адрес, F-код,
+эхо номеров регистров и длина ответа), и собирает задержки ответа в
+гистограммы отдельно для каждого адреса и F-кода.
+
+Время берётся из меток времени кадров, которые ставит адаптер. Как и у
+MasterSession, ожидающий ответа запрос на шине всегда один: ведущий шлёт
+следующий запрос, только дождавшись ответа или таймаута. Поэтому любой
+новый запрос ведущего, на любой адрес, закрывает неотвеченный запрос как
+таймаут. Если это тот же ID с теми же данными, новый запрос считается
+повтором. Задержка ответа на повтор неоднозначна и, как и в MasterSession,
+в гистограмму не попадает. Ответ на уже закрытый запрос - опоздавший: ведущий
+его отбросил, поэтому он считается отдельно и задержки не даёт.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QCanBusFrame>
+#include <QVector>
+#include <stdint.h>
+#include "../cannabus_library/cannabus_common.h"
+
+// Гистограмма с логарифмическими корзинами по образцу HDR Histogram:
+// каждая октава делится на sub_buckets_count равных частей, поэтому
+// относительная погрешность любого перцентиля не больше 1/32
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    ~LatencyHistogram() = default;
+
+    // Значения до 2^26 мкс (около 67 с), большие попадают в последнюю корзину
+    static constexpr uint32_t sub_buckets_bits = 5;
+    static constexpr uint32_t sub_buckets_count = 1 << sub_buckets_bits;
+    static constexpr uint32_t max_value_bits = 26;
+    static constexpr uint32_t buckets_count = sub_buckets_count * (max_value_bits - sub_buckets_bits + 1);
+
+    void add(const uint64_t value);
+    void clear();
+
+    uint64_t getCount() const;
+    uint64_t getMin() const;
+    uint64_t getMax() const;
+    double getMean() const;
+
+    // Перцентиль percentile (0..100) - середина корзины, в которую он попал
+    uint64_t getPercentile(const double percentile) const;
+
+private:
+    static uint32_t getBucket(const uint64_t value);
+    static uint32_t getBucketShift(const uint32_t bucket);
+
+    // Корзины выделяются при первом значении: большинство пар адрес - F-код на шине не встречаются
+    QVector<uint32_t> m_buckets;
+
+    uint64_t m_count = 0;
+    uint64_t m_min = 0;
+    uint64_t m_max = 0;
+    uint64_t m_sum = 0;
+};
+
+class LatencyAnalyzer
+{
+public:
+    LatencyAnalyzer();
+    ~LatencyAnalyzer() = default;
+
+    // Адреса 0..61 и все F-коды
+    static constexpr uint32_t addresses_count = (uint32_t)cannabus::IdAddresses::MAX_PERMITTED_ADDRESS + 1;
+    static constexpr uint32_t f_codes_count = 8;
+    static constexpr uint32_t keys_count = addresses_count * f_codes_count;
+
+    // Порог, после которого ответ считается опоздавшим, мкс
+    static constexpr uint32_t default_late_threshold = 100000;
+
+    struct Stats {
+        LatencyHistogram latency;
+        uint64_t requests = 0;
+        uint64_t answers = 0;
+        uint64_t timeouts = 0;
+        uint64_t retries = 0;
+        uint64_t late = 0;
+        uint64_t irrelevant = 0;
+
+        // Ответы, пришедшие после таймаута запроса
+        uint64_t afterTimeout = 0;
+    };
+
+    // Обработка кадра данных
+    void processDataFrame(const QCanBusFrame &frame);
+
+    // Сброс статистики и ожидаемых ответов
+    void clear();
+
+    void setLateThreshold(const uint32_t lateThreshold);
+    uint32_t getLateThreshold() const;
+
+    // Ключ статистики и обратное преобразование
+    static uint32_t getKey(const uint32_t slaveAddress, const cannabus::IdFCode fCode)
+    {
+        return slaveAddress * f_codes_count + (uint32_t)fCode;
+    }
+
+    static uint32_t getAddressFromKey(const uint32_t key)
+    {
+        return key / f_codes_count;
+    }
+
+    static cannabus::IdFCode getFCodeFromKey(const uint32_t key)
+    {
+        return (cannabus::IdFCode)(key % f_codes_count);
+    }
+
+    bool hasStats(const uint32_t key) const;
+    const Stats &getStats(const uint32_t key) const;
+
+    // Ответы ведомых, для которых не нашлось запроса
+    uint64_t getUnexpectedCount() const;
+
+    // Забрать ключи, статистика по которым изменилась с прошлого вызова
+    void takeDirtyKeys(QVector<uint32_t> &keys);
+
+private:
+    // Запрос, ожидающий ответа
+    struct Pending {
+        bool isActive = false;
+        bool isRetry = false;
+        bool isAnswered = false;
+        uint32_t id = 0;
+        QByteArray data;
+        uint64_t time = 0;
+    };
+
+    void processRequest(const uint32_t frameId, const QByteArray &data, const uint64_t time);
+    void processAnswer(const uint32_t frameId, const QByteArray &data, const uint64_t time);
+
+    // Закрытие ожидающего запроса: без ответа - таймаут; возвращает, был ли таймаут
+    bool closePending();
+
+    // Проверка ответа по правилам MasterSession::isAnswerRelevant
+    static bool isAnswerRelevant(const uint32_t answerId, const QByteArray &answer,
+                                 const uint32_t requestId, const QByteArray &request);
+
+    Stats &getStatsForUpdate(const uint32_t key);
+
+    QVector<Stats> m_stats;
+    QVector<bool> m_isKeyUsed;
+    QVector<bool> m_isKeyDirty;
+    QVector<uint32_t> m_dirtyKeys;
+
+    // Единственный ожидающий запрос и последний закрытый по таймауту (isActive - такой был)
+    Pending m_pending;
+    Pending m_timedOut;
+
+    uint32_t m_lateThreshold = default_late_threshold;
+    uint64_t m_unexpectedCount = 0;
+};
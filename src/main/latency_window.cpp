@@ -0,0 +1,249 @@
+#include "latency_window.h"
+
+#include <QCoreApplication>
+#include <QDate>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTextStream>
+#include <QTime>
+#include <QVBoxLayout>
+
+using namespace cannabus;
+
+LatencyWindow::LatencyWindow(QWidget *parent) :
+    QWidget(parent),
+    m_table(new QTableWidget(this)),
+    m_lateThreshold(new QSpinBox(this)),
+    m_unexpected(new QLabel(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Answer Latency"));
+
+    m_keyRow.fill(-1, LatencyAnalyzer::keys_count);
+
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    makeHeader();
+
+    m_lateThreshold->setRange(1, 10000);
+    m_lateThreshold->setSuffix(tr(" ms"));
+    m_lateThreshold->setValue(LatencyAnalyzer::default_late_threshold / 1000);
+
+    auto saveButton = new QPushButton(tr("Save..."), this);
+    auto clearButton = new QPushButton(tr("Reset"), this);
+
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(new QLabel(tr("Late after"), this));
+    controlsLayout->addWidget(m_lateThreshold);
+    controlsLayout->addWidget(m_unexpected);
+    controlsLayout->addStretch();
+    controlsLayout->addWidget(clearButton);
+    controlsLayout->addWidget(saveButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(m_table);
+    layout->addLayout(controlsLayout);
+
+    connect(m_lateThreshold, QOverload<int>::of(&QSpinBox::valueChanged), this, &LatencyWindow::lateThresholdChanged);
+    connect(saveButton, &QPushButton::clicked, this, &LatencyWindow::saveStats);
+    connect(clearButton, &QPushButton::clicked, this, &LatencyWindow::clearStats);
+
+    resize(1000, 400);
+}
+
+void LatencyWindow::makeHeader()
+{
+    QStringList latencyWindowHeader = {"Address", "F-Code", "Requests", "Answers", "p50, ms", "p99, ms", "Max, ms",
+                                       "Timeouts", "Retries", "Late", "Irrelevant", "After Timeout"};
+
+    m_table->setColumnCount(latencyWindowHeader.count());
+    m_table->setHorizontalHeaderLabels(latencyWindowHeader);
+
+    m_table->horizontalHeader()->setSectionsClickable(false);
+    m_table->horizontalHeader()->setFixedHeight(1.5 * fontMetrics().height());
+}
+
+void LatencyWindow::processDataFrame(const QCanBusFrame &frame)
+{
+    m_analyzer.processDataFrame(frame);
+}
+
+void LatencyWindow::refresh()
+{
+    m_analyzer.takeDirtyKeys(m_dirtyKeys);
+
+    for (const uint32_t key : qAsConst(m_dirtyKeys))
+    {
+        setRow(getRow(key), key);
+    }
+
+    m_unexpected->setText(tr("Unexpected answers: %1").arg(m_analyzer.getUnexpectedCount()));
+}
+
+void LatencyWindow::clearStats()
+{
+    m_analyzer.clear();
+    refresh();
+}
+
+void LatencyWindow::lateThresholdChanged(const int32_t lateThreshold)
+{
+    m_analyzer.setLateThreshold(lateThreshold * 1000);
+}
+
+int32_t LatencyWindow::getRow(const uint32_t key)
+{
+    if (m_keyRow[key] != -1)
+    {
+        return m_keyRow[key];
+    }
+
+    // Строки упорядочены по ключу, то есть по адресу, а внутри адреса - по F-коду
+    int32_t row = 0;
+
+    for (uint32_t otherKey = 0; otherKey < key; otherKey++)
+    {
+        if (m_keyRow[otherKey] != -1)
+        {
+            row++;
+        }
+    }
+
+    for (uint32_t otherKey = key + 1; otherKey < LatencyAnalyzer::keys_count; otherKey++)
+    {
+        if (m_keyRow[otherKey] != -1)
+        {
+            m_keyRow[otherKey]++;
+        }
+    }
+
+    m_table->insertRow(row);
+    m_keyRow[key] = row;
+
+    return row;
+}
+
+void LatencyWindow::setRow(const int32_t row, const uint32_t key)
+{
+    const LatencyAnalyzer::Stats &stats = m_analyzer.getStats(key);
+    const uint32_t slaveAddress = LatencyAnalyzer::getAddressFromKey(key);
+    const IdFCode fCode = LatencyAnalyzer::getFCodeFromKey(key);
+
+    // Адрес и F-код в тех же форматах, что и в логе: '10 (0x0A)' и '0b101'
+    setCell(row, LatencyWindowColumn::slave_address, tr("%1 (0x").arg(slaveAddress, 2, 10, QLatin1Char(' ')) +
+                                                     tr("%1)").arg(slaveAddress, 2, 16, QLatin1Char('0')).toUpper());
+    setCell(row, LatencyWindowColumn::f_code, tr("0b%1").arg((uint32_t)fCode, 3, 2, QLatin1Char('0')));
+
+    setCell(row, LatencyWindowColumn::requests     , tr("%1").arg(stats.requests    ));
+    setCell(row, LatencyWindowColumn::answers      , tr("%1").arg(stats.answers     ));
+    setCell(row, LatencyWindowColumn::timeouts     , tr("%1").arg(stats.timeouts    ));
+    setCell(row, LatencyWindowColumn::retries      , tr("%1").arg(stats.retries     ));
+    setCell(row, LatencyWindowColumn::late         , tr("%1").arg(stats.late        ));
+    setCell(row, LatencyWindowColumn::irrelevant   , tr("%1").arg(stats.irrelevant  ));
+    setCell(row, LatencyWindowColumn::after_timeout, tr("%1").arg(stats.afterTimeout));
+
+    setCell(row, LatencyWindowColumn::p50, latencyToString(stats.latency.getPercentile(50)));
+    setCell(row, LatencyWindowColumn::p99, latencyToString(stats.latency.getPercentile(99)));
+    setCell(row, LatencyWindowColumn::max, latencyToString(stats.latency.getMax()));
+}
+
+void LatencyWindow::setCell(const int32_t row, const LatencyWindowColumn column, const QString text)
+{
+    QTableWidgetItem *item = m_table->item(row, (uint32_t)column);
+
+    if (item == nullptr)
+    {
+        item = new QTableWidgetItem;
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        m_table->setItem(row, (uint32_t)column, item);
+    }
+
+    item->setText(text);
+}
+
+QString LatencyWindow::latencyToString(const uint64_t latency)
+{
+    return tr("%1").arg(latency / 1000.0, 0, 'f', 3);
+}
+
+void LatencyWindow::saveStats()
+{
+    QString currentTime = QTime::currentTime().toString().replace(":", "-");
+    QString currentDate = QDate::currentDate().toString(Qt::ISODate);
+
+    QString name = tr("latency_%1_%2").arg(currentDate).arg(currentTime);
+
+    QString filters("CSV files (*.csv);;All files (*.*)");
+    QString defaultFilter("CSV files (*.csv)");
+    QString fileName = QFileDialog::getSaveFileName(nullptr, "Save Latency Statistics",
+                                                    QCoreApplication::applicationDirPath() + "/" + name + ".csv",
+                                                    filters, &defaultFilter);
+
+    QFile saveFile(fileName);
+
+    if (saveFile.open(QIODevice::WriteOnly) == false)
+    {
+        return;
+    }
+
+    QTextStream data(&saveFile);
+    QStringList stringList;
+
+    // Задержки сохраняем в мкс, а не в мс, как в таблице
+    QStringList header = {"Address", "F-Code", "Requests", "Answers", "Min, us", "Mean, us", "p50, us", "p90, us",
+                          "p99, us", "p99.9, us", "Max, us", "Timeouts", "Retries", "Late", "Irrelevant",
+                          "After Timeout"};
+
+    for (const QString &text : qAsConst(header))
+    {
+        stringList.append("\"" + text + "\"");
+    }
+
+    data << stringList.join(";") + "\n";
+
+    for (uint32_t key = 0; key < LatencyAnalyzer::keys_count; key++)
+    {
+        if (m_analyzer.hasStats(key) == false)
+        {
+            continue;
+        }
+
+        const LatencyAnalyzer::Stats &stats = m_analyzer.getStats(key);
+        const LatencyHistogram &latency = stats.latency;
+
+        stringList.clear();
+
+        stringList << tr("%1").arg(LatencyAnalyzer::getAddressFromKey(key))
+                   << tr("%1").arg((uint32_t)LatencyAnalyzer::getFCodeFromKey(key))
+                   << tr("%1").arg(stats.requests)
+                   << tr("%1").arg(stats.answers)
+                   << tr("%1").arg(latency.getMin())
+                   << tr("%1").arg(latency.getMean(), 0, 'f', 1)
+                   << tr("%1").arg(latency.getPercentile(50))
+                   << tr("%1").arg(latency.getPercentile(90))
+                   << tr("%1").arg(latency.getPercentile(99))
+                   << tr("%1").arg(latency.getPercentile(99.9))
+                   << tr("%1").arg(latency.getMax())
+                   << tr("%1").arg(stats.timeouts)
+                   << tr("%1").arg(stats.retries)
+                   << tr("%1").arg(stats.late)
+                   << tr("%1").arg(stats.irrelevant)
+                   << tr("%1").arg(stats.afterTimeout);
+
+        for (QString &text : stringList)
+        {
+            text = "\"" + text + "\"";
+        }
+
+        data << stringList.join(";") + "\n";
+    }
+
+    saveFile.close();
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+
+Класс LatencyWindow выводит статистику задержек ответов ведомых узлов
+(LatencyAnalyzer) по парам адрес - F-код: медиану, 99-й перцентиль,
+максимум, количество запросов без ответа, повторов, опоздавших и
+неподходящих ответов. Таблица обновляется по таймеру окна лога, причём
+только в строках, статистика которых изменилась. Полная статистика
+с дополнительными перцентилями сохраняется в .csv-файл.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <QCanBusFrame>
+#include <stdint.h>
+#include "latency_analyzer.h"
+
+QT_BEGIN_NAMESPACE
+
+class QLabel;
+class QSpinBox;
+class QTableWidget;
+
+QT_END_NAMESPACE
+
+enum class LatencyWindowColumn {
+    slave_address,
+    f_code,
+    requests,
+    answers,
+    p50,
+    p99,
+    max,
+    timeouts,
+    retries,
+    late,
+    irrelevant,
+    after_timeout
+};
+
+class LatencyWindow : public QWidget
+{
+public:
+    explicit LatencyWindow(QWidget *parent = nullptr);
+    ~LatencyWindow() = default;
+
+    // Обработка кадра данных и обновление изменившихся строк
+    void processDataFrame(const QCanBusFrame &frame);
+    void refresh();
+
+public slots:
+    // Сброс статистики
+    void clearStats();
+
+    // Сохранение статистики в .csv-файл
+    void saveStats();
+
+private slots:
+    void lateThresholdChanged(const int32_t lateThreshold);
+
+private:
+    // Создание заголовка таблицы
+    void makeHeader();
+
+    // Строка таблицы для ключа; если строки ещё нет, она вставляется с сохранением порядка ключей
+    int32_t getRow(const uint32_t key);
+
+    // Заполнение строки статистикой
+    void setRow(const int32_t row, const uint32_t key);
+    void setCell(const int32_t row, const LatencyWindowColumn column, const QString text);
+
+    // Задержка в мкс в виде миллисекунд в формате '12.345'
+    static QString latencyToString(const uint64_t latency);
+
+    LatencyAnalyzer m_analyzer;
+
+    QTableWidget *m_table = nullptr;
+    QSpinBox *m_lateThreshold = nullptr;
+    QLabel *m_unexpected = nullptr;
+
+    QVector<int32_t> m_keyRow;
+    QVector<uint32_t> m_dirtyKeys;
+};
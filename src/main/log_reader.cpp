@@ -0,0 +1,197 @@
+#include "log_reader.h"
+#include "../cannabus_library/cannabus_common.h"
+
+#include <QFile>
+#include <QObject>
+#include <QTextStream>
+
+using namespace cannabus;
+
+bool LogReader::read(const QString &fileName, QVector<Record> &records, QString &errorString)
+{
+    QFile file(fileName);
+
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text) == false)
+    {
+        errorString = file.errorString();
+        return false;
+    }
+
+    QTextStream stream(&file);
+
+    // Номера нужных столбцов по заголовку, в порядке Column
+    const QStringList columnNames = {"Time", "Msg Type", "Address", "F-Code", "DLC", "Data", "Info"};
+    const QStringList header = splitLine(stream.readLine());
+
+    QVector<int32_t> columns;
+
+    for (const QString &name : columnNames)
+    {
+        const int32_t column = header.indexOf(name);
+
+        if (column == -1)
+        {
+            errorString = QObject::tr("no column '%1' in header").arg(name);
+            return false;
+        }
+
+        columns.append(column);
+    }
+
+    records.clear();
+
+    for (uint32_t lineNumber = 2; stream.atEnd() == false; lineNumber++)
+    {
+        const QString line = stream.readLine();
+
+        if (line.isEmpty() != false)
+        {
+            continue;
+        }
+
+        Record record;
+
+        if (parseRecord(splitLine(line), columns, record) == false)
+        {
+            errorString = QObject::tr("invalid frame in line %1").arg(lineNumber);
+            return false;
+        }
+
+        records.append(record);
+    }
+
+    return true;
+}
+
+QStringList LogReader::splitLine(const QString &line)
+{
+    QStringList cells;
+    QString cell;
+    bool isQuoted = false;
+
+    for (const QChar symbol : line)
+    {
+        if (symbol == QLatin1Char('"'))
+        {
+            isQuoted = !isQuoted;
+        }
+        else if (symbol == QLatin1Char(';') && isQuoted == false)
+        {
+            cells.append(cell);
+            cell.clear();
+        }
+        else
+        {
+            cell.append(symbol);
+        }
+    }
+
+    cells.append(cell);
+
+    return cells;
+}
+
+bool LogReader::parseRecord(const QStringList &cells, const QVector<int32_t> &columns, Record &record)
+{
+    for (const int32_t column : columns)
+    {
+        if (column >= cells.count())
+        {
+            return false;
+        }
+    }
+
+    auto cell = [&cells, &columns](const Column column)
+    {
+        return cells[columns[(uint32_t)column]].trimmed();
+    };
+
+    uint64_t time = 0;
+
+    if (parseTime(cell(Column::time), time) == false)
+    {
+        return false;
+    }
+
+    const QCanBusFrame::TimeStamp timeStamp(time / 1000000, time % 1000000);
+
+    // У кадра ошибки нет ни адреса, ни данных
+    if (cell(Column::slave_address).isEmpty() != false)
+    {
+        record.frame = QCanBusFrame(QCanBusFrame::ErrorFrame);
+        record.frame.setTimeStamp(timeStamp);
+        record.errorInfo = cell(Column::msg_info);
+
+        return true;
+    }
+
+    uint32_t msgType = 0;
+    uint32_t fCode = 0;
+
+    if (parseBinary(cell(Column::msg_type), msgType) == false || parseBinary(cell(Column::f_code), fCode) == false)
+    {
+        return false;
+    }
+
+    // Адрес в формате '10 (0x0A)'
+    bool isOk = false;
+    const uint32_t slaveAddress = cell(Column::slave_address).section(QLatin1Char(' '), 0, 0).toUInt(&isOk);
+
+    if (isOk == false || slaveAddress > (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS)
+    {
+        return false;
+    }
+
+    // Размер данных в формате '[8]' должен сойтись с самими данными
+    QString dataSizeText = cell(Column::data_size);
+    const uint32_t dataSize = dataSizeText.remove(QLatin1Char('[')).remove(QLatin1Char(']')).toUInt(&isOk);
+    const QByteArray payload = QByteArray::fromHex(cell(Column::data).toLatin1());
+
+    if (isOk == false || dataSize != (uint32_t)payload.size())
+    {
+        return false;
+    }
+
+    const uint32_t frameId = makeId(slaveAddress, (IdFCode)fCode, (IdMsgTypes)msgType);
+
+    record.frame = QCanBusFrame(frameId, payload);
+    record.frame.setTimeStamp(timeStamp);
+    record.frame.setFlexibleDataRateFormat(payload.size() > 8 ||
+                                           cell(Column::msg_info).contains(QLatin1String("(CAN FD")) != false);
+
+    return true;
+}
+
+bool LogReader::parseTime(const QString &text, uint64_t &time)
+{
+    const QStringList parts = text.split(QLatin1Char('.'));
+
+    if (parts.count() != 2)
+    {
+        return false;
+    }
+
+    bool isSecondsOk = false;
+    bool isFractionOk = false;
+
+    const uint64_t seconds = parts[0].trimmed().toULongLong(&isSecondsOk);
+    const uint64_t fraction = parts[1].toULongLong(&isFractionOk);
+
+    // Дробная часть - в сотнях микросекунд, как её выводит LogWindow::setTime
+    time = seconds * 1000000 + fraction * 100;
+
+    return isSecondsOk != false && isFractionOk != false;
+}
+
+bool LogReader::parseBinary(const QString &text, uint32_t &value)
+{
+    if (text.startsWith(QLatin1String("0b")) == false)
+    {
+        return false;
+    }
+
+    bool isOk = false;
+    value = text.mid(2).toUInt(&isOk, 2);
+
+    return isOk;
+}
@@ -0,0 +1,58 @@
+/****************************************************************************
+
+Класс LogReader читает лог кадров в CSV - сохранённый NarcoCANtrol
+(MainWindow::saveLog) или записанный симулятором сети (--capture) - и
+восстанавливает из него кадры для окна лога и анализаторов.
+
+ID кадра собирается из типа сообщения, адреса и F-кода, данные - из
+шестнадцатеричной строки, метка времени - из столбца времени, где она
+округлена до 100 мкс. Столбцы ищутся по заголовку, поэтому столбец
+Decoded не обязателен. Строка без адреса - кадр ошибки, его описание
+берётся из столбца Info.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QCanBusFrame>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <stdint.h>
+
+class LogReader
+{
+public:
+    struct Record {
+        QCanBusFrame frame;
+
+        // Описание кадра ошибки
+        QString errorInfo;
+    };
+
+    // Чтение всего лога; при ошибке в errorString - что не так и в какой строке
+    static bool read(const QString &fileName, QVector<Record> &records, QString &errorString);
+
+private:
+    enum class Column {
+        time,
+        msg_type,
+        slave_address,
+        f_code,
+        data_size,
+        data,
+        msg_info,
+        count
+    };
+
+    // Разбиение строки по ';' без учёта разделителей в кавычках, кавычки снимаются
+    static QStringList splitLine(const QString &line);
+
+    static bool parseRecord(const QStringList &cells, const QVector<int32_t> &columns, Record &record);
+
+    // Время в формате '1234.1234', в мкс
+    static bool parseTime(const QString &text, uint64_t &time);
+
+    // Число в формате '0b101'
+    static bool parseBinary(const QString &text, uint32_t &value);
+};
@@ -1,6 +1,8 @@
 #include "log_window.h"
 
+#include <QColor>
 #include <QHeaderView>
+#include <QStyledItemDelegate>
 #include <algorithm>
 #include <QFont>
 #include <QFontDatabase>
@@ -20,9 +22,36 @@ namespace cannabus
     }
 }
 
+// Роли ячейки 'Decoded' с данными и идентификатором кадра
+static constexpr int32_t payload_role = Qt::UserRole;
+static constexpr int32_t frame_id_role = Qt::UserRole + 1;
+
+// Расшифровка выполняется при отрисовке, то есть только для видимых строк
+class DecodedItemDelegate : public QStyledItemDelegate
+{
+public:
+    explicit DecodedItemDelegate(LogWindow *logWindow) :
+        QStyledItemDelegate(logWindow),
+        m_logWindow(logWindow)
+    {
+    }
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const override
+    {
+        QStyledItemDelegate::initStyleOption(option, index);
+
+        option->text = m_logWindow->decodeFrame(index.data(frame_id_role).toUInt(), index.data(payload_role).toByteArray());
+    }
+
+private:
+    const LogWindow *m_logWindow = nullptr;
+};
+
 LogWindow::LogWindow(QWidget *parent) : QTableWidget(parent)
 {
     makeHeader();
+    setItemDelegateForColumn((uint32_t)LogWindowColumn::decoded, new DecodedItemDelegate(this));
     verticalHeader()->hide();
 
     horizontalHeader()->setStretchLastSection(true);
@@ -40,7 +69,7 @@ void LogWindow::makeHeader()
                                       .arg(fontFamily)
                                       .arg(fontSize));
 
-    QStringList logWindowHeader = {"No.", "Time", "Msg Type", "Address", "F-Code", "DLC", "Data", "Info"};
+    QStringList logWindowHeader = {"No.", "Time", "Msg Type", "Address", "F-Code", "DLC", "Data", "Info", "Decoded"};
 
     setColumnCount(logWindowHeader.count());
     setHorizontalHeaderLabels(logWindowHeader);
@@ -55,8 +84,9 @@ void LogWindow::makeHeader()
     resizeColumn(LogWindowColumn::msg_type     , " Msg Type "              );
     resizeColumn(LogWindowColumn::slave_address, "10 (0x0A) "              );
     resizeColumn(LogWindowColumn::f_code       , "F-Code "                 );
-    resizeColumn(LogWindowColumn::data_size    , " [8] "                   );
+    resizeColumn(LogWindowColumn::data_size    , " [64] "                  );
     resizeColumn(LogWindowColumn::data         , "11 22 33 44 55 66 77 88 ");
+    resizeColumn(LogWindowColumn::msg_info     , "[Master's high-prio] Writing regs series (CAN FD) ");
 
     horizontalHeader()->setSectionsClickable(false);
     horizontalHeader()->setFixedHeight(1.5 * fontMetrics().height());
@@ -94,7 +124,8 @@ void LogWindow::processDataFrame(const QCanBusFrame &frame)
     setFCode(fCode);
     setDataSize(frame.payload().size());
     setData(frame.payload());
-    setMsgInfo(msgType, fCode, frame.payload().size());
+    setMsgInfo(msgType, fCode, frame.payload().size(), frame.hasFlexibleDataRateFormat());
+    setDecoded(frameId, frame.payload());
 
     scrollToBottom();
 }
@@ -111,6 +142,95 @@ void LogWindow::processErrorFrame(const QCanBusFrame &frame, const QString error
     setMsgInfo(errorInfo);
 }
 
+void LogWindow::markViolation(const QString violationInfo)
+{
+    // Подсвечиваем строку и дописываем нарушение к информации о кадре
+    QString backgroundColor = "mistyrose";
+
+    for (int32_t column = 0; column < columnCount(); column++)
+    {
+        QTableWidgetItem *item = this->item(m_currentRow, column);
+
+        if (item != nullptr)
+        {
+            item->setBackground(QColor(backgroundColor));
+        }
+    }
+
+    QTableWidgetItem *item = this->item(m_currentRow, (uint32_t)LogWindowColumn::msg_info);
+
+    if (item != nullptr)
+    {
+        m_msgInfo = item->text() + tr(" <%1>").arg(violationInfo);
+        item->setText(m_msgInfo);
+    }
+}
+
+uint64_t LogWindow::getRowTime(const int32_t row) const
+{
+    // Точное время хранится в ячейке вместе с округлённым до 100 мкс текстом
+    const QTableWidgetItem *item = this->item(row, (uint32_t)LogWindowColumn::time);
+
+    return item == nullptr ? 0 : item->data(Qt::UserRole).toULongLong();
+}
+
+int32_t LogWindow::getRowSlaveAddress(const int32_t row) const
+{
+    const QTableWidgetItem *item = this->item(row, (uint32_t)LogWindowColumn::slave_address);
+
+    return item == nullptr ? -1 : item->data(Qt::UserRole).toInt();
+}
+
+QString LogWindow::getCellText(const int32_t row, const int32_t column) const
+{
+    const QTableWidgetItem *item = this->item(row, column);
+
+    if (item == nullptr)
+    {
+        return QString();
+    }
+
+    if (column == (int32_t)LogWindowColumn::decoded)
+    {
+        return decodeFrame(item->data(frame_id_role).toUInt(), item->data(payload_role).toByteArray());
+    }
+
+    return item->text();
+}
+
+bool LogWindow::loadRegisterDescriptions(const QString &fileName, QString &errorString)
+{
+    if (m_decoder.load(fileName, errorString) == false)
+    {
+        return false;
+    }
+
+    // Видимые строки перерисовываются уже с новым описанием
+    viewport()->update();
+    return true;
+}
+
+void LogWindow::setDeviceDecoders(const DeviceDecoders *deviceDecoders)
+{
+    m_deviceDecoders = deviceDecoders;
+    viewport()->update();
+}
+
+QString LogWindow::decodeFrame(const uint32_t frameId, const QByteArray &data) const
+{
+    if (DeviceDecoders::isDeviceSpecific(getFCodeFromId(frameId)) == false)
+    {
+        return m_decoder.decode(frameId, data);
+    }
+
+    if (m_deviceDecoders == nullptr || m_deviceDecoders->decode(frameId, data, m_deviceFields) == false)
+    {
+        return QString();
+    }
+
+    return DeviceDecoders::toString(m_deviceFields);
+}
+
 void LogWindow::setCount()
 {
     // Выводим номер принятого кадра с шириной поля в 6 символов
@@ -134,6 +254,7 @@ void LogWindow::setTime(const uint64_t seconds, const uint64_t microseconds)
     auto item = new QTableWidgetItem(m_time);
     item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
     item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    item->setData(Qt::UserRole, (qulonglong)(seconds * 1000000 + microseconds));
     setItem(m_currentRow, (uint32_t)LogWindowColumn::time, item);
 }
 
@@ -160,6 +281,7 @@ void LogWindow::setSlaveAddress(const uint32_t slaveAddress)
     auto item = new QTableWidgetItem(m_slaveAddress);
     item->setTextAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
     item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    item->setData(Qt::UserRole, slaveAddress);
     setItem(m_currentRow, (uint32_t)LogWindowColumn::slave_address, item);
 }
 
@@ -200,7 +322,8 @@ void LogWindow::setData(const QByteArray data)
     setItem(m_currentRow, (uint32_t)LogWindowColumn::data, item);
 }
 
-void LogWindow::setMsgInfo(const IdMsgTypes msgType, const IdFCode fCode, const uint32_t dataSize)
+void LogWindow::setMsgInfo(const IdMsgTypes msgType, const IdFCode fCode, const uint32_t dataSize,
+                           const bool isFlexibleDataRate)
 {
     // Готовим словесное описание для типа сообщения и его F-кода,
     // а затем выводим информацию о кадре в текстовом формате
@@ -258,6 +381,20 @@ void LogWindow::setMsgInfo(const IdMsgTypes msgType, const IdFCode fCode, const
         addBrackets(m_msgInfo, msgTypeInfo.value(msgType));
     }
 
+    // Кадры FD-профиля CannabusPlus (до 62 регистров в диапазоне и 32 в серии)
+    // помечаем, а кадры недопустимой для CAN FD длины считаем битыми
+    if (isFlexibleDataRate != false)
+    {
+        if (isFrameLengthValid(Profile::FD, dataSize) != false)
+        {
+            m_msgInfo.append(" (CAN FD)");
+        }
+        else
+        {
+            m_msgInfo.append(" (CAN FD, invalid length)");
+        }
+    }
+
     auto item = new QTableWidgetItem(m_msgInfo);
     item->setTextAlignment(Qt::AlignLeft | Qt::AlignVCenter);
     item->setFlags(item->flags() & ~Qt::ItemIsEditable);
@@ -276,3 +413,14 @@ void LogWindow::setMsgInfo(const QString errorInfo)
     item->setFlags(item->flags() & ~Qt::ItemIsEditable);
     setItem(m_currentRow, (uint32_t)LogWindowColumn::msg_info, item);
 }
+
+void LogWindow::setDecoded(const uint32_t frameId, const QByteArray data)
+{
+    // Сохраняем только сам кадр, текст строит делегат при отрисовке строки
+    auto item = new QTableWidgetItem;
+    item->setTextAlignment(Qt::AlignLeft | Qt::AlignVCenter);
+    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    item->setData(payload_role, data);
+    item->setData(frame_id_role, frameId);
+    setItem(m_currentRow, (uint32_t)LogWindowColumn::decoded, item);
+}
@@ -6,6 +6,12 @@ USB-CAN-адаптером. В логе сообщений выводится и
 принятого кадра, адресе ведомого узла, типе сообщения и коде функции (F-коде),
 а также о содержимом кадра (регистрах и данных).
 
+Если загружено описание карт регистров (RegisterDecoder), в столбце
+'Decoded' выводятся именованные значения регистров, а для device-specific
+кадров - поля, расшифрованные плагинами (DeviceDecoders). Строка лога хранит
+только идентификатор и данные кадра, а расшифровка выполняется делегатом
+при отрисовке, то есть только для видимых строк.
+
 ****************************************************************************/
 
 #pragma once
@@ -14,6 +20,8 @@ USB-CAN-адаптером. В логе сообщений выводится и
 #include <QCanBusFrame>
 #include <stdint.h>
 #include "../cannabus_library/cannabus_common.h"
+#include "device_decoders.h"
+#include "register_decoder.h"
 
 enum class LogWindowColumn {
     count,
@@ -23,7 +31,8 @@ enum class LogWindowColumn {
     f_code,
     data_size,
     data,
-    msg_info
+    msg_info,
+    decoded
 };
 
 class LogWindow : public QTableWidget
@@ -36,6 +45,25 @@ public:
     void processDataFrame(const QCanBusFrame &frame);
     void processErrorFrame(const QCanBusFrame &frame, const QString errorInfo);
 
+    // Пометка последнего выведенного кадра как нарушающего протокол
+    void markViolation(const QString violationInfo);
+
+    // Время кадра строки в мкс и адрес ведомого узла (-1 для кадра ошибки)
+    uint64_t getRowTime(const int32_t row) const;
+    int32_t getRowSlaveAddress(const int32_t row) const;
+
+    // Текст ячейки, включая расшифровку, которая в ячейке не хранится; пустой, если ячейки нет
+    QString getCellText(const int32_t row, const int32_t column) const;
+
+    // Загрузка описания карт регистров для столбца 'Decoded'
+    bool loadRegisterDescriptions(const QString &fileName, QString &errorString);
+
+    // Плагины расшифровки device-specific кадров
+    void setDeviceDecoders(const DeviceDecoders *deviceDecoders);
+
+    // Текст столбца 'Decoded' для кадра
+    QString decodeFrame(const uint32_t frameId, const QByteArray &data) const;
+
 public slots:
     // Очистка лог и сброс счётчик принятых кадров
     void clearLog();
@@ -56,8 +84,15 @@ private:
     void setFCode(const cannabus::IdFCode fCode);
     void setDataSize(const uint32_t dataSize);
     void setData(const QByteArray data);
-    void setMsgInfo(const cannabus::IdMsgTypes msgType, const cannabus::IdFCode fCode, const uint32_t dataSize);
+    void setMsgInfo(const cannabus::IdMsgTypes msgType, const cannabus::IdFCode fCode, const uint32_t dataSize,
+                    const bool isFlexibleDataRate);
     void setMsgInfo(const QString errorInfo);
+    void setDecoded(const uint32_t frameId, const QByteArray data);
+
+    RegisterDecoder m_decoder;
+
+    const DeviceDecoders *m_deviceDecoders = nullptr;
+    mutable DecodedFields m_deviceFields;
 
     uint64_t m_numberFramesReceived = 0;
     uint64_t m_currentRow = 0;
@@ -3,6 +3,16 @@
 #include "settings_dialog.h"
 #include "bitrate.h"
 #include "filter.h"
+#include "device_decoders.h"
+#include "register_map_window.h"
+#include "latency_window.h"
+#include "traffic_window.h"
+#include "bus_load_window.h"
+#include "conformance_window.h"
+#include "register_history_window.h"
+#include "time_series_window.h"
+#include "period_window.h"
+#include "log_reader.h"
 #include "../cannabus_library/cannabus_common.h"
 
 #include <QCanBus>
@@ -14,6 +24,7 @@
 #include <QDate>
 #include <QTextStream>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QFont>
 #include <QFontDatabase>
 
@@ -47,11 +58,46 @@ MainWindow::MainWindow(QWidget *parent) :
 
     m_filter = new Filter;
 
+    m_deviceDecoders = new DeviceDecoders;
+
+    m_registerMapWindow = new RegisterMapWindow;
+
+    m_registerHistoryWindow = new RegisterHistoryWindow(&m_registerMapWindow->getHistory());
+
+    m_timeSeriesWindow = new TimeSeriesWindow(&m_registerMapWindow->getTimeSeries());
+
+    m_latencyWindow = new LatencyWindow;
+
+    m_trafficWindow = new TrafficWindow;
+
+    m_busLoadWindow = new BusLoadWindow;
+
+    m_conformanceWindow = new ConformanceWindow;
+
+    m_periodWindow = new PeriodWindow;
+
     m_status = new QLabel;
     m_ui->statusBar->addPermanentWidget(m_status);
 
     m_ui->actionDisconnect->setEnabled(false);
 
+    // Плагины расшифровки device-specific кадров лежат в каталоге decoders рядом с программой
+    QStringList decoderErrors;
+    const QStringList decoderNames = m_deviceDecoders->loadPlugins(QCoreApplication::applicationDirPath() + "/decoders",
+                                                                   decoderErrors);
+
+    m_filter->setDeviceDecoders(m_deviceDecoders);
+    m_ui->logWindow->setDeviceDecoders(m_deviceDecoders);
+
+    if (decoderErrors.isEmpty() == false)
+    {
+        m_status->setText(tr("Device decoders: %1; errors: %2").arg(decoderNames.join(", ")).arg(decoderErrors.join("; ")));
+    }
+    else if (decoderNames.isEmpty() == false)
+    {
+        m_status->setText(tr("Device decoders: %1").arg(decoderNames.join(", ")));
+    }
+
     QString fontName = "DroidSansMono.ttf";
     int32_t id = QFontDatabase::addApplicationFont(tr(":/fonts/%1").arg(fontName));
 
@@ -66,6 +112,23 @@ MainWindow::MainWindow(QWidget *parent) :
     m_ui->contentFilterList->setFont(font);
     m_ui->contentFilterList->clearList();
 
+    m_registerMapWindow->setFont(font);
+    m_registerMapWindow->clearMap();
+
+    m_registerHistoryWindow->setFont(font);
+
+    m_timeSeriesWindow->setFont(font);
+
+    m_latencyWindow->setFont(font);
+
+    m_trafficWindow->setFont(font);
+
+    m_busLoadWindow->setFont(font);
+
+    m_conformanceWindow->setFont(font);
+
+    m_periodWindow->setFont(font);
+
     // ************* Эмуляция общения между ведущим и ведомыми узлами *************
 
 #ifdef EMULATION_ENABLED
@@ -90,18 +153,38 @@ MainWindow::~MainWindow()
 {
     delete m_settingsDialog;
     delete m_filter;
+    delete m_deviceDecoders;
+    delete m_registerHistoryWindow;
+    delete m_timeSeriesWindow;
+    delete m_registerMapWindow;
+    delete m_latencyWindow;
+    delete m_trafficWindow;
+    delete m_busLoadWindow;
+    delete m_conformanceWindow;
+    delete m_periodWindow;
     delete m_ui;
 }
 
 void MainWindow::initActionsConnections()
 {   
-    SUPER_CONNECT(m_ui->actionConnect            , triggered, this            , connectDevice           );
-    SUPER_CONNECT(m_ui->actionDisconnect         , triggered, this            , disconnectDevice        );
-    SUPER_CONNECT(m_ui->actionClearLog           , triggered, m_ui->logWindow , clearLog                );
-    SUPER_CONNECT(m_ui->actionQuit               , triggered, this            , close                   );
-    SUPER_CONNECT(m_ui->actionSettings           , triggered, m_settingsDialog, show                    );
-    SUPER_CONNECT(m_ui->actionResetFilterSettings, triggered, this            , setDefaultFilterSettings);
-    SUPER_CONNECT(m_ui->actionSaveLog            , triggered, this            , saveLog                 );
+    SUPER_CONNECT(m_ui->actionConnect                 , triggered  , this                   , connectDevice           );
+    SUPER_CONNECT(m_ui->actionDisconnect              , triggered  , this                   , disconnectDevice        );
+    SUPER_CONNECT(m_ui->actionClearLog                , triggered  , m_ui->logWindow        , clearLog                );
+    SUPER_CONNECT(m_ui->actionQuit                    , triggered  , this                   , close                   );
+    SUPER_CONNECT(m_ui->actionSettings                , triggered  , m_settingsDialog       , show                    );
+    SUPER_CONNECT(m_ui->actionResetFilterSettings     , triggered  , this                   , setDefaultFilterSettings);
+    SUPER_CONNECT(m_ui->actionSaveLog                 , triggered  , this                   , saveLog                 );
+    SUPER_CONNECT(m_ui->actionLoadLog                 , triggered  , this                   , loadLog                 );
+    SUPER_CONNECT(m_ui->actionLoadRegisterDescriptions, triggered  , this                   , loadRegisterDescriptions);
+    SUPER_CONNECT(m_ui->actionRegisterMap             , triggered  , m_registerMapWindow    , show                    );
+    SUPER_CONNECT(m_ui->actionLatency                 , triggered  , m_latencyWindow        , show                    );
+    SUPER_CONNECT(m_ui->actionTraffic                 , triggered  , m_trafficWindow        , show                    );
+    SUPER_CONNECT(m_ui->actionBusLoad                 , triggered  , m_busLoadWindow        , show                    );
+    SUPER_CONNECT(m_ui->actionConformance             , triggered  , m_conformanceWindow    , show                    );
+    SUPER_CONNECT(m_ui->actionRegisterHistory         , triggered  , m_registerHistoryWindow, show                    );
+    SUPER_CONNECT(m_ui->actionTimeSeries              , triggered  , m_timeSeriesWindow     , show                    );
+    SUPER_CONNECT(m_ui->actionPeriod                  , triggered  , m_periodWindow         , show                    );
+    SUPER_CONNECT(m_ui->logWindow                     , cellClicked, this                   , showRegisterHistory     );
 
     SUPER_CONNECT(m_settingsDialog, accepted, this, disconnectDevice);
     SUPER_CONNECT(m_settingsDialog, accepted, this, connectDevice);
@@ -119,6 +202,9 @@ void MainWindow::initFiltersConnections()
     SUPER_CONNECT(this                      , addSlaveAdressesFilter   , m_filter, setSlaveAddressFilter     );
     SUPER_CONNECT(m_filter                  , slaveAddressesFilterAdded, this    , setFilter                 );
 
+    // Устанавливаем связь между фильтром и полем ввода условий на расшифрованные поля device-specific кадров
+    SUPER_CONNECT(m_ui->filterDecodedFields, editingFinished, this, setDecodedFieldsFiltrated);
+
     // Устанавливаем связь между фильтром и окном лога
     SUPER_CONNECT(m_filter, frameIsProcessing, m_ui->logWindow, numberFramesReceivedIncrement);
 
@@ -199,7 +285,7 @@ void MainWindow::saveLog()
 
             for(int32_t column = 0; column < m_ui->logWindow->horizontalHeader()->count(); column++)
             {
-                QString text = m_ui->logWindow->item(row, column)->text();
+                QString text = m_ui->logWindow->getCellText(row, column);
 
                 if (text.length() > 0)
                 {
@@ -218,6 +304,140 @@ void MainWindow::saveLog()
     }
 }
 
+void MainWindow::loadLog()
+{
+    QString filters("CSV files (*.csv);;All files (*.*)");
+    QString fileName = QFileDialog::getOpenFileName(nullptr, "Load Message Log",
+                                                    QCoreApplication::applicationDirPath(), filters);
+
+    if (fileName.isEmpty() != false)
+    {
+        return;
+    }
+
+    QVector<LogReader::Record> records;
+    QString errorString;
+
+    if (LogReader::read(fileName, records, errorString) == false)
+    {
+        m_status->setText(tr("Error loading message log '%1': %2").arg(fileName).arg(errorString));
+        return;
+    }
+
+    // Кадры из файла не смешиваются ни с кадрами с шины, ни с прежней статистикой
+    disconnectDevice();
+
+    m_ui->logWindow->clearLog();
+    m_trafficWindow->clearStats();
+    m_busLoadWindow->clearStats();
+    m_periodWindow->clearStats();
+    m_registerMapWindow->clearMap();
+    m_timeSeriesWindow->clearCurves();
+    m_latencyWindow->clearStats();
+    m_conformanceWindow->clearStats();
+
+    // Загрузка шины считается по скорости, которой в логе нет: её называет пользователь
+    const uint32_t bitRate = askLogBitRate();
+    m_busLoadWindow->setBitRates(bitRate, 0);
+
+    for (const LogReader::Record &record : qAsConst(records))
+    {
+        if (record.frame.frameType() == QCanBusFrame::FrameType::ErrorFrame)
+        {
+            processErrorFrame(record.frame, record.errorInfo);
+        }
+        else
+        {
+            processDataFrame(record.frame);
+        }
+    }
+
+    refreshWindows();
+
+    if (bitRate != 0)
+    {
+        m_status->setText(tr("Message log loaded from '%1': %2 frames at %3")
+                          .arg(fileName).arg(records.count()).arg(bitRateToString(bitRate)));
+    }
+    else
+    {
+        m_status->setText(tr("Message log loaded from '%1': %2 frames, bit rate is unknown")
+                          .arg(fileName).arg(records.count()));
+    }
+}
+
+uint32_t MainWindow::askLogBitRate()
+{
+    // По умолчанию - скорость из настроек подключения, а без неё - 500 кбит/с
+    uint32_t defaultBitRate = (uint32_t)BitRate::KBPS_500;
+
+    for (const SettingsDialog::ConfigurationItem &item : m_settingsDialog->settings().configurations)
+    {
+        if (item.first == QCanBusDevice::BitRateKey && item.second.toUInt() != 0)
+        {
+            defaultBitRate = item.second.toUInt();
+        }
+    }
+
+    QList<uint32_t> bitRates = getNominalBitRates();
+
+    if (bitRates.contains(defaultBitRate) == false)
+    {
+        bitRates.append(defaultBitRate);
+    }
+
+    QStringList items;
+
+    for (const uint32_t bitRate : qAsConst(bitRates))
+    {
+        items.append(bitRateToString(bitRate));
+    }
+
+    items.append(tr("Unknown"));
+
+    bool isOk = false;
+    const QString item = QInputDialog::getItem(this, tr("Load Message Log"), tr("Bit rate of the logged bus:"), items,
+                                               bitRates.indexOf(defaultBitRate), false, &isOk);
+    const int32_t index = items.indexOf(item);
+
+    // Отказ от выбора - скорость неизвестна, окно загрузки шины так и напишет
+    if (isOk == false || index < 0 || index >= bitRates.count())
+    {
+        return 0;
+    }
+
+    return bitRates[index];
+}
+
+void MainWindow::loadRegisterDescriptions()
+{
+    QString filters("JSON files (*.json);;All files (*.*)");
+    QString fileName = QFileDialog::getOpenFileName(nullptr, "Load Register Descriptions",
+                                                    QCoreApplication::applicationDirPath(), filters);
+
+    if (fileName.isEmpty() != false)
+    {
+        return;
+    }
+
+    QString errorString;
+
+    if (m_ui->logWindow->loadRegisterDescriptions(fileName, errorString) == false)
+    {
+        m_status->setText(tr("Error loading register descriptions '%1': %2").arg(fileName).arg(errorString));
+        return;
+    }
+
+    m_status->setText(tr("Register descriptions loaded from '%1'").arg(fileName));
+}
+
+void MainWindow::showRegisterHistory(const int32_t row)
+{
+    // Показываем регистры узла на момент кадра; прежний момент становится моментом сравнения
+    m_registerHistoryWindow->setMoment(m_ui->logWindow->getRowTime(row), m_ui->logWindow->getRowSlaveAddress(row));
+    m_registerHistoryWindow->show();
+}
+
 void MainWindow::processError(QCanBusDevice::CanBusError error) const
 {
     switch(error)
@@ -495,6 +715,14 @@ void MainWindow::connectDevice()
     m_ui->actionConnect->setEnabled(false);
     m_ui->actionDisconnect->setEnabled(true);
     m_ui->logWindow->clearLog();
+    m_registerMapWindow->clearMap();
+    m_registerHistoryWindow->updateState();
+    m_timeSeriesWindow->showAll();
+    m_latencyWindow->clearStats();
+    m_trafficWindow->clearStats();
+    m_periodWindow->clearStats();
+    m_busLoadWindow->clearStats();
+    m_conformanceWindow->clearStats();
 
     m_logWindowUpdateTimer->start(log_window_update_timeout);
     m_sendMessageTimer->start(send_message_timeout);
@@ -524,8 +752,16 @@ void MainWindow::connectDevice()
         return;
     }
 
-    // Очищаем окно лога
+    // Очищаем окно лога, карту регистров и статистику задержек и трафика
     m_ui->logWindow->clearLog();
+    m_registerMapWindow->clearMap();
+    m_registerHistoryWindow->updateState();
+    m_timeSeriesWindow->showAll();
+    m_latencyWindow->clearStats();
+    m_trafficWindow->clearStats();
+    m_periodWindow->clearStats();
+    m_busLoadWindow->clearStats();
+    m_conformanceWindow->clearStats();
 
     // Устанавливаем связь между сигналом возникновения ошибки
     // и функцией-обработчиком ошибок
@@ -554,6 +790,9 @@ void MainWindow::connectDevice()
     m_ui->actionDisconnect->setEnabled(true);
 
     // Определяем битрейт и выводим его в поле статуса подключения
+    // По нему же считается загрузка шины; без известного битрейта она не считается
+    m_busLoadWindow->setBitRates(0, 0);
+
     const QVariant bitRate = m_canDevice->configurationParameter(QCanBusDevice::BitRateKey);
     if (bitRate.isValid() != false)
     {
@@ -562,6 +801,8 @@ void MainWindow::connectDevice()
 
         if (isCanFdEnabled != false && dataBitRate.isValid() != false)
         {
+            m_busLoadWindow->setBitRates(bitRate.toUInt(), dataBitRate.toUInt());
+
             m_status->setText(tr("Plugin '%1': connected to %2 at %3 / %4 with CAN FD")
                             .arg(settings.pluginName)
                             .arg(settings.deviceInterfaceName)
@@ -570,6 +811,8 @@ void MainWindow::connectDevice()
         }
         else
         {
+            m_busLoadWindow->setBitRates(bitRate.toUInt(), 0);
+
             m_status->setText(tr("Plugin '%1': connected to %2 at %3")
                             .arg(settings.pluginName)
                             .arg(settings.deviceInterfaceName)
@@ -645,6 +888,14 @@ void MainWindow::disconnectDevice()
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     m_settingsDialog->close();
+    m_registerMapWindow->close();
+    m_registerHistoryWindow->close();
+    m_timeSeriesWindow->close();
+    m_latencyWindow->close();
+    m_trafficWindow->close();
+    m_periodWindow->close();
+    m_busLoadWindow->close();
+    m_conformanceWindow->close();
     event->accept();
 }
 
@@ -658,12 +909,31 @@ void MainWindow::processFramesReceived()
     {
         auto frame = m_queue.dequeue();
 
+        m_trafficWindow->processDataFrame(frame);
+        m_busLoadWindow->processDataFrame(frame);
+        m_periodWindow->processDataFrame(frame);
+        m_registerMapWindow->processDataFrame(frame);
+        m_latencyWindow->processDataFrame(frame);
+
+        const ConformanceViolation violation = m_conformanceWindow->processDataFrame(frame);
+
         if (m_filter->mustDataFrameBeProcessed(frame) != false)
         {
             m_ui->logWindow->processDataFrame(frame);
+
+            if (violation != ConformanceViolation::none)
+            {
+                m_ui->logWindow->markViolation(ConformanceWindow::getViolationName(violation));
+            }
         }
     }
 
+    m_registerMapWindow->refresh();
+    m_timeSeriesWindow->refresh();
+    m_latencyWindow->refresh();
+    m_busLoadWindow->refresh();
+    m_conformanceWindow->refresh();
+
 #endif
 
     // ******************* Необходимо удалить после тестирования ******************
@@ -683,20 +953,57 @@ void MainWindow::processFramesReceived()
         // Обработка кадров ошибок
         if (frame.frameType() == QCanBusFrame::FrameType::ErrorFrame)
         {
-            const QString errorInfo = m_canDevice->interpretErrorFrame(frame);
-            m_ui->logWindow->processErrorFrame(frame, errorInfo);
-
+            processErrorFrame(frame, m_canDevice->interpretErrorFrame(frame));
             continue;
         }
 
-        // Обработка обычных кадров
-        if (m_filter->mustDataFrameBeProcessed(frame) != false)
+        processDataFrame(frame);
+    }
+
+    refreshWindows();
+}
+
+void MainWindow::processDataFrame(const QCanBusFrame &frame)
+{
+    // Статистика, загрузка, карта регистров и задержки строятся по всему трафику, независимо от фильтров лога
+    m_trafficWindow->processDataFrame(frame);
+    m_busLoadWindow->processDataFrame(frame);
+    m_periodWindow->processDataFrame(frame);
+    m_registerMapWindow->processDataFrame(frame);
+    m_latencyWindow->processDataFrame(frame);
+
+    // Проверка на соответствие протоколу: нарушения подсвечиваются в логе
+    const ConformanceViolation violation = m_conformanceWindow->processDataFrame(frame);
+
+    // Обработка обычных кадров
+    if (m_filter->mustDataFrameBeProcessed(frame) != false)
+    {
+        m_ui->logWindow->processDataFrame(frame);
+
+        if (violation != ConformanceViolation::none)
         {
-            m_ui->logWindow->processDataFrame(frame);
+            m_ui->logWindow->markViolation(ConformanceWindow::getViolationName(violation));
         }
     }
 }
 
+void MainWindow::processErrorFrame(const QCanBusFrame &frame, const QString errorInfo)
+{
+    m_ui->logWindow->processErrorFrame(frame, errorInfo);
+    m_trafficWindow->processErrorFrame();
+    m_busLoadWindow->processErrorFrame(frame);
+}
+
+void MainWindow::refreshWindows()
+{
+    // Перерисовываем только изменившиеся ячейки карты регистров и строки статистики
+    m_registerMapWindow->refresh();
+    m_timeSeriesWindow->refresh();
+    m_latencyWindow->refresh();
+    m_busLoadWindow->refresh();
+    m_conformanceWindow->refresh();
+}
+
 void MainWindow::busStatus()
 {
     // Выводим сообщение о невозможности определить статус шины и
@@ -742,7 +1049,17 @@ void MainWindow::busStatus()
         }
     }
 
-    m_ui->busStatus->setText(tr("CAN bus status: %1.").arg(status));
+    // Добавляем загрузку шины за последнюю секунду, если известен битрейт
+    const double busLoad = m_busLoadWindow->getTotalLoad();
+
+    if (busLoad < 0)
+    {
+        m_ui->busStatus->setText(tr("CAN bus status: %1.").arg(status));
+    }
+    else
+    {
+        m_ui->busStatus->setText(tr("CAN bus status: %1. Bus load: %2 %").arg(status).arg(busLoad, 0, 'f', 1));
+    }
 }
 
 void MainWindow::setSlaveAddressesFiltrated()
@@ -754,6 +1071,11 @@ void MainWindow::setSlaveAddressesFiltrated()
     emit addSlaveAdressesFilter(addressesRange);
 }
 
+void MainWindow::setDecodedFieldsFiltrated()
+{
+    m_filter->setDecodedFieldsFilter(m_ui->filterDecodedFields->text());
+}
+
 void MainWindow::setAllMsgTypesFiltrated()
 {
     const bool isFiltrated = m_ui->filterAllMsgTypes->isChecked();
@@ -867,6 +1189,9 @@ void MainWindow::setDefaultFilterSettings()
     m_ui->filterSlaveAddresses->setText("");
     m_ui->filterSlaveAddresses->editingFinished();
 
+    m_ui->filterDecodedFields->setText("");
+    m_ui->filterDecodedFields->editingFinished();
+
     m_ui->filterAllMsgTypes->setChecked(false);
     m_ui->filterAllMsgTypes->setChecked(true);
 
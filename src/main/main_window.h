@@ -29,6 +29,15 @@ QT_END_NAMESPACE
 
 class SettingsDialog;
 class Filter;
+class DeviceDecoders;
+class RegisterMapWindow;
+class LatencyWindow;
+class TrafficWindow;
+class BusLoadWindow;
+class ConformanceWindow;
+class RegisterHistoryWindow;
+class TimeSeriesWindow;
+class PeriodWindow;
 
 class MainWindow : public QMainWindow
 {
@@ -80,6 +89,7 @@ private slots:
     void setDeviceSpecific_4Filtrated();
 
     void setSlaveAddressesFiltrated();
+    void setDecodedFieldsFiltrated();
 
     void setFilter(const QString addressesRange);
 
@@ -91,6 +101,9 @@ private slots:
     void processError(QCanBusDevice::CanBusError error) const;
     void processFramesReceived();
     void saveLog();
+    void loadLog();
+    void loadRegisterDescriptions();
+    void showRegisterHistory(const int32_t row);
 
     // ************* Эмуляция общения между ведущим и ведомыми узлами *************
 
@@ -109,10 +122,29 @@ private:
     void initActionsConnections();
     void initFiltersConnections();
 
+    // Кадр с шины или из загруженного лога - в окно лога и во все анализаторы
+    void processDataFrame(const QCanBusFrame &frame);
+    void processErrorFrame(const QCanBusFrame &frame, const QString errorInfo);
+
+    // Перерисовка окон анализаторов после пачки кадров
+    void refreshWindows();
+
+    // Скорость шины, на которой записан загружаемый лог; 0 - пользователь её не знает
+    uint32_t askLogBitRate();
+
     Ui::MainWindow *m_ui = nullptr;
     QLabel *m_status = nullptr;
     SettingsDialog *m_settingsDialog = nullptr;
     Filter *m_filter = nullptr;
+    DeviceDecoders *m_deviceDecoders = nullptr;
+    RegisterMapWindow *m_registerMapWindow = nullptr;
+    LatencyWindow *m_latencyWindow = nullptr;
+    TrafficWindow *m_trafficWindow = nullptr;
+    BusLoadWindow *m_busLoadWindow = nullptr;
+    ConformanceWindow *m_conformanceWindow = nullptr;
+    RegisterHistoryWindow *m_registerHistoryWindow = nullptr;
+    TimeSeriesWindow *m_timeSeriesWindow = nullptr;
+    PeriodWindow *m_periodWindow = nullptr;
     std::unique_ptr<QCanBusDevice> m_canDevice;
     QTimer *m_busStatusTimer = nullptr;
     QTimer *m_logWindowUpdateTimer = nullptr;
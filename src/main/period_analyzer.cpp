@@ -0,0 +1,161 @@
+#include "period_analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+PeriodAnalyzer::PeriodAnalyzer()
+{
+    m_stats.resize(ids_count);
+    m_isIdUsed.fill(false, ids_count);
+    m_isIdDirty.fill(false, ids_count);
+}
+
+void PeriodAnalyzer::clear()
+{
+    for (uint32_t frameId = 0; frameId < ids_count; frameId++)
+    {
+        if (m_isIdUsed[frameId] != false)
+        {
+            m_stats[frameId] = Stats();
+            getStatsForUpdate(frameId);
+        }
+    }
+}
+
+bool PeriodAnalyzer::hasStats(const uint32_t frameId) const
+{
+    return m_isIdUsed[frameId];
+}
+
+const PeriodAnalyzer::Stats &PeriodAnalyzer::getStats(const uint32_t frameId) const
+{
+    return m_stats[frameId];
+}
+
+double PeriodAnalyzer::getStdDev(const Stats &stats)
+{
+    return stats.intervals > 1 ? std::sqrt(stats.m2 / (stats.intervals - 1)) : 0.0;
+}
+
+PeriodAnalyzer::Stats &PeriodAnalyzer::getStatsForUpdate(const uint32_t frameId)
+{
+    m_isIdUsed[frameId] = true;
+
+    if (m_isIdDirty[frameId] == false)
+    {
+        m_isIdDirty[frameId] = true;
+        m_dirtyIds.append(frameId);
+    }
+
+    return m_stats[frameId];
+}
+
+void PeriodAnalyzer::takeDirtyIds(QVector<uint32_t> &ids)
+{
+    ids.clear();
+    ids.swap(m_dirtyIds);
+
+    for (const uint32_t frameId : qAsConst(ids))
+    {
+        m_isIdDirty[frameId] = false;
+    }
+}
+
+void PeriodAnalyzer::processDataFrame(const QCanBusFrame &frame)
+{
+    const uint32_t frameId = frame.frameId();
+
+    if (frameId >= ids_count)
+    {
+        return;
+    }
+
+    const uint64_t time = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+
+    Stats &stats = getStatsForUpdate(frameId);
+    stats.frames++;
+
+    if (stats.frames == 1)
+    {
+        stats.lastTime = time;
+        return;
+    }
+
+    // Метки времени, идущие назад, дают нулевой интервал
+    const uint64_t interval = time > stats.lastTime ? time - stats.lastTime : 0;
+    stats.lastTime = std::max(time, stats.lastTime);
+
+    processInterval(stats, interval);
+}
+
+void PeriodAnalyzer::processInterval(Stats &stats, const uint64_t interval)
+{
+    if (stats.period == 0.0)
+    {
+        if (interval != 0)
+        {
+            stats.period = interval;
+            addInterval(stats, interval);
+        }
+
+        return;
+    }
+
+    const uint64_t cycles = (uint64_t)(interval / stats.period + 0.5);
+
+    // Лишний кадр внутри цикла
+    if (cycles == 0)
+    {
+        stats.extra++;
+        stats.missedInRow = 0;
+
+        if (++stats.extraInRow == reseed_count)
+        {
+            stats.period = 0.0;
+            stats.extraInRow = 0;
+            processInterval(stats, interval);
+        }
+
+        return;
+    }
+
+    stats.extraInRow = 0;
+
+    // Пропущенные циклы
+    if (cycles > 1)
+    {
+        stats.missed += cycles - 1;
+
+        if (++stats.missedInRow == reseed_count)
+        {
+            stats.period = 0.0;
+            stats.missedInRow = 0;
+            processInterval(stats, interval);
+        }
+
+        return;
+    }
+
+    stats.missedInRow = 0;
+
+    if (interval > stats.period * (1.0 + late_tolerance))
+    {
+        stats.late++;
+    }
+
+    addInterval(stats, interval);
+
+    stats.period += (interval - stats.period) / period_smoothing;
+}
+
+void PeriodAnalyzer::addInterval(Stats &stats, const uint64_t interval)
+{
+    stats.min = stats.intervals == 0 ? interval : std::min(stats.min, interval);
+    stats.max = stats.intervals == 0 ? interval : std::max(stats.max, interval);
+    stats.intervals++;
+
+    // Среднее и сумма квадратов отклонений по Уэлфорду
+    const double delta = interval - stats.mean;
+    stats.mean += delta / stats.intervals;
+    stats.m2 += delta * (interval - stats.mean);
+}
@@ -0,0 +1,91 @@
+/****************************************************************************
+
+Класс PeriodAnalyzer оценивает период следования кадров каждого CAN ID
+и разброс интервалов между ними, чтобы было видно, выдерживается ли на
+шине расписание опроса ведущего узла.
+
+Период оценивается скользящим средним интервалов, попавших в цикл:
+интервал делится на текущую оценку периода и округляется до числа циклов.
+Один цикл - интервал идёт в оценку периода и в статистику (минимум,
+среднее, максимум и СКО по Уэлфорду); если он длиннее периода больше чем
+на late_tolerance, цикл считается опоздавшим. Несколько циклов - пропущено
+на один меньше, интервал в статистику не идёт. Меньше половины периода -
+лишний кадр. Если расписание меняется, то после reseed_count подряд
+лишних кадров или пропусков оценка периода начинается заново.
+
+Время берётся из меток времени кадров, на кадр - O(1). Учитываются
+стандартные (11-битные) ID, которые использует CannabusPlus.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QCanBusFrame>
+#include <QVector>
+#include <stdint.h>
+
+class PeriodAnalyzer
+{
+public:
+    PeriodAnalyzer();
+    ~PeriodAnalyzer() = default;
+
+    static constexpr uint32_t ids_count = 2048;
+
+    // Доля периода, на которую цикл может затянуться, не считаясь опоздавшим
+    static constexpr double late_tolerance = 0.25;
+
+    // Вес нового интервала в оценке периода - 1/period_smoothing
+    static constexpr double period_smoothing = 16.0;
+
+    // Число подряд лишних кадров или пропусков, после которого период оценивается заново
+    static constexpr uint32_t reseed_count = 4;
+
+    struct Stats {
+        uint64_t frames = 0;
+
+        // Оценка периода, мкс; 0 - ещё неизвестен
+        double period = 0.0;
+
+        // Интервалы в цикле, мкс
+        uint64_t intervals = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+
+        uint64_t late = 0;
+        uint64_t missed = 0;
+        uint64_t extra = 0;
+
+        uint64_t lastTime = 0;
+        uint32_t extraInRow = 0;
+        uint32_t missedInRow = 0;
+    };
+
+    // Обработка кадра данных
+    void processDataFrame(const QCanBusFrame &frame);
+
+    // Сброс статистики
+    void clear();
+
+    bool hasStats(const uint32_t frameId) const;
+    const Stats &getStats(const uint32_t frameId) const;
+
+    // СКО интервалов в цикле, мкс
+    static double getStdDev(const Stats &stats);
+
+    // Забрать ID, статистика по которым изменилась с прошлого вызова
+    void takeDirtyIds(QVector<uint32_t> &ids);
+
+private:
+    void processInterval(Stats &stats, const uint64_t interval);
+    void addInterval(Stats &stats, const uint64_t interval);
+
+    Stats &getStatsForUpdate(const uint32_t frameId);
+
+    QVector<Stats> m_stats;
+    QVector<bool> m_isIdUsed;
+    QVector<bool> m_isIdDirty;
+    QVector<uint32_t> m_dirtyIds;
+};
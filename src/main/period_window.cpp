@@ -0,0 +1,180 @@
+#include "period_window.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+using namespace cannabus;
+
+// Ячейка, которая сортируется по числовому значению, а не по тексту
+class SortKeyItem : public QTableWidgetItem
+{
+public:
+    bool operator<(const QTableWidgetItem &other) const override
+    {
+        return data(Qt::UserRole).toDouble() < other.data(Qt::UserRole).toDouble();
+    }
+};
+
+PeriodWindow::PeriodWindow(QWidget *parent) :
+    QWidget(parent),
+    m_table(new QTableWidget(this)),
+    m_updateTimer(new QTimer(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Periodicity"));
+
+    m_idRow.fill(-1, PeriodAnalyzer::ids_count);
+
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    makeHeader();
+
+    m_table->setSortingEnabled(true);
+    m_table->sortByColumn((uint32_t)PeriodWindowColumn::frame_id, Qt::AscendingOrder);
+
+    auto clearButton = new QPushButton(tr("Reset"), this);
+
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addStretch();
+    controlsLayout->addWidget(clearButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(m_table);
+    layout->addLayout(controlsLayout);
+
+    connect(clearButton, &QPushButton::clicked, this, &PeriodWindow::clearStats);
+    connect(m_updateTimer, &QTimer::timeout, this, &PeriodWindow::refresh);
+
+    resize(1000, 400);
+}
+
+void PeriodWindow::makeHeader()
+{
+    QStringList periodWindowHeader = {"ID", "Msg Type", "Address", "F-Code", "Frames", "Period, ms", "Min, ms",
+                                      "Mean, ms", "Max, ms", "Std Dev, ms", "Late", "Missed", "Extra"};
+
+    m_table->setColumnCount(periodWindowHeader.count());
+    m_table->setHorizontalHeaderLabels(periodWindowHeader);
+
+    m_table->horizontalHeader()->setFixedHeight(1.5 * fontMetrics().height());
+}
+
+void PeriodWindow::processDataFrame(const QCanBusFrame &frame)
+{
+    m_analyzer.processDataFrame(frame);
+}
+
+void PeriodWindow::clearStats()
+{
+    m_analyzer.clear();
+    refresh();
+}
+
+void PeriodWindow::showEvent(QShowEvent *event)
+{
+    refresh();
+    m_updateTimer->start(update_timeout);
+
+    QWidget::showEvent(event);
+}
+
+void PeriodWindow::hideEvent(QHideEvent *event)
+{
+    m_updateTimer->stop();
+
+    QWidget::hideEvent(event);
+}
+
+void PeriodWindow::refresh()
+{
+    m_analyzer.takeDirtyIds(m_dirtyIds);
+
+    if (m_dirtyIds.isEmpty() != false)
+    {
+        return;
+    }
+
+    // Пока строки заполняются, сортировку отключаем, иначе строки переставляются после каждой ячейки
+    m_table->setSortingEnabled(false);
+
+    // Строки могли переставиться и после прошлого обновления, когда пользователь сменил сортировку
+    updateIdRows();
+
+    for (const uint32_t frameId : qAsConst(m_dirtyIds))
+    {
+        if (m_idRow[frameId] == -1)
+        {
+            m_idRow[frameId] = m_table->rowCount();
+            m_table->insertRow(m_idRow[frameId]);
+        }
+
+        setRow(m_idRow[frameId], frameId);
+    }
+
+    m_table->setSortingEnabled(true);
+}
+
+void PeriodWindow::updateIdRows()
+{
+    for (int32_t row = 0; row < m_table->rowCount(); row++)
+    {
+        m_idRow[m_table->item(row, (uint32_t)PeriodWindowColumn::frame_id)->data(Qt::UserRole).toUInt()] = row;
+    }
+}
+
+void PeriodWindow::setRow(const int32_t row, const uint32_t frameId)
+{
+    const PeriodAnalyzer::Stats &stats = m_analyzer.getStats(frameId);
+    const uint32_t slaveAddress = getAddressFromId(frameId);
+    const IdMsgTypes msgType = getMsgTypeFromId(frameId);
+    const IdFCode fCode = getFCodeFromId(frameId);
+
+    // ID, тип сообщения, адрес и F-код в тех же форматах, что и в логе
+    setCell(row, PeriodWindowColumn::frame_id, tr("0x") + tr("%1").arg(frameId, 3, 16, QLatin1Char('0')).toUpper(),
+            frameId);
+    setCell(row, PeriodWindowColumn::msg_type, tr("0b%1").arg((uint32_t)msgType, 2, 2, QLatin1Char('0')),
+            (uint32_t)msgType);
+    setCell(row, PeriodWindowColumn::slave_address, tr("%1 (0x").arg(slaveAddress, 2, 10, QLatin1Char(' ')) +
+                                                    tr("%1)").arg(slaveAddress, 2, 16, QLatin1Char('0')).toUpper(),
+            slaveAddress);
+    setCell(row, PeriodWindowColumn::f_code, tr("0b%1").arg((uint32_t)fCode, 3, 2, QLatin1Char('0')), (uint32_t)fCode);
+
+    setCell(row, PeriodWindowColumn::frames, tr("%1").arg(stats.frames), stats.frames);
+    setCell(row, PeriodWindowColumn::late  , tr("%1").arg(stats.late  ), stats.late  );
+    setCell(row, PeriodWindowColumn::missed, tr("%1").arg(stats.missed), stats.missed);
+    setCell(row, PeriodWindowColumn::extra , tr("%1").arg(stats.extra ), stats.extra );
+
+    const double stdDev = PeriodAnalyzer::getStdDev(stats);
+
+    setCell(row, PeriodWindowColumn::period , intervalToString(stats.period), stats.period);
+    setCell(row, PeriodWindowColumn::min    , intervalToString(stats.min   ), stats.min   );
+    setCell(row, PeriodWindowColumn::mean   , intervalToString(stats.mean  ), stats.mean  );
+    setCell(row, PeriodWindowColumn::max    , intervalToString(stats.max   ), stats.max   );
+    setCell(row, PeriodWindowColumn::std_dev, intervalToString(stdDev      ), stdDev      );
+}
+
+void PeriodWindow::setCell(const int32_t row, const PeriodWindowColumn column, const QString text, const double sortKey)
+{
+    QTableWidgetItem *item = m_table->item(row, (uint32_t)column);
+
+    if (item == nullptr)
+    {
+        item = new SortKeyItem;
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        m_table->setItem(row, (uint32_t)column, item);
+    }
+
+    item->setText(text);
+    item->setData(Qt::UserRole, sortKey);
+}
+
+QString PeriodWindow::intervalToString(const double interval)
+{
+    return tr("%1").arg(interval / 1000.0, 0, 'f', 3);
+}
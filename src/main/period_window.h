@@ -0,0 +1,86 @@
+/****************************************************************************
+
+Класс PeriodWindow выводит периодичность кадров по CAN ID (PeriodAnalyzer):
+оценку периода, минимум, среднее, максимум и СКО интервалов в цикле,
+число опоздавших и пропущенных циклов и лишних кадров. Таблица
+сортируется по любому столбцу и, пока окно открыто, обновляется раз в
+update_timeout только в строках, статистика которых изменилась.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <QCanBusFrame>
+#include <QVector>
+#include <stdint.h>
+#include "../cannabus_library/cannabus_common.h"
+#include "period_analyzer.h"
+
+QT_BEGIN_NAMESPACE
+
+class QTableWidget;
+class QTimer;
+
+QT_END_NAMESPACE
+
+enum class PeriodWindowColumn {
+    frame_id,
+    msg_type,
+    slave_address,
+    f_code,
+    frames,
+    period,
+    min,
+    mean,
+    max,
+    std_dev,
+    late,
+    missed,
+    extra
+};
+
+class PeriodWindow : public QWidget
+{
+public:
+    explicit PeriodWindow(QWidget *parent = nullptr);
+    ~PeriodWindow() = default;
+
+    // Период обновления таблицы, мс
+    static constexpr uint32_t update_timeout = 1000;
+
+    // Обработка кадра данных
+    void processDataFrame(const QCanBusFrame &frame);
+
+public slots:
+    // Обновление изменившихся строк
+    void refresh();
+
+    // Сброс статистики
+    void clearStats();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void makeHeader();
+
+    // Соответствие ID строкам по текущему порядку строк таблицы
+    void updateIdRows();
+
+    // Заполнение строки статистикой; sortKey - значение для сортировки столбца
+    void setRow(const int32_t row, const uint32_t frameId);
+    void setCell(const int32_t row, const PeriodWindowColumn column, const QString text, const double sortKey);
+
+    // Интервал в мкс в виде миллисекунд в формате '12.345'
+    static QString intervalToString(const double interval);
+
+    PeriodAnalyzer m_analyzer;
+
+    QTableWidget *m_table = nullptr;
+    QTimer *m_updateTimer = nullptr;
+
+    QVector<int32_t> m_idRow;
+    QVector<uint32_t> m_dirtyIds;
+};
@@ -0,0 +1,367 @@
+#include "register_decoder.h"
+#include "register_map.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <algorithm>
+
+using namespace cannabus;
+
+RegisterDecoder::RegisterDecoder()
+{
+    clear();
+}
+
+void RegisterDecoder::clear()
+{
+    m_fields.clear();
+    m_regField.fill(no_field, RegisterMap::cells_count);
+    m_regByte.fill(0, RegisterMap::cells_count);
+}
+
+bool RegisterDecoder::isLoaded() const
+{
+    return m_fields.isEmpty() == false;
+}
+
+bool RegisterDecoder::load(const QString &fileName, QString &errorString)
+{
+    QFile file(fileName);
+
+    if (file.open(QIODevice::ReadOnly) == false)
+    {
+        errorString = file.errorString();
+        return false;
+    }
+
+    QVector<Field> fields;
+    QVector<int16_t> regField;
+    QVector<uint8_t> regByte;
+
+    if (parse(file.readAll(), fields, regField, regByte, errorString) == false)
+    {
+        return false;
+    }
+
+    m_fields.swap(fields);
+    m_regField.swap(regField);
+    m_regByte.swap(regByte);
+
+    return true;
+}
+
+bool RegisterDecoder::parse(const QByteArray &json, QVector<Field> &fields, QVector<int16_t> &regField,
+                            QVector<uint8_t> &regByte, QString &errorString) const
+{
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+
+    if (document.isNull() != false)
+    {
+        errorString = QObject::tr("JSON error at offset %1: %2").arg(parseError.offset).arg(parseError.errorString());
+        return false;
+    }
+
+    regField.fill(no_field, RegisterMap::cells_count);
+    regByte.fill(0, RegisterMap::cells_count);
+
+    const QJsonArray devices = document.object().value("devices").toArray();
+
+    if (devices.isEmpty() != false)
+    {
+        errorString = QObject::tr("no devices are described");
+        return false;
+    }
+
+    // Номер значения и позиция байта в нём для каждого регистра устройства
+    QVector<int16_t> deviceRegField;
+    QVector<uint8_t> deviceRegByte;
+
+    for (int32_t deviceIndex = 0; deviceIndex < devices.size(); deviceIndex++)
+    {
+        const QJsonObject device = devices[deviceIndex].toObject();
+        const QJsonArray addresses = device.value("addresses").toArray();
+        const QJsonArray registers = device.value("registers").toArray();
+
+        deviceRegField.fill(no_field, RegisterMap::regs_count);
+        deviceRegByte.fill(0, RegisterMap::regs_count);
+
+        // Значения устройства компилируются один раз и общие для всех его адресов
+        for (int32_t regIndex = 0; regIndex < registers.size(); regIndex++)
+        {
+            const QJsonObject description = registers[regIndex].toObject();
+
+            Field field;
+            field.name = description.value("name").toString();
+            field.width = description.value("width").toInt(1);
+            field.isBigEndian = description.value("endianness").toString("little") == "big";
+            field.isSigned = description.value("signed").toBool(false);
+            field.scale = description.value("scale").toDouble(1.0);
+            field.offset = description.value("offset").toDouble(0.0);
+            field.unit = description.value("unit").toString();
+
+            const int32_t lowReg = description.value("reg").toInt(-1);
+
+            if (field.name.isEmpty() != false || lowReg < 0 ||
+                (field.width != 1 && field.width != 2 && field.width != 4) ||
+                lowReg + field.width > RegisterMap::regs_count)
+            {
+                errorString = QObject::tr("device %1, register %2: invalid name, number or width")
+                              .arg(deviceIndex).arg(regIndex);
+                return false;
+            }
+
+            const QJsonObject labels = description.value("enum").toObject();
+
+            for (auto label = labels.begin(); label != labels.end(); label++)
+            {
+                field.labels.insert(label.key().toLongLong(nullptr, 0), label.value().toString());
+            }
+
+            for (uint32_t byte = 0; byte < field.width; byte++)
+            {
+                if (deviceRegField[lowReg + byte] != no_field)
+                {
+                    errorString = QObject::tr("device %1: register 0x%2 is described twice")
+                                  .arg(deviceIndex).arg(lowReg + byte, 2, 16, QLatin1Char('0'));
+                    return false;
+                }
+
+                deviceRegField[lowReg + byte] = (int16_t)fields.size();
+                deviceRegByte[lowReg + byte] = byte;
+            }
+
+            // Однобайтовое значение расшифровывается выбором готовой строки
+            if (field.width == 1)
+            {
+                field.byteTexts.reserve(256);
+
+                for (uint32_t raw = 0; raw < 256; raw++)
+                {
+                    field.byteTexts.append(formatField(field, raw));
+                }
+            }
+
+            fields.append(field);
+        }
+
+        for (const QJsonValue &addressValue : addresses)
+        {
+            const int32_t slaveAddress = addressValue.toInt(-1);
+
+            if (slaveAddress < (int32_t)IdAddresses::MIN_SLAVE_ADDRESS ||
+                slaveAddress > (int32_t)IdAddresses::MAX_PERMITTED_ADDRESS)
+            {
+                errorString = QObject::tr("device %1: invalid address").arg(deviceIndex);
+                return false;
+            }
+
+            for (uint32_t reg = 0; reg < RegisterMap::regs_count; reg++)
+            {
+                if (deviceRegField[reg] == no_field)
+                {
+                    continue;
+                }
+
+                const uint32_t cell = RegisterMap::getCell(slaveAddress, reg);
+
+                if (regField[cell] != no_field)
+                {
+                    errorString = QObject::tr("register 0x%1 of address %2 is described twice")
+                                  .arg(reg, 2, 16, QLatin1Char('0')).arg(slaveAddress);
+                    return false;
+                }
+
+                regField[cell] = deviceRegField[reg];
+                regByte[cell] = deviceRegByte[reg];
+            }
+        }
+    }
+
+    if (fields.isEmpty() != false)
+    {
+        errorString = QObject::tr("no registers are described");
+        return false;
+    }
+
+    return true;
+}
+
+QString RegisterDecoder::formatField(const Field &field, const uint32_t raw) const
+{
+    int64_t value = raw;
+
+    if (field.isSigned != false)
+    {
+        value = field.width == 1 ? (int8_t)raw : field.width == 2 ? (int16_t)raw : (int32_t)raw;
+    }
+
+    auto label = field.labels.constFind(value);
+
+    if (label != field.labels.constEnd())
+    {
+        return field.name + "=" + label.value();
+    }
+
+    QString text = field.name + "=";
+
+    if (field.scale == 1.0 && field.offset == 0.0)
+    {
+        text += QString::number(value);
+    }
+    else
+    {
+        text += QString::number(value * field.scale + field.offset, 'g', 6);
+    }
+
+    if (field.unit.isEmpty() == false)
+    {
+        text += " " + field.unit;
+    }
+
+    return text;
+}
+
+QString RegisterDecoder::formatUnknown(const uint32_t reg, const uint8_t value) const
+{
+    return "[0x" + QString("%1").arg(reg, 2, 16, QLatin1Char('0')).toUpper() + "]=0x" +
+           QString("%1").arg(value, 2, 16, QLatin1Char('0')).toUpper();
+}
+
+QString RegisterDecoder::decode(const uint32_t frameId, const QByteArray &data) const
+{
+    const uint32_t slaveAddress = getAddressFromId(frameId);
+    const IdMsgTypes msgType = getMsgTypeFromId(frameId);
+    const IdFCode fCode = getFCodeFromId(frameId);
+
+    if (m_fields.isEmpty() != false || data.isEmpty() != false ||
+        slaveAddress < (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS ||
+        slaveAddress > (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS)
+    {
+        return QString();
+    }
+
+    const bool isMasterMsg = msgType == IdMsgTypes::MASTER || msgType == IdMsgTypes::HIGH_PRIO_MASTER;
+    const bool isSlaveMsg = msgType == IdMsgTypes::SLAVE || msgType == IdMsgTypes::HIGH_PRIO_SLAVE;
+    const bool isRange = fCode == IdFCode::WRITE_REGS_RANGE || fCode == IdFCode::READ_REGS_RANGE;
+    const bool isWrite = fCode == IdFCode::WRITE_REGS_RANGE || fCode == IdFCode::WRITE_REGS_SERIES;
+    const bool isRead = fCode == IdFCode::READ_REGS_RANGE || fCode == IdFCode::READ_REGS_SERIES;
+
+    // Значения несут запрос на запись и ответ на чтение, запрос на чтение - только номера регистров
+    const bool hasValues = (isMasterMsg != false && isWrite != false) || (isSlaveMsg != false && isRead != false);
+    const bool hasNames = isMasterMsg != false && isRead != false;
+
+    if (hasValues == false && hasNames == false)
+    {
+        return QString();
+    }
+
+    // Регистры кадра в порядке следования и их значения
+    QVarLengthArray<uint8_t, 64> regs;
+    uint8_t values[RegisterMap::regs_count] = {};
+    bool isPresent[RegisterMap::regs_count] = {};
+
+    if (isRange != false)
+    {
+        if (data.size() < 2)
+        {
+            return QString();
+        }
+
+        const uint32_t regBegin = static_cast<uint8_t>(data[0]);
+        const uint32_t regEnd = static_cast<uint8_t>(data[1]);
+        const uint32_t expectedSize = hasValues != false ? 2 + regEnd - regBegin + 1 : 2;
+
+        if (regEnd < regBegin || (uint32_t)data.size() != expectedSize)
+        {
+            return QString();
+        }
+
+        for (uint32_t reg = regBegin; reg <= regEnd; reg++)
+        {
+            regs.append(reg);
+            values[reg] = hasValues != false ? static_cast<uint8_t>(data[2 + reg - regBegin]) : 0;
+            isPresent[reg] = true;
+        }
+    }
+    else
+    {
+        const int32_t step = hasValues != false ? 2 : 1;
+
+        if (data.size() % step != 0)
+        {
+            return QString();
+        }
+
+        for (int32_t index = 0; index < data.size(); index += step)
+        {
+            const uint8_t reg = data[index];
+
+            regs.append(reg);
+            values[reg] = hasValues != false ? static_cast<uint8_t>(data[index + 1]) : 0;
+            isPresent[reg] = true;
+        }
+    }
+
+    QStringList parts;
+    QVarLengthArray<int16_t, 16> shownFields;
+
+    for (const uint8_t reg : regs)
+    {
+        const uint32_t cell = RegisterMap::getCell(slaveAddress, reg);
+        const int16_t fieldIndex = m_regField[cell];
+
+        if (fieldIndex == no_field)
+        {
+            if (hasValues != false)
+            {
+                parts.append(formatUnknown(reg, values[reg]));
+            }
+
+            continue;
+        }
+
+        // Многобайтное значение выводится один раз, по первому встреченному байту
+        if (std::find(shownFields.begin(), shownFields.end(), fieldIndex) != shownFields.end())
+        {
+            continue;
+        }
+
+        shownFields.append(fieldIndex);
+
+        const Field &field = m_fields[fieldIndex];
+
+        if (hasValues == false)
+        {
+            parts.append(field.name);
+            continue;
+        }
+
+        if (field.width == 1)
+        {
+            parts.append(field.byteTexts[values[reg]]);
+            continue;
+        }
+
+        const uint32_t lowReg = reg - m_regByte[cell];
+        uint32_t raw = 0;
+        bool isComplete = true;
+
+        for (uint32_t byte = 0; byte < field.width; byte++)
+        {
+            const uint32_t shift = 8 * (field.isBigEndian != false ? field.width - 1 - byte : byte);
+
+            isComplete = isComplete && isPresent[lowReg + byte];
+            raw |= (uint32_t)values[lowReg + byte] << shift;
+        }
+
+        // Кадр несёт только часть байтов значения
+        parts.append(isComplete != false ? formatField(field, raw) : field.name + "=?");
+    }
+
+    return parts.join(", ");
+}
@@ -0,0 +1,87 @@
+/****************************************************************************
+
+Класс RegisterDecoder расшифровывает регистры в кадрах CannabusPlus по
+описанию карт регистров устройств, загруженному из JSON-файла:
+
+{
+    "devices": [
+        {
+            "addresses": [1, 2, 3],
+            "registers": [
+                {"reg": 16, "name": "speed", "width": 2, "signed": true,
+                 "scale": 0.1, "offset": 0, "unit": "rpm"},
+                {"reg": 18, "name": "mode", "enum": {"0": "STOP", "1": "RUN"}},
+                {"reg": 20, "name": "counter", "width": 4, "endianness": "big"}
+            ]
+        }
+    ]
+}
+
+Ширина значения - 1, 2 или 4 регистра (по умолчанию 1), порядок байтов
+по умолчанию "little": младший байт в младшем регистре, как в
+setReg16Val/setReg32Val. Значение выводится как raw * scale + offset с
+единицей измерения или, если есть, подписью из "enum".
+
+При загрузке описание компилируется в таблицы: значения каждого
+устройства - один раз, с готовыми строками для всех 256 сырых значений
+однобайтовых, а для каждой пары адрес-регистр - номер общего значения
+устройства и позиция байта в нём. Расшифровка кадра
+сводится к проходу по его регистрам с поиском в таблицах, поэтому её
+можно выполнять при каждой отрисовке строки лога.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <stdint.h>
+
+class RegisterDecoder
+{
+public:
+    RegisterDecoder();
+    ~RegisterDecoder() = default;
+
+    // Загрузка описания; при ошибке прежнее описание сохраняется, а в errorString - причина
+    bool load(const QString &fileName, QString &errorString);
+    void clear();
+
+    bool isLoaded() const;
+
+    // Значения регистров кадра в виде 'name=value unit, ...'; пустая строка, если расшифровывать нечего
+    QString decode(const uint32_t frameId, const QByteArray &data) const;
+
+private:
+    struct Field {
+        QString name;
+        uint32_t width = 1;
+        bool isBigEndian = false;
+        bool isSigned = false;
+        double scale = 1.0;
+        double offset = 0.0;
+        QString unit;
+        QHash<int64_t, QString> labels;
+
+        // Готовые строки 'name=value' однобайтового значения для всех сырых значений
+        QVector<QString> byteTexts;
+    };
+
+    static constexpr int16_t no_field = -1;
+
+    // Разбор описания в новые таблицы без изменения текущих
+    bool parse(const QByteArray &json, QVector<Field> &fields, QVector<int16_t> &regField,
+               QVector<uint8_t> &regByte, QString &errorString) const;
+
+    QString formatField(const Field &field, const uint32_t raw) const;
+    QString formatUnknown(const uint32_t reg, const uint8_t value) const;
+
+    QVector<Field> m_fields;
+
+    // Номер значения устройства и позиция байта в нём для каждой пары адрес-регистр (как ячейки RegisterMap);
+    // все адреса устройства указывают на одни и те же значения
+    QVector<int16_t> m_regField;
+    QVector<uint8_t> m_regByte;
+};
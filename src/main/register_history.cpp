@@ -0,0 +1,142 @@
+#include "register_history.h"
+
+#include <algorithm>
+#include <limits>
+
+// Время первого наблюдения ячейки, которая ещё не наблюдалась
+static constexpr uint64_t never = std::numeric_limits<uint64_t>::max();
+
+RegisterHistory::RegisterHistory(const uint32_t cellsCount) :
+    m_cellsCount(cellsCount)
+{
+    m_values.fill(0x00, cellsCount);
+    m_firstTime.fill(never, cellsCount);
+}
+
+void RegisterHistory::clear()
+{
+    m_changes.clear();
+    m_checkpoints.clear();
+
+    m_values.fill(0x00);
+    m_firstTime.fill(never);
+
+    m_lastTime = 0;
+}
+
+void RegisterHistory::addChange(const uint64_t time, const uint32_t cell, const uint8_t value)
+{
+    const uint64_t changeTime = std::max(time, m_lastTime);
+    m_lastTime = changeTime;
+
+    // Новый участок: первая дельта, заполненный участок или смещение, не влезающее в 32 бита
+    if (m_checkpoints.isEmpty() != false ||
+        m_changes.size() - m_checkpoints.last().firstChange >= checkpoint_interval ||
+        changeTime - m_checkpoints.last().time > std::numeric_limits<uint32_t>::max())
+    {
+        addCheckpoint(changeTime);
+    }
+
+    Change change;
+    change.timeOffset = changeTime - m_checkpoints.last().time;
+    change.cell = cell;
+    change.value = value;
+
+    m_changes.append(change);
+
+    m_values[cell] = value;
+
+    if (m_firstTime[cell] == never)
+    {
+        m_firstTime[cell] = changeTime;
+    }
+}
+
+void RegisterHistory::addCheckpoint(const uint64_t time)
+{
+    Checkpoint checkpoint;
+    checkpoint.time = time;
+    checkpoint.firstChange = m_changes.size();
+    checkpoint.values = m_values;
+
+    m_checkpoints.append(checkpoint);
+}
+
+int32_t RegisterHistory::findCheckpoint(const uint64_t time) const
+{
+    // Первая контрольная точка позже time, перед ней - искомая
+    auto next = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), time,
+                                 [](const uint64_t value, const Checkpoint &checkpoint)
+    {
+        return value < checkpoint.time;
+    });
+
+    return (int32_t)(next - m_checkpoints.begin()) - 1;
+}
+
+void RegisterHistory::getState(const uint64_t time, const uint32_t firstCell, const uint32_t count,
+                               QVector<int16_t> &values) const
+{
+    values.fill((int16_t)not_observed, count);
+
+    const int32_t index = findCheckpoint(time);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    const Checkpoint &checkpoint = m_checkpoints[index];
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (m_firstTime[firstCell + i] <= time)
+        {
+            values[i] = checkpoint.values[firstCell + i];
+        }
+    }
+
+    // Повтор дельт участка до момента time
+    const uint32_t lastChange = index + 1 < m_checkpoints.size() ? m_checkpoints[index + 1].firstChange
+                                                                 : m_changes.size();
+
+    for (uint32_t changeIndex = checkpoint.firstChange; changeIndex < lastChange; changeIndex++)
+    {
+        const Change &change = m_changes[changeIndex];
+
+        if (checkpoint.time + change.timeOffset > time)
+        {
+            break;
+        }
+
+        if (change.cell >= firstCell && change.cell < firstCell + count)
+        {
+            values[change.cell - firstCell] = change.value;
+        }
+    }
+}
+
+bool RegisterHistory::isEmpty() const
+{
+    return m_changes.isEmpty();
+}
+
+uint64_t RegisterHistory::getBeginTime() const
+{
+    return m_checkpoints.isEmpty() != false ? 0 : m_checkpoints.first().time;
+}
+
+uint64_t RegisterHistory::getEndTime() const
+{
+    return m_lastTime;
+}
+
+uint32_t RegisterHistory::getChangesCount() const
+{
+    return m_changes.size();
+}
+
+uint32_t RegisterHistory::getCheckpointsCount() const
+{
+    return m_checkpoints.size();
+}
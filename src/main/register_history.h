@@ -0,0 +1,81 @@
+/****************************************************************************
+
+Класс RegisterHistory хранит историю теневой карты регистров (RegisterMap)
+так, чтобы состояние всех 61 x 256 регистров на любой момент записи
+восстанавливалось сразу, даже на многочасовой записи.
+
+Каждое изменение значения регистра (и первое наблюдение) записывается
+8-байтовой дельтой: смещение времени от начала участка, номер ячейки и
+новое значение. Каждые checkpoint_interval дельт сохраняется контрольная
+точка - полная копия значений карты. Состояние на момент t - ближайшая
+контрольная точка не позже t плюс не больше checkpoint_interval дельт её
+участка. Наблюдался ли регистр к моменту t, определяется по времени его
+первого наблюдения, поэтому в контрольных точках хранятся только значения.
+
+Время - метки кадров в мкс. Метки, идущие назад (сброс адаптера),
+приравниваются к последней, чтобы история оставалась упорядоченной.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QVector>
+#include <stdint.h>
+
+class RegisterHistory
+{
+public:
+    explicit RegisterHistory(const uint32_t cellsCount);
+    ~RegisterHistory() = default;
+
+    // Число дельт между контрольными точками: ограничивает время восстановления состояния
+    static constexpr uint32_t checkpoint_interval = 16384;
+
+    // Значение ячейки, которой к этому моменту ещё не было в трафике
+    static constexpr int16_t not_observed = -1;
+
+    // Запись изменения ячейки; вызывается только для изменившихся и впервые наблюдаемых ячеек
+    void addChange(const uint64_t time, const uint32_t cell, const uint8_t value);
+
+    // Значения ячеек firstCell..firstCell + count - 1 на момент time (включительно);
+    // ненаблюдавшиеся к этому моменту ячейки - not_observed
+    void getState(const uint64_t time, const uint32_t firstCell, const uint32_t count, QVector<int16_t> &values) const;
+
+    bool isEmpty() const;
+    uint64_t getBeginTime() const;
+    uint64_t getEndTime() const;
+    uint32_t getChangesCount() const;
+    uint32_t getCheckpointsCount() const;
+
+    void clear();
+
+private:
+    struct Change {
+        uint32_t timeOffset;
+        uint16_t cell;
+        uint8_t value;
+    };
+
+    // Контрольная точка: значения до первой дельты участка и время этой дельты
+    struct Checkpoint {
+        uint64_t time = 0;
+        uint32_t firstChange = 0;
+        QVector<uint8_t> values;
+    };
+
+    void addCheckpoint(const uint64_t time);
+
+    // Последняя контрольная точка с временем не больше time; -1, если таких нет
+    int32_t findCheckpoint(const uint64_t time) const;
+
+    uint32_t m_cellsCount = 0;
+
+    QVector<Change> m_changes;
+    QVector<Checkpoint> m_checkpoints;
+
+    // Текущие значения (для следующей контрольной точки) и время первого наблюдения ячеек
+    QVector<uint8_t> m_values;
+    QVector<uint64_t> m_firstTime;
+
+    uint64_t m_lastTime = 0;
+};
@@ -0,0 +1,196 @@
+#include "register_history_window.h"
+#include "register_map.h"
+
+#include <QCheckBox>
+#include <QColor>
+#include <QDoubleSpinBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+using namespace cannabus;
+
+RegisterHistoryWindow::RegisterHistoryWindow(const RegisterHistory *history, QWidget *parent) :
+    QWidget(parent),
+    m_history(history),
+    m_slaveAddress(new QSpinBox(this)),
+    m_timeA(new QDoubleSpinBox(this)),
+    m_timeB(new QDoubleSpinBox(this)),
+    m_isDiff(new QCheckBox(tr("Compare with B"), this)),
+    m_info(new QLabel(this)),
+    m_table(new QTableWidget(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Register History"));
+
+    m_slaveAddress->setRange((uint32_t)IdAddresses::MIN_SLAVE_ADDRESS, (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS);
+
+    // Время в секундах с точностью до 100 мкс, как в логе
+    for (QDoubleSpinBox *time : {m_timeA, m_timeB})
+    {
+        time->setDecimals(4);
+        time->setRange(0, 1e9);
+        time->setSuffix(tr(" s"));
+    }
+
+    QStringList header = {"Register", "Value at A", "Value at B"};
+
+    m_table->setColumnCount(header.count());
+    m_table->setHorizontalHeaderLabels(header);
+    m_table->setRowCount(RegisterMap::regs_count);
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->horizontalHeader()->setSectionsClickable(false);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+
+    for (uint32_t reg = 0; reg < RegisterMap::regs_count; reg++)
+    {
+        setCell(reg, RegisterHistoryWindowColumn::reg, tr("0x") + tr("%1").arg(reg, 2, 16, QLatin1Char('0')).toUpper());
+        setCell(reg, RegisterHistoryWindowColumn::value_a, "");
+        setCell(reg, RegisterHistoryWindowColumn::value_b, "");
+    }
+
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(new QLabel(tr("Address"), this));
+    controlsLayout->addWidget(m_slaveAddress);
+    controlsLayout->addWidget(new QLabel(tr("A"), this));
+    controlsLayout->addWidget(m_timeA);
+    controlsLayout->addWidget(new QLabel(tr("B"), this));
+    controlsLayout->addWidget(m_timeB);
+    controlsLayout->addWidget(m_isDiff);
+    controlsLayout->addStretch();
+
+    auto layout = new QVBoxLayout(this);
+    layout->addLayout(controlsLayout);
+    layout->addWidget(m_table);
+    layout->addWidget(m_info);
+
+    connect(m_slaveAddress, QOverload<int>::of(&QSpinBox::valueChanged), this, &RegisterHistoryWindow::updateState);
+    connect(m_timeA, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &RegisterHistoryWindow::updateState);
+    connect(m_timeB, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &RegisterHistoryWindow::updateState);
+    connect(m_isDiff, &QCheckBox::toggled, this, &RegisterHistoryWindow::updateState);
+
+    updateState();
+
+    resize(500, 700);
+}
+
+void RegisterHistoryWindow::setMoment(const uint64_t time, const uint32_t slaveAddress)
+{
+    // Сигналы блокируем, чтобы состояние восстанавливалось один раз, а не на каждое поле
+    for (QWidget *widget : std::initializer_list<QWidget *>{m_slaveAddress, m_timeA, m_timeB})
+    {
+        widget->blockSignals(true);
+    }
+
+    m_timeB->setValue(m_timeA->value());
+
+    // Как и в логе, время отбрасывается до 100 мкс
+    m_timeA->setValue(time / 100 / 10000.0);
+
+    if (slaveAddress >= (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS &&
+        slaveAddress <= (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS)
+    {
+        m_slaveAddress->setValue(slaveAddress);
+    }
+
+    for (QWidget *widget : std::initializer_list<QWidget *>{m_slaveAddress, m_timeA, m_timeB})
+    {
+        widget->blockSignals(false);
+    }
+
+    updateState();
+}
+
+void RegisterHistoryWindow::updateState()
+{
+    const uint32_t firstCell = RegisterMap::getCell(m_slaveAddress->value(), 0);
+    const bool isDiff = m_isDiff->isChecked();
+
+    // Время поля - начало шага в 100 мкс, в состояние входят все кадры этого шага
+    auto getTime = [](const QDoubleSpinBox *time)
+    {
+        return (uint64_t)(time->value() * 10000 + 0.5) * 100 + 99;
+    };
+
+    m_history->getState(getTime(m_timeA), firstCell, RegisterMap::regs_count, m_valuesA);
+
+    if (isDiff != false)
+    {
+        m_history->getState(getTime(m_timeB), firstCell, RegisterMap::regs_count, m_valuesB);
+    }
+
+    m_table->setColumnHidden((uint32_t)RegisterHistoryWindowColumn::value_b, isDiff == false);
+
+    uint32_t differences = 0;
+
+    for (uint32_t reg = 0; reg < RegisterMap::regs_count; reg++)
+    {
+        const bool isDifferent = isDiff != false && m_valuesA[reg] != m_valuesB[reg];
+        const bool isObserved = m_valuesA[reg] != RegisterHistory::not_observed ||
+                                (isDiff != false && m_valuesB[reg] != RegisterHistory::not_observed);
+
+        // Показываем только регистры, которые к этим моментам уже встречались в трафике
+        m_table->setRowHidden(reg, isObserved == false);
+
+        setCell(reg, RegisterHistoryWindowColumn::value_a, valueToString(m_valuesA[reg]));
+
+        if (isDiff != false)
+        {
+            setCell(reg, RegisterHistoryWindowColumn::value_b, valueToString(m_valuesB[reg]));
+        }
+
+        const QColor background = isDifferent != false ? QColor("khaki") : QColor(Qt::transparent);
+
+        for (uint32_t column = 0; column < (uint32_t)m_table->columnCount(); column++)
+        {
+            m_table->item(reg, column)->setBackground(background);
+        }
+
+        if (isDifferent != false)
+        {
+            differences++;
+        }
+    }
+
+    QString info = tr("History: %1 changes, %2 checkpoints, %3 - %4 s")
+                   .arg(m_history->getChangesCount())
+                   .arg(m_history->getCheckpointsCount())
+                   .arg(m_history->getBeginTime() / 1000000.0, 0, 'f', 4)
+                   .arg(m_history->getEndTime() / 1000000.0, 0, 'f', 4);
+
+    if (isDiff != false)
+    {
+        info += tr("; registers differing: %1").arg(differences);
+    }
+
+    m_info->setText(info);
+}
+
+QString RegisterHistoryWindow::valueToString(const int16_t value)
+{
+    if (value == RegisterHistory::not_observed)
+    {
+        return "--";
+    }
+
+    return tr("0x") + tr("%1").arg(value, 2, 16, QLatin1Char('0')).toUpper();
+}
+
+void RegisterHistoryWindow::setCell(const int32_t row, const RegisterHistoryWindowColumn column, const QString text)
+{
+    QTableWidgetItem *item = m_table->item(row, (uint32_t)column);
+
+    if (item == nullptr)
+    {
+        item = new QTableWidgetItem;
+        item->setTextAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        m_table->setItem(row, (uint32_t)column, item);
+    }
+
+    item->setText(text);
+}
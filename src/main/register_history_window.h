@@ -0,0 +1,66 @@
+/****************************************************************************
+
+Класс RegisterHistoryWindow показывает регистры одного адреса на момент
+записи A, восстановленные по истории карты регистров (RegisterHistory),
+и, если включено сравнение, на момент B с подсветкой различий.
+
+Моменты задаются вручную или щелчком по строке лога: выбранный кадр
+становится моментом A, прежний момент A - моментом B, так что два щелчка
+подряд дают разницу между двумя кадрами.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <QVector>
+#include <stdint.h>
+#include "register_history.h"
+
+QT_BEGIN_NAMESPACE
+
+class QCheckBox;
+class QDoubleSpinBox;
+class QLabel;
+class QSpinBox;
+class QTableWidget;
+
+QT_END_NAMESPACE
+
+enum class RegisterHistoryWindowColumn {
+    reg,
+    value_a,
+    value_b
+};
+
+class RegisterHistoryWindow : public QWidget
+{
+public:
+    explicit RegisterHistoryWindow(const RegisterHistory *history, QWidget *parent = nullptr);
+    ~RegisterHistoryWindow() = default;
+
+    // Новый момент A (время кадра в мкс); прежний A становится моментом B.
+    // slaveAddress вне 1..61 (кадр ошибки, широковещательный кадр) адрес не меняет
+    void setMoment(const uint64_t time, const uint32_t slaveAddress);
+
+public slots:
+    // Восстановление и вывод состояния на выбранные моменты
+    void updateState();
+
+private:
+    void setCell(const int32_t row, const RegisterHistoryWindowColumn column, const QString text);
+
+    static QString valueToString(const int16_t value);
+
+    const RegisterHistory *m_history = nullptr;
+
+    QSpinBox *m_slaveAddress = nullptr;
+    QDoubleSpinBox *m_timeA = nullptr;
+    QDoubleSpinBox *m_timeB = nullptr;
+    QCheckBox *m_isDiff = nullptr;
+    QLabel *m_info = nullptr;
+    QTableWidget *m_table = nullptr;
+
+    QVector<int16_t> m_valuesA;
+    QVector<int16_t> m_valuesB;
+};
@@ -0,0 +1,209 @@
+#include "register_map.h"
+
+using namespace cannabus;
+
+RegisterMap::RegisterMap() :
+    m_history(cells_count),
+    m_timeSeries(cells_count)
+{
+    m_values.fill(0x00, cells_count);
+    m_flags.fill(0x00, cells_count);
+    m_updateTime.fill(0, cells_count);
+    m_changeTime.fill(0, cells_count);
+
+    m_dirtyCells.reserve(cells_count);
+}
+
+void RegisterMap::clear()
+{
+    m_dirtyCells.clear();
+
+    // Ранее наблюдавшиеся ячейки надо перерисовать пустыми
+    for (uint32_t cell = 0; cell < cells_count; cell++)
+    {
+        if ((m_flags[cell] & observed) != 0)
+        {
+            m_dirtyCells.append(cell);
+        }
+    }
+
+    m_history.clear();
+    m_timeSeries.clear();
+
+    m_values.fill(0x00);
+    m_flags.fill(0x00);
+    m_updateTime.fill(0);
+    m_changeTime.fill(0);
+
+    for (const uint32_t cell : qAsConst(m_dirtyCells))
+    {
+        m_flags[cell] = dirty;
+    }
+}
+
+void RegisterMap::processDataFrame(const QCanBusFrame &frame, const uint32_t time)
+{
+    const uint32_t frameId = frame.frameId();
+    const uint32_t slaveAddress = getAddressFromId(frameId);
+    const IdMsgTypes msgType = getMsgTypeFromId(frameId);
+    const IdFCode fCode = getFCodeFromId(frameId);
+    const QByteArray data = frame.payload();
+
+    if (slaveAddress > (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS)
+    {
+        return;
+    }
+
+    m_frameTime = frame.timeStamp().seconds() * 1000000 + frame.timeStamp().microSeconds();
+
+    const bool isMasterMsg = msgType == IdMsgTypes::MASTER || msgType == IdMsgTypes::HIGH_PRIO_MASTER;
+    const bool isSlaveMsg = msgType == IdMsgTypes::SLAVE || msgType == IdMsgTypes::HIGH_PRIO_SLAVE;
+
+    // Запрос на запись несёт новые значения регистров, широковещательный - для всех ведомых узлов
+    if (isMasterMsg != false && (fCode == IdFCode::WRITE_REGS_RANGE || fCode == IdFCode::WRITE_REGS_SERIES))
+    {
+        uint32_t firstAddress = slaveAddress;
+        uint32_t lastAddress = slaveAddress;
+
+        if (slaveAddress == (uint32_t)IdAddresses::BROADCAST)
+        {
+            firstAddress = (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS;
+            lastAddress = (uint32_t)IdAddresses::MAX_SLAVE_ADDRESS;
+        }
+
+        for (uint32_t address = firstAddress; address <= lastAddress; address++)
+        {
+            if (fCode == IdFCode::WRITE_REGS_RANGE)
+            {
+                processRange(address, data, time);
+            }
+            else
+            {
+                processSeries(address, data, time);
+            }
+        }
+
+        m_timeSeries.finishFrame(m_frameTime);
+        return;
+    }
+
+    // Ответ на чтение и высокоприоритетное сообщение ведомого несут текущие значения
+    if (isSlaveMsg != false && slaveAddress != (uint32_t)IdAddresses::BROADCAST)
+    {
+        if (fCode == IdFCode::READ_REGS_RANGE)
+        {
+            processRange(slaveAddress, data, time);
+        }
+        else if (fCode == IdFCode::READ_REGS_SERIES)
+        {
+            processSeries(slaveAddress, data, time);
+        }
+    }
+
+    m_timeSeries.finishFrame(m_frameTime);
+}
+
+void RegisterMap::processRange(const uint32_t slaveAddress, const QByteArray &data, const uint32_t time)
+{
+    // Формат '[начало] [конец] [значения...]', кадры с несовпадающей длиной пропускаем
+    if (data.size() < 3)
+    {
+        return;
+    }
+
+    const uint32_t regBegin = static_cast<uint8_t>(data[0]);
+    const uint32_t regEnd = static_cast<uint8_t>(data[1]);
+
+    if (regEnd < regBegin || (uint32_t)data.size() != 2 + regEnd - regBegin + 1)
+    {
+        return;
+    }
+
+    for (uint32_t reg = regBegin; reg <= regEnd; reg++)
+    {
+        setRegValue(slaveAddress, reg, static_cast<uint8_t>(data[2 + reg - regBegin]), time);
+    }
+}
+
+void RegisterMap::processSeries(const uint32_t slaveAddress, const QByteArray &data, const uint32_t time)
+{
+    // Формат '[номер] [значение]' парами
+    if (data.size() == 0 || data.size() % 2 != 0)
+    {
+        return;
+    }
+
+    for (int32_t index = 0; index < data.size(); index += 2)
+    {
+        setRegValue(slaveAddress, static_cast<uint8_t>(data[index]), static_cast<uint8_t>(data[index + 1]), time);
+    }
+}
+
+void RegisterMap::setRegValue(const uint32_t slaveAddress, const uint8_t reg, const uint8_t value, const uint32_t time)
+{
+    const uint32_t cell = getCell(slaveAddress, reg);
+
+    const bool isChanged = (m_flags[cell] & observed) == 0 || m_values[cell] != value;
+
+    m_values[cell] = value;
+    m_updateTime[cell] = time;
+
+    m_timeSeries.addUpdate(m_frameTime, cell, value);
+
+    if (isChanged != false)
+    {
+        m_changeTime[cell] = time;
+        m_history.addChange(m_frameTime, cell, value);
+    }
+
+    // Каждая ячейка попадает в список не больше одного раза до следующего takeDirtyCells
+    if ((m_flags[cell] & dirty) == 0)
+    {
+        m_dirtyCells.append(cell);
+    }
+
+    m_flags[cell] |= observed | dirty;
+}
+
+bool RegisterMap::isObserved(const uint32_t cell) const
+{
+    return (m_flags[cell] & observed) != 0;
+}
+
+uint8_t RegisterMap::getValue(const uint32_t cell) const
+{
+    return m_values[cell];
+}
+
+uint32_t RegisterMap::getUpdateTime(const uint32_t cell) const
+{
+    return m_updateTime[cell];
+}
+
+uint32_t RegisterMap::getChangeTime(const uint32_t cell) const
+{
+    return m_changeTime[cell];
+}
+
+void RegisterMap::takeDirtyCells(QVector<uint32_t> &cells)
+{
+    cells.clear();
+    cells.swap(m_dirtyCells);
+
+    for (const uint32_t cell : qAsConst(cells))
+    {
+        m_flags[cell] &= ~dirty;
+    }
+
+    m_dirtyCells.reserve(cells_count);
+}
+
+const RegisterHistory &RegisterMap::getHistory() const
+{
+    return m_history;
+}
+
+TimeSeriesStore &RegisterMap::getTimeSeries()
+{
+    return m_timeSeries;
+}
@@ -0,0 +1,102 @@
+/****************************************************************************
+
+Класс RegisterMap хранит теневую копию регистров всех ведомых узлов сети,
+восстановленную по наблюдаемому трафику CannabusPlus. Значения берутся из
+ответов на чтение (READ_REGS_*), запросов на запись (WRITE_REGS_*) и
+высокоприоритетных сообщений ведомых узлов.
+
+Карта хранится в плоских массивах 61 адрес x 256 регистров, ячейки одного
+узла лежат подряд, поэтому разбор кадра трогает только соседние байты и
+занимает O(размер кадра). Изменённые ячейки копятся в списке, который
+забирает представление, чтобы перерисовывать только их.
+
+Изменения значений записываются в историю (RegisterHistory) с метками
+времени кадров, по которой восстанавливается состояние карты на любой
+момент записи. Кроме того, каждое обновление регистра (не только
+изменение) записывается в ряды для графиков (TimeSeriesStore).
+
+****************************************************************************/
+
+#pragma once
+
+#include <QCanBusFrame>
+#include <QVector>
+#include <stdint.h>
+#include "../cannabus_library/cannabus_common.h"
+#include "register_history.h"
+#include "time_series.h"
+
+class RegisterMap
+{
+public:
+    RegisterMap();
+    ~RegisterMap() = default;
+
+    // Адреса 1..61: ведомые узлы и адрес прямого доступа
+    static constexpr uint32_t addresses_count = (uint32_t)cannabus::IdAddresses::MAX_PERMITTED_ADDRESS;
+    static constexpr uint32_t regs_count = 256;
+    static constexpr uint32_t cells_count = addresses_count * regs_count;
+
+    // Применение кадра к карте; time - время приёма в мс
+    void processDataFrame(const QCanBusFrame &frame, const uint32_t time);
+
+    // Сброс карты и её истории (все регистры становятся ненаблюдавшимися)
+    void clear();
+
+    // Номер ячейки и обратное преобразование
+    static uint32_t getCell(const uint32_t slaveAddress, const uint32_t reg)
+    {
+        return (slaveAddress - (uint32_t)cannabus::IdAddresses::MIN_SLAVE_ADDRESS) * regs_count + reg;
+    }
+
+    static uint32_t getAddressFromCell(const uint32_t cell)
+    {
+        return cell / regs_count + (uint32_t)cannabus::IdAddresses::MIN_SLAVE_ADDRESS;
+    }
+
+    static uint32_t getRegFromCell(const uint32_t cell)
+    {
+        return cell % regs_count;
+    }
+
+    // Геттеры ячейки
+    bool isObserved(const uint32_t cell) const;
+    uint8_t getValue(const uint32_t cell) const;
+    uint32_t getUpdateTime(const uint32_t cell) const;
+    uint32_t getChangeTime(const uint32_t cell) const;
+
+    // Забрать накопленные с прошлого вызова изменённые ячейки
+    void takeDirtyCells(QVector<uint32_t> &cells);
+
+    // История изменений карты по меткам времени кадров
+    const RegisterHistory &getHistory() const;
+
+    // Ряды значений регистров для графиков
+    TimeSeriesStore &getTimeSeries();
+
+private:
+    // Запись одного регистра в карту
+    void setRegValue(const uint32_t slaveAddress, const uint8_t reg, const uint8_t value, const uint32_t time);
+
+    // Разбор диапазона (начало, конец, значения) и серии (пары номер-значение)
+    void processRange(const uint32_t slaveAddress, const QByteArray &data, const uint32_t time);
+    void processSeries(const uint32_t slaveAddress, const QByteArray &data, const uint32_t time);
+
+    enum CellFlags : uint8_t {
+        observed = 0x01,
+        dirty    = 0x02
+    };
+
+    QVector<uint8_t> m_values;
+    QVector<uint8_t> m_flags;
+    QVector<uint32_t> m_updateTime;
+    QVector<uint32_t> m_changeTime;
+
+    QVector<uint32_t> m_dirtyCells;
+
+    RegisterHistory m_history;
+    TimeSeriesStore m_timeSeries;
+
+    // Метка времени разбираемого кадра, мкс
+    uint64_t m_frameTime = 0;
+};
@@ -0,0 +1,244 @@
+#include "register_map_window.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QHeaderView>
+
+using namespace cannabus;
+
+RegisterMapModel::RegisterMapModel(QObject *parent) : QAbstractTableModel(parent)
+{
+    m_clock.start();
+}
+
+int RegisterMapModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() != false ? 0 : RegisterMap::regs_count;
+}
+
+int RegisterMapModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() != false ? 0 : RegisterMap::addresses_count;
+}
+
+QModelIndex RegisterMapModel::getIndex(const uint32_t cell) const
+{
+    const uint32_t slaveAddress = RegisterMap::getAddressFromCell(cell);
+
+    return index(RegisterMap::getRegFromCell(cell), slaveAddress - (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS);
+}
+
+QVariant RegisterMapModel::data(const QModelIndex &index, int role) const
+{
+    if (index.isValid() == false)
+    {
+        return QVariant();
+    }
+
+    const uint32_t slaveAddress = index.column() + (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS;
+    const uint32_t reg = index.row();
+    const uint32_t cell = RegisterMap::getCell(slaveAddress, reg);
+
+    if (m_map.isObserved(cell) == false)
+    {
+        return QVariant();
+    }
+
+    const uint32_t currentTime = m_clock.elapsed();
+    const uint32_t updateAge = currentTime - m_map.getUpdateTime(cell);
+    const uint32_t changeAge = currentTime - m_map.getChangeTime(cell);
+    const uint32_t value = m_map.getValue(cell);
+
+    switch (role)
+    {
+        case Qt::DisplayRole:
+        {
+            // Выводим значение в шестнадцатеричной системе счисления в формате 'A5'
+            return tr("%1").arg(value, 2, 16, QLatin1Char('0')).toUpper();
+        }
+        case Qt::TextAlignmentRole:
+        {
+            return int(Qt::AlignHCenter | Qt::AlignVCenter);
+        }
+        case Qt::BackgroundRole:
+        {
+            if (changeAge < highlight_timeout)
+            {
+                return QBrush(QColor("khaki"));
+            }
+
+            return QVariant();
+        }
+        case Qt::ForegroundRole:
+        {
+            if (updateAge >= stale_timeout)
+            {
+                return QBrush(Qt::gray);
+            }
+
+            return QVariant();
+        }
+        case Qt::ToolTipRole:
+        {
+            const QString regHex = tr("%1").arg(reg, 2, 16, QLatin1Char('0')).toUpper();
+            const QString valueHex = tr("%1").arg(value, 2, 16, QLatin1Char('0')).toUpper();
+
+            return tr("Address %1, register 0x%2 = 0x%3 (%4)\nUpdated %5 s ago\nChanged %6 s ago")
+                    .arg(slaveAddress)
+                    .arg(regHex)
+                    .arg(valueHex)
+                    .arg(value)
+                    .arg(updateAge / 1000.0, 0, 'f', 1)
+                    .arg(changeAge / 1000.0, 0, 'f', 1);
+        }
+        default:
+        {
+            return QVariant();
+        }
+    }
+}
+
+QVariant RegisterMapModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    // Столбцы - адреса ведомых узлов в десятичной системе, строки - номера регистров в формате '0x12'
+    if (orientation == Qt::Horizontal)
+    {
+        return tr("%1").arg(section + (uint32_t)IdAddresses::MIN_SLAVE_ADDRESS);
+    }
+
+    return tr("0x") + tr("%1").arg(section, 2, 16, QLatin1Char('0')).toUpper();
+}
+
+void RegisterMapModel::processDataFrame(const QCanBusFrame &frame)
+{
+    m_map.processDataFrame(frame, m_clock.elapsed());
+}
+
+void RegisterMapModel::refresh()
+{
+    const uint32_t currentTime = m_clock.elapsed();
+
+    m_map.takeDirtyCells(m_dirtyCells);
+
+    for (const uint32_t cell : qAsConst(m_dirtyCells))
+    {
+        const QModelIndex cellIndex = getIndex(cell);
+        emit dataChanged(cellIndex, cellIndex);
+
+        if (m_map.isObserved(cell) == false)
+        {
+            continue;
+        }
+
+        // Запоминаем, когда ячейку придётся перерисовать ещё раз: по окончании подсветки и при устаревании
+        m_staleQueue.enqueue({cell, m_map.getUpdateTime(cell)});
+
+        if (m_map.getChangeTime(cell) == m_map.getUpdateTime(cell))
+        {
+            m_highlightQueue.enqueue({cell, m_map.getChangeTime(cell)});
+        }
+    }
+
+    updateExpired(m_highlightQueue, highlight_timeout, currentTime, true);
+    updateExpired(m_staleQueue, stale_timeout, currentTime, false);
+}
+
+void RegisterMapModel::updateExpired(QQueue<CellTime> &queue, const uint32_t timeout, const uint32_t currentTime,
+                                     const bool isChangeTime)
+{
+    // Очередь упорядочена по времени, поэтому просматриваем только истёкшие записи в её начале
+    while (queue.isEmpty() == false && currentTime - queue.head().time >= timeout)
+    {
+        const CellTime cellTime = queue.dequeue();
+
+        // Если ячейка с тех пор обновлялась, для неё в очереди есть более поздняя запись
+        const uint32_t cellLastTime = isChangeTime != false ? m_map.getChangeTime(cellTime.cell)
+                                                            : m_map.getUpdateTime(cellTime.cell);
+
+        if (m_map.isObserved(cellTime.cell) != false && cellLastTime == cellTime.time)
+        {
+            const QModelIndex cellIndex = getIndex(cellTime.cell);
+            emit dataChanged(cellIndex, cellIndex);
+        }
+    }
+}
+
+void RegisterMapModel::clear()
+{
+    m_map.clear();
+
+    m_highlightQueue.clear();
+    m_staleQueue.clear();
+
+    refresh();
+}
+
+const RegisterHistory &RegisterMapModel::getHistory() const
+{
+    return m_map.getHistory();
+}
+
+TimeSeriesStore &RegisterMapModel::getTimeSeries()
+{
+    return m_map.getTimeSeries();
+}
+
+RegisterMapWindow::RegisterMapWindow(QWidget *parent) :
+    QTableView(parent),
+    m_model(new RegisterMapModel(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Register Map"));
+
+    setModel(m_model);
+
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    makeHeader();
+
+    resize(1000, 600);
+}
+
+void RegisterMapWindow::makeHeader()
+{
+    // Размеры ячеек задаём фиксированными: подгонка по содержимому обходит все 15616 ячеек
+    horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    horizontalHeader()->setDefaultSectionSize(fontMetrics().horizontalAdvance(" 00 "));
+    horizontalHeader()->setSectionsClickable(false);
+
+    verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    verticalHeader()->setDefaultSectionSize(1.5 * fontMetrics().height());
+    verticalHeader()->setSectionsClickable(false);
+}
+
+void RegisterMapWindow::processDataFrame(const QCanBusFrame &frame)
+{
+    m_model->processDataFrame(frame);
+}
+
+void RegisterMapWindow::refresh()
+{
+    m_model->refresh();
+}
+
+void RegisterMapWindow::clearMap()
+{
+    m_model->clear();
+    makeHeader();
+}
+
+const RegisterHistory &RegisterMapWindow::getHistory() const
+{
+    return m_model->getHistory();
+}
+
+TimeSeriesStore &RegisterMapWindow::getTimeSeries()
+{
+    return m_model->getTimeSeries();
+}
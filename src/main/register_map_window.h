@@ -0,0 +1,92 @@
+/****************************************************************************
+
+Класс RegisterMapWindow показывает теневую карту регистров (RegisterMap)
+в виде таблицы: строки - регистры, столбцы - адреса ведомых узлов.
+Недавно изменившиеся значения подсвечиваются, давно не обновлявшиеся
+выводятся серым, время с последнего обновления - во всплывающей подсказке.
+
+Перерисовываются только ячейки, которые изменились с прошлого обновления
+окна, и ячейки, у которых закончилась подсветка или наступило устаревание.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QTableView>
+#include <stdint.h>
+#include "register_map.h"
+
+class RegisterMapModel : public QAbstractTableModel
+{
+public:
+    explicit RegisterMapModel(QObject *parent = nullptr);
+    ~RegisterMapModel() = default;
+
+    // Время подсветки изменившегося значения и время, после которого значение считается устаревшим, мс
+    static constexpr uint32_t highlight_timeout = 2000;
+    static constexpr uint32_t stale_timeout = 10000;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Применение принятого кадра к карте
+    void processDataFrame(const QCanBusFrame &frame);
+
+    // Перерисовка изменившихся ячеек
+    void refresh();
+
+    // Очистка карты
+    void clear();
+
+    const RegisterHistory &getHistory() const;
+    TimeSeriesStore &getTimeSeries();
+
+private:
+    struct CellTime {
+        uint32_t cell;
+        uint32_t time;
+    };
+
+    QModelIndex getIndex(const uint32_t cell) const;
+
+    // Перерисовка ячеек, у которых истёк таймаут timeout с момента времени из очереди
+    void updateExpired(QQueue<CellTime> &queue, const uint32_t timeout, const uint32_t currentTime, const bool isChangeTime);
+
+    RegisterMap m_map;
+    QElapsedTimer m_clock;
+
+    QVector<uint32_t> m_dirtyCells;
+    QQueue<CellTime> m_highlightQueue;
+    QQueue<CellTime> m_staleQueue;
+};
+
+class RegisterMapWindow : public QTableView
+{
+public:
+    explicit RegisterMapWindow(QWidget *parent = nullptr);
+    ~RegisterMapWindow() = default;
+
+    // Применение кадра и перерисовка (см. RegisterMapModel)
+    void processDataFrame(const QCanBusFrame &frame);
+    void refresh();
+
+    // История карты для восстановления состояния на момент записи
+    const RegisterHistory &getHistory() const;
+
+    // Ряды значений регистров для графиков
+    TimeSeriesStore &getTimeSeries();
+
+public slots:
+    // Очистка карты и пересчёт размеров ячеек под текущий шрифт
+    void clearMap();
+
+private:
+    void makeHeader();
+
+    RegisterMapModel *m_model = nullptr;
+};
@@ -0,0 +1,390 @@
+#include "time_series.h"
+
+#include <algorithm>
+#include <limits>
+
+// zigzag: малые по модулю разности любого знака кодируются малыми числами
+static uint64_t zigzagEncode(const int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zigzagDecode(const uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint64_t getVarint(const uint8_t *&data)
+{
+    uint64_t value = 0;
+    uint32_t shift = 0;
+
+    while ((*data & 0x80) != 0)
+    {
+        value |= (uint64_t)(*data & 0x7F) << shift;
+        shift += 7;
+        data++;
+    }
+
+    value |= (uint64_t)*data << shift;
+    data++;
+
+    return value;
+}
+
+void TimeSeries::putVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        m_data.append((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+
+    m_data.append((uint8_t)value);
+}
+
+void TimeSeries::append(const uint64_t time, const int64_t value)
+{
+    if (m_blocks.isEmpty() != false || m_blocks.last().count == block_size)
+    {
+        Block block;
+        block.firstTime = time;
+        block.lastTime = time;
+        block.firstValue = value;
+        block.lastValue = value;
+        block.min = value;
+        block.max = value;
+        block.offset = m_data.size();
+        block.count = 1;
+
+        m_blocks.append(block);
+        return;
+    }
+
+    Block &block = m_blocks.last();
+    const uint64_t blockTime = std::max(time, block.lastTime);
+
+    putVarint(blockTime - block.lastTime);
+    putVarint(zigzagEncode(value - block.lastValue));
+
+    block.lastTime = blockTime;
+    block.lastValue = value;
+    block.min = std::min(block.min, value);
+    block.max = std::max(block.max, value);
+    block.count++;
+}
+
+void TimeSeries::clear()
+{
+    m_blocks.clear();
+    m_data.clear();
+}
+
+uint32_t TimeSeries::getCount() const
+{
+    return m_blocks.isEmpty() != false ? 0 : (m_blocks.size() - 1) * block_size + m_blocks.last().count;
+}
+
+uint64_t TimeSeries::getBeginTime() const
+{
+    return m_blocks.isEmpty() != false ? 0 : m_blocks.first().firstTime;
+}
+
+uint64_t TimeSeries::getEndTime() const
+{
+    return m_blocks.isEmpty() != false ? 0 : m_blocks.last().lastTime;
+}
+
+template <typename Visitor>
+void TimeSeries::visitBlock(const Block &block, Visitor visitor) const
+{
+    const uint8_t *data = m_data.constData() + block.offset;
+
+    uint64_t time = block.firstTime;
+    int64_t value = block.firstValue;
+
+    visitor(time, value);
+
+    for (uint32_t i = 1; i < block.count; i++)
+    {
+        time += getVarint(data);
+        value += zigzagDecode(getVarint(data));
+
+        visitor(time, value);
+    }
+}
+
+void TimeSeries::getColumns(const uint64_t begin, const uint64_t end, QVector<Column> &columns) const
+{
+    for (Column &column : columns)
+    {
+        column = Column();
+    }
+
+    if (columns.isEmpty() != false || end <= begin)
+    {
+        return;
+    }
+
+    const uint64_t span = end - begin;
+    const uint64_t columnsCount = columns.size();
+
+    auto getColumn = [&](const uint64_t time)
+    {
+        return std::min<uint64_t>((time - begin) * columnsCount / span, columnsCount - 1);
+    };
+
+    auto addToColumn = [&](Column &column, const int64_t first, const int64_t last, const int64_t min, const int64_t max)
+    {
+        if (column.hasData == false)
+        {
+            column.hasData = true;
+            column.first = first;
+            column.min = min;
+            column.max = max;
+        }
+
+        column.last = last;
+        column.min = std::min(column.min, min);
+        column.max = std::max(column.max, max);
+    };
+
+    // Первый блок, который заканчивается не раньше начала отрезка
+    auto block = std::lower_bound(m_blocks.begin(), m_blocks.end(), begin, [](const Block &block, const uint64_t time)
+    {
+        return block.lastTime < time;
+    });
+
+    for (; block != m_blocks.end() && block->firstTime <= end; block++)
+    {
+        const bool isInside = block->firstTime >= begin && block->lastTime <= end;
+
+        // Блок целиком в одном столбце - хватает его сводки
+        if (isInside != false && getColumn(block->firstTime) == getColumn(block->lastTime))
+        {
+            addToColumn(columns[getColumn(block->firstTime)], block->firstValue, block->lastValue, block->min, block->max);
+            continue;
+        }
+
+        visitBlock(*block, [&](const uint64_t time, const int64_t value)
+        {
+            if (time >= begin && time <= end)
+            {
+                addToColumn(columns[getColumn(time)], value, value, value, value);
+            }
+        });
+    }
+}
+
+void TimeSeries::decode(QVector<uint64_t> &times, QVector<int64_t> &values) const
+{
+    times.clear();
+    values.clear();
+
+    times.reserve(getCount());
+    values.reserve(getCount());
+
+    for (const Block &block : m_blocks)
+    {
+        visitBlock(block, [&](const uint64_t time, const int64_t value)
+        {
+            times.append(time);
+            values.append(value);
+        });
+    }
+}
+
+TimeSeriesStore::TimeSeriesStore(const uint32_t cellsCount)
+{
+    m_byteSeries.resize(cellsCount);
+    m_values.fill(0x00, cellsCount);
+    m_isObserved.fill(false, cellsCount);
+}
+
+void TimeSeriesStore::clear()
+{
+    for (TimeSeries &series : m_byteSeries)
+    {
+        series.clear();
+    }
+
+    m_values.fill(0x00);
+    m_isObserved.fill(false);
+    m_frameCells.clear();
+    m_lastTime = 0;
+
+    // Ряды, на которые ссылаются графики, не удаляем, а очищаем
+    for (auto &wide : m_wideSeries)
+    {
+        wide->series.clear();
+    }
+}
+
+void TimeSeriesStore::addUpdate(const uint64_t time, const uint32_t cell, const uint8_t value)
+{
+    m_lastTime = std::max(time, m_lastTime);
+
+    m_byteSeries[cell].append(m_lastTime, value);
+
+    m_values[cell] = value;
+    m_isObserved[cell] = true;
+
+    if (m_wideSeries.empty() == false)
+    {
+        m_frameCells.append(cell);
+    }
+}
+
+void TimeSeriesStore::finishFrame(const uint64_t time)
+{
+    if (m_frameCells.isEmpty() != false)
+    {
+        return;
+    }
+
+    m_lastTime = std::max(time, m_lastTime);
+
+    // Одна точка на кадр для каждого многобайтного значения, байты которого он обновил
+    for (auto &wide : m_wideSeries)
+    {
+        const bool isUpdated = std::any_of(m_frameCells.begin(), m_frameCells.end(), [&wide](const uint32_t cell)
+        {
+            return cell >= wide->lowCell && cell < wide->lowCell + wide->width;
+        });
+
+        if (isUpdated != false && isAssembled(*wide) != false)
+        {
+            wide->series.append(m_lastTime, assemble(*wide));
+        }
+    }
+
+    m_frameCells.clear();
+}
+
+const TimeSeries *TimeSeriesStore::getSeries(const uint32_t lowCell, const uint32_t regsPerCell, const uint32_t width,
+                                             const bool isSigned)
+{
+    if (width != 1 && width != 2 && width != 4)
+    {
+        return nullptr;
+    }
+
+    // Значение не может переходить через последний регистр узла
+    if (lowCell % regsPerCell + width > regsPerCell || lowCell + width > (uint32_t)m_byteSeries.size())
+    {
+        return nullptr;
+    }
+
+    if (width == 1 && isSigned == false)
+    {
+        return &m_byteSeries[lowCell];
+    }
+
+    for (auto &wide : m_wideSeries)
+    {
+        if (wide->lowCell == lowCell && wide->width == width && wide->isSigned == isSigned)
+        {
+            return &wide->series;
+        }
+    }
+
+    std::unique_ptr<WideSeries> wide(new WideSeries);
+    wide->lowCell = lowCell;
+    wide->width = width;
+    wide->isSigned = isSigned;
+
+    buildSeries(*wide);
+
+    m_wideSeries.push_back(std::move(wide));
+
+    return &m_wideSeries.back()->series;
+}
+
+void TimeSeriesStore::buildSeries(WideSeries &wide) const
+{
+    // Слияние однобайтовых рядов по времени; обновления с одной меткой - один кадр, одна точка
+    QVector<uint64_t> times[4];
+    QVector<int64_t> values[4];
+    int32_t positions[4] = {};
+
+    for (uint32_t byte = 0; byte < wide.width; byte++)
+    {
+        m_byteSeries[wide.lowCell + byte].decode(times[byte], values[byte]);
+    }
+
+    uint8_t bytes[4] = {};
+    bool isObserved[4] = {};
+
+    while (true)
+    {
+        uint64_t time = std::numeric_limits<uint64_t>::max();
+
+        for (uint32_t byte = 0; byte < wide.width; byte++)
+        {
+            if (positions[byte] < times[byte].size())
+            {
+                time = std::min(time, times[byte][positions[byte]]);
+            }
+        }
+
+        if (time == std::numeric_limits<uint64_t>::max())
+        {
+            break;
+        }
+
+        for (uint32_t byte = 0; byte < wide.width; byte++)
+        {
+            while (positions[byte] < times[byte].size() && times[byte][positions[byte]] == time)
+            {
+                bytes[byte] = values[byte][positions[byte]];
+                isObserved[byte] = true;
+                positions[byte]++;
+            }
+        }
+
+        if (std::all_of(isObserved, isObserved + wide.width, [](const bool isByteObserved) { return isByteObserved; }))
+        {
+            uint32_t value = 0;
+
+            for (uint32_t byte = 0; byte < wide.width; byte++)
+            {
+                value |= (uint32_t)bytes[byte] << (8 * byte);
+            }
+
+            const int64_t signedValue = wide.width == 1 ? (int8_t)value : wide.width == 2 ? (int16_t)value : (int32_t)value;
+
+            wide.series.append(time, wide.isSigned != false ? signedValue : (int64_t)value);
+        }
+    }
+}
+
+bool TimeSeriesStore::isAssembled(const WideSeries &wide) const
+{
+    for (uint32_t byte = 0; byte < wide.width; byte++)
+    {
+        if (m_isObserved[wide.lowCell + byte] == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int64_t TimeSeriesStore::assemble(const WideSeries &wide) const
+{
+    // Младший байт - в младшем регистре, как в setReg16Val/setReg32Val
+    uint32_t value = 0;
+
+    for (uint32_t byte = 0; byte < wide.width; byte++)
+    {
+        value |= (uint32_t)m_values[wide.lowCell + byte] << (8 * byte);
+    }
+
+    if (wide.isSigned == false)
+    {
+        return value;
+    }
+
+    return wide.width == 1 ? (int8_t)value : wide.width == 2 ? (int16_t)value : (int32_t)value;
+}
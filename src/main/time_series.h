@@ -0,0 +1,125 @@
+/****************************************************************************
+
+Классы TimeSeries и TimeSeriesStore хранят значения регистров во времени
+для построения графиков по записи.
+
+TimeSeries - один ряд в колоночном виде: метки времени и значения
+хранятся разностями от предыдущей точки (varint, значения - zigzag),
+обычно 2-3 байта на точку. Точки разбиты на блоки по block_size, для
+каждого блока запоминаются границы по времени, первое и последнее
+значения, минимум и максимум. Прореживание до столбцов пикселей
+(getColumns) берёт сводку блока целиком, если блок попадает в один
+столбец, и декодирует только блоки на границах столбцов, поэтому
+стоимость определяется шириной графика, а не числом точек.
+
+TimeSeriesStore записывает каждое обновление каждого регистра в
+однобайтовый ряд ячейки. Многобайтные значения (16 и 32 бита) собираются
+так же, как в setReg16Val/setReg32Val: младший байт - в младшем регистре.
+Их ряды строятся по запросу из однобайтовых и дальше пополняются по
+кадрам: обновление нескольких байтов значения одним кадром даёт одну
+точку, а не промежуточные значения с частью старых байтов.
+
+Время - метки кадров в мкс; метки, идущие назад, приравниваются к
+последней.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QVector>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+class TimeSeries
+{
+public:
+    TimeSeries() = default;
+    ~TimeSeries() = default;
+
+    static constexpr uint32_t block_size = 1024;
+
+    // Сводка точек, попавших в один столбец графика
+    struct Column {
+        bool hasData = false;
+        int64_t first = 0;
+        int64_t last = 0;
+        int64_t min = 0;
+        int64_t max = 0;
+    };
+
+    void append(const uint64_t time, const int64_t value);
+    void clear();
+
+    uint32_t getCount() const;
+    uint64_t getBeginTime() const;
+    uint64_t getEndTime() const;
+
+    // Прореживание отрезка времени [begin, end] до columns.size() столбцов
+    void getColumns(const uint64_t begin, const uint64_t end, QVector<Column> &columns) const;
+
+    // Все точки ряда по порядку
+    void decode(QVector<uint64_t> &times, QVector<int64_t> &values) const;
+
+private:
+    struct Block {
+        uint64_t firstTime = 0;
+        uint64_t lastTime = 0;
+        int64_t firstValue = 0;
+        int64_t lastValue = 0;
+        int64_t min = 0;
+        int64_t max = 0;
+        uint32_t offset = 0;
+        uint32_t count = 0;
+    };
+
+    // Обход точек блока; первая точка хранится в самом блоке, остальные - разностями
+    template <typename Visitor>
+    void visitBlock(const Block &block, Visitor visitor) const;
+
+    void putVarint(uint64_t value);
+
+    QVector<Block> m_blocks;
+    QVector<uint8_t> m_data;
+};
+
+class TimeSeriesStore
+{
+public:
+    explicit TimeSeriesStore(const uint32_t cellsCount);
+    ~TimeSeriesStore() = default;
+
+    // Обновление ячейки разбираемым кадром и завершение разбора кадра
+    void addUpdate(const uint64_t time, const uint32_t cell, const uint8_t value);
+    void finishFrame(const uint64_t time);
+
+    // Ряд значения из width (1, 2 или 4) регистров, начиная с младшего lowCell, как в setReg16Val/setReg32Val;
+    // nullptr, если значение выходит за регистры одного узла
+    const TimeSeries *getSeries(const uint32_t lowCell, const uint32_t regsPerCell, const uint32_t width,
+                                const bool isSigned);
+
+    void clear();
+
+private:
+    struct WideSeries {
+        uint32_t lowCell = 0;
+        uint32_t width = 0;
+        bool isSigned = false;
+        TimeSeries series;
+    };
+
+    void buildSeries(WideSeries &wide) const;
+    int64_t assemble(const WideSeries &wide) const;
+    bool isAssembled(const WideSeries &wide) const;
+
+    QVector<TimeSeries> m_byteSeries;
+
+    // Текущие значения ячеек и ячейки, обновлённые разбираемым кадром
+    QVector<uint8_t> m_values;
+    QVector<bool> m_isObserved;
+    QVector<uint32_t> m_frameCells;
+
+    uint64_t m_lastTime = 0;
+
+    std::vector<std::unique_ptr<WideSeries>> m_wideSeries;
+};
@@ -0,0 +1,370 @@
+#include "time_series_window.h"
+#include "register_map.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QVBoxLayout>
+#include <QWheelEvent>
+#include <algorithm>
+
+using namespace cannabus;
+
+TimeSeriesPlot::TimeSeriesPlot(QWidget *parent) :
+    QWidget(parent)
+{
+    setMinimumSize(400, 200);
+}
+
+void TimeSeriesPlot::addCurve(const TimeSeries *series, const QString name)
+{
+    static const QVector<QColor> colors = {Qt::blue, Qt::red, Qt::darkGreen, Qt::magenta, Qt::darkCyan, Qt::darkYellow};
+
+    Curve curve;
+    curve.series = series;
+    curve.name = name;
+    curve.color = colors[m_curves.size() % colors.size()];
+
+    m_curves.append(curve);
+    update();
+}
+
+void TimeSeriesPlot::clearCurves()
+{
+    m_curves.clear();
+    update();
+}
+
+void TimeSeriesPlot::showAll()
+{
+    m_isFollowing = true;
+    update();
+}
+
+QRect TimeSeriesPlot::getPlotRect() const
+{
+    // Слева - подписи значений, снизу - подписи времени
+    const int32_t textHeight = fontMetrics().height();
+
+    return rect().adjusted(fontMetrics().width("-2147483648") + 10, textHeight, -10, -textHeight - 5);
+}
+
+bool TimeSeriesPlot::getDataRange(uint64_t &begin, uint64_t &end) const
+{
+    bool hasData = false;
+
+    for (const Curve &curve : m_curves)
+    {
+        if (curve.series->getCount() == 0)
+        {
+            continue;
+        }
+
+        begin = hasData != false ? std::min(begin, curve.series->getBeginTime()) : curve.series->getBeginTime();
+        end = hasData != false ? std::max(end, curve.series->getEndTime()) : curve.series->getEndTime();
+        hasData = true;
+    }
+
+    return hasData;
+}
+
+void TimeSeriesPlot::setView(const int64_t begin, const int64_t end)
+{
+    const int64_t span = std::max<int64_t>(end - begin, min_span);
+    const int64_t viewBegin = std::max<int64_t>(begin, 0);
+
+    m_begin = viewBegin;
+    m_end = viewBegin + span;
+    m_isFollowing = false;
+
+    update();
+}
+
+void TimeSeriesPlot::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    const QRect plotRect = getPlotRect();
+    painter.setPen(Qt::gray);
+    painter.drawRect(plotRect);
+
+    uint64_t dataBegin = 0;
+    uint64_t dataEnd = 0;
+
+    if (plotRect.width() <= 0 || getDataRange(dataBegin, dataEnd) == false)
+    {
+        painter.drawText(plotRect, Qt::AlignCenter, tr("No data"));
+        return;
+    }
+
+    if (m_isFollowing != false)
+    {
+        m_begin = dataBegin;
+        m_end = std::max(dataEnd, dataBegin + min_span);
+    }
+
+    // Прореживание всех рядов и общий диапазон значений
+    QVector<QVector<TimeSeries::Column>> columns(m_curves.size());
+
+    bool hasValues = false;
+    int64_t minValue = 0;
+    int64_t maxValue = 0;
+
+    for (int32_t index = 0; index < m_curves.size(); index++)
+    {
+        columns[index].resize(plotRect.width());
+        m_curves[index].series->getColumns(m_begin, m_end, columns[index]);
+
+        for (const TimeSeries::Column &column : qAsConst(columns[index]))
+        {
+            if (column.hasData == false)
+            {
+                continue;
+            }
+
+            minValue = hasValues != false ? std::min(minValue, column.min) : column.min;
+            maxValue = hasValues != false ? std::max(maxValue, column.max) : column.max;
+            hasValues = true;
+        }
+    }
+
+    if (hasValues == false)
+    {
+        minValue = 0;
+        maxValue = 1;
+    }
+    else if (minValue == maxValue)
+    {
+        minValue--;
+        maxValue++;
+    }
+
+    auto getY = [&](const int64_t value)
+    {
+        return plotRect.bottom() - (double)(value - minValue) * (plotRect.height() - 1) / (maxValue - minValue);
+    };
+
+    // Сетка и подписи значений
+    static constexpr int32_t grid_lines = 4;
+
+    for (int32_t line = 0; line <= grid_lines; line++)
+    {
+        const int64_t value = minValue + (maxValue - minValue) * line / grid_lines;
+        const double y = getY(value);
+
+        painter.setPen(QColor("gainsboro"));
+        painter.drawLine(QPointF(plotRect.left(), y), QPointF(plotRect.right(), y));
+
+        painter.setPen(Qt::black);
+        painter.drawText(QRectF(0, y - fontMetrics().height() / 2.0, plotRect.left() - 5, fontMetrics().height()),
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(value));
+    }
+
+    // Подписи времени в секундах, как в логе
+    const int32_t textTop = plotRect.bottom() + 5;
+
+    painter.drawText(QRect(plotRect.left(), textTop, plotRect.width(), fontMetrics().height()), Qt::AlignLeft,
+                     tr("%1 s").arg(m_begin / 1000000.0, 0, 'f', 4));
+    painter.drawText(QRect(plotRect.left(), textTop, plotRect.width(), fontMetrics().height()), Qt::AlignRight,
+                     tr("%1 s").arg(m_end / 1000000.0, 0, 'f', 4));
+
+    // Столбец - отрезок от минимума до максимума, соседние столбцы соединяются последним и первым значениями
+    painter.setClipRect(plotRect);
+
+    QVector<QLineF> lines;
+
+    for (int32_t index = 0; index < m_curves.size(); index++)
+    {
+        lines.clear();
+
+        const TimeSeries::Column *previous = nullptr;
+        int32_t previousX = 0;
+
+        for (int32_t column = 0; column < columns[index].size(); column++)
+        {
+            const TimeSeries::Column &current = columns[index][column];
+
+            if (current.hasData == false)
+            {
+                continue;
+            }
+
+            const int32_t x = plotRect.left() + column;
+
+            if (previous != nullptr)
+            {
+                lines.append(QLineF(previousX, getY(previous->last), x, getY(current.first)));
+            }
+
+            lines.append(QLineF(x, getY(current.min), x, getY(current.max)));
+
+            previous = &current;
+            previousX = x;
+        }
+
+        painter.setPen(m_curves[index].color);
+        painter.drawLines(lines);
+    }
+
+    painter.setClipping(false);
+
+    // Легенда
+    int32_t legendX = plotRect.left();
+
+    for (const Curve &curve : qAsConst(m_curves))
+    {
+        painter.setPen(curve.color);
+        painter.drawText(QPoint(legendX, fontMetrics().ascent()), curve.name);
+        legendX += fontMetrics().width(curve.name) + 20;
+    }
+}
+
+void TimeSeriesPlot::wheelEvent(QWheelEvent *event)
+{
+    const QRect plotRect = getPlotRect();
+
+    if (plotRect.width() <= 0 || m_end <= m_begin)
+    {
+        return;
+    }
+
+    // Масштаб относительно времени под курсором
+    const double factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+    const double position = std::min(std::max((double)(event->pos().x() - plotRect.left()) / plotRect.width(), 0.0), 1.0);
+
+    const double span = m_end - m_begin;
+    const double cursorTime = m_begin + span * position;
+
+    setView(cursorTime - span * factor * position, cursorTime + span * factor * (1 - position));
+
+    event->accept();
+}
+
+void TimeSeriesPlot::mousePressEvent(QMouseEvent *event)
+{
+    m_dragX = event->pos().x();
+    m_dragBegin = m_begin;
+    m_dragEnd = m_end;
+}
+
+void TimeSeriesPlot::mouseMoveEvent(QMouseEvent *event)
+{
+    const QRect plotRect = getPlotRect();
+
+    if ((event->buttons() & Qt::LeftButton) == 0 || plotRect.width() <= 0)
+    {
+        return;
+    }
+
+    const int64_t span = m_dragEnd - m_dragBegin;
+    const int64_t shift = (int64_t)(m_dragX - event->pos().x()) * span / plotRect.width();
+
+    setView((int64_t)m_dragBegin + shift, (int64_t)m_dragEnd + shift);
+}
+
+void TimeSeriesPlot::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+
+    showAll();
+}
+
+TimeSeriesWindow::TimeSeriesWindow(TimeSeriesStore *store, QWidget *parent) :
+    QWidget(parent),
+    m_store(store),
+    m_slaveAddress(new QSpinBox(this)),
+    m_reg(new QSpinBox(this)),
+    m_width(new QComboBox(this)),
+    m_isSigned(new QCheckBox(tr("Signed"), this)),
+    m_info(new QLabel(this)),
+    m_plot(new TimeSeriesPlot(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Register Plot"));
+
+    m_slaveAddress->setRange((uint32_t)IdAddresses::MIN_SLAVE_ADDRESS, (uint32_t)IdAddresses::MAX_PERMITTED_ADDRESS);
+
+    m_reg->setRange(0, RegisterMap::regs_count - 1);
+    m_reg->setDisplayIntegerBase(16);
+    m_reg->setPrefix(tr("0x"));
+
+    // Число регистров значения хранится в данных пункта
+    m_width->addItem(tr("8 bit"), 1);
+    m_width->addItem(tr("16 bit"), 2);
+    m_width->addItem(tr("32 bit"), 4);
+
+    auto addButton = new QPushButton(tr("Add"), this);
+    auto clearButton = new QPushButton(tr("Clear"), this);
+
+    auto controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(new QLabel(tr("Address"), this));
+    controlsLayout->addWidget(m_slaveAddress);
+    controlsLayout->addWidget(new QLabel(tr("Low register"), this));
+    controlsLayout->addWidget(m_reg);
+    controlsLayout->addWidget(m_width);
+    controlsLayout->addWidget(m_isSigned);
+    controlsLayout->addWidget(addButton);
+    controlsLayout->addStretch();
+    controlsLayout->addWidget(clearButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addLayout(controlsLayout);
+    layout->addWidget(m_plot);
+    layout->addWidget(m_info);
+
+    connect(addButton, &QPushButton::clicked, this, &TimeSeriesWindow::addCurve);
+    connect(clearButton, &QPushButton::clicked, this, &TimeSeriesWindow::clearCurves);
+
+    m_info->setText(tr("Wheel - zoom, drag - pan, double click - whole capture"));
+
+    resize(900, 500);
+}
+
+void TimeSeriesWindow::refresh()
+{
+    if (isVisible() != false)
+    {
+        m_plot->update();
+    }
+}
+
+void TimeSeriesWindow::addCurve()
+{
+    const uint32_t slaveAddress = m_slaveAddress->value();
+    const uint32_t reg = m_reg->value();
+    const uint32_t width = m_width->currentData().toUInt();
+    const bool isSigned = m_isSigned->isChecked();
+
+    const TimeSeries *series = m_store->getSeries(RegisterMap::getCell(slaveAddress, reg), RegisterMap::regs_count,
+                                                  width, isSigned);
+
+    if (series == nullptr)
+    {
+        m_info->setText(tr("Value does not fit into registers of one slave"));
+        return;
+    }
+
+    const QString name = tr("%1: 0x").arg(slaveAddress) + tr("%1").arg(reg, 2, 16, QLatin1Char('0')).toUpper() +
+                         tr(" %1%2").arg(isSigned != false ? "s" : "u").arg(width * 8);
+
+    m_plot->addCurve(series, name);
+    m_info->setText(tr("%1: %2 points").arg(name).arg(series->getCount()));
+}
+
+void TimeSeriesWindow::clearCurves()
+{
+    m_plot->clearCurves();
+}
+
+void TimeSeriesWindow::showAll()
+{
+    m_plot->showAll();
+}
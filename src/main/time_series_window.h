@@ -0,0 +1,112 @@
+/****************************************************************************
+
+Классы TimeSeriesPlot и TimeSeriesWindow строят графики значений
+регистров по рядам карты регистров (TimeSeriesStore).
+
+TimeSeriesPlot рисует ряды с прореживанием до столбцов пикселей: для
+каждого столбца берутся первое, последнее, минимальное и максимальное
+значения (TimeSeries::getColumns), столбец рисуется вертикальным отрезком
+от минимума до максимума, соседние столбцы соединяются. Так выбросы не
+теряются при любом масштабе, а время отрисовки зависит от ширины графика,
+а не от числа точек. Колесо мыши меняет масштаб по времени, перетаскивание
+сдвигает окно, двойной щелчок показывает всю запись и включает слежение
+за новыми данными.
+
+В TimeSeriesWindow выбирается адрес, младший регистр, разрядность
+(8, 16 или 32 бита, младший байт в младшем регистре, как в
+setReg16Val/setReg32Val) и знаковость значения.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <QColor>
+#include <QVector>
+#include <stdint.h>
+#include "time_series.h"
+
+QT_BEGIN_NAMESPACE
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QSpinBox;
+
+QT_END_NAMESPACE
+
+class TimeSeriesPlot : public QWidget
+{
+public:
+    explicit TimeSeriesPlot(QWidget *parent = nullptr);
+    ~TimeSeriesPlot() = default;
+
+    void addCurve(const TimeSeries *series, const QString name);
+    void clearCurves();
+
+    // Вся запись со слежением за новыми данными
+    void showAll();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    struct Curve {
+        const TimeSeries *series = nullptr;
+        QString name;
+        QColor color;
+    };
+
+    // Минимальная ширина окна по времени, мкс
+    static constexpr uint64_t min_span = 100;
+
+    QRect getPlotRect() const;
+
+    // Время всех рядов; false, если точек нет
+    bool getDataRange(uint64_t &begin, uint64_t &end) const;
+
+    void setView(const int64_t begin, const int64_t end);
+
+    QVector<Curve> m_curves;
+    QVector<TimeSeries::Column> m_columns;
+
+    bool m_isFollowing = true;
+    uint64_t m_begin = 0;
+    uint64_t m_end = 0;
+
+    // Положение мыши и окно в начале перетаскивания
+    int32_t m_dragX = 0;
+    uint64_t m_dragBegin = 0;
+    uint64_t m_dragEnd = 0;
+};
+
+class TimeSeriesWindow : public QWidget
+{
+public:
+    explicit TimeSeriesWindow(TimeSeriesStore *store, QWidget *parent = nullptr);
+    ~TimeSeriesWindow() = default;
+
+    // Перерисовка графика новыми данными
+    void refresh();
+
+public slots:
+    void addCurve();
+    void clearCurves();
+
+    // Вся запись, например после переподключения
+    void showAll();
+
+private:
+    TimeSeriesStore *m_store = nullptr;
+
+    QSpinBox *m_slaveAddress = nullptr;
+    QSpinBox *m_reg = nullptr;
+    QComboBox *m_width = nullptr;
+    QCheckBox *m_isSigned = nullptr;
+    QLabel *m_info = nullptr;
+    TimeSeriesPlot *m_plot = nullptr;
+};
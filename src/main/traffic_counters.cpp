@@ -0,0 +1,34 @@
+#include "traffic_counters.h"
+
+void TrafficCounters::reset(Counter &counter)
+{
+    counter.frames.store(0, std::memory_order_relaxed);
+    counter.bytes.store(0, std::memory_order_relaxed);
+}
+
+void TrafficCounters::clear()
+{
+    reset(m_total);
+
+    for (Counter &counter : m_ids)
+    {
+        reset(counter);
+    }
+
+    for (Counter &counter : m_addresses)
+    {
+        reset(counter);
+    }
+
+    for (Counter &counter : m_msgTypes)
+    {
+        reset(counter);
+    }
+
+    for (Counter &counter : m_fCodes)
+    {
+        reset(counter);
+    }
+
+    m_errorFrames.store(0, std::memory_order_relaxed);
+}
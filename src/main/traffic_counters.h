@@ -0,0 +1,115 @@
+/****************************************************************************
+
+Класс TrafficCounters считает кадры и байты данных по ID, адресам ведомых
+узлов, типам сообщений и F-кодам. Счётчики пишет только поток приёма
+кадров, поэтому инкремент - это обычные load и store без атомарного
+чтения-модификации-записи и без блокировок: на кадр приходится несколько
+сложений. Атомарность отдельных load/store нужна, чтобы читать счётчики
+из любого потока без гонок (значения могут отставать на кадр).
+
+Скорости (кадры/с, байты/с) по счётчикам считает читатель - по разности
+снимков, см. TrafficWindow.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QCanBusFrame>
+#include <atomic>
+#include <stdint.h>
+#include "../cannabus_library/cannabus_common.h"
+
+class TrafficCounters
+{
+public:
+    TrafficCounters() = default;
+    ~TrafficCounters() = default;
+
+    TrafficCounters(const TrafficCounters &) = delete;
+    TrafficCounters &operator=(const TrafficCounters &) = delete;
+
+    // Размеры групп: все 11-битные ID, все 6-битные адреса, типы сообщений и F-коды
+    static constexpr uint32_t ids_count = 2048;
+    static constexpr uint32_t addresses_count = 64;
+    static constexpr uint32_t msg_types_count = 4;
+    static constexpr uint32_t f_codes_count = 8;
+
+    struct Counter {
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    // Учёт кадра данных, вызывается только из потока приёма
+    void processDataFrame(const QCanBusFrame &frame)
+    {
+        countFrame(frame.frameId(), frame.payload().size());
+    }
+
+    void countFrame(const uint32_t frameId, const uint32_t dataSize)
+    {
+        const uint32_t id = frameId & (ids_count - 1);
+
+        increment(m_total, dataSize);
+        increment(m_ids[id], dataSize);
+        increment(m_addresses[cannabus::getAddressFromId(id)], dataSize);
+        increment(m_msgTypes[(uint32_t)cannabus::getMsgTypeFromId(id)], dataSize);
+        increment(m_fCodes[(uint32_t)cannabus::getFCodeFromId(id)], dataSize);
+    }
+
+    // Учёт кадра ошибки
+    void countErrorFrame()
+    {
+        m_errorFrames.store(m_errorFrames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Обнуление, вызывается только из потока приёма
+    void clear();
+
+    const Counter &getTotal() const
+    {
+        return m_total;
+    }
+
+    const Counter &getId(const uint32_t id) const
+    {
+        return m_ids[id];
+    }
+
+    const Counter &getAddress(const uint32_t slaveAddress) const
+    {
+        return m_addresses[slaveAddress];
+    }
+
+    const Counter &getMsgType(const cannabus::IdMsgTypes msgType) const
+    {
+        return m_msgTypes[(uint32_t)msgType];
+    }
+
+    const Counter &getFCode(const cannabus::IdFCode fCode) const
+    {
+        return m_fCodes[(uint32_t)fCode];
+    }
+
+    uint64_t getErrorFrames() const
+    {
+        return m_errorFrames.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Писатель один, поэтому read-modify-write не нужен
+    static void increment(Counter &counter, const uint32_t dataSize)
+    {
+        counter.frames.store(counter.frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counter.bytes.store(counter.bytes.load(std::memory_order_relaxed) + dataSize, std::memory_order_relaxed);
+    }
+
+    static void reset(Counter &counter);
+
+    Counter m_total;
+    Counter m_ids[ids_count];
+    Counter m_addresses[addresses_count];
+    Counter m_msgTypes[msg_types_count];
+    Counter m_fCodes[f_codes_count];
+
+    std::atomic<uint64_t> m_errorFrames{0};
+};
@@ -0,0 +1,313 @@
+#include "traffic_window.h"
+
+#include <QHeaderView>
+#include <QLabel>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+using namespace cannabus;
+
+TrafficWindow::TrafficWindow(QWidget *parent) :
+    QWidget(parent),
+    m_total(new QLabel(this)),
+    m_updateTimer(new QTimer(this)),
+    m_tabs(new QTabWidget(this))
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle(tr("Traffic Statistics"));
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(m_total);
+    layout->addWidget(m_tabs);
+
+    addGroup(tr("Message Types"), msg_types_offset, TrafficCounters::msg_types_count, false, [](uint32_t index)
+    {
+        static const QStringList msgTypeInfo = {"Master's high-prio", "Slave's high-prio",
+                                                "Master's request", "Slave's response"};
+
+        return tr("0b%1 ").arg(index, 2, 2, QLatin1Char('0')) + msgTypeInfo.at(index);
+    });
+
+    addGroup(tr("F-Codes"), f_codes_offset, TrafficCounters::f_codes_count, false, [](uint32_t index)
+    {
+        static const QStringList fCodeInfo = {"Writing regs range", "Writing regs series",
+                                              "Reading regs range", "Reading regs series",
+                                              "Device-specific (1)", "Device-specific (2)",
+                                              "Device-specific (3)", "Device-specific (4)"};
+
+        return tr("0b%1 ").arg(index, 3, 2, QLatin1Char('0')) + fCodeInfo.at(index);
+    });
+
+    addGroup(tr("Addresses"), addresses_offset, TrafficCounters::addresses_count, true, [](uint32_t index)
+    {
+        return tr("%1 (0x").arg(index, 2, 10, QLatin1Char(' ')) +
+               tr("%1)").arg(index, 2, 16, QLatin1Char('0')).toUpper();
+    });
+
+    addGroup(tr("IDs"), ids_offset, TrafficCounters::ids_count, true, [](uint32_t index)
+    {
+        return tr("0x") + tr("%1").arg(index, 3, 16, QLatin1Char('0')).toUpper();
+    });
+
+    m_snapshots.resize(snapshots_count);
+
+    for (Snapshot &snapshot : m_snapshots)
+    {
+        snapshot.frames.fill(0, counters_count);
+        snapshot.bytes.fill(0, counters_count);
+    }
+
+    m_clock.start();
+
+    connect(m_updateTimer, &QTimer::timeout, this, &TrafficWindow::updateDashboard);
+
+    resize(700, 500);
+}
+
+void TrafficWindow::addGroup(const QString title, const uint32_t offset, const uint32_t count, const bool isSparse,
+                             std::function<QString(uint32_t)> getName)
+{
+    Group group;
+    group.table = new QTableWidget(this);
+    group.offset = offset;
+    group.count = count;
+    group.isSparse = isSparse;
+    group.getName = getName;
+    group.rows.fill(-1, count);
+    group.isActive.fill(false, count);
+
+    QStringList header = {"Name", "Frames", "Bytes", "Frames/s", "Bytes/s", "Share, %"};
+
+    group.table->setColumnCount(header.count());
+    group.table->setHorizontalHeaderLabels(header);
+    group.table->verticalHeader()->hide();
+    group.table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    group.table->horizontalHeader()->setSectionsClickable(false);
+    group.table->horizontalHeader()->setStretchLastSection(true);
+
+    // Строки постоянных групп создаём сразу, чтобы порядок не зависел от трафика
+    if (isSparse == false)
+    {
+        for (uint32_t index = 0; index < count; index++)
+        {
+            getRow(group, index);
+        }
+    }
+
+    m_tabs->addTab(group.table, title);
+    m_groups.append(group);
+}
+
+void TrafficWindow::processDataFrame(const QCanBusFrame &frame)
+{
+    m_counters.processDataFrame(frame);
+}
+
+void TrafficWindow::processErrorFrame()
+{
+    m_counters.countErrorFrame();
+}
+
+void TrafficWindow::clearStats()
+{
+    m_counters.clear();
+
+    for (Group &group : m_groups)
+    {
+        if (group.isSparse != false)
+        {
+            group.table->setRowCount(0);
+            group.rows.fill(-1);
+        }
+
+        // Постоянные строки надо перерисовать с нулями
+        group.isActive.fill(true);
+    }
+
+    resetSnapshots();
+    updateDashboard();
+}
+
+void TrafficWindow::showEvent(QShowEvent *event)
+{
+    // Снимки, сделанные до скрытия окна, для скоростей уже не годятся
+    resetSnapshots();
+    updateDashboard();
+
+    m_updateTimer->start(dashboard_update_timeout);
+
+    QWidget::showEvent(event);
+}
+
+void TrafficWindow::hideEvent(QHideEvent *event)
+{
+    m_updateTimer->stop();
+
+    QWidget::hideEvent(event);
+}
+
+void TrafficWindow::resetSnapshots()
+{
+    m_snapshotsTaken = 0;
+}
+
+void TrafficWindow::takeSnapshot(Snapshot &snapshot) const
+{
+    auto copyCounter = [&snapshot](const uint32_t index, const TrafficCounters::Counter &counter)
+    {
+        snapshot.frames[index] = counter.frames.load(std::memory_order_relaxed);
+        snapshot.bytes[index] = counter.bytes.load(std::memory_order_relaxed);
+    };
+
+    snapshot.time = m_clock.elapsed();
+
+    copyCounter(total_offset, m_counters.getTotal());
+
+    for (uint32_t id = 0; id < TrafficCounters::ids_count; id++)
+    {
+        copyCounter(ids_offset + id, m_counters.getId(id));
+    }
+
+    for (uint32_t slaveAddress = 0; slaveAddress < TrafficCounters::addresses_count; slaveAddress++)
+    {
+        copyCounter(addresses_offset + slaveAddress, m_counters.getAddress(slaveAddress));
+    }
+
+    for (uint32_t msgType = 0; msgType < TrafficCounters::msg_types_count; msgType++)
+    {
+        copyCounter(msg_types_offset + msgType, m_counters.getMsgType((IdMsgTypes)msgType));
+    }
+
+    for (uint32_t fCode = 0; fCode < TrafficCounters::f_codes_count; fCode++)
+    {
+        copyCounter(f_codes_offset + fCode, m_counters.getFCode((IdFCode)fCode));
+    }
+}
+
+void TrafficWindow::updateDashboard()
+{
+    // Кольцо снимков: новый записывается на место самого старого
+    Snapshot &current = m_snapshots[m_snapshotsTaken % snapshots_count];
+    takeSnapshot(current);
+    m_snapshotsTaken++;
+
+    const Snapshot &oldest = m_snapshots[m_snapshotsTaken >= snapshots_count ? m_snapshotsTaken % snapshots_count : 0];
+    const uint32_t interval = current.time - oldest.time;
+
+    const uint64_t frames = current.frames[total_offset];
+    const uint64_t bytes = current.bytes[total_offset];
+    const double seconds = interval / 1000.0;
+
+    const double framesRate = interval == 0 ? 0 : (frames - oldest.frames[total_offset]) / seconds;
+    const double bytesRate = interval == 0 ? 0 : (bytes - oldest.bytes[total_offset]) / seconds;
+
+    m_total->setText(tr("Frames: %1 (%2/s)   Bytes: %3 (%4/s)   Error frames: %5")
+                     .arg(frames)
+                     .arg(framesRate, 0, 'f', 1)
+                     .arg(bytes)
+                     .arg(bytesRate, 0, 'f', 1)
+                     .arg(m_counters.getErrorFrames()));
+
+    for (Group &group : m_groups)
+    {
+        updateGroup(group, current, oldest, interval);
+    }
+}
+
+void TrafficWindow::updateGroup(Group &group, const Snapshot &current, const Snapshot &oldest, const uint32_t interval)
+{
+    const double seconds = interval / 1000.0;
+    const uint64_t framesInWindow = current.frames[total_offset] - oldest.frames[total_offset];
+
+    for (uint32_t index = 0; index < group.count; index++)
+    {
+        const uint32_t counter = group.offset + index;
+        const uint64_t frames = current.frames[counter];
+
+        if (group.isSparse != false && frames == 0)
+        {
+            continue;
+        }
+
+        const int32_t row = getRow(group, index);
+        const uint64_t framesDelta = frames - oldest.frames[counter];
+
+        // Строки, в которых уже выведена нулевая скорость, не трогаем
+        if (framesDelta == 0 && group.isActive[index] == false)
+        {
+            continue;
+        }
+
+        group.isActive[index] = framesDelta != 0;
+
+        const uint64_t bytesDelta = current.bytes[counter] - oldest.bytes[counter];
+        const double framesRate = interval == 0 ? 0 : framesDelta / seconds;
+        const double bytesRate = interval == 0 ? 0 : bytesDelta / seconds;
+        const double share = framesInWindow == 0 ? 0 : 100.0 * framesDelta / framesInWindow;
+
+        setCell(group.table, row, TrafficWindowColumn::frames           , tr("%1").arg(frames));
+        setCell(group.table, row, TrafficWindowColumn::bytes            , tr("%1").arg(current.bytes[counter]));
+        setCell(group.table, row, TrafficWindowColumn::frames_per_second, tr("%1").arg(framesRate, 0, 'f', 1));
+        setCell(group.table, row, TrafficWindowColumn::bytes_per_second , tr("%1").arg(bytesRate, 0, 'f', 1));
+        setCell(group.table, row, TrafficWindowColumn::share            , tr("%1").arg(share, 0, 'f', 1));
+    }
+}
+
+int32_t TrafficWindow::getRow(Group &group, const uint32_t index)
+{
+    if (group.rows[index] != -1)
+    {
+        return group.rows[index];
+    }
+
+    // Строки упорядочены по номеру счётчика
+    int32_t row = 0;
+
+    for (uint32_t other = 0; other < index; other++)
+    {
+        if (group.rows[other] != -1)
+        {
+            row++;
+        }
+    }
+
+    for (uint32_t other = index + 1; other < group.count; other++)
+    {
+        if (group.rows[other] != -1)
+        {
+            group.rows[other]++;
+        }
+    }
+
+    group.table->insertRow(row);
+    group.rows[index] = row;
+    group.isActive[index] = true;
+
+    auto item = new QTableWidgetItem(group.getName(index));
+    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    group.table->setItem(row, (uint32_t)TrafficWindowColumn::name, item);
+
+    for (uint32_t column = (uint32_t)TrafficWindowColumn::frames; column <= (uint32_t)TrafficWindowColumn::share; column++)
+    {
+        setCell(group.table, row, (TrafficWindowColumn)column, "");
+    }
+
+    return row;
+}
+
+void TrafficWindow::setCell(QTableWidget *table, const int32_t row, const TrafficWindowColumn column, const QString text)
+{
+    QTableWidgetItem *item = table->item(row, (uint32_t)column);
+
+    if (item == nullptr)
+    {
+        item = new QTableWidgetItem;
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+        table->setItem(row, (uint32_t)column, item);
+    }
+
+    item->setText(text);
+}
@@ -0,0 +1,118 @@
+/****************************************************************************
+
+Класс TrafficWindow - панель статистики трафика: количество кадров и байт
+и скорости (кадры/с, байты/с) по типам сообщений, F-кодам, адресам ведомых
+узлов и отдельным ID.
+
+Счётчики (TrafficCounters) обновляются на каждом принятом кадре, а панель
+раз в dashboard_update_timeout делает их снимок. Скорости считаются по
+разности текущего снимка и снимка rate_window назад, поэтому стоимость
+обновления не зависит от скорости потока кадров. Пока окно скрыто, снимки
+не делаются.
+
+****************************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <QCanBusFrame>
+#include <QElapsedTimer>
+#include <QVector>
+#include <functional>
+#include <stdint.h>
+#include "traffic_counters.h"
+
+QT_BEGIN_NAMESPACE
+
+class QLabel;
+class QTabWidget;
+class QTableWidget;
+class QTimer;
+
+QT_END_NAMESPACE
+
+enum class TrafficWindowColumn {
+    name,
+    frames,
+    bytes,
+    frames_per_second,
+    bytes_per_second,
+    share
+};
+
+class TrafficWindow : public QWidget
+{
+public:
+    explicit TrafficWindow(QWidget *parent = nullptr);
+    ~TrafficWindow() = default;
+
+    // Период обновления панели и окно усреднения скоростей, мс
+    static constexpr uint32_t dashboard_update_timeout = 500;
+    static constexpr uint32_t rate_window = 5000;
+    static constexpr uint32_t snapshots_count = rate_window / dashboard_update_timeout + 1;
+
+    // Учёт кадров данных и кадров ошибок
+    void processDataFrame(const QCanBusFrame &frame);
+    void processErrorFrame();
+
+public slots:
+    // Обнуление счётчиков
+    void clearStats();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void updateDashboard();
+
+private:
+    // Снимок всех счётчиков: общий, ID, адреса, типы сообщений, F-коды - подряд
+    static constexpr uint32_t total_offset = 0;
+    static constexpr uint32_t ids_offset = total_offset + 1;
+    static constexpr uint32_t addresses_offset = ids_offset + TrafficCounters::ids_count;
+    static constexpr uint32_t msg_types_offset = addresses_offset + TrafficCounters::addresses_count;
+    static constexpr uint32_t f_codes_offset = msg_types_offset + TrafficCounters::msg_types_count;
+    static constexpr uint32_t counters_count = f_codes_offset + TrafficCounters::f_codes_count;
+
+    struct Snapshot {
+        uint32_t time = 0;
+        QVector<uint64_t> frames;
+        QVector<uint64_t> bytes;
+    };
+
+    // Таблица одной группы счётчиков; строки редких групп (адреса, ID) появляются с первым кадром
+    struct Group {
+        QTableWidget *table = nullptr;
+        uint32_t offset = 0;
+        uint32_t count = 0;
+        bool isSparse = false;
+        std::function<QString(uint32_t)> getName;
+        QVector<int32_t> rows;
+
+        // Были ли кадры в окне на прошлом обновлении: строки без кадров ни тогда, ни сейчас не перерисовываются
+        QVector<bool> isActive;
+    };
+
+    void takeSnapshot(Snapshot &snapshot) const;
+    void resetSnapshots();
+
+    void addGroup(const QString title, const uint32_t offset, const uint32_t count, const bool isSparse,
+                  std::function<QString(uint32_t)> getName);
+    void updateGroup(Group &group, const Snapshot &current, const Snapshot &oldest, const uint32_t interval);
+
+    int32_t getRow(Group &group, const uint32_t index);
+    void setCell(QTableWidget *table, const int32_t row, const TrafficWindowColumn column, const QString text);
+
+    TrafficCounters m_counters;
+
+    QLabel *m_total = nullptr;
+    QTimer *m_updateTimer = nullptr;
+    QTabWidget *m_tabs = nullptr;
+
+    QVector<Group> m_groups;
+
+    QElapsedTimer m_clock;
+    QVector<Snapshot> m_snapshots;
+    uint32_t m_snapshotsTaken = 0;
+};
@@ -0,0 +1,167 @@
+#include "capture_writer.h"
+#include "cannabus_common.h"
+#include <string.h>
+
+namespace simulator
+{
+    namespace
+    {
+        // подписи как в LogWindow::setMsgInfo, выравнивание по самой длинной
+        const char * const msg_type_info[] = { "Master's high-prio",
+                                               "Slave's high-prio",
+                                               "Master's request",
+                                               "Slave's response" };
+
+        const char * const fcode_info[] = { "Writing regs range",
+                                            "Writing regs series",
+                                            "Reading regs range",
+                                            "Reading regs series",
+                                            "Device-specific (1)",
+                                            "Device-specific (2)",
+                                            "Device-specific (3)",
+                                            "Device-specific (4)" };
+
+        const int msg_type_info_width = 18;
+        const int fcode_info_width = 19;
+
+        const uint8_t classic_length_max = 8;
+
+        // буфер побольше - запись часа работы шины не должна упираться в вызовы записи
+        const size_t file_buffer_size = 1 << 20;
+
+        void writeBinary( FILE * file, uint32_t value, uint32_t digits )
+        {
+            fputs( "\"0b", file );
+
+            for( uint32_t i = digits; i > 0; i-- )
+            {
+                fputc( ( ( value >> ( i - 1 ) ) & 1 ) ? '1' : '0', file );
+            }
+
+            fputs( "\";", file );
+        }
+    }
+
+    bool CaptureWriter::open( const char * fileName )
+    {
+        close();
+
+        m_file = fopen( fileName, "w" );
+
+        if( m_file == nullptr )
+        {
+            return false;
+        }
+
+        setvbuf( m_file, nullptr, _IOFBF, file_buffer_size );
+
+        fputs( "\"No.\";\"Time\";\"Msg Type\";\"Address\";\"F-Code\";\"DLC\";\"Data\";\"Info\"\n", m_file );
+
+        m_framesCount = 0;
+
+        return true;
+    }
+
+    void CaptureWriter::close( void )
+    {
+        if( m_file == nullptr )
+        {
+            return;
+        }
+
+        fclose( m_file );
+        m_file = nullptr;
+    }
+
+    /**************************************************************************************************
+    Описание:  Запись кадра данных
+    Аргументы: msg  - кадр
+               time - время конца кадра
+    Возврат:   -
+    Замечания: кадры длиннее 8 байт помечаются как CAN FD, как это делает лог
+    **************************************************************************************************/
+    void CaptureWriter::writeFrame( const can::CanMessage & msg, Time time )
+    {
+        if( m_file == nullptr )
+        {
+            return;
+        }
+
+        using namespace cannabus;
+
+        writeCountAndTime( time );
+
+        uint32_t msgType = (uint32_t)getMsgTypeFromId( msg.id );
+        uint32_t fCode = (uint32_t)getFCodeFromId( msg.id );
+        uint32_t slaveAddress = getAddressFromId( msg.id );
+
+        writeBinary( m_file, msgType, 2 );
+
+        fprintf( m_file, "\"%2u (0x%02X)\";", slaveAddress, slaveAddress );
+
+        writeBinary( m_file, fCode, 3 );
+
+        fprintf( m_file, "\"[%u]\";", msg.length );
+
+        if( msg.length != 0 )
+        {
+            fputc( '"', m_file );
+
+            for( uint8_t i = 0; i < msg.length; i++ )
+            {
+                fprintf( m_file, i == 0 ? "%02X" : " %02X", msg.data[i] );
+            }
+
+            fputc( '"', m_file );
+        }
+
+        fputs( ";\"", m_file );
+
+        if( msg.length == 0 )
+        {
+            fputs( "[Slave's response] Incorrect request", m_file );
+        }
+        else
+        {
+            // "[Тип] " с добивкой до самой длинной подписи, затем F-код с добивкой
+            const char * typeInfo = msg_type_info[ msgType ];
+            int padding = msg_type_info_width - (int)strlen( typeInfo );
+
+            fprintf( m_file, "[%s]%*s %-*s", typeInfo, padding, "", fcode_info_width, fcode_info[ fCode ] );
+        }
+
+        if( msg.length > classic_length_max )
+        {
+            fputs( isFrameLengthValid( Profile::FD, msg.length ) ? " (CAN FD)" : " (CAN FD, invalid length)", m_file );
+        }
+
+        fputs( "\"\n", m_file );
+    }
+
+    void CaptureWriter::writeErrorFrame( Time time )
+    {
+        if( m_file == nullptr )
+        {
+            return;
+        }
+
+        writeCountAndTime( time );
+
+        // пустые тип, адрес, F-код, DLC и данные, как у кадра ошибки в логе
+        fputs( ";;;;;\"Error frame\"\n", m_file );
+    }
+
+    void CaptureWriter::writeCountAndTime( Time time )
+    {
+        m_framesCount++;
+
+        uint64_t seconds = time / ns_in_second;
+        uint64_t microseconds = ( time % ns_in_second ) / 1000;
+
+        fprintf( m_file, "\"%6llu\";\"%4llu.%04llu\";",
+                 (unsigned long long)m_framesCount,
+                 (unsigned long long)seconds,
+                 (unsigned long long)( microseconds / 100 ) );
+    }
+
+} // namespace simulator
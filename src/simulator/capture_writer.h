@@ -0,0 +1,50 @@
+#pragma once
+
+#include "virtual_bus.h"
+#include "can/i_can.h"
+#include <stdint.h>
+#include <stdio.h>
+
+namespace simulator
+{
+    // Запись прогона в том же CSV, который сохраняет лог NarcoCANtrol (MainWindow::saveLog):
+    // те же столбцы "No.;Time;Msg Type;Address;F-Code;DLC;Data;Info" и то же форматирование ячеек,
+    // что и в LogWindow, поэтому запись симулятора открывается в NarcoCANtrol (Load Message Log, LogReader)
+    // и разбирается теми же анализаторами, что и запись с реальной шины
+    class CaptureWriter
+    {
+
+    public:
+
+        CaptureWriter() = default;
+
+        // копировать запрещено
+        CaptureWriter( const CaptureWriter & rhs ) = delete;
+        CaptureWriter & operator=( CaptureWriter & s ) = delete;
+
+        ~CaptureWriter()
+        {
+            close();
+        }
+
+        bool open( const char * fileName );
+        void close( void );
+
+        bool isOpen( void ) const
+        {
+            return m_file != nullptr;
+        }
+
+        void writeFrame( const can::CanMessage & msg, Time time );
+        void writeErrorFrame( Time time );
+
+    private:
+
+        void writeCountAndTime( Time time );
+
+        FILE * m_file = nullptr;
+
+        uint64_t m_framesCount = 0;
+    };
+
+} // namespace simulator
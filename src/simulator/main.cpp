@@ -0,0 +1,734 @@
+/****************************************************************************
+
+Симулятор сети CANNABUS PLUS с виртуальным временем.
+
+Мастер (MasterSession и модели слейвов Slave) и до 60 слейвов (SlaveSession со
+своими таблицами) работают через виртуальные CAN-порты одной шины. Шина считает
+длительность каждого кадра по его битам, разыгрывает арбитраж по ID и вносит
+ошибки, а время перескакивает от события к событию, поэтому час работы сети
+прогоняется за секунды. Прогон пишется в CSV, как лог NarcoCANtrol, и
+открывается в нём командой Load Message Log.
+
+С --bulk мастер раз в секунду читает всю таблицу выбранного слейва блочной
+передачей, и в отчете её скорость сравнивается с пределом шины: временем тех же
+кадров, идущих подряд без пауз. С --block мастер раз в пять секунд передает
+выбранному слейву образ потоковой передачей (BlockSender), и её скорость
+сравнивается с сырой пропускной способностью шины.
+
+Использование:
+    cannabus_simulator [--duration с] [--bitrate бит/с] [--slaves N]
+                       [--ro-interval мс] [--ber вероятность] [--seed N]
+                       [--offline адрес] [--weighted адрес] [--bulk адрес]
+                       [--block адрес] [--capture файл.csv]
+
+****************************************************************************/
+
+#include "virtual_bus.h"
+#include "capture_writer.h"
+#include "cannabus_master_session.h"
+#include "cannabus_slave_session.h"
+#include "cannabus_slave.h"
+#include "cannabus_slave_scheduler.h"
+#include "cannabus_reg_table.h"
+#include "cannabus_block_transfer.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace simulator;
+
+namespace
+{
+    // карта регистров у всех слейвов сценария одна: 16 ro-регистров датчиков и 16 rw-уставок
+    static constexpr uint8_t ro_reg_min = 0;
+    static constexpr uint8_t ro_reg_max = 15;
+    static constexpr uint8_t rw_reg_min = 16;
+    static constexpr uint8_t rw_reg_max = 31;
+
+    using SimRegTable = cannabus::CannabusRegTable< ro_reg_min, ro_reg_max, rw_reg_min, rw_reg_max >;
+
+    struct Options
+    {
+        uint32_t duration = 3600;
+        uint32_t bitRate = 500000;
+        uint32_t slavesNum = 60;
+        uint32_t roInterval = 1000;
+        double bitErrorRate = 0;
+        uint32_t seed = 1;
+        uint32_t offlineAddress = 0;
+        uint32_t weightedAddress = 0;
+        uint32_t bulkAddress = 0;
+        uint32_t blockAddress = 0;
+        const char * captureFile = nullptr;
+    };
+
+    // тайминги узлов: как часто крутится их основной цикл и как быстро они реагируют на прерывание
+    static constexpr Time master_tick = 1 * ns_in_ms;
+    static constexpr Time master_reaction = 20000;
+    static constexpr Time slave_tick = 5 * ns_in_ms;
+    static constexpr Time slave_reaction = 50000;
+
+    static constexpr uint32_t answer_timeout = 20;
+    static constexpr uint32_t lost_link_timeout = 2000;
+    static constexpr uint32_t coalesce_window = 10;
+
+    // вес слейва, выделенного --weighted: за круг планировщика он получает во столько раз больше шины
+    static constexpr uint32_t weighted_slave_weight = 4;
+    static constexpr size_t slaves_max = (size_t)cannabus::IdAddresses::MAX_SLAVE_ADDRESS;
+
+    static constexpr Time sensors_period = 10 * ns_in_ms;
+    static constexpr Time alarm_period = 500 * ns_in_ms;
+    static constexpr Time operator_period = 200 * ns_in_ms;
+    static constexpr Time bulk_period = 1 * ns_in_second;
+
+    static constexpr uint16_t bulk_regs_num = rw_reg_max - ro_reg_min + 1;
+
+    // потоковая передача образа: окно на все 32 кадра, данные через первую device-specific функцию
+    static constexpr Time block_period = 5 * ns_in_second;
+    static constexpr uint32_t block_image_size = 16 * 1024;
+    static constexpr uint8_t block_window_frames = cannabus::block_frames_max;
+    static constexpr cannabus::IdFCode block_fcode = cannabus::IdFCode::DEVICE_SPECIFIC1;
+
+    // Предел шины для блочного чтения regsNum регистров: биты запросов и ответов всех сегментов
+    // в наихудшем стаффинге. Сегменты режутся так же, как в MasterSession, одиночный регистр идет серией
+    uint32_t getBulkReadBits( uint16_t regsNum )
+    {
+        uint32_t bits = 0;
+
+        for( uint16_t offset = 0; offset < regsNum; )
+        {
+            uint8_t segmentRegs = cannabus::getRangeRegsFit( cannabus::Profile::CLASSIC,
+                                                             (uint8_t)std::min<uint16_t>( regsNum - offset, UINT8_MAX ) );
+
+            if( segmentRegs == 1 )
+            {
+                bits += cannabus::getFrameBitsWorstCase( 1 ) + cannabus::getFrameBitsWorstCase( 2 );
+            }
+            else
+            {
+                bits += cannabus::getFrameBitsWorstCase( 2 ) + cannabus::getFrameBitsWorstCase( 2 + segmentRegs );
+            }
+
+            offset += segmentRegs;
+        }
+
+        return bits;
+    }
+
+
+    // модель слейва на стороне мастера
+    class SimSlave : public cannabus::RegTableSlave< SimRegTable >
+    {
+
+    public:
+
+        virtual void synchronize() override
+        {
+        }
+
+        uint32_t answersCount = 0;
+    };
+
+
+    // само устройство-слейв
+    struct Device
+    {
+        explicit Device( VirtualBus & bus ) :
+            can( bus )
+        {
+        }
+
+        VirtualCan can;
+        cannabus::SlaveSession session;
+        SimRegTable table;
+
+        uint8_t sensorValue = 0;
+        uint32_t linkLostCount = 0;
+
+        cannabus::BlockReceiver blockReceiver;
+        uint32_t blockBytes = 0;
+    };
+
+
+    // Мастер: сессия и обход моделей слейвов планировщиком SlaveScheduler.
+    // Синхронизатор живет во внешней библиотеке таблиц, поэтому в сценарии его роль играет этот класс
+    class Master
+    {
+
+    public:
+
+        Master( VirtualBus & bus, uint32_t slavesNum, uint32_t roInterval, uint32_t weightedAddress ) :
+            m_bus( bus ),
+            m_can( bus, 3, 64 ),
+            m_session( answer_timeout ),
+            m_slaves( slavesNum ),
+            m_setpointTimes( slavesNum ),
+            m_isSetpointPending( slavesNum, false )
+        {
+            for( uint32_t i = 0; i < slavesNum; i++ )
+            {
+                uint8_t slaveAdr = i + (uint32_t)cannabus::IdAddresses::MIN_SLAVE_ADDRESS;
+
+                m_slaves[i].reset( new SimSlave );
+                m_slaves[i]->init( slaveAdr, roInterval );
+
+                // ro-регистры опрашиваются окнами с одинаковым интервалом: все окна слейва созревают разом,
+                // и только вес в планировщике решает, сколько из них уйдет за один его слот
+                m_slaves[i]->addRoRefreshClass( ro_reg_min, ro_reg_max, roInterval, roInterval );
+
+                m_scheduler.addSlave( *m_slaves[i], slaveAdr == weightedAddress ? weighted_slave_weight : 1 );
+            }
+
+            m_session.init( m_can,
+                            [this]( const can::CanMessage & answer ){ onAnswer( answer ); },
+                            [this]( const can::CanMessage & msg, uint32_t slaveAdr ){ onUnexpected( msg, slaveAdr ); },
+                            [this](){ onFailure(); },
+                            [this]( const can::CanMessage & ){ m_irrelevantCount++; } );
+
+            m_session.fillFilters();
+
+            m_can.setNode( [this]( uint32_t curTime ){ work( curTime ); }, master_tick, master_reaction );
+        }
+
+        SimSlave & getSlave( uint8_t slaveAdr )
+        {
+            return *m_slaves[ slaveAdr - (uint32_t)cannabus::IdAddresses::MIN_SLAVE_ADDRESS ];
+        }
+
+        uint32_t getSlavesNum( void ) const
+        {
+            return m_slaves.size();
+        }
+
+        uint32_t getFailuresCount( void ) const
+        {
+            return m_failuresCount;
+        }
+
+        uint32_t getHighPrioCount( void ) const
+        {
+            return m_highPrioCount;
+        }
+
+        uint32_t getIrrelevantCount( void ) const
+        {
+            return m_irrelevantCount;
+        }
+
+        cannabus::SlaveScheduler< slaves_max > & getScheduler( void )
+        {
+            return m_scheduler;
+        }
+
+        // оператор сменил уставку: замеряем, через сколько мастер отправит её слейву
+        void onSetpointChanged( uint8_t slaveAdr, uint32_t curTime )
+        {
+            uint32_t index = slaveAdr - (uint32_t)cannabus::IdAddresses::MIN_SLAVE_ADDRESS;
+
+            if( ! m_isSetpointPending[ index ] )
+            {
+                m_setpointTimes[ index ] = curTime;
+                m_isSetpointPending[ index ] = true;
+            }
+        }
+
+        // худшая задержка от смены уставки до запроса на запись, мс
+        uint32_t getSetpointLatencyMax( void ) const
+        {
+            return m_setpointLatencyMax;
+        }
+
+        // блочное чтение всей таблицы слейва; пока оно идет, обычный опрос стоит
+        bool tryStartBulkRead( uint8_t slaveAdr )
+        {
+            if( ! m_session.tryStartBulkRead( slaveAdr, ro_reg_min,
+                                              umba::ArrayView<uint8_t>( m_bulkValues, bulk_regs_num ),
+                                              [this]( bool isOk ){ onBulkComplete( isOk ); } ) )
+            {
+                return false;
+            }
+
+            m_bulkStartTime = m_bus.getTime();
+
+            return true;
+        }
+
+        // потоковая передача образа слейву; опрос планировщиком идет вперемешку с ней
+        bool tryStartBlockSend( uint8_t slaveAdr )
+        {
+            if( m_blockSender.isActive() )
+            {
+                return false;
+            }
+
+            m_blockSender.init( m_session, slaveAdr, block_fcode );
+
+            return m_blockSender.tryStart( umba::ArrayView<const uint8_t>( m_blockImage, block_image_size ),
+                                           block_window_frames,
+                                           [this]( bool isOk ){ onBlockComplete( isOk ); },
+                                           m_curTime );
+        }
+
+        uint32_t getBlockOkCount( void ) const
+        {
+            return m_blockOkCount;
+        }
+
+        uint32_t getBlockFailedCount( void ) const
+        {
+            return m_blockFailedCount;
+        }
+
+        // средняя по успешным передачам скорость из BlockSender::getBytesPerSecond
+        uint32_t getBlockBytesPerSecond( void ) const
+        {
+            return m_blockOkCount == 0 ? 0 : (uint32_t)( m_blockRateSum / m_blockOkCount );
+        }
+
+        uint32_t getBulkOkCount( void ) const
+        {
+            return m_bulkOkCount;
+        }
+
+        uint32_t getBulkFailedCount( void ) const
+        {
+            return m_bulkFailedCount;
+        }
+
+        // суммарная длительность успешных блочных чтений, нс
+        Time getBulkTime( void ) const
+        {
+            return m_bulkTime;
+        }
+
+    private:
+
+        void work( uint32_t curTime )
+        {
+            m_curTime = curTime;
+
+            m_blockSender.work( curTime );
+
+            trySendNext( curTime );
+
+            bool wasRequestPending = m_isRequestPending;
+
+            m_session.work( curTime );
+
+            // ответ принят - следующий запрос уходит в этом же вызове, а не на следующем тике
+            if( wasRequestPending && ! m_isRequestPending )
+            {
+                trySendNext( curTime );
+                m_session.work( curTime );
+            }
+        }
+
+        void trySendNext( uint32_t curTime )
+        {
+            if( m_isRequestPending )
+            {
+                return;
+            }
+
+            can::CanMessage request;
+
+            if( ! m_scheduler.tryGetRequest( request, curTime ) )
+            {
+                return;
+            }
+
+            m_session.sendRequest( request );
+
+            m_requestAdr = cannabus::getAddressFromId( request.id );
+            m_isRequestPending = true;
+
+            cannabus::IdFCode fcode = cannabus::getFCodeFromId( request.id );
+            uint32_t index = m_requestAdr - (uint32_t)cannabus::IdAddresses::MIN_SLAVE_ADDRESS;
+
+            if( m_isSetpointPending[ index ] &&
+                ( fcode == cannabus::IdFCode::WRITE_REGS_RANGE || fcode == cannabus::IdFCode::WRITE_REGS_SERIES ) )
+            {
+                // отвалившийся слейв ждет конца паузы, это не задержка планировщика
+                if( getSlave( m_requestAdr ).isConnected() )
+                {
+                    m_setpointLatencyMax = std::max( m_setpointLatencyMax, curTime - m_setpointTimes[ index ] );
+                }
+
+                m_isSetpointPending[ index ] = false;
+            }
+        }
+
+        void onAnswer( const can::CanMessage & answer )
+        {
+            SimSlave & slave = getSlave( m_requestAdr );
+
+            slave.processAnswer( answer );
+            slave.setConnectionState( true );
+            slave.synchronize();
+            slave.answersCount++;
+
+            m_scheduler.onAnswerReceived();
+            m_isRequestPending = false;
+        }
+
+        void onFailure( void )
+        {
+            getSlave( m_requestAdr ).setConnectionState( false );
+
+            // отвалившийся слейв планировщик обходит с растущей паузой
+            m_scheduler.onConnectionFailure( m_curTime );
+
+            m_failuresCount++;
+            m_isRequestPending = false;
+        }
+
+        void onBulkComplete( bool isOk )
+        {
+            if( ! isOk )
+            {
+                m_bulkFailedCount++;
+                return;
+            }
+
+            m_bulkOkCount++;
+            m_bulkTime += m_bus.getTime() - m_bulkStartTime;
+        }
+
+        void onBlockComplete( bool isOk )
+        {
+            if( ! isOk )
+            {
+                m_blockFailedCount++;
+                return;
+            }
+
+            m_blockOkCount++;
+            m_blockRateSum += m_blockSender.getBytesPerSecond();
+        }
+
+        void onUnexpected( const can::CanMessage & msg, uint32_t slaveAdr )
+        {
+            (void)msg;
+            (void)slaveAdr;
+
+            m_highPrioCount++;
+        }
+
+        VirtualBus & m_bus;
+        VirtualCan m_can;
+        cannabus::MasterSession m_session;
+
+        std::vector< std::unique_ptr< SimSlave > > m_slaves;
+        cannabus::SlaveScheduler< slaves_max > m_scheduler;
+
+        std::vector< uint32_t > m_setpointTimes;
+        std::vector< bool > m_isSetpointPending;
+        uint32_t m_setpointLatencyMax = 0;
+
+        uint32_t m_curTime = 0;
+        uint8_t m_requestAdr = 0;
+        bool m_isRequestPending = false;
+
+        uint32_t m_failuresCount = 0;
+        uint32_t m_highPrioCount = 0;
+        uint32_t m_irrelevantCount = 0;
+
+        uint8_t m_bulkValues[ bulk_regs_num ] = {};
+        Time m_bulkStartTime = 0;
+        Time m_bulkTime = 0;
+        uint32_t m_bulkOkCount = 0;
+        uint32_t m_bulkFailedCount = 0;
+
+        cannabus::BlockSender m_blockSender;
+        uint8_t m_blockImage[ block_image_size ] = {};
+        uint64_t m_blockRateSum = 0;
+        uint32_t m_blockOkCount = 0;
+        uint32_t m_blockFailedCount = 0;
+    };
+
+
+    bool parseOptions( int argc, char * argv[], Options & options )
+    {
+        for( int i = 1; i < argc; i++ )
+        {
+            const char * name = argv[i];
+
+            if( i + 1 >= argc )
+            {
+                fprintf( stderr, "no value for %s\n", name );
+                return false;
+            }
+
+            const char * value = argv[ ++i ];
+
+            if( strcmp( name, "--duration" ) == 0 )
+            {
+                options.duration = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--bitrate" ) == 0 )
+            {
+                options.bitRate = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--slaves" ) == 0 )
+            {
+                options.slavesNum = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--ro-interval" ) == 0 )
+            {
+                options.roInterval = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--ber" ) == 0 )
+            {
+                options.bitErrorRate = strtod( value, nullptr );
+            }
+            else if( strcmp( name, "--seed" ) == 0 )
+            {
+                options.seed = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--offline" ) == 0 )
+            {
+                options.offlineAddress = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--weighted" ) == 0 )
+            {
+                options.weightedAddress = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--bulk" ) == 0 )
+            {
+                options.bulkAddress = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--block" ) == 0 )
+            {
+                options.blockAddress = strtoul( value, nullptr, 10 );
+            }
+            else if( strcmp( name, "--capture" ) == 0 )
+            {
+                options.captureFile = value;
+            }
+            else
+            {
+                fprintf( stderr, "unknown option %s\n", name );
+                return false;
+            }
+        }
+
+        uint32_t slavesMax = (uint32_t)cannabus::IdAddresses::MAX_SLAVE_ADDRESS;
+
+        if( options.slavesNum == 0 || options.slavesNum > slavesMax || options.bitRate == 0 )
+        {
+            fprintf( stderr, "slaves must be 1..%u, bitrate must not be 0\n", slavesMax );
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    Options options;
+
+    if( ! parseOptions( argc, argv, options ) )
+    {
+        return 1;
+    }
+
+    VirtualBus bus( options.bitRate, 0, options.seed );
+    bus.setBitErrorRate( options.bitErrorRate );
+
+    CaptureWriter capture;
+
+    if( options.captureFile != nullptr && ! capture.open( options.captureFile ) )
+    {
+        fprintf( stderr, "can't open %s\n", options.captureFile );
+        return 1;
+    }
+
+    bus.setFrameHandler( [&capture]( const can::CanMessage & msg, Time time, bool isError )
+    {
+        if( isError )
+        {
+            capture.writeErrorFrame( time );
+        }
+        else
+        {
+            capture.writeFrame( msg, time );
+        }
+    } );
+
+    Master master( bus, options.slavesNum, options.roInterval, options.weightedAddress );
+
+    std::vector< std::unique_ptr< Device > > devices;
+
+    for( uint32_t i = 0; i < options.slavesNum; i++ )
+    {
+        devices.emplace_back( new Device( bus ) );
+
+        Device & device = *devices.back();
+        uint8_t slaveAdr = i + (uint32_t)cannabus::IdAddresses::MIN_SLAVE_ADDRESS;
+
+        device.session.init( device.can, slaveAdr, device.table,
+                             [&device](){ device.linkLostCount++; },
+                             callback::NullCallback(),
+                             lost_link_timeout );
+
+        device.session.fillFilters();
+        device.session.setHighPrioCoalesceWindow( coalesce_window );
+
+        if( slaveAdr == options.blockAddress )
+        {
+            device.blockReceiver.init( callback::NullCallback(),
+                                       [&device]( uint32_t, umba::ArrayView<const uint8_t> data ){ device.blockBytes += data.size(); },
+                                       callback::NullCallback() );
+
+            device.session.setDeviceSpecific( block_fcode,
+                                              [&device]( umba::ArrayView<uint8_t> request, umba::ArrayView<uint8_t> answer )
+                                              {
+                                                  return device.blockReceiver.handle( request, answer );
+                                              } );
+        }
+
+        device.can.setNode( [&device]( uint32_t curTime ){ device.session.work( curTime ); }, slave_tick, slave_reaction );
+    }
+
+    // датчики слейвов меняются постоянно, а о нулевом время от времени сообщается высокоприоритеткой
+    bus.addTimer( 0, sensors_period, [&devices]( Time )
+    {
+        for( auto & device : devices )
+        {
+            device->sensorValue++;
+            device->table.setRegVal( ro_reg_min, device->sensorValue );
+            device->table.setRegVal( ro_reg_min + 1 + device->sensorValue % ( ro_reg_max - ro_reg_min ), device->sensorValue );
+        }
+    } );
+
+    bus.addTimer( alarm_period, alarm_period, [&devices]( Time )
+    {
+        for( auto & device : devices )
+        {
+            device->session.notifyRegChanged( ro_reg_min );
+        }
+    } );
+
+    // оператор время от времени меняет уставки, мастер сам дописывает их в слейвы
+    uint32_t operatorStep = 0;
+
+    bus.addTimer( operator_period, operator_period, [&master, &operatorStep]( Time time )
+    {
+        operatorStep++;
+
+        uint8_t slaveAdr = 1 + operatorStep % master.getSlavesNum();
+        uint8_t regNum = rw_reg_min + operatorStep % ( rw_reg_max - rw_reg_min + 1 );
+
+        master.getSlave( slaveAdr ).getSlaveTable()->setRegVal( regNum, (uint8_t)operatorStep );
+        master.onSetpointChanged( slaveAdr, (uint32_t)( time / ns_in_ms ) );
+    } );
+
+    // блочное чтение не запускается, пока не закончилось предыдущее
+    if( options.bulkAddress != 0 && options.bulkAddress <= options.slavesNum )
+    {
+        uint8_t bulkAddress = options.bulkAddress;
+
+        bus.addTimer( bulk_period, bulk_period, [&master, bulkAddress]( Time ){ master.tryStartBulkRead( bulkAddress ); } );
+    }
+
+    if( options.blockAddress != 0 && options.blockAddress <= options.slavesNum )
+    {
+        uint8_t blockAddress = options.blockAddress;
+
+        bus.addTimer( block_period, block_period, [&master, blockAddress]( Time ){ master.tryStartBlockSend( blockAddress ); } );
+    }
+
+    // отказ одного слейва во второй четверти прогона
+    if( options.offlineAddress != 0 && options.offlineAddress <= options.slavesNum )
+    {
+        Device & device = *devices[ options.offlineAddress - 1 ];
+        Time quarter = (Time)options.duration * ns_in_second / 4;
+
+        bus.addTimer( quarter, 0, [&device]( Time ){ device.can.setOnline( false ); } );
+        bus.addTimer( 2 * quarter, 0, [&device]( Time ){ device.can.setOnline( true ); } );
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    bus.runUntil( (Time)options.duration * ns_in_second );
+
+    std::chrono::duration< double > wallTime = std::chrono::steady_clock::now() - wallStart;
+
+    capture.close();
+
+    uint64_t answers = 0;
+    uint32_t linkLost = 0;
+    uint32_t rxOverflows = 0;
+
+    for( uint32_t i = 0; i < options.slavesNum; i++ )
+    {
+        answers += master.getSlave( i + 1 ).answersCount;
+        linkLost += devices[i]->linkLostCount;
+        rxOverflows += devices[i]->can.getRxOverflowCount();
+    }
+
+    printf( "simulated:      %u s\n", options.duration );
+    printf( "wall time:      %.2f s\n", wallTime.count() );
+    printf( "frames:         %llu\n", (unsigned long long)bus.getFramesCount() );
+    printf( "error frames:   %llu\n", (unsigned long long)bus.getErrorFramesCount() );
+    printf( "bus load:       %.1f %%\n", 100.0 * bus.getBusyTime() / ( (double)options.duration * ns_in_second ) );
+    printf( "answers:        %llu\n", (unsigned long long)answers );
+    printf( "master fails:   %u\n", master.getFailuresCount() );
+    printf( "high-prio msgs: %u\n", master.getHighPrioCount() );
+    printf( "irrelevant:     %u\n", master.getIrrelevantCount() );
+    printf( "link lost:      %u\n", linkLost );
+    printf( "rx overflows:   %u\n", rxOverflows );
+
+    // граница круга планировщика против замеренной задержки записи уставок;
+    // высокоприоритетные сообщения слейвов планировщик не учитывает, они удлиняют круг сверх границы
+    auto & scheduler = master.getScheduler();
+
+    printf( "round bound:    %.1f ms\n", 1000.0 * scheduler.getRoundBitsMax() / options.bitRate );
+    printf( "setpoint max:   %u ms\n", master.getSetpointLatencyMax() );
+
+    if( options.weightedAddress != 0 && options.weightedAddress <= options.slavesNum )
+    {
+        uint64_t busBits = 0;
+
+        for( uint32_t i = 0; i < options.slavesNum; i++ )
+        {
+            busBits += scheduler.getBusBits( i + 1 );
+        }
+
+        printf( "weighted share: %.1f %% (slave %u, weight %u)\n",
+                100.0 * scheduler.getBusBits( options.weightedAddress ) / busBits,
+                options.weightedAddress, weighted_slave_weight );
+    }
+
+    // скорость блочного чтения против шины, занятой только его кадрами
+    if( master.getBulkOkCount() != 0 )
+    {
+        double bulkTime = (double)master.getBulkTime() / master.getBulkOkCount() / ns_in_second;
+        double busTime = (double)getBulkReadBits( bulk_regs_num ) / options.bitRate;
+
+        printf( "bulk reads:     %u ok, %u failed\n", master.getBulkOkCount(), master.getBulkFailedCount() );
+        printf( "bulk rate:      %.0f regs/s, bus bound %.0f regs/s (%.1f %%)\n",
+                bulk_regs_num / bulkTime, bulk_regs_num / busTime, 100.0 * busTime / bulkTime );
+    }
+
+    // Потоковая передача против сырой шины: кадры по 8 байт подряд без пауз, в наихудшем стаффинге. Между ними - предел самого
+    // протокола: в кадре данных 7 байт полезных, и на каждое окно приходится пара кадров опроса
+    if( master.getBlockOkCount() != 0 )
+    {
+        double rawRate = 8.0 * options.bitRate / cannabus::getFrameBitsWorstCase( 8 );
+        double windowRate = (double)block_window_frames * cannabus::block_frame_payload * options.bitRate /
+                            ( block_window_frames * cannabus::getFrameBitsWorstCase( 8 ) +
+                              cannabus::getFrameBitsWorstCase( 4 ) + cannabus::getFrameBitsWorstCase( 7 ) );
+
+        printf( "block sends:    %u ok, %u failed\n", master.getBlockOkCount(), master.getBlockFailedCount() );
+        printf( "block rate:     %u B/s, window bound %.0f B/s, raw bus %.0f B/s (%.1f %%)\n",
+                master.getBlockBytesPerSecond(), windowRate, rawRate, 100.0 * master.getBlockBytesPerSecond() / rawRate );
+    }
+
+    return 0;
+}
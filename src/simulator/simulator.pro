@@ -0,0 +1,32 @@
+# Симулятор сети CANNABUS PLUS с виртуальным временем, консольное приложение без Qt.
+# Внешние библиотеки (umba, can, callbacks, reg_tables) ищутся в LIBS_ROOT:
+#   qmake simulator.pro LIBS_ROOT=/path/to/libs
+
+TEMPLATE = app
+TARGET = cannabus_simulator
+
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+isEmpty(LIBS_ROOT): LIBS_ROOT = $$PWD/../../../libs
+
+INCLUDEPATH += \
+    $$PWD \
+    $$PWD/../cannabus_library \
+    $$LIBS_ROOT
+
+SOURCES += \
+    capture_writer.cpp \
+    main.cpp \
+    virtual_bus.cpp \
+    ../cannabus_library/cannabus_block_transfer.cpp \
+    ../cannabus_library/cannabus_master_session.cpp \
+    ../cannabus_library/cannabus_request_creator.cpp \
+    ../cannabus_library/cannabus_slave.cpp \
+    ../cannabus_library/cannabus_slave_session.cpp
+
+HEADERS += \
+    capture_writer.h \
+    project_config.h \
+    virtual_bus.h \
+    ../cannabus_library/cannabus_frame_bits.h
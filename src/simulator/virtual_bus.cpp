@@ -0,0 +1,463 @@
+#include "virtual_bus.h"
+#include "cannabus_frame_bits.h"
+#include <cmath>
+
+namespace simulator
+{
+    /**************************************************************************************************
+    Описание:  Подключение порта к шине
+    Аргументы: bus          - шина
+               mailboxesNum - число ящиков на передачу
+               rxFifoSize   - глубина приемного FIFO
+               filtersNum   - число аппаратных фильтров
+    Возврат:   -
+    Замечания: -
+    **************************************************************************************************/
+    VirtualCan::VirtualCan( VirtualBus & bus, uint32_t mailboxesNum, uint32_t rxFifoSize, uint32_t filtersNum ) :
+        m_bus( bus ),
+        m_mailboxesNum( mailboxesNum ),
+        m_rxFifoSize( rxFifoSize ),
+        m_filters( filtersNum )
+    {
+        m_mailboxes.reserve( mailboxesNum );
+
+        m_index = m_bus.connect( *this );
+    }
+
+    /**************************************************************************************************
+    Описание:  Задать узел, который работает с портом
+    Аргументы: work          - обработчик узла, получает время в миллисекундах, как work() сессий
+               tickPeriod    - период вызова без событий, 0 - только по событиям
+               reactionDelay - задержка обработки пришедшего кадра
+    Возврат:   -
+    Замечания: первый тик - сразу, чтобы узел успел проинициализироваться
+    **************************************************************************************************/
+    void VirtualCan::setNode( OnWork work, Time tickPeriod, Time reactionDelay )
+    {
+        m_work = work;
+        m_tickPeriod = tickPeriod;
+        m_reactionDelay = reactionDelay;
+
+        if( m_tickPeriod != 0 )
+        {
+            m_bus.schedule( m_bus.getTime(), VirtualBus::EventType::NODE_TICK, m_index );
+        }
+    }
+
+    /**************************************************************************************************
+    Описание:  Включить или отключить узел
+    Аргументы: isOnline - узел на шине
+    Возврат:   -
+    Замечания: при отключении теряется всё, что лежало в ящиках и в FIFO
+    **************************************************************************************************/
+    void VirtualCan::setOnline( bool isOnline )
+    {
+        m_isOnline = isOnline;
+
+        if( ! m_isOnline )
+        {
+            m_bus.m_pendingFrames -= m_mailboxes.size();
+
+            m_mailboxes.clear();
+            m_rxFifo.clear();
+        }
+    }
+
+    bool VirtualCan::tryToReceive( can::CanMessage & msg )
+    {
+        if( m_rxFifo.empty() )
+        {
+            return false;
+        }
+
+        msg = m_rxFifo.front();
+        m_rxFifo.pop_front();
+
+        return true;
+    }
+
+    can::ReturnState VirtualCan::transmitMessage( const can::CanMessage & msg )
+    {
+        if( ! isReadyToTransmit() )
+        {
+            return can::ReturnState::ERROR;
+        }
+
+        // на шину кадр попадет после того, как узел закончит работу, - так кадры,
+        // поставленные разными узлами в один и тот же момент, честно участвуют в арбитраже
+        m_mailboxes.push_back( msg );
+        m_bus.m_pendingFrames++;
+
+        return can::ReturnState::OK;
+    }
+
+    bool VirtualCan::isReadyToTransmit( void )
+    {
+        return m_isOnline && m_mailboxes.size() < m_mailboxesNum;
+    }
+
+    void VirtualCan::addFilter( const can::CanFilter & filter, uint32_t filterNum )
+    {
+        if( filterNum >= m_filters.size() )
+        {
+            return;
+        }
+
+        m_filters[ filterNum ].filter = filter;
+        m_filters[ filterNum ].isUsed = true;
+    }
+
+    /**************************************************************************************************
+    Описание:  Проверка ID аппаратными фильтрами
+    Аргументы: id - ID кадра
+    Возврат:   true, если кадр принимается
+    Замечания: пока ни одного фильтра не задано, принимается всё
+    **************************************************************************************************/
+    bool VirtualCan::isAccepted( uint32_t id ) const
+    {
+        bool isAnyUsed = false;
+
+        for( const auto & slot : m_filters )
+        {
+            if( ! slot.isUsed )
+            {
+                continue;
+            }
+
+            isAnyUsed = true;
+
+            if( ( ( id ^ slot.filter.filter ) & slot.filter.mask ) == 0 )
+            {
+                return true;
+            }
+        }
+
+        return ! isAnyUsed;
+    }
+
+    int32_t VirtualCan::getBestMailbox( void ) const
+    {
+        int32_t best = -1;
+
+        for( uint32_t i = 0; i < m_mailboxes.size(); i++ )
+        {
+            if( best < 0 || m_mailboxes[i].id < m_mailboxes[ best ].id )
+            {
+                best = i;
+            }
+        }
+
+        return best;
+    }
+
+    /**************************************************************************************************
+    Описание:  Прием кадра с шины
+    Аргументы: msg - кадр
+    Возврат:   -
+    Замечания: при переполненном FIFO кадр теряется, как в настоящем контроллере
+    **************************************************************************************************/
+    void VirtualCan::deliver( const can::CanMessage & msg )
+    {
+        if( ! m_isOnline || ! isAccepted( msg.id ) )
+        {
+            return;
+        }
+
+        if( m_rxFifo.size() >= m_rxFifoSize )
+        {
+            m_rxOverflowCount++;
+            return;
+        }
+
+        m_rxFifo.push_back( msg );
+
+        m_bus.wake( *this );
+    }
+
+
+    /**************************************************************************************************
+    Описание:  Создание шины
+    Аргументы: bitRate     - номинальная скорость, бит/с
+               dataBitRate - скорость фазы данных CAN FD, 0 - как номинальная
+               seed        - затравка генератора ошибок, один и тот же прогон повторяется в точности
+    Возврат:   -
+    Замечания: -
+    **************************************************************************************************/
+    VirtualBus::VirtualBus( uint32_t bitRate, uint32_t dataBitRate, uint32_t seed ) :
+        m_bitRate( bitRate ),
+        m_dataBitRate( dataBitRate != 0 ? dataBitRate : bitRate ),
+        m_random( seed != 0 ? seed : 1 )
+    {
+    }
+
+    void VirtualBus::addTimer( Time firstTime, Time period, OnTimer onTimer )
+    {
+        m_timers.push_back( Timer{ period, onTimer } );
+
+        schedule( firstTime, EventType::TIMER, m_timers.size() - 1 );
+    }
+
+    /**************************************************************************************************
+    Описание:  Прогон до заданного момента
+    Аргументы: endTime - виртуальное время, до которого идет прогон
+    Возврат:   -
+    Замечания: время перескакивает от события к событию, поэтому час работы шины считается
+               за время, пропорциональное числу кадров и вызовов узлов, а не длительности
+    **************************************************************************************************/
+    void VirtualBus::runUntil( Time endTime )
+    {
+        while( ! m_events.empty() && m_events.top().time <= endTime )
+        {
+            Event event = m_events.top();
+            m_events.pop();
+
+            m_time = event.time;
+
+            uint32_t curTime = (uint32_t)( m_time / ns_in_ms );
+
+            switch( event.type )
+            {
+            case EventType::FRAME_END:
+
+                onFrameEnd();
+                break;
+
+            case EventType::NODE_WAKE:
+            {
+                VirtualCan & node = *m_nodes[ event.index ];
+
+                node.m_isWakePending = false;
+
+                if( node.m_isOnline )
+                {
+                    node.m_work( curTime );
+                }
+
+                break;
+            }
+
+            case EventType::NODE_TICK:
+            {
+                VirtualCan & node = *m_nodes[ event.index ];
+
+                if( node.m_isOnline )
+                {
+                    node.m_work( curTime );
+                }
+
+                schedule( m_time + node.m_tickPeriod, EventType::NODE_TICK, event.index );
+                break;
+            }
+
+            case EventType::TIMER:
+            {
+                Timer & timer = m_timers[ event.index ];
+
+                timer.onTimer( m_time );
+
+                if( timer.period != 0 )
+                {
+                    schedule( m_time + timer.period, EventType::TIMER, event.index );
+                }
+
+                break;
+            }
+            }
+
+            tryStartFrame();
+        }
+
+        m_time = endTime;
+    }
+
+    uint32_t VirtualBus::connect( VirtualCan & can )
+    {
+        m_nodes.push_back( &can );
+
+        return m_nodes.size() - 1;
+    }
+
+    void VirtualBus::schedule( Time time, EventType type, uint32_t index )
+    {
+        m_events.push( Event{ time, m_eventSeq++, type, index } );
+    }
+
+    void VirtualBus::wake( VirtualCan & can )
+    {
+        if( can.m_isWakePending || ! can.m_work )
+        {
+            return;
+        }
+
+        can.m_isWakePending = true;
+
+        schedule( m_time + can.m_reactionDelay, EventType::NODE_WAKE, can.m_index );
+    }
+
+    /**************************************************************************************************
+    Описание:  Арбитраж: на шину выходит кадр с меньшим ID из всех ящиков всех узлов
+    Аргументы: -
+    Возврат:   -
+    Замечания: одинаковые ID от разных узлов в cannabus невозможны, первый найденный выигрывает
+    **************************************************************************************************/
+    void VirtualBus::tryStartFrame( void )
+    {
+        // на каждом событии опрашивать все узлы незачем, если ни у кого нет кадров
+        if( m_isBusy || m_pendingFrames == 0 )
+        {
+            return;
+        }
+
+        int32_t bestNode = -1;
+        int32_t bestMailbox = -1;
+
+        for( uint32_t i = 0; i < m_nodes.size(); i++ )
+        {
+            const VirtualCan & node = *m_nodes[i];
+
+            if( ! node.m_isOnline || node.m_mailboxes.empty() )
+            {
+                continue;
+            }
+
+            int32_t mailbox = node.getBestMailbox();
+
+            if( bestNode < 0 || node.m_mailboxes[ mailbox ].id < m_nodes[ bestNode ]->m_mailboxes[ bestMailbox ].id )
+            {
+                bestNode = i;
+                bestMailbox = mailbox;
+            }
+        }
+
+        if( bestNode < 0 )
+        {
+            return;
+        }
+
+        m_isBusy = true;
+        m_senderIndex = bestNode;
+        m_senderMailbox = bestMailbox;
+        m_senderId = m_nodes[ bestNode ]->m_mailboxes[ bestMailbox ].id;
+
+        uint32_t bitsNum = 0;
+        Time duration = getFrameDuration( m_nodes[ bestNode ]->m_mailboxes[ bestMailbox ], bitsNum );
+
+        // кадр без подтверждения - тоже ошибка, передатчик будет повторять его, пока кто-нибудь не ответит
+        m_isCurrentCorrupted = isFrameCorrupted( bitsNum ) || ! isFrameAcked( bestNode );
+
+        if( m_isCurrentCorrupted )
+        {
+            duration += cannabus::error_frame_bits * ns_in_second / m_bitRate;
+        }
+
+        m_busyTime += duration;
+
+        schedule( m_time + duration, EventType::FRAME_END, 0 );
+    }
+
+    /**************************************************************************************************
+    Описание:  Конец кадра на шине
+    Аргументы: -
+    Возврат:   -
+    Замечания: целый кадр освобождает ящик передатчика и раздается всем остальным узлам,
+               испорченный остается в ящике и снова участвует в арбитраже
+    **************************************************************************************************/
+    void VirtualBus::onFrameEnd( void )
+    {
+        m_isBusy = false;
+
+        VirtualCan & sender = *m_nodes[ m_senderIndex ];
+
+        // передатчик отключили посреди кадра
+        if( (uint32_t)m_senderMailbox >= sender.m_mailboxes.size() ||
+            sender.m_mailboxes[ m_senderMailbox ].id != m_senderId )
+        {
+            return;
+        }
+
+        if( m_isCurrentCorrupted )
+        {
+            m_errorFramesCount++;
+
+            if( m_onFrame )
+            {
+                m_onFrame( sender.m_mailboxes[ m_senderMailbox ], m_time, true );
+            }
+
+            return;
+        }
+
+        can::CanMessage msg = sender.m_mailboxes[ m_senderMailbox ];
+        sender.m_mailboxes.erase( sender.m_mailboxes.begin() + m_senderMailbox );
+        m_pendingFrames--;
+
+        sender.m_txFramesCount++;
+        m_framesCount++;
+
+        if( m_onFrame )
+        {
+            m_onFrame( msg, m_time, false );
+        }
+
+        for( uint32_t i = 0; i < m_nodes.size(); i++ )
+        {
+            if( i != m_senderIndex )
+            {
+                m_nodes[i]->deliver( msg );
+            }
+        }
+
+        // освободился ящик
+        wake( sender );
+    }
+
+    Time VirtualBus::getFrameDuration( const can::CanMessage & msg, uint32_t & bitsNum ) const
+    {
+        static const uint8_t classic_length_max = 8;
+
+        if( msg.length <= classic_length_max )
+        {
+            bitsNum = cannabus::getFrameBits( msg.id, &msg.data[0], msg.length );
+
+            return (Time)bitsNum * ns_in_second / m_bitRate;
+        }
+
+        cannabus::FdFrameBits bits = cannabus::getFdFrameBitsWorstCase( msg.length );
+
+        bitsNum = bits.arbitration + bits.data;
+
+        return (Time)bits.arbitration * ns_in_second / m_bitRate +
+               (Time)bits.data * ns_in_second / m_dataBitRate;
+    }
+
+    bool VirtualBus::isFrameCorrupted( uint32_t bitsNum )
+    {
+        if( m_bitErrorRate <= 0 )
+        {
+            return false;
+        }
+
+        // xorshift64*: быстрый и воспроизводимый от прогона к прогону
+        m_random ^= m_random >> 12;
+        m_random ^= m_random << 25;
+        m_random ^= m_random >> 27;
+
+        double random = (double)( ( m_random * 2685821657736338717ull ) >> 11 ) / (double)( 1ull << 53 );
+
+        return random < 1.0 - std::pow( 1.0 - m_bitErrorRate, (double)bitsNum );
+    }
+
+    bool VirtualBus::isFrameAcked( uint32_t senderIndex ) const
+    {
+        for( uint32_t i = 0; i < m_nodes.size(); i++ )
+        {
+            if( i != senderIndex && m_nodes[i]->m_isOnline )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+} // namespace simulator
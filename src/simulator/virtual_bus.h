@@ -0,0 +1,260 @@
+#pragma once
+
+#include "can/i_can.h"
+#include "callbacks/callbacks.h"
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace simulator
+{
+    // виртуальное время в наносекундах
+    using Time = uint64_t;
+
+    static constexpr Time ns_in_ms = 1000000;
+    static constexpr Time ns_in_second = 1000 * ns_in_ms;
+
+    class VirtualBus;
+
+    // Виртуальный CAN-порт одного узла.
+    // Как у настоящего контроллера: несколько ящиков на передачу, из которых первым уходит кадр
+    // с меньшим ID, приемное FIFO ограниченной глубины и аппаратные фильтры filter/mask.
+    // Узел - это функция work, которую шина вызывает, когда узлу есть что делать:
+    // пришел кадр, освободился ящик или подошел очередной тик
+    class VirtualCan : public can::ICan
+    {
+
+    public:
+
+        using OnWork = callback::Callback<void ( uint32_t curTime )>;
+
+        explicit VirtualCan( VirtualBus & bus,
+                             uint32_t mailboxesNum = 3,
+                             uint32_t rxFifoSize = 3,
+                             uint32_t filtersNum = 14 );
+
+        // копировать запрещено
+        VirtualCan( const VirtualCan & rhs ) = delete;
+        VirtualCan & operator=( VirtualCan & s ) = delete;
+
+        // tickPeriod - как часто узел вызывается без всяких событий (таймауты сессий считаются по времени);
+        // reactionDelay - через сколько после прихода кадра узел успевает его обработать
+        void setNode( OnWork work, Time tickPeriod, Time reactionDelay );
+
+        // отключенный узел не передает, не принимает и не подтверждает кадры
+        void setOnline( bool isOnline );
+
+        bool isOnline( void ) const
+        {
+            return m_isOnline;
+        }
+
+        uint32_t getRxOverflowCount( void ) const
+        {
+            return m_rxOverflowCount;
+        }
+
+        uint32_t getTxFramesCount( void ) const
+        {
+            return m_txFramesCount;
+        }
+
+        // can::ICan
+        virtual void lock( void ) override
+        {
+            m_isLocked = true;
+        }
+
+        virtual bool isLocked( void ) override
+        {
+            return m_isLocked;
+        }
+
+        virtual bool isInited( void ) override
+        {
+            return true;
+        }
+
+        virtual bool tryToReceive( can::CanMessage & msg ) override;
+        virtual can::ReturnState transmitMessage( const can::CanMessage & msg ) override;
+        virtual bool isReadyToTransmit( void ) override;
+
+        virtual uint32_t getFilterCapacity( void ) override
+        {
+            return m_filters.size();
+        }
+
+        virtual void addFilter( const can::CanFilter & filter, uint32_t filterNum ) override;
+
+    private:
+
+        friend class VirtualBus;
+
+        struct FilterSlot
+        {
+            can::CanFilter filter = {};
+            bool isUsed = false;
+        };
+
+        bool isAccepted( uint32_t id ) const;
+
+        // ящик с кадром, который выиграет арбитраж у этого узла, или -1
+        int32_t getBestMailbox( void ) const;
+
+        void deliver( const can::CanMessage & msg );
+
+        VirtualBus & m_bus;
+        uint32_t m_index = 0;
+
+        uint32_t m_mailboxesNum;
+        uint32_t m_rxFifoSize;
+
+        std::vector< can::CanMessage > m_mailboxes;
+        std::deque< can::CanMessage > m_rxFifo;
+        std::vector< FilterSlot > m_filters;
+
+        OnWork m_work = {};
+        Time m_tickPeriod = 0;
+        Time m_reactionDelay = 0;
+
+        // вызов по событию уже назначен, второй не нужен - work разгребает всё сразу
+        bool m_isWakePending = false;
+
+        bool m_isOnline = true;
+        bool m_isLocked = false;
+
+        uint32_t m_rxOverflowCount = 0;
+        uint32_t m_txFramesCount = 0;
+    };
+
+
+    // Шина с виртуальным временем.
+    // Время не тикает, а перескакивает от события к событию: конец кадра, вызов узла, таймер сценария.
+    // Длительность кадра считается по его битам при заданной скорости, из кадров, ждущих в ящиках,
+    // шина выбирает кадр с меньшим ID, как арбитраж. Ошибки вносятся с заданной вероятностью на бит:
+    // испорченный кадр занимает шину вместе с кадром ошибки и повторяется передатчиком
+    class VirtualBus
+    {
+
+    public:
+
+        // dataBitRate нужна только кадрам CAN FD (длиннее 8 байт)
+        explicit VirtualBus( uint32_t bitRate, uint32_t dataBitRate = 0, uint32_t seed = 1 );
+
+        // копировать запрещено
+        VirtualBus( const VirtualBus & rhs ) = delete;
+        VirtualBus & operator=( VirtualBus & s ) = delete;
+
+        void setBitErrorRate( double bitErrorRate )
+        {
+            m_bitErrorRate = bitErrorRate;
+        }
+
+        // кадр, прошедший по шине, и время его конца; isError - кадр испорчен и будет повторен
+        using OnFrame = callback::Callback<void ( const can::CanMessage & msg, Time time, bool isError )>;
+
+        void setFrameHandler( OnFrame onFrame )
+        {
+            m_onFrame = onFrame;
+        }
+
+        using OnTimer = callback::Callback<void ( Time time )>;
+
+        void addTimer( Time firstTime, Time period, OnTimer onTimer );
+
+        void runUntil( Time endTime );
+
+        Time getTime( void ) const
+        {
+            return m_time;
+        }
+
+        uint64_t getFramesCount( void ) const
+        {
+            return m_framesCount;
+        }
+
+        uint64_t getErrorFramesCount( void ) const
+        {
+            return m_errorFramesCount;
+        }
+
+        // суммарное время занятости шины, для загрузки
+        Time getBusyTime( void ) const
+        {
+            return m_busyTime;
+        }
+
+    private:
+
+        friend class VirtualCan;
+
+        enum class EventType{ FRAME_END, NODE_WAKE, NODE_TICK, TIMER };
+
+        struct Event
+        {
+            Time time;
+            // порядок событий с одинаковым временем - порядок их назначения, чтобы прогон был воспроизводимым
+            uint64_t seq;
+            EventType type;
+            uint32_t index;
+
+            bool operator>( const Event & rhs ) const
+            {
+                return time != rhs.time ? time > rhs.time : seq > rhs.seq;
+            }
+        };
+
+        struct Timer
+        {
+            Time period;
+            OnTimer onTimer;
+        };
+
+        uint32_t connect( VirtualCan & can );
+
+        void schedule( Time time, EventType type, uint32_t index );
+        void wake( VirtualCan & can );
+
+        void onFrameEnd( void );
+        void tryStartFrame( void );
+
+        // длительность кадра и число его бит, в которые может попасть ошибка
+        Time getFrameDuration( const can::CanMessage & msg, uint32_t & bitsNum ) const;
+        bool isFrameCorrupted( uint32_t bitsNum );
+        bool isFrameAcked( uint32_t senderIndex ) const;
+
+        uint32_t m_bitRate;
+        uint32_t m_dataBitRate;
+
+        double m_bitErrorRate = 0;
+        uint64_t m_random;
+
+        Time m_time = 0;
+        uint64_t m_eventSeq = 0;
+
+        std::priority_queue< Event, std::vector< Event >, std::greater< Event > > m_events;
+
+        std::vector< VirtualCan * > m_nodes;
+        std::vector< Timer > m_timers;
+
+        // кадров во всех ящиках всех узлов
+        uint32_t m_pendingFrames = 0;
+
+        // кадр, который сейчас на шине
+        bool m_isBusy = false;
+        uint32_t m_senderIndex = 0;
+        int32_t m_senderMailbox = 0;
+        uint32_t m_senderId = 0;
+        bool m_isCurrentCorrupted = false;
+
+        uint64_t m_framesCount = 0;
+        uint64_t m_errorFramesCount = 0;
+        Time m_busyTime = 0;
+
+        OnFrame m_onFrame = {};
+    };
+
+} // namespace simulator